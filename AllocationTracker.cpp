@@ -0,0 +1,321 @@
+#include "AllocationTracker.h"
+
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <cstdlib>
+#include <cstring>
+
+// Annonymous namespace to hold variables
+// only accessible in this file
+namespace
+{
+	// Tag 0 is everything outside a scope
+	const char* tagNames[AllocationTracker::MaxTags] = { "Untagged" };
+	std::atomic<unsigned int> tagCount{ 1 };
+	std::mutex tagMutex;
+
+	// Running totals, bumped from any thread
+	struct TagCounters
+	{
+		std::atomic<unsigned long long> allocations;
+		std::atomic<unsigned long long> bytes;
+		std::atomic<unsigned long long> liveAllocations;
+		std::atomic<unsigned long long> liveBytes;
+		std::atomic<unsigned long long> peakBytes;
+		std::atomic<long long> gpuBytes;
+		std::atomic<long long> gpuPeakBytes;
+	};
+	TagCounters counters[AllocationTracker::MaxTags];
+
+	// Written by the main thread only
+	AllocationTracker::Counts frameStart[AllocationTracker::MaxTags] = {};
+	AllocationTracker::Counts lastFrame[AllocationTracker::MaxTags] = {};
+	AllocationTracker::Budget budgets[AllocationTracker::MaxTags] = {};
+	bool overBudget[AllocationTracker::MaxTags] = {};
+
+	// Plain data, so it's usable before anything else on the
+	// thread has been constructed
+	thread_local unsigned int currentTag = 0;
+
+	// In front of every tracked allocation.  16 bytes, so
+	// what follows keeps malloc's alignment.
+	struct Header
+	{
+		size_t size;
+		size_t tag;
+	};
+
+	template<typename T>
+	void RaisePeak(std::atomic<T>& peak, T value)
+	{
+		T seen = peak.load(std::memory_order_relaxed);
+		while (value > seen && !peak.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {}
+	}
+
+	void WriteJsonString(FILE* file, const char* text)
+	{
+		fputc('"', file);
+		for (const char* c = text; *c; c++)
+		{
+			if (*c == '"' || *c == '\\')
+				fputc('\\', file);
+			fputc(*c, file);
+		}
+		fputc('"', file);
+	}
+}
+
+unsigned int AllocationTracker::RegisterTag(const char* name)
+{
+	std::lock_guard<std::mutex> lock(tagMutex);
+
+	unsigned int count = tagCount.load(std::memory_order_relaxed);
+	for (unsigned int t = 0; t < count; t++)
+	{
+		if (strcmp(tagNames[t], name) == 0)
+			return t;
+	}
+
+	if (count == MaxTags)
+		return 0;
+
+	tagNames[count] = name;
+	tagCount.store(count + 1, std::memory_order_release);
+	return count;
+}
+
+unsigned int AllocationTracker::GetTagCount()
+{
+	return tagCount.load(std::memory_order_acquire);
+}
+
+const char* AllocationTracker::GetTagName(unsigned int tag)
+{
+	return tag < GetTagCount() ? tagNames[tag] : "";
+}
+
+// --------------------------------------------------------
+// Whatever was counted since the last call becomes the
+// last frame, and budgets are checked.  Allocations on
+// other threads land in whichever frame was open when they
+// happened.
+// --------------------------------------------------------
+void AllocationTracker::BeginFrame()
+{
+	unsigned int count = GetTagCount();
+	for (unsigned int t = 0; t < count; t++)
+	{
+		Counts now = { counters[t].allocations.load(std::memory_order_relaxed), counters[t].bytes.load(std::memory_order_relaxed) };
+		lastFrame[t].allocations = now.allocations - frameStart[t].allocations;
+		lastFrame[t].bytes = now.bytes - frameStart[t].bytes;
+		frameStart[t] = now;
+
+		// Only reported as it goes over, not every frame it stays there
+		TagMemory memory = GetMemory(t);
+		bool over =
+			(budgets[t].cpuBytes > 0 && memory.liveBytes > budgets[t].cpuBytes) ||
+			(budgets[t].gpuBytes > 0 && memory.gpuBytes > budgets[t].gpuBytes);
+		if (over && !overBudget[t])
+		{
+			printf("Memory budget exceeded: %s is using %.2f MB (budget %.2f MB) and %.2f MB GPU (budget %.2f MB)\n",
+				tagNames[t],
+				memory.liveBytes / (1024.0 * 1024.0), budgets[t].cpuBytes / (1024.0 * 1024.0),
+				memory.gpuBytes / (1024.0 * 1024.0), budgets[t].gpuBytes / (1024.0 * 1024.0));
+		}
+		overBudget[t] = over;
+	}
+}
+
+AllocationTracker::Counts AllocationTracker::GetLastFrame(unsigned int tag)
+{
+	return tag < MaxTags ? lastFrame[tag] : Counts{};
+}
+
+AllocationTracker::Counts AllocationTracker::GetLastFrameTotal()
+{
+	Counts total = {};
+	for (unsigned int t = 0; t < GetTagCount(); t++)
+	{
+		total.allocations += lastFrame[t].allocations;
+		total.bytes += lastFrame[t].bytes;
+	}
+	return total;
+}
+
+AllocationTracker::Counts AllocationTracker::GetTotal(unsigned int tag)
+{
+	if (tag >= MaxTags)
+		return {};
+	return { counters[tag].allocations.load(std::memory_order_relaxed), counters[tag].bytes.load(std::memory_order_relaxed) };
+}
+
+AllocationTracker::TagMemory AllocationTracker::GetMemory(unsigned int tag)
+{
+	if (tag >= GetTagCount())
+		return {};
+
+	TagCounters& c = counters[tag];
+	long long gpu = c.gpuBytes.load(std::memory_order_relaxed);
+
+	TagMemory memory = {};
+	memory.name = tagNames[tag];
+	memory.liveBytes = c.liveBytes.load(std::memory_order_relaxed);
+	memory.peakBytes = c.peakBytes.load(std::memory_order_relaxed);
+	memory.liveAllocations = c.liveAllocations.load(std::memory_order_relaxed);
+	memory.totalAllocations = c.allocations.load(std::memory_order_relaxed);
+	memory.gpuBytes = gpu > 0 ? (unsigned long long)gpu : 0;
+	memory.gpuPeakBytes = (unsigned long long)c.gpuPeakBytes.load(std::memory_order_relaxed);
+	return memory;
+}
+
+// --------------------------------------------------------
+// Charged to the calling thread's current tag; Free()
+// credits whichever tag that was
+// --------------------------------------------------------
+void* AllocationTracker::Allocate(size_t size)
+{
+	Header* header = (Header*)malloc(sizeof(Header) + size);
+	if (!header)
+		return 0;
+
+	unsigned int tag = currentTag;
+	header->size = size;
+	header->tag = tag;
+
+	TagCounters& c = counters[tag];
+	c.allocations.fetch_add(1, std::memory_order_relaxed);
+	c.bytes.fetch_add(size, std::memory_order_relaxed);
+	c.liveAllocations.fetch_add(1, std::memory_order_relaxed);
+	RaisePeak(c.peakBytes, c.liveBytes.fetch_add(size, std::memory_order_relaxed) + size);
+	return header + 1;
+}
+
+void AllocationTracker::Free(void* memory)
+{
+	if (!memory)
+		return;
+
+	Header* header = (Header*)memory - 1;
+	TagCounters& c = counters[header->tag];
+	c.liveAllocations.fetch_sub(1, std::memory_order_relaxed);
+	c.liveBytes.fetch_sub(header->size, std::memory_order_relaxed);
+	free(header);
+}
+
+void AllocationTracker::AddGpuBytes(unsigned int tag, long long bytes)
+{
+	if (tag >= MaxTags)
+		tag = 0;
+
+	TagCounters& c = counters[tag];
+	RaisePeak(c.gpuPeakBytes, c.gpuBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+}
+
+void AllocationTracker::SetBudget(unsigned int tag, Budget budget)
+{
+	if (tag < MaxTags)
+		budgets[tag] = budget;
+}
+
+AllocationTracker::Budget AllocationTracker::GetBudget(unsigned int tag)
+{
+	return tag < MaxTags ? budgets[tag] : Budget{};
+}
+
+bool AllocationTracker::IsOverBudget(unsigned int tag)
+{
+	return tag < MaxTags && overBudget[tag];
+}
+
+void AllocationTracker::WriteJSON(FILE* file)
+{
+	fprintf(file, "{\n  \"tags\": [");
+	for (unsigned int t = 0; t < GetTagCount(); t++)
+	{
+		TagMemory m = GetMemory(t);
+		fprintf(file, "%s\n    { \"name\": ", t > 0 ? "," : "");
+		WriteJsonString(file, m.name);
+		fprintf(file, ", \"liveBytes\": %llu, \"peakBytes\": %llu, \"liveAllocations\": %llu, \"totalAllocations\": %llu, \"gpuBytes\": %llu, \"gpuPeakBytes\": %llu",
+			m.liveBytes, m.peakBytes, m.liveAllocations, m.totalAllocations, m.gpuBytes, m.gpuPeakBytes);
+		fprintf(file, ", \"cpuBudget\": %llu, \"gpuBudget\": %llu, \"overBudget\": %s }",
+			budgets[t].cpuBytes, budgets[t].gpuBytes, overBudget[t] ? "true" : "false");
+	}
+	fprintf(file, "\n  ]\n}\n");
+}
+
+unsigned int AllocationTracker::Enter(unsigned int tag)
+{
+	unsigned int previous = currentTag;
+	currentTag = tag < MaxTags ? tag : 0;
+	return previous;
+}
+
+void AllocationTracker::Leave(unsigned int previous)
+{
+	currentTag = previous;
+}
+
+
+#if ALLOCATION_TRACKING_ENABLED
+
+// --------------------------------------------------------
+// The replaceable global allocation functions.  The array,
+// nothrow and sized forms all come through here; aligned
+// new keeps the library's version, since nothing in the
+// game is over-aligned.
+// --------------------------------------------------------
+void* operator new(size_t size)
+{
+	void* memory = AllocationTracker::Allocate(size);
+	if (!memory)
+		throw std::bad_alloc();
+	return memory;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return AllocationTracker::Allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return AllocationTracker::Allocate(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+	AllocationTracker::Free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	AllocationTracker::Free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	AllocationTracker::Free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+	AllocationTracker::Free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+	AllocationTracker::Free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+	AllocationTracker::Free(memory);
+}
+
+#endif
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+
+// Global operator new and delete are only replaced when this is 1
+#ifndef ALLOCATION_TRACKING_ENABLED
+#define ALLOCATION_TRACKING_ENABLED 1
+#endif
+
+// --------------------------------------------------------
+// Accounts for heap memory (and estimated GPU memory) per
+// subsystem, and counts allocations per frame
+//
+// - Global operator new and delete are replaced (in
+//   AllocationTracker.cpp), so everything that reaches the
+//   heap through them is seen, on any thread
+// - ALLOCATION_SCOPE("Name") charges whatever this thread
+//   allocates for the rest of the block to that tag; scopes
+//   nest, and anything outside them is "Untagged".  Names
+//   must be string literals (only the pointer is kept).
+// - Each allocation remembers its tag and size in a small
+//   header, so freeing it (on any thread) is credited back
+//   to the tag that made it
+// - Allocators that would go to malloc directly (ImGui's)
+//   use Allocate() and Free() instead
+// - GPU resources are reported by whoever creates them,
+//   as estimated sizes through AddGpuBytes()
+// - Tags can be given budgets, checked once per frame; a
+//   tag going over one is reported on the console
+// - The main thread marks frame boundaries with
+//   BeginFrame(), like the profiler
+// --------------------------------------------------------
+namespace AllocationTracker
+{
+	const unsigned int MaxTags = 32;
+
+	struct Counts
+	{
+		unsigned long long allocations;
+		unsigned long long bytes;
+	};
+
+	// Everything known about one tag right now
+	struct TagMemory
+	{
+		const char* name;
+		unsigned long long liveBytes;
+		unsigned long long peakBytes;
+		unsigned long long liveAllocations;
+		unsigned long long totalAllocations;	// Since the program started
+		unsigned long long gpuBytes;
+		unsigned long long gpuPeakBytes;
+	};
+
+	// 0 for no limit
+	struct Budget
+	{
+		unsigned long long cpuBytes;
+		unsigned long long gpuBytes;
+	};
+
+	// The same index every time for the same name.  Past
+	// MaxTags, everything goes to "Untagged".
+	unsigned int RegisterTag(const char* name);
+	unsigned int GetTagCount();
+	const char* GetTagName(unsigned int tag);
+
+	// Call on the main thread as each frame starts
+	void BeginFrame();
+
+	// The most recently finished frame
+	Counts GetLastFrame(unsigned int tag);
+	Counts GetLastFrameTotal();
+
+	// Since the program started
+	Counts GetTotal(unsigned int tag);
+
+	TagMemory GetMemory(unsigned int tag);
+
+	// Tracked heap memory for anything that can't go through
+	// new and delete
+	void* Allocate(size_t size);
+	void Free(void* memory);
+
+	// Estimated GPU memory: positive when created, negative
+	// when released
+	void AddGpuBytes(unsigned int tag, long long bytes);
+
+	void SetBudget(unsigned int tag, Budget budget);
+	Budget GetBudget(unsigned int tag);
+
+	// As of the last BeginFrame()
+	bool IsOverBudget(unsigned int tag);
+
+	// Every tag's memory, budget and totals
+	void WriteJSON(FILE* file);
+
+	// Used by Scope; Enter() returns the tag to go back to
+	unsigned int Enter(unsigned int tag);
+	void Leave(unsigned int previous);
+
+	// Charges its thread's allocations to a tag while alive
+	class Scope
+	{
+	public:
+		explicit Scope(unsigned int tag) : previous(Enter(tag)) {}
+		~Scope() { Leave(previous); }
+		Scope(const Scope&) = delete; // Remove copy constructor
+		Scope& operator=(const Scope&) = delete; // Remove copy-assignment operator
+
+	private:
+		unsigned int previous;
+	};
+}
+
+#define ALLOCATION_CONCAT_INNER(a, b) a##b
+#define ALLOCATION_CONCAT(a, b) ALLOCATION_CONCAT_INNER(a, b)
+
+#if ALLOCATION_TRACKING_ENABLED
+#define ALLOCATION_SCOPE(name) \
+	static const unsigned int ALLOCATION_CONCAT(allocationTag, __LINE__) = AllocationTracker::RegisterTag(name); \
+	AllocationTracker::Scope ALLOCATION_CONCAT(allocationScope, __LINE__)(ALLOCATION_CONCAT(allocationTag, __LINE__))
+#else
+#define ALLOCATION_SCOPE(name) ((void)0)
+#endif
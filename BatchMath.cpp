@@ -0,0 +1,244 @@
+#include "BatchMath.h"
+#include "BatchMathKernels.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define BATCHMATH_X86 1
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+namespace BatchMath
+{
+	// Annonymous namespace to hold variables
+	// only accessible in this file
+	namespace
+	{
+		// One float at a time - also used for every tail
+		struct LaneScalar
+		{
+			static const size_t Width = 1;
+			float v;
+
+			static LaneScalar Load(const float* p) { return { *p }; }
+			static void Store(float* p, LaneScalar a) { *p = a.v; }
+			static LaneScalar Set1(float f) { return { f }; }
+			static LaneScalar Abs(LaneScalar a) { return { a.v < 0.0f ? -a.v : a.v }; }
+			static LaneScalar MulAdd(LaneScalar a, LaneScalar b, LaneScalar c) { return { a.v * b.v + c.v }; }
+		};
+
+		inline LaneScalar operator+(LaneScalar a, LaneScalar b) { return { a.v + b.v }; }
+		inline LaneScalar operator-(LaneScalar a, LaneScalar b) { return { a.v - b.v }; }
+		inline LaneScalar operator*(LaneScalar a, LaneScalar b) { return { a.v * b.v }; }
+		inline LaneScalar operator/(LaneScalar a, LaneScalar b) { return { a.v / b.v }; }
+
+#if BATCHMATH_X86
+		// Four floats at a time; SSE2 is always there on x64
+		struct LaneSSE
+		{
+			static const size_t Width = 4;
+			__m128 v;
+
+			static LaneSSE Load(const float* p) { return { _mm_loadu_ps(p) }; }
+			static void Store(float* p, LaneSSE a) { _mm_storeu_ps(p, a.v); }
+			static LaneSSE Set1(float f) { return { _mm_set1_ps(f) }; }
+			static LaneSSE Abs(LaneSSE a) { return { _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v) }; }
+			static LaneSSE MulAdd(LaneSSE a, LaneSSE b, LaneSSE c) { return { _mm_add_ps(_mm_mul_ps(a.v, b.v), c.v) }; }
+		};
+
+		inline LaneSSE operator+(LaneSSE a, LaneSSE b) { return { _mm_add_ps(a.v, b.v) }; }
+		inline LaneSSE operator-(LaneSSE a, LaneSSE b) { return { _mm_sub_ps(a.v, b.v) }; }
+		inline LaneSSE operator*(LaneSSE a, LaneSSE b) { return { _mm_mul_ps(a.v, b.v) }; }
+		inline LaneSSE operator/(LaneSSE a, LaneSSE b) { return { _mm_div_ps(a.v, b.v) }; }
+#endif
+
+		// Asks the CPU (once) what the widest usable path is
+		Level DetectBestLevel()
+		{
+#if BATCHMATH_X86
+#if defined(_MSC_VER)
+			int info[4] = {};
+			__cpuid(info, 0);
+			int maxLeaf = info[0];
+
+			__cpuid(info, 1);
+			bool fma = (info[2] & (1 << 12)) != 0;
+			bool osxsave = (info[2] & (1 << 27)) != 0;
+			bool avx = (info[2] & (1 << 28)) != 0;
+
+			// The OS must also save the YMM registers on context switches
+			bool ymmSaved = osxsave && (_xgetbv(0) & 6) == 6;
+
+			bool avx2 = false;
+			if (maxLeaf >= 7)
+			{
+				__cpuidex(info, 7, 0);
+				avx2 = (info[1] & (1 << 5)) != 0;
+			}
+
+			if (avx && avx2 && fma && ymmSaved)
+				return Level::AVX2;
+#else
+			__builtin_cpu_init();
+			if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+				return Level::AVX2;
+#endif
+			return Level::SSE;
+#else
+			return Level::Scalar;
+#endif
+		}
+
+		Level bestLevel = DetectBestLevel();
+		Level currentLevel = bestLevel;
+
+		// How many of count items the current SIMD path takes;
+		// the rest (or everything, when scalar) runs scalar
+		size_t SimdCount(size_t count)
+		{
+			switch (currentLevel)
+			{
+			case Level::AVX2: return count - count % 8;
+			case Level::SSE: return count - count % 4;
+			default: return 0;
+			}
+		}
+	}
+}
+
+
+// --------------------------------------------------------
+// Storage
+// - Each of the 16 element arrays is padded to a multiple
+//   of 8 floats, so every array starts 32-byte aligned
+//   relative to the first
+// --------------------------------------------------------
+BatchMath::MatrixStorage::MatrixStorage(size_t count)
+{
+	Resize(count);
+}
+
+void BatchMath::MatrixStorage::Resize(size_t count)
+{
+	this->count = count;
+	stride = (count + 7) & ~(size_t)7;
+	data.assign(stride * 16, 0.0f);
+}
+
+size_t BatchMath::MatrixStorage::Count() const
+{
+	return count;
+}
+
+BatchMath::MatrixSoA BatchMath::MatrixStorage::View()
+{
+	MatrixSoA view = {};
+	for (int e = 0; e < 16; e++)
+		view.m[e] = data.data() + e * stride;
+	return view;
+}
+
+void BatchMath::MatrixStorage::Set(size_t index, const float* rowMajor16)
+{
+	for (int e = 0; e < 16; e++)
+		data[e * stride + index] = rowMajor16[e];
+}
+
+void BatchMath::MatrixStorage::Get(size_t index, float* rowMajor16) const
+{
+	for (int e = 0; e < 16; e++)
+		rowMajor16[e] = data[e * stride + index];
+}
+
+
+// --------------------------------------------------------
+// Level selection
+// --------------------------------------------------------
+BatchMath::Level BatchMath::GetLevel() { return currentLevel; }
+BatchMath::Level BatchMath::GetBestLevel() { return bestLevel; }
+
+void BatchMath::SetLevel(Level level)
+{
+	currentLevel = (int)level > (int)bestLevel ? bestLevel : level;
+}
+
+const char* BatchMath::LevelName(Level level)
+{
+	switch (level)
+	{
+	case Level::AVX2: return "AVX2";
+	case Level::SSE: return "SSE";
+	default: return "Scalar";
+	}
+}
+
+
+// --------------------------------------------------------
+// Dispatch
+// - The bulk of the batch runs on the current path, and
+//   whatever doesn't fill a full SIMD step runs scalar
+// --------------------------------------------------------
+void BatchMath::Multiply(const MatrixSoA& a, const MatrixSoA& b, const MatrixSoA& out, size_t count)
+{
+	size_t bulk = SimdCount(count);
+
+#if BATCHMATH_X86
+	if (currentLevel == Level::AVX2) AVX2::Multiply(a, b, out, 0, bulk);
+	else if (currentLevel == Level::SSE) Kernels::Multiply<LaneSSE>(a, b, out, 0, bulk);
+#endif
+
+	Kernels::Multiply<LaneScalar>(a, b, out, bulk, count);
+}
+
+void BatchMath::MultiplyShared(const MatrixSoA& a, const float* shared, const MatrixSoA& out, size_t count)
+{
+	size_t bulk = SimdCount(count);
+
+#if BATCHMATH_X86
+	if (currentLevel == Level::AVX2) AVX2::MultiplyShared(a, shared, out, 0, bulk);
+	else if (currentLevel == Level::SSE) Kernels::MultiplyShared<LaneSSE>(a, shared, out, 0, bulk);
+#endif
+
+	Kernels::MultiplyShared<LaneScalar>(a, shared, out, bulk, count);
+}
+
+void BatchMath::AffineInverse(const MatrixSoA& in, const MatrixSoA& out, size_t count)
+{
+	size_t bulk = SimdCount(count);
+
+#if BATCHMATH_X86
+	if (currentLevel == Level::AVX2) AVX2::AffineInverse(in, out, 0, bulk);
+	else if (currentLevel == Level::SSE) Kernels::AffineInverse<LaneSSE>(in, out, 0, bulk);
+#endif
+
+	Kernels::AffineInverse<LaneScalar>(in, out, bulk, count);
+}
+
+void BatchMath::TransformVectors(const MatrixSoA& m, const Vector4SoA& v, const Vector4SoA& out, size_t count)
+{
+	size_t bulk = SimdCount(count);
+
+#if BATCHMATH_X86
+	if (currentLevel == Level::AVX2) AVX2::TransformVectors(m, v, out, 0, bulk);
+	else if (currentLevel == Level::SSE) Kernels::TransformVectors<LaneSSE>(m, v, out, 0, bulk);
+#endif
+
+	Kernels::TransformVectors<LaneScalar>(m, v, out, bulk, count);
+}
+
+void BatchMath::TransformAABBs(
+	const MatrixSoA& m,
+	const Vector3SoA& localMin, const Vector3SoA& localMax,
+	const Vector3SoA& outMin, const Vector3SoA& outMax,
+	size_t count)
+{
+	size_t bulk = SimdCount(count);
+
+#if BATCHMATH_X86
+	if (currentLevel == Level::AVX2) AVX2::TransformAABBs(m, localMin, localMax, outMin, outMax, 0, bulk);
+	else if (currentLevel == Level::SSE) Kernels::TransformAABBs<LaneSSE>(m, localMin, localMax, outMin, outMax, 0, bulk);
+#endif
+
+	Kernels::TransformAABBs<LaneScalar>(m, localMin, localMax, outMin, outMax, bulk, count);
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// --------------------------------------------------------
+// Batched 4x4 matrix math over structure-of-arrays data
+//
+// - DirectXMath works on one XMMATRIX at a time; these
+//   kernels instead process one *element* of many matrices
+//   at a time, so a single SIMD register holds e.g. the _11
+//   of 8 different matrices
+// - The widest path the CPU supports is picked at runtime:
+//   AVX2 + FMA (8 wide), SSE2 (4 wide) or plain scalar
+// - Matrices follow the DirectXMath (row-vector) convention:
+//   v' = v * M and translation lives in the fourth row
+// - No Windows or DirectX headers are used, so this builds
+//   on any platform
+// --------------------------------------------------------
+namespace BatchMath
+{
+	enum class Level
+	{
+		Scalar,
+		SSE,
+		AVX2
+	};
+
+	// Element (row r, column c) of matrix i is m[r * 4 + c][i]
+	struct MatrixSoA
+	{
+		float* m[16];
+	};
+
+	// Component arrays for a batch of vectors
+	struct Vector4SoA
+	{
+		float* x;
+		float* y;
+		float* z;
+		float* w;
+	};
+
+	struct Vector3SoA
+	{
+		float* x;
+		float* y;
+		float* z;
+	};
+
+	// Owns padded, aligned storage for count matrices and
+	// hands out a MatrixSoA view of it
+	class MatrixStorage
+	{
+	public:
+		MatrixStorage() = default;
+		explicit MatrixStorage(size_t count);
+
+		void Resize(size_t count);
+		size_t Count() const;
+		MatrixSoA View();
+
+		// AoS <-> SoA helpers, matrices given as 16 row-major floats
+		void Set(size_t index, const float* rowMajor16);
+		void Get(size_t index, float* rowMajor16) const;
+
+	private:
+		std::vector<float> data;
+		size_t count = 0;
+		size_t stride = 0;
+	};
+
+	// Which path runs, and which paths the CPU allows
+	Level GetLevel();
+	Level GetBestLevel();
+	void SetLevel(Level level); // Clamped to GetBestLevel()
+	const char* LevelName(Level level);
+
+	// out[i] = a[i] * b[i]
+	void Multiply(const MatrixSoA& a, const MatrixSoA& b, const MatrixSoA& out, size_t count);
+
+	// out[i] = a[i] * shared, with shared given as 16 row-major floats
+	void MultiplyShared(const MatrixSoA& a, const float* shared, const MatrixSoA& out, size_t count);
+
+	// Inverse of affine matrices (fourth column must be 0,0,0,1)
+	void AffineInverse(const MatrixSoA& in, const MatrixSoA& out, size_t count);
+
+	// out[i] = v[i] * m[i]
+	void TransformVectors(const MatrixSoA& m, const Vector4SoA& v, const Vector4SoA& out, size_t count);
+
+	// Transforms local AABBs into new axis-aligned world bounds
+	void TransformAABBs(
+		const MatrixSoA& m,
+		const Vector3SoA& localMin, const Vector3SoA& localMax,
+		const Vector3SoA& outMin, const Vector3SoA& outMax,
+		size_t count);
+}
@@ -0,0 +1,84 @@
+// --------------------------------------------------------
+// The 8-wide AVX2 + FMA path of BatchMath
+//
+// - Only ever called after BatchMath has confirmed the CPU
+//   supports AVX2 and FMA
+// - MSVC builds this file with /arch:AVX2 (see the project
+//   file); GCC and Clang get the target from the pragmas
+// --------------------------------------------------------
+
+#include "BatchMath.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2,fma"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#endif
+
+#include "BatchMathKernels.h"
+
+namespace BatchMath
+{
+	namespace
+	{
+		// Eight floats at a time
+		struct LaneAVX2
+		{
+			static const size_t Width = 8;
+			__m256 v;
+
+			static LaneAVX2 Load(const float* p) { return { _mm256_loadu_ps(p) }; }
+			static void Store(float* p, LaneAVX2 a) { _mm256_storeu_ps(p, a.v); }
+			static LaneAVX2 Set1(float f) { return { _mm256_set1_ps(f) }; }
+			static LaneAVX2 Abs(LaneAVX2 a) { return { _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v) }; }
+			static LaneAVX2 MulAdd(LaneAVX2 a, LaneAVX2 b, LaneAVX2 c) { return { _mm256_fmadd_ps(a.v, b.v, c.v) }; }
+		};
+
+		inline LaneAVX2 operator+(LaneAVX2 a, LaneAVX2 b) { return { _mm256_add_ps(a.v, b.v) }; }
+		inline LaneAVX2 operator-(LaneAVX2 a, LaneAVX2 b) { return { _mm256_sub_ps(a.v, b.v) }; }
+		inline LaneAVX2 operator*(LaneAVX2 a, LaneAVX2 b) { return { _mm256_mul_ps(a.v, b.v) }; }
+		inline LaneAVX2 operator/(LaneAVX2 a, LaneAVX2 b) { return { _mm256_div_ps(a.v, b.v) }; }
+	}
+}
+
+void BatchMath::AVX2::Multiply(const MatrixSoA& a, const MatrixSoA& b, const MatrixSoA& out, size_t begin, size_t end)
+{
+	Kernels::Multiply<LaneAVX2>(a, b, out, begin, end);
+}
+
+void BatchMath::AVX2::MultiplyShared(const MatrixSoA& a, const float* shared, const MatrixSoA& out, size_t begin, size_t end)
+{
+	Kernels::MultiplyShared<LaneAVX2>(a, shared, out, begin, end);
+}
+
+void BatchMath::AVX2::AffineInverse(const MatrixSoA& in, const MatrixSoA& out, size_t begin, size_t end)
+{
+	Kernels::AffineInverse<LaneAVX2>(in, out, begin, end);
+}
+
+void BatchMath::AVX2::TransformVectors(const MatrixSoA& m, const Vector4SoA& v, const Vector4SoA& out, size_t begin, size_t end)
+{
+	Kernels::TransformVectors<LaneAVX2>(m, v, out, begin, end);
+}
+
+void BatchMath::AVX2::TransformAABBs(
+	const MatrixSoA& m,
+	const Vector3SoA& localMin, const Vector3SoA& localMax,
+	const Vector3SoA& outMin, const Vector3SoA& outMax,
+	size_t begin, size_t end)
+{
+	Kernels::TransformAABBs<LaneAVX2>(m, localMin, localMax, outMin, outMax, begin, end);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
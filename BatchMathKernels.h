@@ -0,0 +1,203 @@
+#pragma once
+
+// --------------------------------------------------------
+// Width-agnostic kernel bodies shared by every BatchMath
+// path.  Each is written against a "lane" type L that
+// provides Width, Load, Store, Set1, Abs and the usual
+// arithmetic operators, and is instantiated once per path.
+//
+// Only include this from BatchMath*.cpp files.
+// --------------------------------------------------------
+
+#include "BatchMath.h"
+
+namespace BatchMath
+{
+	namespace Kernels
+	{
+		template<typename L>
+		void Multiply(const MatrixSoA& a, const MatrixSoA& b, const MatrixSoA& out, size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i += L::Width)
+			{
+				L bm[16];
+				for (int e = 0; e < 16; e++)
+					bm[e] = L::Load(b.m[e] + i);
+
+				for (int r = 0; r < 4; r++)
+				{
+					L a0 = L::Load(a.m[r * 4 + 0] + i);
+					L a1 = L::Load(a.m[r * 4 + 1] + i);
+					L a2 = L::Load(a.m[r * 4 + 2] + i);
+					L a3 = L::Load(a.m[r * 4 + 3] + i);
+
+					for (int c = 0; c < 4; c++)
+					{
+						L v = a0 * bm[c];
+						v = L::MulAdd(a1, bm[4 + c], v);
+						v = L::MulAdd(a2, bm[8 + c], v);
+						v = L::MulAdd(a3, bm[12 + c], v);
+						L::Store(out.m[r * 4 + c] + i, v);
+					}
+				}
+			}
+		}
+
+		template<typename L>
+		void MultiplyShared(const MatrixSoA& a, const float* shared, const MatrixSoA& out, size_t begin, size_t end)
+		{
+			// The shared matrix is broadcast once for the whole batch
+			L bm[16];
+			for (int e = 0; e < 16; e++)
+				bm[e] = L::Set1(shared[e]);
+
+			for (size_t i = begin; i < end; i += L::Width)
+			{
+				for (int r = 0; r < 4; r++)
+				{
+					L a0 = L::Load(a.m[r * 4 + 0] + i);
+					L a1 = L::Load(a.m[r * 4 + 1] + i);
+					L a2 = L::Load(a.m[r * 4 + 2] + i);
+					L a3 = L::Load(a.m[r * 4 + 3] + i);
+
+					for (int c = 0; c < 4; c++)
+					{
+						L v = a0 * bm[c];
+						v = L::MulAdd(a1, bm[4 + c], v);
+						v = L::MulAdd(a2, bm[8 + c], v);
+						v = L::MulAdd(a3, bm[12 + c], v);
+						L::Store(out.m[r * 4 + c] + i, v);
+					}
+				}
+			}
+		}
+
+		// Affine inverse: the upper 3x3 is inverted with the
+		// adjugate / determinant, and the new translation is
+		// -t * inverse(A)
+		template<typename L>
+		void AffineInverse(const MatrixSoA& in, const MatrixSoA& out, size_t begin, size_t end)
+		{
+			L zero = L::Set1(0.0f);
+			L one = L::Set1(1.0f);
+
+			for (size_t i = begin; i < end; i += L::Width)
+			{
+				L m00 = L::Load(in.m[0] + i), m01 = L::Load(in.m[1] + i), m02 = L::Load(in.m[2] + i);
+				L m10 = L::Load(in.m[4] + i), m11 = L::Load(in.m[5] + i), m12 = L::Load(in.m[6] + i);
+				L m20 = L::Load(in.m[8] + i), m21 = L::Load(in.m[9] + i), m22 = L::Load(in.m[10] + i);
+				L tx = L::Load(in.m[12] + i), ty = L::Load(in.m[13] + i), tz = L::Load(in.m[14] + i);
+
+				// Cofactors of the first row
+				L c00 = m11 * m22 - m12 * m21;
+				L c01 = m12 * m20 - m10 * m22;
+				L c02 = m10 * m21 - m11 * m20;
+
+				L invDet = one / (m00 * c00 + m01 * c01 + m02 * c02);
+
+				// Inverse = transpose of the cofactor matrix / det
+				L i00 = c00 * invDet;
+				L i01 = (m02 * m21 - m01 * m22) * invDet;
+				L i02 = (m01 * m12 - m02 * m11) * invDet;
+				L i10 = c01 * invDet;
+				L i11 = (m00 * m22 - m02 * m20) * invDet;
+				L i12 = (m02 * m10 - m00 * m12) * invDet;
+				L i20 = c02 * invDet;
+				L i21 = (m01 * m20 - m00 * m21) * invDet;
+				L i22 = (m00 * m11 - m01 * m10) * invDet;
+
+				L::Store(out.m[0] + i, i00); L::Store(out.m[1] + i, i01); L::Store(out.m[2] + i, i02); L::Store(out.m[3] + i, zero);
+				L::Store(out.m[4] + i, i10); L::Store(out.m[5] + i, i11); L::Store(out.m[6] + i, i12); L::Store(out.m[7] + i, zero);
+				L::Store(out.m[8] + i, i20); L::Store(out.m[9] + i, i21); L::Store(out.m[10] + i, i22); L::Store(out.m[11] + i, zero);
+
+				L::Store(out.m[12] + i, zero - (tx * i00 + ty * i10 + tz * i20));
+				L::Store(out.m[13] + i, zero - (tx * i01 + ty * i11 + tz * i21));
+				L::Store(out.m[14] + i, zero - (tx * i02 + ty * i12 + tz * i22));
+				L::Store(out.m[15] + i, one);
+			}
+		}
+
+		template<typename L>
+		void TransformVectors(const MatrixSoA& m, const Vector4SoA& v, const Vector4SoA& out, size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i += L::Width)
+			{
+				L x = L::Load(v.x + i);
+				L y = L::Load(v.y + i);
+				L z = L::Load(v.z + i);
+				L w = L::Load(v.w + i);
+
+				float* dst[4] = { out.x, out.y, out.z, out.w };
+				for (int c = 0; c < 4; c++)
+				{
+					L r = x * L::Load(m.m[c] + i);
+					r = L::MulAdd(y, L::Load(m.m[4 + c] + i), r);
+					r = L::MulAdd(z, L::Load(m.m[8 + c] + i), r);
+					r = L::MulAdd(w, L::Load(m.m[12 + c] + i), r);
+					L::Store(dst[c] + i, r);
+				}
+			}
+		}
+
+		// Arvo's method: transform the center, and grow the
+		// extents by the absolute value of the 3x3 part
+		template<typename L>
+		void TransformAABBs(
+			const MatrixSoA& m,
+			const Vector3SoA& localMin, const Vector3SoA& localMax,
+			const Vector3SoA& outMin, const Vector3SoA& outMax,
+			size_t begin, size_t end)
+		{
+			L half = L::Set1(0.5f);
+
+			for (size_t i = begin; i < end; i += L::Width)
+			{
+				L minX = L::Load(localMin.x + i), minY = L::Load(localMin.y + i), minZ = L::Load(localMin.z + i);
+				L maxX = L::Load(localMax.x + i), maxY = L::Load(localMax.y + i), maxZ = L::Load(localMax.z + i);
+
+				L cx = (minX + maxX) * half, cy = (minY + maxY) * half, cz = (minZ + maxZ) * half;
+				L ex = (maxX - minX) * half, ey = (maxY - minY) * half, ez = (maxZ - minZ) * half;
+
+				float* dstMin[3] = { outMin.x, outMin.y, outMin.z };
+				float* dstMax[3] = { outMax.x, outMax.y, outMax.z };
+				for (int c = 0; c < 3; c++)
+				{
+					L r0 = L::Load(m.m[c] + i);
+					L r1 = L::Load(m.m[4 + c] + i);
+					L r2 = L::Load(m.m[8 + c] + i);
+
+					L center = L::Load(m.m[12 + c] + i);
+					center = L::MulAdd(cx, r0, center);
+					center = L::MulAdd(cy, r1, center);
+					center = L::MulAdd(cz, r2, center);
+
+					L extent = ex * L::Abs(r0);
+					extent = L::MulAdd(ey, L::Abs(r1), extent);
+					extent = L::MulAdd(ez, L::Abs(r2), extent);
+
+					L::Store(dstMin[c] + i, center - extent);
+					L::Store(dstMax[c] + i, center + extent);
+				}
+			}
+		}
+	}
+}
+
+namespace BatchMath
+{
+	// Entry points of the AVX2 path, which lives in its own
+	// file so it can be compiled with AVX2 code generation.
+	// [begin, end) must be a multiple of 8 long.
+	namespace AVX2
+	{
+		void Multiply(const MatrixSoA& a, const MatrixSoA& b, const MatrixSoA& out, size_t begin, size_t end);
+		void MultiplyShared(const MatrixSoA& a, const float* shared, const MatrixSoA& out, size_t begin, size_t end);
+		void AffineInverse(const MatrixSoA& in, const MatrixSoA& out, size_t begin, size_t end);
+		void TransformVectors(const MatrixSoA& m, const Vector4SoA& v, const Vector4SoA& out, size_t begin, size_t end);
+		void TransformAABBs(
+			const MatrixSoA& m,
+			const Vector3SoA& localMin, const Vector3SoA& localMax,
+			const Vector3SoA& outMin, const Vector3SoA& outMax,
+			size_t begin, size_t end);
+	}
+}
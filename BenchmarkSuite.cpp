@@ -0,0 +1,182 @@
+#include "BenchmarkSuite.h"
+#include "CrtCompat.h"
+
+#include <thread>
+#include <string>
+#include <cstring>
+
+namespace BenchmarkSuite
+{
+	// Annonymous namespace to hold helpers
+	// only accessible in this file
+	namespace
+	{
+		SyntheticScene::Spec MakeScene(const char* name, unsigned int entityCount, unsigned int meshCount, float dynamicRatio, SyntheticScene::Distribution distribution)
+		{
+			SyntheticScene::Spec spec;
+			spec.name = name;
+			spec.entityCount = entityCount;
+			spec.meshCount = meshCount;
+			spec.dynamicRatio = dynamicRatio;
+			spec.distribution = distribution;
+			return spec;
+		}
+
+		void WriteJsonString(FILE* file, const char* text)
+		{
+			fputc('"', file);
+			for (const char* c = text; *c; c++)
+			{
+				if (*c == '"' || *c == '\\')
+					fprintf(file, "\\%c", *c);
+				else if ((unsigned char)*c < 0x20)
+					fprintf(file, "\\u%04x", (unsigned int)(unsigned char)*c);
+				else
+					fputc(*c, file);
+			}
+			fputc('"', file);
+		}
+	}
+}
+
+void BenchmarkSuite::GetDefaultScenes(std::vector<SyntheticScene::Spec>& outScenes)
+{
+	using SyntheticScene::Distribution;
+
+	outScenes.clear();
+	outScenes.push_back(MakeScene("uniform-static-10k", 10000, 8, 0.0f, Distribution::Uniform));
+	outScenes.push_back(MakeScene("uniform-dynamic-10k", 10000, 8, 1.0f, Distribution::Uniform));
+	outScenes.push_back(MakeScene("clustered-static-10k", 10000, 8, 0.0f, Distribution::Clustered));
+	outScenes.push_back(MakeScene("uniform-mixed-100k", 100000, 16, 0.1f, Distribution::Uniform));
+	outScenes.push_back(MakeScene("clustered-mixed-100k", 100000, 16, 0.1f, Distribution::Clustered));
+}
+
+void BenchmarkSuite::Run(const std::vector<SyntheticScene::Spec>& scenes, const Headless::Options& options, std::vector<Entry>& outEntries)
+{
+	outEntries.clear();
+	for (const SyntheticScene::Spec& spec : scenes)
+	{
+		Headless::Options sceneOptions = options;
+		sceneOptions.scene = &spec;
+
+		outEntries.push_back(Entry());
+		outEntries.back().scene = spec;
+		Headless::Run(sceneOptions, outEntries.back().report);
+	}
+}
+
+// --------------------------------------------------------
+// One object per scene: what it was, then the numbers.
+// Build date and core count go at the top, since both
+// change what the numbers mean.
+// --------------------------------------------------------
+void BenchmarkSuite::WriteJSON(const std::vector<Entry>& entries, FILE* file)
+{
+	fprintf(file, "{\n");
+	fprintf(file, "  \"build\": \"%s %s\",\n", __DATE__, __TIME__);
+	fprintf(file, "  \"hardwareThreads\": %u,\n", std::thread::hardware_concurrency());
+	fprintf(file, "  \"scenes\": [");
+
+	for (size_t e = 0; e < entries.size(); e++)
+	{
+		const SyntheticScene::Spec& s = entries[e].scene;
+		const Headless::Report& r = entries[e].report;
+		const GameCore::HeadlessCounts& c = r.counts;
+		double frames = r.frames > 0 ? (double)r.frames : 1.0;
+		double rendered = c.frames > 0 ? (double)c.frames : 1.0;
+
+		fprintf(file, "%s\n    {\n", e > 0 ? "," : "");
+		fprintf(file, "      \"name\": ");
+		WriteJsonString(file, s.name.c_str());
+		fprintf(file, ",\n");
+		fprintf(file, "      \"entities\": %u, \"meshes\": %u, \"dynamicRatio\": %.3f, \"distribution\": \"%s\", \"clusters\": %u, \"extent\": %.1f, \"seed\": %u,\n",
+			s.entityCount, s.meshCount, s.dynamicRatio, SyntheticScene::GetDistributionName(s.distribution), s.clusterCount, s.extent, s.seed);
+		fprintf(file, "      \"frames\": %u, \"width\": %u, \"height\": %u, \"totalMs\": %.3f,\n", r.frames, r.width, r.height, r.totalMs);
+		fprintf(file, "      \"frameMs\": { \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f },\n",
+			r.frameP50Ms, r.frameP95Ms, r.frameP99Ms, r.frameMaxMs);
+		fprintf(file, "      \"perFrame\": { \"visible\": %.2f, \"culled\": %.2f, \"draws\": %.2f, \"geometryBinds\": %.2f, \"instanceRanges\": %.2f, \"instanceBytes\": %.1f, \"worldViewProjBytes\": %.1f },\n",
+			c.visibleEntities / frames, c.culledEntities / frames, c.draws / rendered, c.geometryBinds / rendered,
+			c.instanceRanges / rendered, c.instanceBytes / rendered, c.worldViewProjBytes / rendered);
+
+		fprintf(file, "      \"overdraw\": { \"frontToBack\": %s, \"depthPrepass\": %s, \"shadedPixels\": %.1f, \"coveredPixels\": %.1f, \"prepassPixels\": %.1f, \"ratio\": %.4f },\n",
+			r.frontToBack ? "true" : "false", r.depthPrepass ? "true" : "false", c.shadedPixels / rendered, c.coveredPixels / rendered,
+			c.prepassPixels / rendered, c.coveredPixels > 0 ? (double)c.shadedPixels / c.coveredPixels : 0.0);
+
+		const RenderGraph::Stats& g = r.renderGraph;
+		fprintf(file, "      \"renderGraph\": { \"passes\": %u, \"culledPasses\": %u, \"transientTextures\": %u, \"physicalTextures\": %u, \"transientBytes\": %zu, \"allocatedBytes\": %zu, \"peakLiveBytes\": %zu },\n",
+			g.passes, g.culledPasses, g.transientTextures, g.physicalTextures, g.transientBytes, g.allocatedBytes, g.peakLiveBytes);
+
+		const LightGrid::Stats& l = r.lights;
+		fprintf(file, "      \"lights\": { \"lights\": %u, \"clusters\": %u, \"occupiedClusters\": %u, \"indices\": %u, \"maxPerCluster\": %u, \"sphereTests\": %llu, \"uploadBytes\": %.1f },\n",
+			l.lights, l.clusters, l.occupiedClusters, l.indices, l.maxPerCluster, l.sphereTests, c.lightBytes / rendered);
+
+		const GameCore::ViewCosts& v = r.views;
+		double viewFrames = v.frames > 0 ? (double)v.frames : 1.0;
+		fprintf(file, "      \"views\": { \"layout\": \"%s\", \"count\": %u, \"cullMs\": %.4f, \"candidates\": %.1f, \"perView\": [",
+			GameCore::GetViewLayoutName(r.viewLayout), v.viewCount, v.cullMs / viewFrames, v.candidates / viewFrames);
+		for (unsigned int i = 0; i < v.viewCount; i++)
+		{
+			fprintf(file, "%s { \"visible\": %.1f, \"filterMs\": %.4f, \"recordMs\": %.4f }", i > 0 ? "," : "",
+				v.visible[i] / viewFrames, v.filterMs[i] / viewFrames, v.recordMs[i] / viewFrames);
+		}
+		fprintf(file, " ] },\n");
+
+		double steadyFrames = r.steadyFrames > 0 ? (double)r.steadyFrames : 1.0;
+		fprintf(file, "      \"steadyAllocations\": { \"frames\": %u, \"total\": %llu, \"perFrame\": %.3f },\n",
+			r.steadyFrames, r.steadyAllocations, r.steadyAllocations / steadyFrames);
+
+		fprintf(file, "      \"phases\": [");
+		for (size_t p = 0; p < r.phases.size(); p++)
+		{
+			const Headless::Phase& phase = r.phases[p];
+			fprintf(file, "%s\n        { \"thread\": ", p > 0 ? "," : "");
+			WriteJsonString(file, phase.thread.c_str());
+			fprintf(file, ", \"name\": ");
+			WriteJsonString(file, phase.name.c_str());
+			fprintf(file, ", \"callsPerFrame\": %.3f, \"msPerFrame\": %.4f, \"maxMs\": %.4f }", phase.calls / frames, phase.totalMs / frames, phase.maxMs);
+		}
+		fprintf(file, "\n      ]\n    }");
+	}
+
+	fprintf(file, "\n  ]\n}\n");
+}
+
+int BenchmarkSuite::RunCommandLine(const char* commandLine)
+{
+	Headless::Options options;
+	Headless::ParseOptions(commandLine, options);
+
+	std::vector<SyntheticScene::Spec> scenes;
+	GetDefaultScenes(scenes);
+
+	const char* only = strstr(commandLine, "-scene ");
+	if (only)
+	{
+		only += strlen("-scene ");
+		std::string name(only, strcspn(only, " "));
+
+		std::vector<SyntheticScene::Spec> matching;
+		for (const SyntheticScene::Spec& s : scenes)
+		{
+			if (s.name == name)
+				matching.push_back(s);
+		}
+		scenes = matching;
+	}
+
+	std::vector<Entry> entries;
+	Run(scenes, options, entries);
+	for (const Entry& entry : entries)
+	{
+		printf("\n== %s ==\n", entry.scene.name.c_str());
+		Headless::Print(entry.report, stdout);
+	}
+
+	FILE* file = 0;
+	if (fopen_s(&file, "BenchmarkSuite.json", "w") == 0 && file)
+	{
+		WriteJSON(entries, file);
+		fclose(file);
+	}
+	return 0;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+#include <cstdio>
+
+#include "Headless.h"
+#include "SyntheticScene.h"
+
+// --------------------------------------------------------
+// Headless runs over a set of synthetic scenes, written out
+// as JSON so results can be compared between builds
+//
+// - Each scene gets a fresh game, flown around its camera
+//   path for the same number of frames
+// - Per-phase CPU times, draw calls and culling counts are
+//   all per frame, averaged over the run
+// --------------------------------------------------------
+namespace BenchmarkSuite
+{
+	// Small to large, static to dynamic, even to clustered
+	void GetDefaultScenes(std::vector<SyntheticScene::Spec>& outScenes);
+
+	struct Entry
+	{
+		SyntheticScene::Spec scene;
+		Headless::Report report;
+	};
+
+	// options.scene is ignored; every scene is run in turn
+	void Run(const std::vector<SyntheticScene::Spec>& scenes, const Headless::Options& options, std::vector<Entry>& outEntries);
+
+	void WriteJSON(const std::vector<Entry>& entries, FILE* file);
+
+	// Every default scene (or just "-scene name"), with the
+	// rest of the arguments as for Headless::ParseOptions(),
+	// printed to the console and to BenchmarkSuite.json.
+	// Returns the process's exit code.
+	int RunCommandLine(const char* commandLine);
+}
@@ -0,0 +1,779 @@
+#include "Benchmarks.h"
+#include "MatrixBatch.h"
+#include "BatchMath.h"
+#include "Scene.h"
+#include "Systems.h"
+#include "JobSystem.h"
+#include "RecordingCommandBackend.h"
+#include "Profiler.h"
+#include "SoftwareRasterizer.h"
+#include "LightGrid.h"
+#include "Vertex.h"
+
+#include <DirectXMath.h>
+#include <chrono>
+#include <memory>
+#include <algorithm>
+#include <thread>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace Benchmarks
+{
+	// Annonymous namespace to hold helpers
+	// only accessible in this file
+	namespace
+	{
+		// How many times each kernel runs; the best time is kept
+		const int runCount = 5;
+
+		// Tiny deterministic random number generator so every
+		// run of a benchmark sees exactly the same data
+		unsigned int rngState = 1;
+		float RandomFloat(float minValue, float maxValue)
+		{
+			rngState = rngState * 1664525u + 1013904223u;
+			return minValue + (rngState >> 8) * (1.0f / 16777216.0f) * (maxValue - minValue);
+		}
+
+		void RandomWorldMatrices(std::vector<XMFLOAT4X4>& matrices)
+		{
+			rngState = 1;
+			for (XMFLOAT4X4& m : matrices)
+			{
+				XMMATRIX world =
+					XMMatrixScaling(RandomFloat(0.5f, 2.0f), RandomFloat(0.5f, 2.0f), RandomFloat(0.5f, 2.0f)) *
+					XMMatrixRotationRollPitchYaw(RandomFloat(-XM_PI, XM_PI), RandomFloat(-XM_PI, XM_PI), RandomFloat(-XM_PI, XM_PI)) *
+					XMMatrixTranslation(RandomFloat(-100, 100), RandomFloat(-100, 100), RandomFloat(-100, 100));
+				XMStoreFloat4x4(&m, world);
+			}
+		}
+
+		void RandomWorldMatrices(BatchMath::MatrixStorage& matrices)
+		{
+			std::vector<XMFLOAT4X4> aos(matrices.Count());
+			RandomWorldMatrices(aos);
+			for (size_t i = 0; i < aos.size(); i++)
+				matrices.Set(i, &aos[i]._11);
+		}
+
+		// Deterministic Fisher-Yates shuffle
+		template<typename T>
+		void Shuffle(std::vector<T>& items)
+		{
+			rngState = 7;
+			for (size_t i = items.size(); i > 1; i--)
+			{
+				rngState = rngState * 1664525u + 1013904223u;
+				std::swap(items[i - 1], items[(rngState >> 8) % i]);
+			}
+		}
+
+		// Stand-in for the Entity class the scene replaced: one
+		// heap object per entity, reached through a shared_ptr,
+		// whose mesh getter hands out a shared_ptr copy
+		struct LegacyEntity
+		{
+			Transform transform;
+			std::shared_ptr<int> mesh;
+			XMFLOAT4 tint;
+
+			std::shared_ptr<int> GetMesh() { return mesh; }
+		};
+
+		// Something handle-sized to look up
+		struct HandleTarget
+		{
+			XMFLOAT4X4 world;
+			float value;
+		};
+
+		// Keeps the compiler from throwing the loops away
+		volatile float sink = 0.0f;
+
+		double NowMilliseconds()
+		{
+			using namespace std::chrono;
+			return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+		}
+
+		// Runs the kernel several times and records the best
+		template<typename Kernel>
+		Result Measure(const std::string& name, unsigned int items, Kernel kernel)
+		{
+			double best = 1e30;
+			for (int run = 0; run < runCount; run++)
+			{
+				double start = NowMilliseconds();
+				kernel();
+				double elapsed = NowMilliseconds() - start;
+				if (elapsed < best) best = elapsed;
+			}
+
+			Result result = {};
+			result.name = name;
+			result.items = items;
+			result.milliseconds = best;
+			result.itemsPerSecond = best > 0.0 ? items / (best / 1000.0) : 0.0;
+			return result;
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Compares computing WVP for many objects one at a time
+// (view * projection rebuilt per object, as the vertex
+// shader used to do per vertex) against the batched pass
+// --------------------------------------------------------
+void Benchmarks::WorldViewProj(unsigned int objectCount, std::vector<Result>& outResults)
+{
+	std::vector<XMFLOAT4X4> worlds(objectCount);
+	std::vector<XMFLOAT4X4> wvps(objectCount);
+	RandomWorldMatrices(worlds);
+
+	XMFLOAT4X4 view;
+	XMFLOAT4X4 proj;
+	XMStoreFloat4x4(&view, XMMatrixLookToLH(XMVectorSet(0, 0, -5, 0), XMVectorSet(0, 0, 1, 0), XMVectorSet(0, 1, 0, 0)));
+	XMStoreFloat4x4(&proj, XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.01f, 1000.0f));
+
+	outResults.push_back(Measure("WVP per object", objectCount, [&]()
+		{
+			XMMATRIX v = XMLoadFloat4x4(&view);
+			XMMATRIX p = XMLoadFloat4x4(&proj);
+			for (unsigned int i = 0; i < objectCount; i++)
+				XMStoreFloat4x4(&wvps[i], XMLoadFloat4x4(&worlds[i]) * v * p);
+		}));
+
+	outResults.push_back(Measure("WVP batched", objectCount, [&]()
+		{
+			XMFLOAT4X4 viewProj;
+			XMStoreFloat4x4(&viewProj, XMLoadFloat4x4(&view) * XMLoadFloat4x4(&proj));
+			MatrixBatch::MultiplyByMatrix(worlds.data(), sizeof(XMFLOAT4X4), objectCount, viewProj, wvps.data());
+		}));
+}
+
+
+// --------------------------------------------------------
+// Throughput of each BatchMath kernel, once per path
+// (scalar, SSE, AVX2) that this CPU can run
+// --------------------------------------------------------
+void Benchmarks::BatchMathKernels(unsigned int itemCount, std::vector<Result>& outResults)
+{
+	using namespace BatchMath;
+
+	MatrixStorage a(itemCount);
+	MatrixStorage b(itemCount);
+	MatrixStorage out(itemCount);
+	RandomWorldMatrices(a);
+	RandomWorldMatrices(b);
+
+	// Plain component arrays for vectors and bounds
+	std::vector<float> components(itemCount * 20, 1.0f);
+	float* c = components.data();
+	Vector4SoA vectors = { c, c + itemCount, c + itemCount * 2, c + itemCount * 3 };
+	Vector4SoA vectorsOut = { c + itemCount * 4, c + itemCount * 5, c + itemCount * 6, c + itemCount * 7 };
+	Vector3SoA boundsMin = { c + itemCount * 8, c + itemCount * 9, c + itemCount * 10 };
+	Vector3SoA boundsMax = { c + itemCount * 11, c + itemCount * 12, c + itemCount * 13 };
+	Vector3SoA boundsOutMin = { c + itemCount * 14, c + itemCount * 15, c + itemCount * 16 };
+	Vector3SoA boundsOutMax = { c + itemCount * 17, c + itemCount * 18, c + itemCount * 19 };
+
+	// One name per path and kernel
+	static const char* names[3][5] =
+	{
+		{ "Scalar multiply", "Scalar multiply shared", "Scalar affine inverse", "Scalar transform vectors", "Scalar transform AABBs" },
+		{ "SSE multiply", "SSE multiply shared", "SSE affine inverse", "SSE transform vectors", "SSE transform AABBs" },
+		{ "AVX2 multiply", "AVX2 multiply shared", "AVX2 affine inverse", "AVX2 transform vectors", "AVX2 transform AABBs" },
+	};
+
+	// The same matrix on the right of every product, as with
+	// a view-projection
+	XMFLOAT4X4 shared;
+	XMStoreFloat4x4(&shared, XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 1000.0f));
+
+	Level previous = GetLevel();
+	for (int level = 0; level <= (int)GetBestLevel(); level++)
+	{
+		SetLevel((Level)level);
+		MatrixSoA av = a.View();
+		MatrixSoA bv = b.View();
+		MatrixSoA ov = out.View();
+
+		outResults.push_back(Measure(names[level][0], itemCount, [&]() { Multiply(av, bv, ov, itemCount); }));
+		outResults.push_back(Measure(names[level][1], itemCount, [&]() { MultiplyShared(av, &shared._11, ov, itemCount); }));
+		outResults.push_back(Measure(names[level][2], itemCount, [&]() { AffineInverse(av, ov, itemCount); }));
+		outResults.push_back(Measure(names[level][3], itemCount, [&]() { TransformVectors(av, vectors, vectorsOut, itemCount); }));
+		outResults.push_back(Measure(names[level][4], itemCount, [&]() { TransformAABBs(av, boundsMin, boundsMax, boundsOutMin, boundsOutMax, itemCount); }));
+	}
+	SetLevel(previous);
+}
+
+
+// --------------------------------------------------------
+// The same per-entity read (world translation, tint and
+// mesh) over both layouts.  The legacy list is measured in
+// creation order and shuffled, as a scene that has spawned
+// and destroyed things for a while would be.
+// --------------------------------------------------------
+void Benchmarks::EntityIteration(unsigned int entityCount, std::vector<Result>& outResults)
+{
+	rngState = 1;
+	std::vector<XMFLOAT3> positions(entityCount);
+	for (XMFLOAT3& p : positions)
+		p = XMFLOAT3(RandomFloat(-100, 100), RandomFloat(-100, 100), RandomFloat(-100, 100));
+
+	// Old layout
+	{
+		std::shared_ptr<int> mesh = std::make_shared<int>(0);
+		std::vector<std::shared_ptr<LegacyEntity>> legacy;
+		legacy.reserve(entityCount);
+		for (unsigned int i = 0; i < entityCount; i++)
+		{
+			legacy.push_back(std::make_shared<LegacyEntity>());
+			legacy.back()->transform.SetPosition(positions[i]);
+			legacy.back()->mesh = mesh;
+			legacy.back()->tint = XMFLOAT4(1, 1, 1, 1);
+		}
+
+		auto walk = [&]()
+		{
+			float sum = 0.0f;
+			for (auto& e : legacy)
+			{
+				std::shared_ptr<int> m = e->GetMesh();
+				XMFLOAT4X4 world = e->transform.GetWorldMatrix();
+				sum += world._41 + world._42 + world._43 + e->tint.x + (float)*m;
+			}
+			sink = sum;
+		};
+
+		outResults.push_back(Measure("shared_ptr<Entity> iterate", entityCount, walk));
+		Shuffle(legacy);
+		outResults.push_back(Measure("shared_ptr<Entity> iterate (shuffled)", entityCount, walk));
+	}
+
+	// Archetype scene
+	{
+		SlotMap<int, Mesh> meshStandIns;
+		MeshHandle mesh = meshStandIns.Emplace(0);
+		Scene scene;
+		scene.Reserve(ComponentTransform | ComponentMesh | ComponentTint, entityCount);
+		for (unsigned int i = 0; i < entityCount; i++)
+		{
+			EntityId id = scene.CreateEntity(ComponentTransform | ComponentMesh | ComponentTint);
+			scene.GetTransform(id)->SetPosition(positions[i]);
+			scene.SetMesh(id, mesh);
+			*scene.GetTint(id) = XMFLOAT4(1, 1, 1, 1);
+		}
+
+		outResults.push_back(Measure("Scene iterate", entityCount, [&]()
+			{
+				float sum = 0.0f;
+				scene.ForEach(ComponentTransform | ComponentMesh | ComponentTint, [&](Archetype& a)
+				{
+					for (size_t i = 0; i < a.Count(); i++)
+					{
+						XMFLOAT4X4 world = a.transforms[i].GetWorldMatrix();
+						sum += world._41 + world._42 + world._43 + a.tints[i].x + (float)meshStandIns[a.meshes[i]];
+					}
+				});
+				sink = sum;
+			}));
+	}
+
+	// Structural changes: fill a scene, then empty it in random order
+	{
+		std::vector<EntityId> ids(entityCount);
+		Scene scene;
+
+		outResults.push_back(Measure("Scene create + destroy", entityCount, [&]()
+			{
+				for (unsigned int i = 0; i < entityCount; i++)
+					ids[i] = scene.CreateEntity(ComponentTransform | ComponentMesh | ComponentTint);
+				Shuffle(ids);
+				for (unsigned int i = 0; i < entityCount; i++)
+					scene.DestroyEntity(ids[i]);
+			}));
+	}
+}
+
+
+// --------------------------------------------------------
+// Reaching objects through shared_ptr (copied, as the old
+// by-value parameters did, and just dereferenced) versus
+// generational handles.  Both are visited in a shuffled
+// order, like entities referring to shared meshes.
+// --------------------------------------------------------
+void Benchmarks::HandleAccess(unsigned int objectCount, std::vector<Result>& outResults)
+{
+	// shared_ptr
+	{
+		std::vector<std::shared_ptr<HandleTarget>> pointers;
+		pointers.reserve(objectCount);
+		for (unsigned int i = 0; i < objectCount; i++)
+		{
+			pointers.push_back(std::make_shared<HandleTarget>());
+			pointers.back()->value = (float)i;
+		}
+		Shuffle(pointers);
+
+		outResults.push_back(Measure("shared_ptr copy + access", objectCount, [&]()
+			{
+				float sum = 0.0f;
+				for (auto& p : pointers)
+				{
+					std::shared_ptr<HandleTarget> copy = p;
+					sum += copy->value;
+				}
+				sink = sum;
+			}));
+
+		outResults.push_back(Measure("shared_ptr access", objectCount, [&]()
+			{
+				float sum = 0.0f;
+				for (auto& p : pointers)
+					sum += p->value;
+				sink = sum;
+			}));
+	}
+
+	// Slot map
+	{
+		SlotMap<HandleTarget> map;
+		map.Reserve(objectCount);
+		std::vector<SlotMap<HandleTarget>::HandleType> handles;
+		handles.reserve(objectCount);
+		for (unsigned int i = 0; i < objectCount; i++)
+		{
+			HandleTarget target = {};
+			target.value = (float)i;
+			handles.push_back(map.Emplace(target));
+		}
+		Shuffle(handles);
+
+		outResults.push_back(Measure("SlotMap handle Get()", objectCount, [&]()
+			{
+				float sum = 0.0f;
+				for (auto h : handles)
+				{
+					HandleTarget* t = map.Get(h);
+					if (t) sum += t->value;
+				}
+				sink = sum;
+			}));
+
+		outResults.push_back(Measure("SlotMap handle []", objectCount, [&]()
+			{
+				float sum = 0.0f;
+				for (auto h : handles)
+					sum += map[h].value;
+				sink = sum;
+			}));
+
+		outResults.push_back(Measure("SlotMap dense iterate", objectCount, [&]()
+			{
+				float sum = 0.0f;
+				for (HandleTarget& t : map)
+					sum += t.value;
+				sink = sum;
+			}));
+
+		// Removing and re-adding everything exercises the
+		// free list and generation bumps
+		outResults.push_back(Measure("SlotMap remove + emplace", objectCount, [&]()
+			{
+				for (unsigned int i = 0; i < objectCount; i++)
+					map.Remove(handles[i]);
+				for (unsigned int i = 0; i < objectCount; i++)
+					handles[i] = map.Emplace(HandleTarget());
+			}));
+	}
+}
+
+
+// --------------------------------------------------------
+// Runs the per-frame scene systems on a synthetic scene
+// with 1, 2, 4, ... up to every hardware thread.  The job
+// system is restarted for each count and put back as it
+// was at the end.
+// --------------------------------------------------------
+void Benchmarks::JobScaling(unsigned int entityCount, std::vector<Result>& outResults)
+{
+	// Scattered spinning unit boxes
+	Scene scene;
+	scene.Reserve(ComponentRenderable, entityCount);
+	rngState = 1;
+	for (unsigned int i = 0; i < entityCount; i++)
+	{
+		EntityId id = scene.CreateEntity(ComponentRenderable);
+		scene.GetTransform(id)->SetPosition(RandomFloat(-100, 100), RandomFloat(-100, 100), RandomFloat(-100, 100));
+		*scene.GetLocalBounds(id) = { XMFLOAT3(-0.5f, -0.5f, -0.5f), XMFLOAT3(0.5f, 0.5f, 0.5f) };
+		*scene.GetFlags(id) = EntityVisible | EntitySpin;
+		*scene.GetInstanceSlot(id) = i;
+	}
+
+	// A camera in the middle looking down +Z, so roughly
+	// a fifth of the boxes survive culling
+	XMFLOAT4X4 view;
+	XMFLOAT4X4 viewProj;
+	XMStoreFloat4x4(&view, XMMatrixLookToLH(XMVectorSet(0, 0, 0, 0), XMVectorSet(0, 0, 1, 0), XMVectorSet(0, 1, 0, 0)));
+	XMStoreFloat4x4(&viewProj, XMLoadFloat4x4(&view) * XMMatrixPerspectiveFovLH(XM_PIDIV2, 16.0f / 9.0f, 0.1f, 1000.0f));
+	Frustum frustum;
+	frustum.Build(viewProj);
+
+	std::vector<Systems::DrawPacket> packets;
+	packets.reserve(entityCount);
+
+	unsigned int previousWorkers = JobSystem::GetWorkerCount();
+	unsigned int maxThreads = std::thread::hardware_concurrency();
+	if (maxThreads == 0) maxThreads = 1;
+
+	for (unsigned int threads = 1; ; threads = threads * 2 < maxThreads ? threads * 2 : maxThreads)
+	{
+		// One thread means no workers at all
+		if (threads == 1)
+			JobSystem::ShutDown();
+		else
+			JobSystem::Initialize(threads - 1);
+
+		std::string suffix = " (" + std::to_string(threads) + (threads == 1 ? " thread)" : " threads)");
+
+		outResults.push_back(Measure("Spin" + suffix, entityCount, [&]() { Systems::Spin(scene, 0.001f); }));
+		outResults.push_back(Measure("Bounds" + suffix, entityCount, [&]() { Systems::UpdateBounds(scene); }));
+		outResults.push_back(Measure("Cull + packets" + suffix, entityCount, [&]() { Systems::BuildDrawPackets(scene, frustum, view, packets); }));
+
+		if (threads == maxThreads)
+			break;
+	}
+
+	if (previousWorkers > 0)
+		JobSystem::Initialize(previousWorkers);
+	else
+		JobSystem::ShutDown();
+
+	// Single threaded; each run starts again from scene order,
+	// and the copy back is timed along with the sort
+	std::vector<Systems::DrawPacket> culled = packets;
+	outResults.push_back(Measure("Sort front to back", (unsigned int)culled.size(), [&]() { packets = culled; Systems::SortFrontToBack(packets); }));
+}
+
+// --------------------------------------------------------
+// Systems::Draw() over draws that cycle through a few fake
+// meshes, so geometry changes show up in the stream too
+// --------------------------------------------------------
+void Benchmarks::CommandRecording(unsigned int drawCount, std::vector<Result>& outResults)
+{
+	const unsigned int meshCount = 8;
+
+	// Never dereferenced, only recorded
+	std::vector<DrawItem> draws(drawCount);
+	for (unsigned int i = 0; i < drawCount; i++)
+	{
+		size_t m = i / 64 % meshCount;
+		draws[i].vertexBuffer = reinterpret_cast<ID3D11Buffer*>((m * 2 + 1) * 16);
+		draws[i].indexBuffer = reinterpret_cast<ID3D11Buffer*>((m * 2 + 2) * 16);
+		draws[i].vertexStride = 32;
+		draws[i].indexCount = 36;
+		draws[i].instanceSlot = i;
+	}
+
+	unsigned int previousWorkers = JobSystem::GetWorkerCount();
+	unsigned int maxThreads = std::thread::hardware_concurrency();
+	if (maxThreads == 0) maxThreads = 1;
+
+	RecordingCommandBackend backend(maxThreads);
+
+	// Reference stream: no workers means a single chunk
+	JobSystem::ShutDown();
+	Systems::Draw(draws.data(), drawCount, backend);
+	std::vector<RecordingCommandBackend::Command> serial = backend.GetSubmitted();
+
+	for (unsigned int threads = 1; ; threads = threads * 2 < maxThreads ? threads * 2 : maxThreads)
+	{
+		if (threads == 1)
+			JobSystem::ShutDown();
+		else
+			JobSystem::Initialize(threads - 1);
+
+		// Ordering check first, then time without keeping a copy
+		backend.keepSubmitted = true;
+		unsigned int chunks = Systems::Draw(draws.data(), drawCount, backend);
+		const std::vector<RecordingCommandBackend::Command>& parallel = backend.GetSubmitted();
+		bool matches = parallel.size() == serial.size();
+		for (size_t i = 0; matches && i < serial.size(); i++)
+		{
+			matches =
+				parallel[i].type == serial[i].type &&
+				parallel[i].vertexBuffer == serial[i].vertexBuffer &&
+				parallel[i].indexBuffer == serial[i].indexBuffer &&
+				parallel[i].a == serial[i].a && parallel[i].b == serial[i].b && parallel[i].c == serial[i].c;
+		}
+
+		backend.keepSubmitted = false;
+		std::string name = "Record draws (" + std::to_string(threads) + (threads == 1 ? " thread, " : " threads, ") +
+			std::to_string(chunks) + (chunks == 1 ? " chunk)" : " chunks)") + (matches ? "" : " ORDER MISMATCH");
+		outResults.push_back(Measure(name, drawCount, [&]() { Systems::Draw(draws.data(), drawCount, backend); }));
+
+		if (threads == maxThreads)
+			break;
+	}
+
+	if (previousWorkers > 0)
+		JobSystem::Initialize(previousWorkers);
+	else
+		JobSystem::ShutDown();
+}
+
+// --------------------------------------------------------
+// Front-facing triangles 10 - 60 pixels across, scattered
+// over the screen at random depths, with an identity WVP so
+// the positions are already clip space.  Drawn 256 to a
+// draw, as a mesh would be.
+// --------------------------------------------------------
+void Benchmarks::SoftwareRendering(unsigned int triangleCount, std::vector<Result>& outResults)
+{
+	const unsigned int width = 1280;
+	const unsigned int height = 720;
+	const unsigned int trianglesPerDraw = 256;
+
+	rngState = 1;
+	std::vector<Vertex> vertices(triangleCount * 3);
+	std::vector<unsigned int> indices(triangleCount * 3);
+	for (unsigned int t = 0; t < triangleCount; t++)
+	{
+		float x = RandomFloat(-1.0f, 1.0f);
+		float y = RandomFloat(-1.0f, 1.0f);
+		float z = RandomFloat(0.0f, 1.0f);
+		float size = RandomFloat(10.0f, 60.0f);
+		for (unsigned int i = 0; i < 3; i++)
+		{
+			Vertex& v = vertices[t * 3 + i];
+			v.Position = XMFLOAT3(
+				x + RandomFloat(-size, size) / width,
+				y + RandomFloat(-size, size) / height,
+				z);
+			v.Color = XMFLOAT4(RandomFloat(0, 1), RandomFloat(0, 1), RandomFloat(0, 1), 1.0f);
+		}
+
+		// Clockwise once on screen (where y points down), or it'd be culled
+		XMFLOAT3& a = vertices[t * 3].Position;
+		XMFLOAT3& b = vertices[t * 3 + 1].Position;
+		XMFLOAT3& c = vertices[t * 3 + 2].Position;
+		if ((b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y) > 0)
+			std::swap(vertices[t * 3 + 1], vertices[t * 3 + 2]);
+
+		indices[t * 3] = t * 3;
+		indices[t * 3 + 1] = t * 3 + 1;
+		indices[t * 3 + 2] = t * 3 + 2;
+	}
+
+	std::vector<DrawItem> draws;
+	for (unsigned int first = 0; first < triangleCount; first += trianglesPerDraw)
+	{
+		DrawItem draw = {};
+		draw.vertexStride = sizeof(Vertex);
+		draw.indexCount = (std::min(trianglesPerDraw, triangleCount - first)) * 3;
+		draw.instanceSlot = 0;
+		draw.vertices = vertices.data();
+		draw.indices = indices.data() + first * 3;
+		draws.push_back(draw);
+	}
+
+	InstanceData instance = {};
+	XMStoreFloat4x4(&instance.world, XMMatrixIdentity());
+	instance.colorTint = XMFLOAT4(1, 1, 1, 1);
+	std::vector<DrawData> drawData(draws.size());
+	for (DrawData& data : drawData)
+		XMStoreFloat4x4(&data.worldViewProj, XMMatrixIdentity());
+	DirtyRange range = { 0, 1 };
+
+	InstanceUpdate update = {};
+	update.ranges = &range;
+	update.rangeCount = 1;
+	update.data = &instance;
+	update.instanceCount = 1;
+	update.capacity = 1;
+	update.draws = drawData.data();
+	update.drawCount = (unsigned int)drawData.size();
+
+	SoftwareRasterizer rasterizer(width, height);
+	rasterizer.Upload(update);
+	const float clearColor[4] = { 0, 0, 0, 1 };
+
+	unsigned int previousWorkers = JobSystem::GetWorkerCount();
+	unsigned int maxThreads = std::thread::hardware_concurrency();
+	if (maxThreads == 0) maxThreads = 1;
+
+	for (unsigned int threads = 1; ; threads = threads * 2 < maxThreads ? threads * 2 : maxThreads)
+	{
+		if (threads == 1)
+			JobSystem::ShutDown();
+		else
+			JobSystem::Initialize(threads - 1);
+
+		std::string suffix = " (" + std::to_string(threads) + (threads == 1 ? " thread)" : " threads)");
+		Result triangles = Measure("Software raster triangles" + suffix, triangleCount, [&]()
+			{
+				rasterizer.Clear(clearColor);
+				rasterizer.Draw(draws.data(), (unsigned int)draws.size(), 0);
+			});
+
+		// Same runs, counted by what reached the screen
+		Result pixels = triangles;
+		pixels.name = "Software raster pixels" + suffix;
+		pixels.items = rasterizer.GetStats().pixels;
+		pixels.itemsPerSecond = pixels.milliseconds > 0.0 ? pixels.items / (pixels.milliseconds / 1000.0) : 0.0;
+
+		outResults.push_back(triangles);
+		outResults.push_back(pixels);
+
+		if (threads == maxThreads)
+			break;
+	}
+
+	if (previousWorkers > 0)
+		JobSystem::Initialize(previousWorkers);
+	else
+		JobSystem::ShutDown();
+}
+
+// --------------------------------------------------------
+// Point and spot lights scattered through the view of a
+// camera at the origin looking down +Z, assigned to a
+// 1920x1080 grid of clusters, on 1 to N threads
+// --------------------------------------------------------
+void Benchmarks::LightAssignment(unsigned int lightCount, std::vector<Result>& outResults)
+{
+	const unsigned int width = 1920;
+	const unsigned int height = 1080;
+
+	rngState = 1;
+	std::vector<Light> lights(lightCount);
+	for (unsigned int i = 0; i < lightCount; i++)
+	{
+		Light& light = lights[i];
+		light = {};
+		light.position = XMFLOAT3(RandomFloat(-150, 150), RandomFloat(-40, 40), RandomFloat(0, 250));
+		light.range = RandomFloat(5, 20);
+		light.color = XMFLOAT3(RandomFloat(0, 1), RandomFloat(0, 1), RandomFloat(0, 1));
+		light.intensity = 1.0f;
+		light.spotCosOuter = -1.0f;
+
+		// Every fourth one a spot light, pointing somewhere down
+		if (i % 4 == 0)
+		{
+			XMStoreFloat3(&light.direction, XMVector3Normalize(XMVectorSet(RandomFloat(-1, 1), -1.0f, RandomFloat(-1, 1), 0)));
+			float angle = RandomFloat(0.2f, 1.0f);
+			light.spotCosOuter = cosf(angle);
+			light.spotCosInner = cosf(angle * 0.8f);
+		}
+	}
+
+	XMFLOAT4X4 view;
+	XMFLOAT4X4 projection;
+	XMStoreFloat4x4(&view, XMMatrixLookToLH(XMVectorSet(0, 0, 0, 0), XMVectorSet(0, 0, 1, 0), XMVectorSet(0, 1, 0, 0)));
+	XMStoreFloat4x4(&projection, XMMatrixPerspectiveFovLH(XM_PIDIV4, (float)width / height, 0.1f, 1000.0f));
+
+	LightGrid grid;
+	grid.Configure(width, height, projection);
+
+	unsigned int previousWorkers = JobSystem::GetWorkerCount();
+	unsigned int maxThreads = std::thread::hardware_concurrency();
+	if (maxThreads == 0) maxThreads = 1;
+
+	for (unsigned int threads = 1; ; threads = threads * 2 < maxThreads ? threads * 2 : maxThreads)
+	{
+		if (threads == 1)
+			JobSystem::ShutDown();
+		else
+			JobSystem::Initialize(threads - 1);
+
+		std::string suffix = " (" + std::to_string(threads) + (threads == 1 ? " thread)" : " threads)");
+		Result assigned = Measure("Light assignment" + suffix, lightCount, [&]() { grid.Assign(lights.data(), lightCount, view); });
+
+		// Same runs, counted by light/cluster pairs found
+		Result indices = assigned;
+		indices.name = "Light cluster entries" + suffix;
+		indices.items = grid.GetStats().indices;
+		indices.itemsPerSecond = indices.milliseconds > 0.0 ? indices.items / (indices.milliseconds / 1000.0) : 0.0;
+
+		outResults.push_back(assigned);
+		outResults.push_back(indices);
+
+		if (threads == maxThreads)
+			break;
+	}
+
+	if (previousWorkers > 0)
+		JobSystem::Initialize(previousWorkers);
+	else
+		JobSystem::ShutDown();
+}
+
+// --------------------------------------------------------
+// Back-to-back empty scopes, flat and nested, on a thread
+// that already has its ring
+// --------------------------------------------------------
+bool Benchmarks::ProfilerMarkers(unsigned int markerCount, std::vector<Result>& outResults)
+{
+#if PROFILER_ENABLED
+	const double budgetNs = 20.0;
+
+	// Warm up: the first marker on a thread sets up its ring
+	{
+		PROFILE_SCOPE("Benchmark warm-up");
+	}
+
+	Result flat = Measure("Profiler markers", markerCount, [&]()
+		{
+			for (unsigned int i = 0; i < markerCount; i++)
+			{
+				PROFILE_SCOPE("Benchmark marker");
+			}
+		});
+
+	Result nested = Measure("Profiler markers", markerCount, [&]()
+		{
+			for (unsigned int i = 0; i < markerCount; i += 4)
+			{
+				PROFILE_SCOPE("Benchmark outer");
+				{
+					PROFILE_SCOPE("Benchmark middle");
+					{
+						PROFILE_SCOPE("Benchmark inner");
+						{
+							PROFILE_SCOPE("Benchmark innermost");
+						}
+					}
+				}
+			}
+		});
+
+	bool withinBudget = true;
+	for (Result* r : { &flat, &nested })
+	{
+		double ns = r->milliseconds * 1000000.0 / markerCount;
+		if (ns > budgetNs)
+			withinBudget = false;
+
+		char suffix[64];
+		snprintf(suffix, sizeof(suffix), " (%s, %.1f ns each)%s",
+			r == &flat ? "flat" : "nested", ns, ns > budgetNs ? " OVER BUDGET" : "");
+		r->name += suffix;
+		outResults.push_back(*r);
+	}
+	return withinBudget;
+#else
+	Result result = {};
+	result.name = "Profiler markers (compiled out)";
+	result.items = markerCount;
+	outResults.push_back(result);
+	return true;
+#endif
+}
+
+void Benchmarks::Print(const std::vector<Result>& results, FILE* file)
+{
+	for (const Result& r : results)
+		fprintf(file, "%-48s %10.3f ms %10.2f M/s\n", r.name.c_str(), r.milliseconds, r.itemsPerSecond / 1000000.0);
+}
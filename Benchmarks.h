@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdio>
+
+// --------------------------------------------------------
+// Micro-benchmarks for CPU-side kernels, runnable on demand
+// from the inspector.  Each returns a single result.
+// --------------------------------------------------------
+namespace Benchmarks
+{
+	struct Result
+	{
+		std::string name;
+		unsigned int items;		// How many things were processed per run
+		double milliseconds;	// Best time of all runs
+		double itemsPerSecond;
+	};
+
+	// Batched world * viewProj for the given object count,
+	// alongside the old "two full multiplies per object" path
+	void WorldViewProj(unsigned int objectCount, std::vector<Result>& outResults);
+
+	// Every BatchMath kernel on every path the CPU supports
+	void BatchMathKernels(unsigned int itemCount, std::vector<Result>& outResults);
+
+	// Walking every entity's transform, tint and mesh in the
+	// archetype scene versus the old vector<shared_ptr<Entity>>,
+	// plus creating and destroying that many entities
+	void EntityIteration(unsigned int entityCount, std::vector<Result>& outResults);
+
+	// Generational handle lookups versus shared_ptr access
+	void HandleAccess(unsigned int objectCount, std::vector<Result>& outResults);
+
+	// Transform update, bounds and culling / draw packet
+	// building over a synthetic scene, on 1 to N threads,
+	// then sorting the packets front to back.  Needs no
+	// window or device.
+	void JobScaling(unsigned int entityCount, std::vector<Result>& outResults);
+
+	// Recording drawCount draws through the headless command
+	// backend on 1 to N threads.  Each parallel run is also
+	// checked against serial recording for identical order.
+	void CommandRecording(unsigned int drawCount, std::vector<Result>& outResults);
+
+	// Drawing triangleCount small random triangles with the
+	// software rasterizer at 1280x720 on 1 to N threads, as
+	// triangles and as pixels written per second
+	void SoftwareRendering(unsigned int triangleCount, std::vector<Result>& outResults);
+
+	// LightGrid::Assign() for lightCount lights (a quarter
+	// of them spot lights) over 1920x1080 worth of clusters,
+	// on 1 to N threads.  Needs no window or device.
+	void LightAssignment(unsigned int lightCount, std::vector<Result>& outResults);
+
+	// Cost of one empty PROFILE_SCOPE, which should stay
+	// under 20 ns; the result's name says if it didn't, and
+	// false is returned so callers can fail the run
+	bool ProfilerMarkers(unsigned int markerCount, std::vector<Result>& outResults);
+
+	// Writes results as plain text lines
+	void Print(const std::vector<Result>& results, FILE* file);
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+// --------------------------------------------------------
+// An axis-aligned bounding box
+// --------------------------------------------------------
+struct Bounds
+{
+	DirectX::XMFLOAT3 min;
+	DirectX::XMFLOAT3 max;
+};
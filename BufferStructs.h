@@ -1,11 +1,60 @@
 #pragma once
-#include <d3d11.h>
 #include <DirectXMath.h>
 
 
+// Per-frame data, shared by every draw
 struct VertexShaderData {
-	DirectX::XMFLOAT4 colorTint;
-	DirectX::XMFLOAT4X4 world;
 	DirectX::XMFLOAT4X4 viewMatrix;
 	DirectX::XMFLOAT4X4 projectionMatrix;
-};
\ No newline at end of file
+	unsigned int drawOffset;	// Where this view's block of DrawData starts
+	float padding[3];
+};
+
+// Per-instance data, one element of the instance structured buffer
+// - Must match InstanceData in VertexShader.hlsl
+struct InstanceData {
+	DirectX::XMFLOAT4X4 world;
+	DirectX::XMFLOAT4 colorTint;
+};
+
+// Per-draw data, rebuilt each frame for just the visible draws
+// - Must match DrawData in VertexShader.hlsl
+struct DrawData {
+	DirectX::XMFLOAT4X4 worldViewProj;
+	unsigned int instanceSlot;	// Where the draw's InstanceData lives
+	unsigned int padding[3];
+};
+
+// A point light, or a spot light if spotCosOuter > -1
+// - Must match Light in PixelShader.hlsl
+struct Light {
+	DirectX::XMFLOAT3 position;
+	float range;				// Nothing at all beyond this
+	DirectX::XMFLOAT3 color;
+	float intensity;
+	DirectX::XMFLOAT3 direction;	// Spot lights only, normalized
+	float spotCosOuter;			// Cosine of the cone's half angle, -1 for a point light
+	float spotCosInner;			// Full intensity inside this
+	float padding[3];
+};
+
+// One cluster's run of the light index list
+// - Must match clusterRanges in PixelShader.hlsl
+struct ClusterRange {
+	unsigned int offset;
+	unsigned int count;
+};
+
+// Per-frame lighting constants for the pixel shader
+// - Must match LightingData in PixelShader.hlsl
+struct LightingData {
+	DirectX::XMFLOAT3 cameraPosition;
+	float ambient;
+	unsigned int clusterCountX;
+	unsigned int clusterCountY;
+	unsigned int clusterCountZ;
+	unsigned int clusterTileSize;	// Pixels per side
+	float sliceScale;				// slice = log(view depth) * scale + bias
+	float sliceBias;
+	float padding[2];
+};
@@ -1,6 +1,6 @@
 #include "Camera.h"
-#include "Input.h"
 #include <algorithm>
+#include <cmath>
 
 using namespace DirectX;
 
@@ -11,6 +11,8 @@ Camera::Camera(float aspectRatio, DirectX::XMFLOAT3 initialPosition, DirectX::XM
     transform.SetPosition(initialPosition.x, initialPosition.y, initialPosition.z);
     transform.SetRotation(XMConvertToRadians(inOrientation.x), XMConvertToRadians(inOrientation.y), XMConvertToRadians(inOrientation.z));
 
+    previousPose = transform.GetPose();
+
     UpdateProjectionMatrix(aspectRatio);
     UpdateViewMatrix();
 }
@@ -47,24 +49,41 @@ void Camera::UpdateViewMatrix()
     XMStoreFloat4x4(&viewMatrix, XMMatrixLookToLH(position, forward, worldUp));
 }
 
-void Camera::Update(float dt)
+DirectX::XMFLOAT4X4 Camera::GetInterpolatedViewMatrix(float alpha)
 {
+    TransformPose pose = Transform::Lerp(previousPose, transform.GetPose(), alpha);
+
+    XMVECTOR position = XMLoadFloat3(&pose.position);
+    XMVECTOR rotation = XMQuaternionRotationRollPitchYawFromVector(XMLoadFloat3(&pose.rotation));
+    XMVECTOR forward = XMVector3Rotate(XMVectorSet(0, 0, 1, 0), rotation);
+
+    XMFLOAT4X4 view;
+    XMStoreFloat4x4(&view, XMMatrixLookToLH(position, forward, XMVectorSet(0, 1, 0, 0)));
+    return view;
+}
+
+void Camera::Update(float dt, DirectX::XMFLOAT3 move, float mouseX, float mouseY)
+{
+    previousPose = transform.GetPose();
+
+    if (path)
+    {
+        pathTime += dt;
+        MoveAlongPath();
+        return;
+    }
+
     //Keyboard input
-    if (Input::KeyDown('W')) transform.MoveRelative(0.0f, 0.0f, moveSpeed * dt);
-    if (Input::KeyDown('S')) transform.MoveRelative(0.0f, 0.0f, -moveSpeed * dt);
-    if (Input::KeyDown('A')) transform.MoveRelative(-moveSpeed * dt, 0.0f, 0.0f);
-    if (Input::KeyDown('D')) transform.MoveRelative(moveSpeed * dt, 0.0f, 0.0f);
-    if (Input::KeyDown(VK_SPACE)) transform.MoveRelative(0.0f, moveSpeed * dt, 0.0f);
-    if (Input::KeyDown('X')) transform.MoveRelative(0.0f, -moveSpeed * dt, 0.0f);
+    // - Read by the caller too, as a direction in camera space
+    if (move.x != 0 || move.y != 0 || move.z != 0)
+        transform.MoveRelative(move.x * moveSpeed * dt, move.y * moveSpeed * dt, move.z * moveSpeed * dt);
 
     //mouse input
-    if (Input::MouseLeftDown()) 
+    // - Gathered by the caller, since a frame may run several steps or none
+    if (mouseX != 0 || mouseY != 0) 
     {
-        float cursorMovementX = Input::GetMouseXDelta();
-        float cursorMovementY = Input::GetMouseYDelta();
-
-        float x = cursorMovementX * mouseSpeed * dt;
-        float y = cursorMovementY * mouseSpeed * dt;
+        float x = mouseX * mouseSpeed * dt;
+        float y = mouseY * mouseSpeed * dt;
         transform.Rotate(y, x, 0);
 
         //Clamping
@@ -80,3 +99,44 @@ void Camera::Update(float dt)
     
     UpdateViewMatrix();
 }
+
+// --------------------------------------------------------
+// Starts at the beginning of the path right away, with no
+// blending in from wherever the camera was
+// --------------------------------------------------------
+void Camera::FollowPath(const CameraPath* path, float loopSeconds)
+{
+    this->path = path;
+    pathLoopSeconds = loopSeconds > 0 ? loopSeconds : 1.0f;
+    pathTime = 0;
+
+    if (path)
+    {
+        MoveAlongPath();
+        previousPose = transform.GetPose();
+    }
+}
+
+void Camera::MoveAlongPath()
+{
+    float t = pathTime / pathLoopSeconds;
+    XMFLOAT3 position = path->GetPosition(t);
+    XMFLOAT3 ahead = path->GetPosition(t + 0.01f);
+
+    XMFLOAT3 direction;
+    XMStoreFloat3(&direction, XMVector3Normalize(XMVectorSubtract(XMLoadFloat3(&ahead), XMLoadFloat3(&position))));
+
+    // Forward is (0, 0, 1) turned by pitch, then yaw
+    float pitch = asinf(std::clamp(-direction.y, -1.0f, 1.0f));
+    float yaw = atan2f(direction.x, direction.z);
+
+    // Keep yaw continuous, or interpolating across the
+    // +/- pi seam would swing the camera the long way round
+    float previousYaw = transform.GetPitchYawRoll().y;
+    while (yaw - previousYaw > XM_PI) yaw -= XM_2PI;
+    while (yaw - previousYaw < -XM_PI) yaw += XM_2PI;
+
+    transform.SetPosition(position);
+    transform.SetRotation(pitch, yaw, 0);
+    UpdateViewMatrix();
+}
@@ -1,6 +1,7 @@
 #pragma once
-#include "Input.h"
 #include "Transform.h"
+#include "SlotMap.h"
+#include "CameraPath.h"
 #include <DirectXMath.h>
 
 class Camera
@@ -14,11 +15,24 @@ public:
 
 	void UpdateProjectionMatrix(float aspectRatio);
 	void UpdateViewMatrix();
-	void Update(float dt);
 
+	// One simulation step: moving along move (right, up and
+	// forward, each -1 to 1), plus turning by however far the
+	// mouse moved (in pixels) since the last step
+	void Update(float dt, DirectX::XMFLOAT3 move, float mouseX, float mouseY);
+
+	// The view alpha of the way from the previous step's pose
+	// to the current one
+	DirectX::XMFLOAT4X4 GetInterpolatedViewMatrix(float alpha);
+
+	// Scripted flight instead of input: every step moves the
+	// camera along the path (one lap per loopSeconds), looking
+	// a little way ahead.  Null hands control back to input.
+	void FollowPath(const CameraPath* path, float loopSeconds);
 
 private:
 	Transform transform;
+	TransformPose previousPose;
 	DirectX::XMFLOAT4X4 viewMatrix;
 	DirectX::XMFLOAT4X4 projectionMatrix;
 
@@ -30,5 +44,10 @@ private:
 	float mouseSpeed;
 	bool isOrtho;
 
+	const CameraPath* path = 0;
+	float pathLoopSeconds = 1.0f;
+	float pathTime = 0;
+	void MoveAlongPath();
 };
 
+typedef Handle<Camera> CameraHandle;
@@ -0,0 +1,45 @@
+#include "CameraPath.h"
+
+#include <cmath>
+
+using namespace DirectX;
+
+void CameraPath::AddPoint(XMFLOAT3 point)
+{
+	points.push_back(point);
+}
+
+void CameraPath::Clear()
+{
+	points.clear();
+}
+
+unsigned int CameraPath::GetPointCount()
+{
+	return (unsigned int)points.size();
+}
+
+// --------------------------------------------------------
+// Finds the segment t falls in and blends its four
+// surrounding points
+// --------------------------------------------------------
+XMFLOAT3 CameraPath::GetPosition(float t) const
+{
+	if (points.empty())
+		return XMFLOAT3(0, 0, 0);
+
+	size_t count = points.size();
+	float along = (t - floorf(t)) * count;
+	size_t segment = (size_t)along;
+	if (segment >= count)
+		segment = count - 1;
+
+	XMVECTOR p0 = XMLoadFloat3(&points[(segment + count - 1) % count]);
+	XMVECTOR p1 = XMLoadFloat3(&points[segment]);
+	XMVECTOR p2 = XMLoadFloat3(&points[(segment + 1) % count]);
+	XMVECTOR p3 = XMLoadFloat3(&points[(segment + 2) % count]);
+
+	XMFLOAT3 position;
+	XMStoreFloat3(&position, XMVectorCatmullRom(p0, p1, p2, p3, along - segment));
+	return position;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <vector>
+#include <DirectXMath.h>
+
+// --------------------------------------------------------
+// A closed Catmull-Rom spline through a list of points,
+// for scripted camera flights
+//
+// - The curve passes through every point and loops back
+//   from the last to the first
+// - t runs from 0 to 1 once around the loop, spending the
+//   same time between each pair of points, and wraps
+// --------------------------------------------------------
+class CameraPath
+{
+public:
+	void AddPoint(DirectX::XMFLOAT3 point);
+	void Clear();
+	unsigned int GetPointCount();
+
+	DirectX::XMFLOAT3 GetPosition(float t) const;
+
+private:
+	std::vector<DirectX::XMFLOAT3> points;
+};
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "JobSystem.h"
+
+// Only ever passed through as opaque pointers here, so the
+// headless backend builds without any DirectX headers
+struct ID3D11Buffer;
+struct Vertex;
+
+// One mesh's geometry wherever a backend draws it from.
+// Null for backends that never reach a GPU.
+struct GeometryBuffers
+{
+	ID3D11Buffer* vertexBuffer;
+	ID3D11Buffer* indexBuffer;
+
+	// Positions alone (float3), for depth-only passes
+	ID3D11Buffer* positionBuffer;
+};
+
+// One indexed draw of a single instance, resolved down to
+// raw buffers so it can be recorded on any thread without
+// touching the mesh it came from
+struct DrawItem
+{
+	ID3D11Buffer* vertexBuffer;
+	ID3D11Buffer* indexBuffer;
+	unsigned int vertexStride;
+	unsigned int indexCount;
+	unsigned int instanceSlot;
+
+	// Positions alone (float3), for depth-only passes
+	ID3D11Buffer* positionBuffer;
+
+	// The same geometry in CPU memory, for the software rasterizer
+	const Vertex* vertices;
+	const unsigned int* indices;
+};
+
+// --------------------------------------------------------
+// The handful of commands a draw needs, recorded into
+// whatever a backend hands out (a D3D11 context, or just
+// a list in memory)
+// --------------------------------------------------------
+class CommandContext
+{
+public:
+	virtual ~CommandContext() = default;
+
+	virtual void SetGeometry(ID3D11Buffer* vertexBuffer, unsigned int vertexStride, ID3D11Buffer* indexBuffer) = 0;
+	virtual void DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startInstance) = 0;
+};
+
+// --------------------------------------------------------
+// Where command contexts come from and how their work
+// reaches the GPU
+//
+// - A frame is split into chunks; each chunk is recorded
+//   by one thread into its own context
+// - BeginChunk / EndChunk may run on any thread, as long
+//   as no two threads use the same chunk
+// - Submit() runs on the main thread and executes every
+//   chunk in chunk order
+// --------------------------------------------------------
+class CommandBackend
+{
+public:
+	virtual ~CommandBackend() = default;
+
+	// Most chunks a frame may be split into
+	virtual unsigned int GetMaxChunks() = 0;
+
+	virtual void BeginFrame(unsigned int chunkCount) = 0;
+	virtual CommandContext* BeginChunk(unsigned int chunk) = 0;
+	virtual void EndChunk(unsigned int chunk) = 0;
+	virtual void Submit() = 0;
+
+	// Copies a mesh's geometry to wherever this backend draws
+	// from.  It stays there until released, or until the
+	// backend goes away.
+	virtual GeometryBuffers CreateGeometry(const Vertex* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount) = 0;
+	virtual void ReleaseGeometry(const GeometryBuffers& geometry) = 0;
+};
+
+namespace CommandRecording
+{
+	// How many chunks count items are split into: one per
+	// thread at most, and never fewer than minPerChunk items
+	// each, since every chunk has a fixed cost
+	inline unsigned int ChunkCount(CommandBackend& backend, unsigned int count, unsigned int minPerChunk)
+	{
+		unsigned int chunks = minPerChunk > 0 ? count / minPerChunk : count;
+		unsigned int threads = JobSystem::GetThreadCount();
+		unsigned int maxChunks = backend.GetMaxChunks();
+
+		if (chunks > threads) chunks = threads;
+		if (chunks > maxChunks) chunks = maxChunks;
+		return chunks > 0 ? chunks : 1;
+	}
+
+	// --------------------------------------------------------
+	// Splits [0, count) into contiguous chunks, records each
+	// on the job system with record(context, begin, end) and
+	// submits them in order.  Returns the chunk count used.
+	// --------------------------------------------------------
+	template<typename RecordFn>
+	unsigned int Record(CommandBackend& backend, unsigned int count, unsigned int minPerChunk, const RecordFn& record)
+	{
+		unsigned int chunks = ChunkCount(backend, count, minPerChunk);
+		unsigned int perChunk = (count + chunks - 1) / chunks;
+
+		backend.BeginFrame(chunks);
+		JobSystem::ParallelFor(chunks, 1, [&](unsigned int first, unsigned int last)
+		{
+			for (unsigned int chunk = first; chunk < last; chunk++)
+			{
+				unsigned int begin = chunk * perChunk;
+				unsigned int end = begin + perChunk < count ? begin + perChunk : count;
+
+				CommandContext* context = backend.BeginChunk(chunk);
+				if (begin < end)
+					record(*context, begin, end);
+				backend.EndChunk(chunk);
+			}
+		});
+		backend.Submit();
+		return chunks;
+	}
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdio>
+#include <cerrno>
+
+// --------------------------------------------------------
+// The MSVC runtime's checked functions the portable code
+// uses, for runtimes without them
+// --------------------------------------------------------
+#if !defined(_WIN32)
+inline int fopen_s(FILE** file, const char* path, const char* mode)
+{
+	*file = fopen(path, mode);
+	return *file ? 0 : errno;
+}
+#endif
@@ -0,0 +1,298 @@
+#include "D3D11CommandBackend.h"
+#include "Graphics.h"
+#include "Vertex.h"
+#include <DirectXMath.h>
+
+D3D11CommandBackend::~D3D11CommandBackend()
+{
+}
+
+// --------------------------------------------------------
+// Creates one deferred context per possible chunk
+// --------------------------------------------------------
+void D3D11CommandBackend::Initialize(unsigned int maxChunks)
+{
+	if (maxChunks == 0)
+		maxChunks = 1;
+
+	deferredContexts.clear();
+	commandLists.clear();
+	contexts.clear();
+
+	deferredContexts.resize(maxChunks);
+	commandLists.resize(maxChunks);
+	contexts.resize(maxChunks);
+
+	for (unsigned int i = 0; i < maxChunks; i++)
+	{
+		Graphics::Device->CreateDeferredContext(0, deferredContexts[i].GetAddressOf());
+		contexts[i].context = deferredContexts[i].Get();
+	}
+}
+
+unsigned int D3D11CommandBackend::GetMaxChunks()
+{
+	return (unsigned int)contexts.size();
+}
+
+unsigned int D3D11CommandBackend::GetLastChunkCount()
+{
+	return chunkCount;
+}
+
+void D3D11CommandBackend::BeginFrame(unsigned int chunkCount)
+{
+	this->chunkCount = chunkCount;
+
+	// Only deferred contexts need the state handed over
+	if (chunkCount > 1)
+		CaptureState();
+}
+
+CommandContext* D3D11CommandBackend::BeginChunk(unsigned int chunk)
+{
+	if (chunkCount <= 1)
+	{
+		immediate.context = Graphics::Context.Get();
+		immediate.boundVertexBuffer = 0;
+		immediate.boundIndexBuffer = 0;
+		return &immediate;
+	}
+
+	Context& c = contexts[chunk];
+	c.boundVertexBuffer = 0;
+	c.boundIndexBuffer = 0;
+	ApplyState(c.context);
+	return &c;
+}
+
+void D3D11CommandBackend::EndChunk(unsigned int chunk)
+{
+	if (chunkCount <= 1)
+		return;
+
+	// FALSE: the deferred context doesn't need its state back,
+	// it gets everything reapplied next frame anyway
+	commandLists[chunk].Reset();
+	contexts[chunk].context->FinishCommandList(FALSE, commandLists[chunk].GetAddressOf());
+}
+
+// --------------------------------------------------------
+// Plays the command lists back in chunk order, which keeps
+// draw order identical to recording everything serially
+// --------------------------------------------------------
+void D3D11CommandBackend::Submit()
+{
+	if (chunkCount <= 1)
+		return;
+
+	for (unsigned int c = 0; c < chunkCount; c++)
+	{
+		if (!commandLists[c])
+			continue;
+
+		// TRUE: put the immediate context's state back afterwards,
+		// since UI and the next frame carry on from it
+		Graphics::Context->ExecuteCommandList(commandLists[c].Get(), TRUE);
+		commandLists[c].Reset();
+	}
+
+	// Don't hold on to this frame's resources
+	state = {};
+}
+
+
+// --------------------------------------------------------
+// Reads back everything the draws depend on from the
+// immediate context
+// --------------------------------------------------------
+void D3D11CommandBackend::CaptureState()
+{
+	ID3D11DeviceContext* context = Graphics::Context.Get();
+	state = {};
+
+	context->IAGetPrimitiveTopology(&state.topology);
+	context->IAGetInputLayout(state.inputLayout.GetAddressOf());
+	context->IAGetVertexBuffers(1, 1, state.drawIdBuffer.GetAddressOf(), &state.drawIdStride, &state.drawIdOffset);
+
+	context->VSGetShader(state.vertexShader.GetAddressOf(), 0, 0);
+	context->VSGetConstantBuffers(0, 1, state.vsConstantBuffer.GetAddressOf());
+	ID3D11ShaderResourceView* resources[2] = {};
+	context->VSGetShaderResources(0, 2, resources);
+	for (int i = 0; i < 2; i++)
+		state.vsResources[i].Attach(resources[i]);
+
+	context->PSGetShader(state.pixelShader.GetAddressOf(), 0, 0);
+	context->PSGetConstantBuffers(0, 1, state.psConstantBuffer.GetAddressOf());
+	ID3D11ShaderResourceView* psResources[3] = {};
+	context->PSGetShaderResources(0, 3, psResources);
+	for (int i = 0; i < 3; i++)
+		state.psResources[i].Attach(psResources[i]);
+
+	context->RSGetState(state.rasterizerState.GetAddressOf());
+	state.viewportCount = 1;
+	context->RSGetViewports(&state.viewportCount, &state.viewport);
+
+	context->OMGetRenderTargets(1, state.renderTarget.GetAddressOf(), state.depthTarget.GetAddressOf());
+	context->OMGetDepthStencilState(state.depthState.GetAddressOf(), &state.stencilRef);
+	context->OMGetBlendState(state.blendState.GetAddressOf(), state.blendFactor, &state.sampleMask);
+}
+
+void D3D11CommandBackend::ApplyState(ID3D11DeviceContext* context)
+{
+	context->IASetPrimitiveTopology(state.topology);
+	context->IASetInputLayout(state.inputLayout.Get());
+	context->IASetVertexBuffers(1, 1, state.drawIdBuffer.GetAddressOf(), &state.drawIdStride, &state.drawIdOffset);
+
+	context->VSSetShader(state.vertexShader.Get(), 0, 0);
+	context->VSSetConstantBuffers(0, 1, state.vsConstantBuffer.GetAddressOf());
+	ID3D11ShaderResourceView* resources[2] = { state.vsResources[0].Get(), state.vsResources[1].Get() };
+	context->VSSetShaderResources(0, 2, resources);
+
+	context->PSSetShader(state.pixelShader.Get(), 0, 0);
+	context->PSSetConstantBuffers(0, 1, state.psConstantBuffer.GetAddressOf());
+	ID3D11ShaderResourceView* psResources[3] = { state.psResources[0].Get(), state.psResources[1].Get(), state.psResources[2].Get() };
+	context->PSSetShaderResources(0, 3, psResources);
+
+	context->RSSetState(state.rasterizerState.Get());
+	if (state.viewportCount > 0)
+		context->RSSetViewports(1, &state.viewport);
+
+	context->OMSetRenderTargets(1, state.renderTarget.GetAddressOf(), state.depthTarget.Get());
+	context->OMSetDepthStencilState(state.depthState.Get(), state.stencilRef);
+	context->OMSetBlendState(state.blendState.Get(), state.blendFactor, state.sampleMask);
+}
+
+
+// --------------------------------------------------------
+// Geometry
+// - Immutable buffers, kept alive here until released, so
+//   meshes only ever hold raw pointers to them
+// --------------------------------------------------------
+GeometryBuffers D3D11CommandBackend::CreateGeometry(const Vertex* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount)
+{
+	Microsoft::WRL::ComPtr<ID3D11Buffer> vertexBuffer;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> positionBuffer;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> indexBuffer;
+
+	// Create a VERTEX BUFFER
+	// - This holds the vertex data of triangles for a single object
+	// - This buffer is created on the GPU, which is where the data needs to
+	//    be if we want the GPU to act on it (as in: draw it to the screen)
+	{
+		// First, we need to describe the buffer we want Direct3D to make on the GPU
+		//  - Note that this variable is created on the stack since we only need it once
+		//  - After the buffer is created, this description variable is unnecessary
+		D3D11_BUFFER_DESC vbd = {};
+		vbd.Usage = D3D11_USAGE_IMMUTABLE;	// Will NEVER change
+		vbd.ByteWidth = sizeof(Vertex) * vertexCount;       // number of vertices in the buffer
+		vbd.BindFlags = D3D11_BIND_VERTEX_BUFFER; // Tells Direct3D this is a vertex buffer
+		vbd.CPUAccessFlags = 0;	// Note: We cannot access the data from C++ (this is good)
+		vbd.MiscFlags = 0;
+		vbd.StructureByteStride = 0;
+
+		// Create the proper struct to hold the initial vertex data
+		// - This is how we initially fill the buffer with data
+		// - Essentially, we're specifying a pointer to the data to copy
+		D3D11_SUBRESOURCE_DATA initialVertexData = {};
+		initialVertexData.pSysMem = vertices; // pSysMem = Pointer to System Memory
+
+		// Actually create the buffer on the GPU with the initial data
+		// - Once we do this, we'll NEVER CHANGE DATA IN THE BUFFER AGAIN
+		Graphics::Device->CreateBuffer(&vbd, &initialVertexData, vertexBuffer.GetAddressOf());
+		Graphics::TrackBufferMemory(vertexBuffer.Get(), "Meshes");
+	}
+
+	// Create a POSITION-ONLY VERTEX BUFFER
+	// - The same positions again, packed tightly, for passes
+	//   that only write depth and so never read the colors
+	{
+		std::vector<DirectX::XMFLOAT3> positions(vertexCount);
+		for (unsigned int i = 0; i < vertexCount; i++)
+			positions[i] = vertices[i].Position;
+
+		D3D11_BUFFER_DESC pbd = {};
+		pbd.Usage = D3D11_USAGE_IMMUTABLE;
+		pbd.ByteWidth = sizeof(DirectX::XMFLOAT3) * vertexCount;
+		pbd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+
+		D3D11_SUBRESOURCE_DATA initialPositionData = {};
+		initialPositionData.pSysMem = positions.data();
+
+		Graphics::Device->CreateBuffer(&pbd, &initialPositionData, positionBuffer.GetAddressOf());
+		Graphics::TrackBufferMemory(positionBuffer.Get(), "Meshes");
+	}
+
+	// Create an INDEX BUFFER
+	// - This holds indices to elements in the vertex buffer
+	// - This is most useful when vertices are shared among neighboring triangles
+	// - This buffer is created on the GPU, which is where the data needs to
+	//    be if we want the GPU to act on it (as in: draw it to the screen)
+	{
+		// Describe the buffer, as we did above, with two major differences
+		//  - Byte Width (3 unsigned integers vs. 3 whole vertices)
+		//  - Bind Flag (used as an index buffer instead of a vertex buffer) 
+		D3D11_BUFFER_DESC ibd = {};
+		ibd.Usage = D3D11_USAGE_IMMUTABLE;	// Will NEVER change
+		ibd.ByteWidth = sizeof(unsigned int) * indexCount;	// number of indices in the buffer
+		ibd.BindFlags = D3D11_BIND_INDEX_BUFFER;	// Tells Direct3D this is an index buffer
+		ibd.CPUAccessFlags = 0;	// Note: We cannot access the data from C++ (this is good)
+		ibd.MiscFlags = 0;
+		ibd.StructureByteStride = 0;
+
+		// Specify the initial data for this buffer, similar to above
+		D3D11_SUBRESOURCE_DATA initialIndexData = {};
+		initialIndexData.pSysMem = indices; // pSysMem = Pointer to System Memory
+
+		// Actually create the buffer with the initial data
+		// - Once we do this, we'll NEVER CHANGE THE BUFFER AGAIN
+		Graphics::Device->CreateBuffer(&ibd, &initialIndexData, indexBuffer.GetAddressOf());
+		Graphics::TrackBufferMemory(indexBuffer.Get(), "Meshes");
+	}
+
+	geometry.push_back(vertexBuffer);
+	geometry.push_back(positionBuffer);
+	geometry.push_back(indexBuffer);
+	return { vertexBuffer.Get(), indexBuffer.Get(), positionBuffer.Get() };
+}
+
+void D3D11CommandBackend::ReleaseGeometry(const GeometryBuffers& buffers)
+{
+	for (size_t i = 0; i < geometry.size();)
+	{
+		ID3D11Buffer* buffer = geometry[i].Get();
+		if (buffer == buffers.vertexBuffer || buffer == buffers.indexBuffer || buffer == buffers.positionBuffer)
+		{
+			geometry[i] = geometry.back();
+			geometry.pop_back();
+		}
+		else
+			i++;
+	}
+}
+
+
+// --------------------------------------------------------
+// Commands
+// --------------------------------------------------------
+void D3D11CommandBackend::Context::SetGeometry(ID3D11Buffer* vertexBuffer, unsigned int vertexStride, ID3D11Buffer* indexBuffer)
+{
+	if (vertexBuffer != boundVertexBuffer)
+	{
+		UINT stride = vertexStride;
+		UINT offset = 0;
+		context->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
+		boundVertexBuffer = vertexBuffer;
+	}
+
+	if (indexBuffer != boundIndexBuffer)
+	{
+		context->IASetIndexBuffer(indexBuffer, DXGI_FORMAT_R32_UINT, 0);
+		boundIndexBuffer = indexBuffer;
+	}
+}
+
+void D3D11CommandBackend::Context::DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startInstance)
+{
+	context->DrawIndexedInstanced(indexCount, instanceCount, 0, 0, startInstance);
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <vector>
+
+#include "CommandBackend.h"
+
+// --------------------------------------------------------
+// Records chunks on D3D11 deferred contexts and executes
+// the resulting command lists on the immediate context.
+//
+// - Deferred contexts start with no state at all, so the
+//   immediate context's pipeline state is captured at
+//   BeginFrame() and applied to every chunk
+// - A single chunk skips all that and draws straight on
+//   the immediate context
+// --------------------------------------------------------
+class D3D11CommandBackend : public CommandBackend
+{
+public:
+	D3D11CommandBackend() = default;
+	~D3D11CommandBackend();
+	D3D11CommandBackend(const D3D11CommandBackend&) = delete; // Remove copy constructor
+	D3D11CommandBackend& operator=(const D3D11CommandBackend&) = delete; // Remove copy-assignment operator
+
+	void Initialize(unsigned int maxChunks);
+
+	unsigned int GetMaxChunks() override;
+	void BeginFrame(unsigned int chunkCount) override;
+	CommandContext* BeginChunk(unsigned int chunk) override;
+	void EndChunk(unsigned int chunk) override;
+	void Submit() override;
+	GeometryBuffers CreateGeometry(const Vertex* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount) override;
+	void ReleaseGeometry(const GeometryBuffers& buffers) override;
+
+	unsigned int GetLastChunkCount();
+
+private:
+	class Context : public CommandContext
+	{
+	public:
+		void SetGeometry(ID3D11Buffer* vertexBuffer, unsigned int vertexStride, ID3D11Buffer* indexBuffer) override;
+		void DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startInstance) override;
+
+		ID3D11DeviceContext* context = 0;
+
+		// Skips rebinding the same mesh back to back
+		ID3D11Buffer* boundVertexBuffer = 0;
+		ID3D11Buffer* boundIndexBuffer = 0;
+	};
+
+	// Whatever the immediate context had bound when the frame began
+	struct PipelineState
+	{
+		D3D11_PRIMITIVE_TOPOLOGY topology;
+		Microsoft::WRL::ComPtr<ID3D11InputLayout> inputLayout;
+		Microsoft::WRL::ComPtr<ID3D11Buffer> drawIdBuffer;
+		UINT drawIdStride;
+		UINT drawIdOffset;
+		Microsoft::WRL::ComPtr<ID3D11VertexShader> vertexShader;
+		Microsoft::WRL::ComPtr<ID3D11Buffer> vsConstantBuffer;
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> vsResources[2];
+		Microsoft::WRL::ComPtr<ID3D11PixelShader> pixelShader;
+		Microsoft::WRL::ComPtr<ID3D11Buffer> psConstantBuffer;
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> psResources[3];
+		Microsoft::WRL::ComPtr<ID3D11RasterizerState> rasterizerState;
+		D3D11_VIEWPORT viewport;
+		UINT viewportCount;
+		Microsoft::WRL::ComPtr<ID3D11RenderTargetView> renderTarget;
+		Microsoft::WRL::ComPtr<ID3D11DepthStencilView> depthTarget;
+		Microsoft::WRL::ComPtr<ID3D11DepthStencilState> depthState;
+		UINT stencilRef;
+		Microsoft::WRL::ComPtr<ID3D11BlendState> blendState;
+		FLOAT blendFactor[4];
+		UINT sampleMask;
+	};
+
+	void CaptureState();
+	void ApplyState(ID3D11DeviceContext* context);
+
+	std::vector<Microsoft::WRL::ComPtr<ID3D11DeviceContext>> deferredContexts;
+	std::vector<Microsoft::WRL::ComPtr<ID3D11CommandList>> commandLists;
+	std::vector<Context> contexts;
+	Context immediate;
+
+	PipelineState state = {};
+	unsigned int chunkCount = 0;
+
+	// Every mesh buffer not yet released
+	std::vector<Microsoft::WRL::ComPtr<ID3D11Buffer>> geometry;
+};
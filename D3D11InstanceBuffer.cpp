@@ -0,0 +1,177 @@
+#include "D3D11InstanceBuffer.h"
+#include "Graphics.h"
+#include "AllocationTracker.h"
+
+D3D11InstanceBuffer::~D3D11InstanceBuffer()
+{
+}
+
+// --------------------------------------------------------
+// Sends a captured update to the GPU: one UpdateSubresource()
+// per dirty range, then every view's DrawData in one mapped
+// copy, so only what's visible crosses the bus each frame
+// --------------------------------------------------------
+void D3D11InstanceBuffer::Upload(const InstanceUpdate& update)
+{
+	if (update.capacity > gpuCapacity)
+		CreateBuffers(update.capacity);
+
+	// The per-draw buffer is sized separately, doubling as
+	// more gets visible (or more views are drawn)
+	if (update.drawCount > drawCapacity)
+	{
+		unsigned int count = drawCapacity > 0 ? drawCapacity : 1;
+		while (count < update.drawCount)
+			count *= 2;
+		CreateDrawDataBuffer(count);
+	}
+
+	unsigned int bytes = 0;
+	const InstanceData* next = update.data;
+	for (unsigned int i = 0; i < update.rangeCount; i++)
+	{
+		const DirtyRange& range = update.ranges[i];
+
+		// Buffers are 1D, so only left/right matter
+		D3D11_BOX box = {};
+		box.left = range.begin * sizeof(InstanceData);
+		box.right = range.end * sizeof(InstanceData);
+		box.top = 0;
+		box.bottom = 1;
+		box.front = 0;
+		box.back = 1;
+
+		Graphics::Context->UpdateSubresource(instanceBuffer.Get(), 0, &box, next, 0, 0);
+		next += range.end - range.begin;
+		bytes += box.right - box.left;
+	}
+	uploadedBytes = bytes;
+	uploadedRanges = update.rangeCount;
+
+	wvpBytes = 0;
+	if (update.drawCount == 0)
+		return;
+
+	D3D11_MAPPED_SUBRESOURCE mapped = {};
+	if (FAILED(Graphics::Context->Map(drawDataBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)))
+		return;
+
+	memcpy(mapped.pData, update.draws, update.drawCount * sizeof(DrawData));
+
+	Graphics::Context->Unmap(drawDataBuffer.Get(), 0);
+	wvpBytes = (unsigned int)(update.drawCount * sizeof(DrawData));
+}
+
+// --------------------------------------------------------
+// Binds the instance and per-draw data to the vertex shader
+// and the draw id stream to the input assembler
+// --------------------------------------------------------
+void D3D11InstanceBuffer::Bind(unsigned int srvSlot, unsigned int drawSrvSlot, unsigned int drawIdVertexSlot)
+{
+	Graphics::Context->VSSetShaderResources(srvSlot, 1, instanceSRV.GetAddressOf());
+	Graphics::Context->VSSetShaderResources(drawSrvSlot, 1, drawDataSRV.GetAddressOf());
+
+	UINT stride = sizeof(unsigned int);
+	UINT offset = 0;
+	Graphics::Context->IASetVertexBuffers(drawIdVertexSlot, 1, drawIdBuffer.GetAddressOf(), &stride, &offset);
+}
+
+unsigned int D3D11InstanceBuffer::GetUploadedBytes()
+{
+	return uploadedBytes;
+}
+
+unsigned int D3D11InstanceBuffer::GetUploadedRanges()
+{
+	return uploadedRanges;
+}
+
+unsigned int D3D11InstanceBuffer::GetWorldViewProjBytes()
+{
+	return wvpBytes;
+}
+
+void D3D11InstanceBuffer::CreateBuffers(unsigned int capacity)
+{
+	ALLOCATION_SCOPE("Instances");
+
+	gpuCapacity = capacity;
+
+	// The structured buffer itself, updated with UpdateSubresource()
+	{
+		D3D11_BUFFER_DESC desc = {};
+		desc.Usage = D3D11_USAGE_DEFAULT;
+		desc.ByteWidth = sizeof(InstanceData) * capacity;
+		desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		desc.CPUAccessFlags = 0;
+		desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+		desc.StructureByteStride = sizeof(InstanceData);
+
+		instanceBuffer.Reset();
+		Graphics::Device->CreateBuffer(&desc, 0, instanceBuffer.GetAddressOf());
+		Graphics::TrackBufferMemory(instanceBuffer.Get(), "Instances");
+
+		D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+		srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+		srvDesc.Buffer.FirstElement = 0;
+		srvDesc.Buffer.NumElements = capacity;
+
+		instanceSRV.Reset();
+		Graphics::Device->CreateShaderResourceView(instanceBuffer.Get(), &srvDesc, instanceSRV.GetAddressOf());
+	}
+
+	// The draw id stream: simply 0, 1, 2, ... so that drawing
+	// with StartInstanceLocation = i hands the shader its
+	// position in the draw list.  No view draws a slot twice,
+	// so capacity entries are always enough.
+	{
+		std::vector<unsigned int> ids(capacity);
+		for (unsigned int i = 0; i < capacity; i++)
+			ids[i] = i;
+
+		D3D11_BUFFER_DESC desc = {};
+		desc.Usage = D3D11_USAGE_IMMUTABLE;
+		desc.ByteWidth = sizeof(unsigned int) * capacity;
+		desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+
+		D3D11_SUBRESOURCE_DATA initialData = {};
+		initialData.pSysMem = ids.data();
+
+		drawIdBuffer.Reset();
+		Graphics::Device->CreateBuffer(&desc, &initialData, drawIdBuffer.GetAddressOf());
+		Graphics::TrackBufferMemory(drawIdBuffer.Get(), "Instances");
+	}
+}
+
+// --------------------------------------------------------
+// The per-frame DrawData buffer, rewritten each frame with
+// just that frame's visible draws, every view's in turn
+// --------------------------------------------------------
+void D3D11InstanceBuffer::CreateDrawDataBuffer(unsigned int count)
+{
+	ALLOCATION_SCOPE("Instances");
+
+	drawCapacity = count;
+
+	D3D11_BUFFER_DESC desc = {};
+	desc.Usage = D3D11_USAGE_DYNAMIC;
+	desc.ByteWidth = sizeof(DrawData) * count;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+	desc.StructureByteStride = sizeof(DrawData);
+
+	drawDataBuffer.Reset();
+	Graphics::Device->CreateBuffer(&desc, 0, drawDataBuffer.GetAddressOf());
+	Graphics::TrackBufferMemory(drawDataBuffer.Get(), "Instances");
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+	srvDesc.Buffer.FirstElement = 0;
+	srvDesc.Buffer.NumElements = count;
+
+	drawDataSRV.Reset();
+	Graphics::Device->CreateShaderResourceView(drawDataBuffer.Get(), &srvDesc, drawDataSRV.GetAddressOf());
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <atomic>
+
+#include "InstanceBuffer.h"
+
+// --------------------------------------------------------
+// The GPU side of the per-instance data: a persistent
+// structured buffer mirroring InstanceBuffer's shadow,
+// and a per-frame one of DrawData
+//
+// - Only captured ranges are re-uploaded, one
+//   UpdateSubresource() per coalesced range
+// - A matching "draw id" vertex stream hands the vertex
+//   shader the draw's position through the instance
+//   index, and DrawData leads it on to the slot
+// - Buffers are only created by the first Upload(), and
+//   recreated larger when an update needs more room
+// --------------------------------------------------------
+class D3D11InstanceBuffer
+{
+public:
+	D3D11InstanceBuffer() = default;
+	~D3D11InstanceBuffer();
+	D3D11InstanceBuffer(const D3D11InstanceBuffer&) = delete; // Remove copy constructor
+	D3D11InstanceBuffer& operator=(const D3D11InstanceBuffer&) = delete; // Remove copy-assignment operator
+
+	// Grows the GPU buffers if needed and sends a captured update
+	void Upload(const InstanceUpdate& update);
+	void Bind(unsigned int srvSlot, unsigned int drawSrvSlot, unsigned int drawIdVertexSlot);
+
+	// Stats from the most recent Upload()
+	unsigned int GetUploadedBytes();
+	unsigned int GetUploadedRanges();
+	unsigned int GetWorldViewProjBytes();
+
+private:
+	void CreateBuffers(unsigned int capacity);
+	void CreateDrawDataBuffer(unsigned int count);
+
+	Microsoft::WRL::ComPtr<ID3D11Buffer> instanceBuffer;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> instanceSRV;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> drawIdBuffer;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> drawDataBuffer;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> drawDataSRV;
+
+	unsigned int gpuCapacity = 0;	// What the buffers were created with
+	unsigned int drawCapacity = 0;	// DrawData the per-draw buffer holds, for every view
+
+	// Written by Upload(), read from the UI
+	std::atomic<unsigned int> uploadedBytes{ 0 };
+	std::atomic<unsigned int> uploadedRanges{ 0 };
+	std::atomic<unsigned int> wvpBytes{ 0 };
+};
@@ -0,0 +1,139 @@
+#include "D3D11TexturePool.h"
+#include "Graphics.h"
+#include "AllocationTracker.h"
+
+// Annonymous namespace to hold helpers
+// only accessible in this file
+namespace
+{
+	// Depth is typeless underneath, so it can be viewed both
+	// as a depth buffer and as a plain float texture
+	void GetFormats(TextureFormat format, DXGI_FORMAT& texture, DXGI_FORMAT& view, DXGI_FORMAT& shaderResource)
+	{
+		switch (format)
+		{
+		case TextureFormat::RGBA16F: texture = view = shaderResource = DXGI_FORMAT_R16G16B16A16_FLOAT; break;
+		case TextureFormat::R32F: texture = view = shaderResource = DXGI_FORMAT_R32_FLOAT; break;
+		case TextureFormat::Depth32F:
+			texture = DXGI_FORMAT_R32_TYPELESS;
+			view = DXGI_FORMAT_D32_FLOAT;
+			shaderResource = DXGI_FORMAT_R32_FLOAT;
+			break;
+		default: texture = view = shaderResource = DXGI_FORMAT_R8G8B8A8_UNORM; break;
+		}
+	}
+
+	bool SameDesc(const TextureDesc& a, const TextureDesc& b)
+	{
+		return a.width == b.width && a.height == b.height && a.format == b.format;
+	}
+}
+
+
+D3D11TexturePool::~D3D11TexturePool()
+{
+	Release();
+}
+
+void D3D11TexturePool::Realize(const RenderGraph& graph)
+{
+	unsigned int count = graph.GetPhysicalCount();
+	for (unsigned int p = 0; p < count; p++)
+	{
+		Texture& t = textures[p];
+		const TextureDesc& desc = graph.GetPhysicalDesc(p);
+		if (t.texture && SameDesc(t.desc, desc))
+			continue;
+
+		Destroy(t);
+		Create(t, desc);
+	}
+
+	// Whatever the graph stopped using goes
+	for (unsigned int p = count; p < textureCount; p++)
+		Destroy(textures[p]);
+	textureCount = count;
+}
+
+void D3D11TexturePool::Release()
+{
+	for (unsigned int p = 0; p < textureCount; p++)
+		Destroy(textures[p]);
+	textureCount = 0;
+}
+
+ID3D11RenderTargetView* D3D11TexturePool::GetRenderTarget(const RenderGraph& graph, RenderResource resource)
+{
+	unsigned int p = graph.GetPhysical(resource);
+	return p < textureCount ? textures[p].renderTarget.Get() : 0;
+}
+
+ID3D11DepthStencilView* D3D11TexturePool::GetDepthTarget(const RenderGraph& graph, RenderResource resource)
+{
+	unsigned int p = graph.GetPhysical(resource);
+	return p < textureCount ? textures[p].depthTarget.Get() : 0;
+}
+
+ID3D11ShaderResourceView* D3D11TexturePool::GetShaderResource(const RenderGraph& graph, RenderResource resource)
+{
+	unsigned int p = graph.GetPhysical(resource);
+	return p < textureCount ? textures[p].shaderResource.Get() : 0;
+}
+
+bool D3D11TexturePool::Create(Texture& t, const TextureDesc& desc)
+{
+	ALLOCATION_SCOPE("Render graph");
+
+	DXGI_FORMAT textureFormat, viewFormat, shaderResourceFormat;
+	GetFormats(desc.format, textureFormat, viewFormat, shaderResourceFormat);
+	bool depth = desc.format == TextureFormat::Depth32F;
+
+	D3D11_TEXTURE2D_DESC textureDesc = {};
+	textureDesc.Width = desc.width;
+	textureDesc.Height = desc.height;
+	textureDesc.MipLevels = 1;
+	textureDesc.ArraySize = 1;
+	textureDesc.Format = textureFormat;
+	textureDesc.SampleDesc.Count = 1;
+	textureDesc.Usage = D3D11_USAGE_DEFAULT;
+	textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | (depth ? D3D11_BIND_DEPTH_STENCIL : D3D11_BIND_RENDER_TARGET);
+	if (FAILED(Graphics::Device->CreateTexture2D(&textureDesc, 0, t.texture.GetAddressOf())))
+		return false;
+
+	if (depth)
+	{
+		D3D11_DEPTH_STENCIL_VIEW_DESC dsvDesc = {};
+		dsvDesc.Format = viewFormat;
+		dsvDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
+		Graphics::Device->CreateDepthStencilView(t.texture.Get(), &dsvDesc, t.depthTarget.GetAddressOf());
+	}
+	else
+		Graphics::Device->CreateRenderTargetView(t.texture.Get(), 0, t.renderTarget.GetAddressOf());
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Format = shaderResourceFormat;
+	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+	srvDesc.Texture2D.MipLevels = 1;
+	Graphics::Device->CreateShaderResourceView(t.texture.Get(), &srvDesc, t.shaderResource.GetAddressOf());
+
+	t.desc = desc;
+	size_t size = RenderGraph::GetTextureBytes(desc);
+	bytes += size;
+	AllocationTracker::AddGpuBytes(AllocationTracker::RegisterTag("Render graph"), (long long)size);
+	return true;
+}
+
+void D3D11TexturePool::Destroy(Texture& t)
+{
+	if (t.texture)
+	{
+		size_t size = RenderGraph::GetTextureBytes(t.desc);
+		bytes -= size;
+		AllocationTracker::AddGpuBytes(AllocationTracker::RegisterTag("Render graph"), -(long long)size);
+	}
+
+	t.shaderResource.Reset();
+	t.depthTarget.Reset();
+	t.renderTarget.Reset();
+	t.texture.Reset();
+}
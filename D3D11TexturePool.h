@@ -0,0 +1,52 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl/client.h>
+#include "RenderGraph.h"
+
+// --------------------------------------------------------
+// The real textures behind a render graph's transient
+// resources, one per physical texture
+//
+// - Realize() after every Compile(); textures are only
+//   (re)created when a physical texture's description
+//   changes, so a steady frame creates nothing
+// - Color formats get a render target view, depth formats
+//   a depth-stencil view, and both can be read by shaders
+// - Runs wherever the graph executes (the render thread)
+// --------------------------------------------------------
+class D3D11TexturePool
+{
+public:
+	D3D11TexturePool() = default;
+	~D3D11TexturePool();
+	D3D11TexturePool(const D3D11TexturePool&) = delete; // Remove copy constructor
+	D3D11TexturePool& operator=(const D3D11TexturePool&) = delete; // Remove copy-assignment operator
+
+	void Realize(const RenderGraph& graph);
+	void Release();
+
+	// Null for imported or culled resources
+	ID3D11RenderTargetView* GetRenderTarget(const RenderGraph& graph, RenderResource resource);
+	ID3D11DepthStencilView* GetDepthTarget(const RenderGraph& graph, RenderResource resource);
+	ID3D11ShaderResourceView* GetShaderResource(const RenderGraph& graph, RenderResource resource);
+
+	size_t GetBytes() { return bytes; }
+
+private:
+	struct Texture
+	{
+		TextureDesc desc;
+		Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
+		Microsoft::WRL::ComPtr<ID3D11RenderTargetView> renderTarget;
+		Microsoft::WRL::ComPtr<ID3D11DepthStencilView> depthTarget;
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> shaderResource;
+	};
+
+	bool Create(Texture& texture, const TextureDesc& desc);
+	void Destroy(Texture& texture);
+
+	Texture textures[RenderGraph::MaxResources] = {};
+	unsigned int textureCount = 0;
+	size_t bytes = 0;
+};
@@ -0,0 +1,155 @@
+#include "DirtyRangeTracker.h"
+
+DirtyRangeTracker::DirtyRangeTracker(unsigned int slotCount)
+{
+	Resize(slotCount);
+}
+
+// --------------------------------------------------------
+// Grows or shrinks the number of tracked slots.  Existing
+// dirty state is kept for slots that survive the resize.
+// The word array doubles when it runs out, so growing one
+// slot at a time is amortized O(1).
+// --------------------------------------------------------
+void DirtyRangeTracker::Resize(unsigned int slotCount)
+{
+	// Drop any marks that fall off the end when shrinking
+	for (unsigned int s = slotCount; s < this->slotCount; s++)
+	{
+		if (IsDirty(s))
+			dirtyCount--;
+	}
+
+	// Atomics can't be moved, so a new word array is built,
+	// but only once the current one is out of room
+	unsigned int newWordCount = (slotCount + 63) / 64;
+	if (newWordCount > wordCapacity)
+	{
+		unsigned int newCapacity = wordCapacity > 0 ? wordCapacity * 2 : 1;
+		while (newCapacity < newWordCount)
+			newCapacity *= 2;
+
+		std::unique_ptr<std::atomic<uint64_t>[]> newBits(new std::atomic<uint64_t>[newCapacity]);
+		for (unsigned int w = 0; w < newCapacity; w++)
+			newBits[w].store(w < wordCount ? Word(w) : 0, std::memory_order_relaxed);
+
+		bits = std::move(newBits);
+		wordCapacity = newCapacity;
+	}
+
+	// Words beyond the end are always clear, so growing
+	// into them later finds no stale marks
+	for (unsigned int w = newWordCount; w < wordCount; w++)
+		bits[w].store(0, std::memory_order_relaxed);
+
+	wordCount = newWordCount;
+	this->slotCount = slotCount;
+
+	// Keep the unused tail bits of the last word clear
+	if (slotCount % 64 != 0)
+		bits[wordCount - 1].fetch_and((1ull << (slotCount % 64)) - 1, std::memory_order_relaxed);
+}
+
+unsigned int DirtyRangeTracker::GetSlotCount() const
+{
+	return slotCount;
+}
+
+unsigned int DirtyRangeTracker::GetDirtyCount() const
+{
+	return dirtyCount.load(std::memory_order_relaxed);
+}
+
+bool DirtyRangeTracker::IsDirty(unsigned int slot) const
+{
+	if (slot >= slotCount) return false;
+	return (Word(slot / 64) >> (slot % 64)) & 1;
+}
+
+// --------------------------------------------------------
+// Safe to call from many threads at once: the bit is set
+// atomically and only whoever actually set it counts it
+// --------------------------------------------------------
+void DirtyRangeTracker::MarkDirty(unsigned int slot)
+{
+	if (slot >= slotCount) return;
+
+	uint64_t mask = 1ull << (slot % 64);
+	std::atomic<uint64_t>& word = bits[slot / 64];
+
+	// Cheap check first, so re-marking a dirty slot doesn't
+	// bounce the cache line between threads
+	if (word.load(std::memory_order_relaxed) & mask)
+		return;
+
+	if (!(word.fetch_or(mask, std::memory_order_relaxed) & mask))
+		dirtyCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void DirtyRangeTracker::MarkRangeDirty(unsigned int begin, unsigned int end)
+{
+	if (end > slotCount) end = slotCount;
+	for (unsigned int s = begin; s < end; s++)
+		MarkDirty(s);
+}
+
+void DirtyRangeTracker::MarkAllDirty()
+{
+	MarkRangeDirty(0, slotCount);
+}
+
+void DirtyRangeTracker::Clear()
+{
+	for (unsigned int w = 0; w < wordCount; w++)
+		bits[w].store(0, std::memory_order_relaxed);
+	dirtyCount = 0;
+}
+
+uint64_t DirtyRangeTracker::Word(unsigned int index) const
+{
+	return bits[index].load(std::memory_order_relaxed);
+}
+
+// --------------------------------------------------------
+// Walks the bit set and emits [begin, end) ranges of dirty
+// slots.  Fully clean words are skipped in one step, and
+// runs inside a word are found by scanning set/clear bits.
+//
+// outRanges - Cleared and filled with the resulting ranges
+// maxGap    - Largest run of clean slots that will be
+//             swallowed to join two neighbouring ranges
+// --------------------------------------------------------
+void DirtyRangeTracker::Coalesce(std::vector<DirtyRange>& outRanges, unsigned int maxGap) const
+{
+	outRanges.clear();
+	if (dirtyCount == 0)
+		return;
+
+	unsigned int slot = 0;
+	while (slot < slotCount)
+	{
+		// Skip whole clean words at once
+		uint64_t word = Word(slot / 64) >> (slot % 64);
+		if (word == 0)
+		{
+			slot = (slot / 64 + 1) * 64;
+			continue;
+		}
+
+		// Find the start of the next dirty run
+		while (!IsDirty(slot))
+			slot++;
+		unsigned int begin = slot;
+
+		// And its end
+		while (slot < slotCount && IsDirty(slot))
+			slot++;
+		unsigned int end = slot;
+
+		// Either extend the previous range or start a new one
+		if (!outRanges.empty() && begin - outRanges.back().end <= maxGap)
+			outRanges.back().end = end;
+		else
+			outRanges.push_back({ begin, end });
+	}
+}
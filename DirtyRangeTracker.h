@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <atomic>
+#include <memory>
+
+// A half-open range of slots [begin, end) that needs uploading
+struct DirtyRange
+{
+	unsigned int begin;
+	unsigned int end;
+};
+
+// --------------------------------------------------------
+// Tracks which slots of a persistent array have changed
+// since the last upload, and turns them into as few
+// contiguous ranges as possible.
+//
+// - No graphics API calls happen here, so the tracker
+//   can be exercised without a device
+// - Marking is O(1); coalescing is linear in the number
+//   of 64-slot words, skipping clean words quickly
+// - MarkDirty() may be called from several threads at
+//   once (transforms update on job workers); everything
+//   else is for one thread at a time
+// --------------------------------------------------------
+class DirtyRangeTracker
+{
+public:
+	DirtyRangeTracker() = default;
+	explicit DirtyRangeTracker(unsigned int slotCount);
+
+	void Resize(unsigned int slotCount);
+	unsigned int GetSlotCount() const;
+	unsigned int GetDirtyCount() const;
+	bool IsDirty(unsigned int slot) const;
+
+	void MarkDirty(unsigned int slot);
+	void MarkRangeDirty(unsigned int begin, unsigned int end);
+	void MarkAllDirty();
+	void Clear();
+
+	// Builds the list of dirty ranges.  Ranges separated by
+	// at most maxGap clean slots are merged into one, trading
+	// a few redundant bytes for fewer upload calls.
+	void Coalesce(std::vector<DirtyRange>& outRanges, unsigned int maxGap = 0) const;
+
+private:
+	uint64_t Word(unsigned int index) const;
+
+	std::unique_ptr<std::atomic<uint64_t>[]> bits;
+	unsigned int wordCount = 0;
+	unsigned int wordCapacity = 0;	// Words allocated; those past wordCount are clear
+	unsigned int slotCount = 0;
+	std::atomic<unsigned int> dirtyCount{ 0 };
+};
@@ -0,0 +1,234 @@
+#include "FileWatcher.h"
+
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+
+// Annonymous namespace to hold helpers
+// only accessible in this file
+namespace
+{
+	// Fewer than MAXIMUM_WAIT_OBJECTS, with room to spare
+	const size_t maxDirectories = 60;
+
+	void AddChange(std::vector<FileWatcher::Change>& changes, const std::wstring& path, Clock::time_point now)
+	{
+		for (const FileWatcher::Change& c : changes)
+		{
+			if (c.path == path)
+				return;
+		}
+		changes.push_back({ path, now });
+	}
+}
+
+
+std::unique_ptr<FileWatcher> CreateFileWatcher(bool useNotifications)
+{
+	if (useNotifications)
+		return std::make_unique<DirectoryFileWatcher>();
+	return std::make_unique<PollingFileWatcher>();
+}
+
+
+void PollingFileWatcher::Watch(const std::wstring& path)
+{
+	for (const File& f : files)
+	{
+		if (f.path == path)
+			return;
+	}
+
+	File file = { path, {}, 0 };
+	WIN32_FILE_ATTRIBUTE_DATA data = {};
+	if (GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &data))
+	{
+		file.written = data.ftLastWriteTime;
+		file.size = data.nFileSizeLow;
+	}
+	files.push_back(file);
+}
+
+// --------------------------------------------------------
+// A file that's missing right now (mid-save, say) keeps its
+// old stamp, and counts as changed once it's back
+// --------------------------------------------------------
+void PollingFileWatcher::GetChanges(std::vector<Change>& outChanges, unsigned int waitMs)
+{
+	if (waitMs > 0)
+		std::this_thread::sleep_for(std::chrono::milliseconds(waitMs));
+
+	Clock::time_point now = Clock::now();
+	for (File& file : files)
+	{
+		WIN32_FILE_ATTRIBUTE_DATA data = {};
+		if (!GetFileAttributesExW(file.path.c_str(), GetFileExInfoStandard, &data))
+			continue;
+
+		if (CompareFileTime(&data.ftLastWriteTime, &file.written) != 0 || data.nFileSizeLow != file.size)
+		{
+			file.written = data.ftLastWriteTime;
+			file.size = data.nFileSizeLow;
+			AddChange(outChanges, file.path, now);
+		}
+	}
+}
+
+
+DirectoryFileWatcher::~DirectoryFileWatcher()
+{
+	for (auto& directory : directories)
+		Close(*directory);
+}
+
+void DirectoryFileWatcher::Watch(const std::wstring& path)
+{
+	size_t slash = path.find_last_of(L"\\/");
+	std::wstring directoryPath = slash == std::wstring::npos ? L"." : path.substr(0, slash);
+	std::wstring name = slash == std::wstring::npos ? path : path.substr(slash + 1);
+
+	Directory* directory = 0;
+	for (auto& d : directories)
+	{
+		if (_wcsicmp(d->path.c_str(), directoryPath.c_str()) == 0)
+			directory = d.get();
+	}
+
+	if (!directory)
+	{
+		if (directories.size() == maxDirectories)
+		{
+			fallback.Watch(path);
+			return;
+		}
+
+		auto added = std::make_unique<Directory>();
+		added->path = directoryPath;
+		added->overlapped = {};
+		added->handle = CreateFileW(directoryPath.c_str(), FILE_LIST_DIRECTORY,
+			FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, 0, OPEN_EXISTING,
+			FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, 0);
+		added->overlapped.hEvent = CreateEventW(0, TRUE, FALSE, 0);
+
+		if (added->handle == INVALID_HANDLE_VALUE || !added->overlapped.hEvent || !Issue(*added))
+		{
+			Close(*added);
+			fallback.Watch(path);
+			return;
+		}
+
+		directory = added.get();
+		directories.push_back(std::move(added));
+	}
+
+	for (const std::wstring& p : directory->paths)
+	{
+		if (p == path)
+			return;
+	}
+	directory->names.push_back(name);
+	directory->paths.push_back(path);
+}
+
+// --------------------------------------------------------
+// Waits on every directory at once.  Editors tend to save
+// by writing a temporary file and renaming it over the
+// original, so renames count as well as writes.
+// --------------------------------------------------------
+void DirectoryFileWatcher::GetChanges(std::vector<Change>& outChanges, unsigned int waitMs)
+{
+	HANDLE events[maxDirectories] = {};
+	for (size_t d = 0; d < directories.size(); d++)
+		events[d] = directories[d]->overlapped.hEvent;
+
+	if (!directories.empty())
+		WaitForMultipleObjects((DWORD)directories.size(), events, FALSE, waitMs);
+	else if (waitMs > 0)
+		std::this_thread::sleep_for(std::chrono::milliseconds(waitMs));
+
+	Clock::time_point now = Clock::now();
+	for (size_t d = 0; d < directories.size(); )
+	{
+		Directory& directory = *directories[d];
+
+		DWORD bytes = 0;
+		if (!GetOverlappedResult(directory.handle, &directory.overlapped, &bytes, FALSE))
+		{
+			if (GetLastError() == ERROR_IO_INCOMPLETE)
+			{
+				d++;
+				continue;
+			}
+			bytes = 0;
+		}
+
+		// Nothing in the buffer means it overflowed, so any of
+		// them might have changed
+		if (bytes == 0)
+		{
+			for (const std::wstring& path : directory.paths)
+				AddChange(outChanges, path, now);
+		}
+
+		const unsigned char* next = (const unsigned char*)directory.buffer;
+		while (bytes > 0)
+		{
+			const FILE_NOTIFY_INFORMATION* info = (const FILE_NOTIFY_INFORMATION*)next;
+			if (info->Action == FILE_ACTION_MODIFIED || info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_RENAMED_NEW_NAME)
+			{
+				std::wstring name(info->FileName, info->FileNameLength / sizeof(wchar_t));
+				for (size_t n = 0; n < directory.names.size(); n++)
+				{
+					if (_wcsicmp(directory.names[n].c_str(), name.c_str()) == 0)
+						AddChange(outChanges, directory.paths[n], now);
+				}
+			}
+
+			if (info->NextEntryOffset == 0)
+				break;
+			next += info->NextEntryOffset;
+		}
+
+		// Keep listening, or hand the directory's files over to
+		// polling if that stops working
+		ResetEvent(directory.overlapped.hEvent);
+		if (Issue(directory))
+		{
+			d++;
+			continue;
+		}
+
+		for (const std::wstring& path : directory.paths)
+			fallback.Watch(path);
+		Close(directory);
+		directories.erase(directories.begin() + d);
+	}
+
+	if (!fallback.IsEmpty())
+		fallback.GetChanges(outChanges, 0);
+}
+
+bool DirectoryFileWatcher::Issue(Directory& directory)
+{
+	return ReadDirectoryChangesW(directory.handle, directory.buffer, sizeof(directory.buffer), FALSE,
+		FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE,
+		0, &directory.overlapped, 0) != FALSE;
+}
+
+void DirectoryFileWatcher::Close(Directory& directory)
+{
+	if (directory.handle != INVALID_HANDLE_VALUE)
+	{
+		// Let any outstanding read finish before its buffer goes
+		DWORD bytes = 0;
+		CancelIoEx(directory.handle, &directory.overlapped);
+		GetOverlappedResult(directory.handle, &directory.overlapped, &bytes, TRUE);
+		CloseHandle(directory.handle);
+		directory.handle = INVALID_HANDLE_VALUE;
+	}
+	if (directory.overlapped.hEvent)
+	{
+		CloseHandle(directory.overlapped.hEvent);
+		directory.overlapped.hEvent = 0;
+	}
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <Windows.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+
+// --------------------------------------------------------
+// Reports files that have changed on disk
+//
+// - Files are watched one at a time, by the path they'll be
+//   reported under
+// - GetChanges() waits up to waitMs for something to change
+//   and returns whatever has, each file at most once
+// - Not thread safe: one thread watches and waits
+// --------------------------------------------------------
+class FileWatcher
+{
+public:
+	struct Change
+	{
+		std::wstring path;	// As given to Watch()
+		std::chrono::steady_clock::time_point noticed;
+	};
+
+	virtual ~FileWatcher() = default;
+
+	virtual const char* GetName() = 0;
+	virtual void Watch(const std::wstring& path) = 0;
+	virtual void GetChanges(std::vector<Change>& outChanges, unsigned int waitMs) = 0;
+};
+
+// --------------------------------------------------------
+// Compares each file's write time and size every time it's
+// asked.  Works anywhere, including network drives, but
+// only notices a change as often as it's polled.
+// --------------------------------------------------------
+class PollingFileWatcher : public FileWatcher
+{
+public:
+	const char* GetName() override { return "Polling"; }
+	void Watch(const std::wstring& path) override;
+	void GetChanges(std::vector<Change>& outChanges, unsigned int waitMs) override;
+
+	bool IsEmpty() { return files.empty(); }
+
+private:
+	struct File
+	{
+		std::wstring path;
+		FILETIME written;
+		DWORD size;
+	};
+	std::vector<File> files;
+};
+
+// --------------------------------------------------------
+// OS notifications: one ReadDirectoryChangesW() per
+// directory, waited on together, so a save is seen as soon
+// as it happens.  Directories that can't be watched this
+// way (or more than a wait can cover) are polled instead.
+// --------------------------------------------------------
+class DirectoryFileWatcher : public FileWatcher
+{
+public:
+	DirectoryFileWatcher() = default;
+	~DirectoryFileWatcher();
+	DirectoryFileWatcher(const DirectoryFileWatcher&) = delete; // Remove copy constructor
+	DirectoryFileWatcher& operator=(const DirectoryFileWatcher&) = delete; // Remove copy-assignment operator
+
+	const char* GetName() override { return "OS notifications"; }
+	void Watch(const std::wstring& path) override;
+	void GetChanges(std::vector<Change>& outChanges, unsigned int waitMs) override;
+
+private:
+	struct Directory
+	{
+		std::wstring path;
+		HANDLE handle;
+		OVERLAPPED overlapped;
+		std::vector<std::wstring> names;	// Watched files in here
+		std::vector<std::wstring> paths;	// The same files, as given to Watch()
+		DWORD buffer[4096];					// FILE_NOTIFY_INFORMATIONs, DWORD aligned
+	};
+
+	bool Issue(Directory& directory);
+	void Close(Directory& directory);
+
+	std::vector<std::unique_ptr<Directory>> directories;
+	PollingFileWatcher fallback;
+};
+
+// Notifications where possible, polling if asked for
+std::unique_ptr<FileWatcher> CreateFileWatcher(bool useNotifications);
@@ -0,0 +1,61 @@
+#include "FixedTimestep.h"
+#include <cmath>
+
+FixedTimestep::FixedTimestep(float stepsPerSecond, unsigned int maxSteps)
+	: maxSteps(maxSteps)
+{
+	SetRate(stepsPerSecond);
+}
+
+unsigned int FixedTimestep::Advance(float frameSeconds)
+{
+	if (frameSeconds > 0)
+		accumulator += frameSeconds;
+
+	unsigned int steps = 0;
+	while (accumulator >= stepSeconds && steps < maxSteps)
+	{
+		accumulator -= stepSeconds;
+		steps++;
+	}
+
+	// Still a step or more behind?  Let it go, but keep the
+	// fraction so the step phase doesn't jump
+	if (accumulator >= stepSeconds)
+	{
+		float remainder = fmodf(accumulator, stepSeconds);
+		droppedSeconds += accumulator - remainder;
+		accumulator = remainder;
+	}
+
+	return steps;
+}
+
+float FixedTimestep::GetAlpha()
+{
+	return accumulator / stepSeconds;
+}
+
+void FixedTimestep::SetRate(float stepsPerSecond)
+{
+	stepSeconds = 1.0f / (stepsPerSecond > 1.0f ? stepsPerSecond : 1.0f);
+
+	// Never claim to be more than a step past
+	if (accumulator > stepSeconds)
+		accumulator = stepSeconds;
+}
+
+float FixedTimestep::GetRate()
+{
+	return 1.0f / stepSeconds;
+}
+
+float FixedTimestep::GetStepSeconds()
+{
+	return stepSeconds;
+}
+
+double FixedTimestep::GetDroppedSeconds()
+{
+	return droppedSeconds;
+}
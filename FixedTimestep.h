@@ -0,0 +1,39 @@
+#pragma once
+
+// --------------------------------------------------------
+// Turns variable frame times into a whole number of fixed
+// simulation steps
+//
+// - Frame time goes into an accumulator; every full step's
+//   worth that builds up is one step to run
+// - At most maxSteps run per frame.  Anything beyond that
+//   is dropped instead of carried over, so one slow frame
+//   can't snowball into ever slower catch-up frames
+// - What's left over says how far the present lies between
+//   the last two steps, for interpolating when drawing
+// --------------------------------------------------------
+class FixedTimestep
+{
+public:
+	explicit FixedTimestep(float stepsPerSecond = 60.0f, unsigned int maxSteps = 5);
+
+	// Adds a frame's time and returns how many steps to run
+	unsigned int Advance(float frameSeconds);
+
+	// 0 = exactly at the last step, 1 = a whole step past it
+	float GetAlpha();
+
+	void SetRate(float stepsPerSecond);
+	float GetRate();
+	float GetStepSeconds();
+
+	unsigned int maxSteps;
+
+	// Total simulation time thrown away by the step cap
+	double GetDroppedSeconds();
+
+private:
+	float stepSeconds;
+	float accumulator = 0;
+	double droppedSeconds = 0;
+};
@@ -0,0 +1,167 @@
+#include "FramePacing.h"
+
+#include <Windows.h>
+#include <chrono>
+
+// Older SDKs don't have it; older Windows versions reject it
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+namespace FramePacing
+{
+	// Annonymous namespace to hold variables
+	// only accessible in this file
+	namespace
+	{
+		HANDLE timer = 0;
+		Settings settings;
+		Stats stats = {};
+		Clock::time_point frameStart;
+		bool slept = false;
+		unsigned long long drawnFrames = 0;
+		double totalDrawMs = 0;
+
+		double Seconds(Clock::duration d)
+		{
+			return std::chrono::duration<double>(d).count();
+		}
+
+		// Sleeps for up to the given time, waking early for any
+		// new window message.  Returns the time actually slept.
+		double Wait(double seconds)
+		{
+			if (seconds <= 0)
+				return 0;
+
+			Clock::time_point start = Clock::now();
+			if (timer)
+			{
+				// Negative for a time relative to now, in 100ns units
+				LARGE_INTEGER due = {};
+				due.QuadPart = -(LONGLONG)(seconds * 10000000.0);
+				SetWaitableTimer(timer, &due, 0, 0, 0, FALSE);
+
+				DWORD woken = MsgWaitForMultipleObjectsEx(1, &timer, INFINITE, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+				if (woken != WAIT_OBJECT_0)
+					CancelWaitableTimer(timer);
+			}
+			else
+				MsgWaitForMultipleObjectsEx(0, 0, (DWORD)(seconds * 1000.0), QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+
+			return Seconds(Clock::now() - start);
+		}
+	}
+}
+
+
+// --------------------------------------------------------
+// Creates the timer, falling back to a regular resolution
+// one where high resolution isn't supported
+// --------------------------------------------------------
+void FramePacing::Initialize()
+{
+	ShutDown();
+
+	timer = CreateWaitableTimerExW(0, 0, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+	stats.highResolutionTimer = timer != 0;
+	if (!timer)
+		timer = CreateWaitableTimerExW(0, 0, 0, TIMER_ALL_ACCESS);
+
+	frameStart = Clock::now();
+}
+
+void FramePacing::ShutDown()
+{
+	if (timer)
+		CloseHandle(timer);
+	timer = 0;
+}
+
+FramePacing::Settings FramePacing::GetSettings()
+{
+	return settings;
+}
+
+void FramePacing::SetSettings(const Settings& newSettings)
+{
+	settings = newSettings;
+}
+
+void FramePacing::WaitForMessages()
+{
+	Clock::time_point start = Clock::now();
+	MsgWaitForMultipleObjectsEx(0, 0, INFINITE, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+	stats.minimizedSeconds += Seconds(Clock::now() - start);
+}
+
+void FramePacing::BeginFrame()
+{
+	frameStart = Clock::now();
+}
+
+bool FramePacing::ShouldDraw(bool changed)
+{
+	return changed || !settings.enabled || !settings.skipStaticFrames;
+}
+
+// --------------------------------------------------------
+// The slower of the two caps wins when both apply.  A
+// focused window that drew something isn't capped at all,
+// as before (vsync, if on, paces it instead).
+// --------------------------------------------------------
+void FramePacing::EndFrame(bool drawn, double drawMs, bool focused)
+{
+	stats.frames++;
+	if (drawn)
+	{
+		drawnFrames++;
+		totalDrawMs += drawMs;
+	}
+	else
+		stats.skippedDraws++;
+
+	stats.averageDrawMs = drawnFrames > 0 ? totalDrawMs / drawnFrames : 0;
+	stats.savedDrawMs = stats.skippedDraws * stats.averageDrawMs;
+
+	slept = false;
+	if (!settings.enabled)
+		return;
+
+	float rate = 0;
+	if (!focused && settings.unfocusedRate > 0)
+	{
+		rate = settings.unfocusedRate;
+		stats.throttledFrames++;
+	}
+	if (!drawn && settings.idleRate > 0 && (rate == 0 || settings.idleRate < rate))
+		rate = settings.idleRate;
+	if (rate == 0)
+		return;
+
+	double remaining = 1.0 / rate - Seconds(Clock::now() - frameStart);
+	double seconds = Wait(remaining);
+	stats.sleptSeconds += seconds;
+	slept = seconds > 0;
+}
+
+bool FramePacing::SleptLastFrame()
+{
+	return slept;
+}
+
+FramePacing::Stats FramePacing::GetStats()
+{
+	return stats;
+}
+
+void FramePacing::ResetStats()
+{
+	bool highResolution = stats.highResolutionTimer;
+	stats = {};
+	stats.highResolutionTimer = highResolution;
+	drawnFrames = 0;
+	totalDrawMs = 0;
+}
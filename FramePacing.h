@@ -0,0 +1,67 @@
+#pragma once
+
+// --------------------------------------------------------
+// Keeps the main loop from running flat out when there is
+// nothing worth showing
+//
+// - While the window is minimized, no frames run at all;
+//   the loop just waits for its next message
+// - Without focus, frames run at most unfocusedRate times
+//   a second
+// - A frame with nothing new in it (see Game::NeedsDraw())
+//   skips Draw() and the render thread entirely, and the
+//   next one waits for idleRate's tick
+// - Waits are on a high-resolution waitable timer where the
+//   OS has one (Windows 10 1803 on), and a regular one
+//   otherwise, never a busy loop.  Any window message ends
+//   a wait early, so input is never held up by one.
+// - Everything here runs on the main thread
+// --------------------------------------------------------
+namespace FramePacing
+{
+	void Initialize();
+	void ShutDown();
+
+	struct Settings
+	{
+		bool enabled = true;
+		bool skipStaticFrames = true;
+		float unfocusedRate = 20.0f;	// Frames per second without focus
+		float idleRate = 30.0f;			// Frames per second with nothing new to draw
+	};
+	Settings GetSettings();
+	void SetSettings(const Settings& settings);
+
+	// Waits for the window's next message; for while it's
+	// minimized
+	void WaitForMessages();
+
+	// Call at the start of every frame the loop runs
+	void BeginFrame();
+
+	// True if Draw() should run, given whether anything has
+	// changed since the last frame that was drawn
+	bool ShouldDraw(bool changed);
+
+	// Call at the end of every frame, with how long Draw()
+	// took if it ran.  Sleeps until the next frame is due.
+	void EndFrame(bool drawn, double drawMs, bool focused);
+
+	// Whether the most recent frame ended in a sleep, which
+	// makes the next frame time longer on purpose
+	bool SleptLastFrame();
+
+	struct Stats
+	{
+		unsigned long long frames;			// Drawn or not
+		unsigned long long skippedDraws;	// Nothing new to show
+		unsigned long long throttledFrames;	// Capped for lack of focus
+		double sleptSeconds;				// Between frames
+		double minimizedSeconds;
+		double averageDrawMs;				// Over the frames that drew
+		double savedDrawMs;					// Each skipped draw at the average cost
+		bool highResolutionTimer;
+	};
+	Stats GetStats();
+	void ResetStats();
+}
@@ -0,0 +1,68 @@
+#include "FramePacket.h"
+#include "imgui.h"
+
+#include <new>
+#include <cstring>
+
+// Annonymous namespace to hold helpers
+// only accessible in this file
+namespace
+{
+	// Points an ImVector at a copy of another's elements in
+	// packet memory.  The vector must never be destroyed or
+	// grown, since ImGui would try to free that memory.
+	template<typename T>
+	void CopyVector(ImVector<T>& destination, const ImVector<T>& source, LinearAllocator& memory)
+	{
+		T* data = memory.Allocate<T>(source.Size);
+		if (source.Size > 0)
+			memcpy(data, source.Data, sizeof(T) * source.Size);
+
+		destination.Data = data;
+		destination.Size = source.Size;
+		destination.Capacity = source.Size;
+	}
+}
+
+// --------------------------------------------------------
+// Only the parts ImGui_ImplDX11_RenderDrawData() reads are
+// copied: the command, index and vertex buffers of each
+// list.  The copies are never destroyed; resetting the
+// packet's memory is what frees them.
+// --------------------------------------------------------
+void FramePacket::CopyUI(const ImDrawData* source)
+{
+	ui = 0;
+	if (!source || !source->Valid)
+		return;
+
+	ImDrawData* copy = new (memory.Allocate(sizeof(ImDrawData), alignof(ImDrawData))) ImDrawData();
+	copy->Valid = true;
+	copy->CmdListsCount = source->CmdListsCount;
+	copy->TotalIdxCount = source->TotalIdxCount;
+	copy->TotalVtxCount = source->TotalVtxCount;
+	copy->DisplayPos = source->DisplayPos;
+	copy->DisplaySize = source->DisplaySize;
+	copy->FramebufferScale = source->FramebufferScale;
+	copy->OwnerViewport = source->OwnerViewport;
+
+	ImDrawList** lists = memory.Allocate<ImDrawList*>(source->CmdListsCount);
+	for (int i = 0; i < source->CmdListsCount; i++)
+	{
+		const ImDrawList* list = source->CmdLists[i];
+
+		ImDrawList* listCopy = new (memory.Allocate(sizeof(ImDrawList), alignof(ImDrawList))) ImDrawList(0);
+		CopyVector(listCopy->CmdBuffer, list->CmdBuffer, memory);
+		CopyVector(listCopy->IdxBuffer, list->IdxBuffer, memory);
+		CopyVector(listCopy->VtxBuffer, list->VtxBuffer, memory);
+		listCopy->Flags = list->Flags;
+
+		lists[i] = listCopy;
+	}
+
+	copy->CmdLists.Data = lists;
+	copy->CmdLists.Size = source->CmdListsCount;
+	copy->CmdLists.Capacity = source->CmdListsCount;
+
+	ui = copy;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <chrono>
+#include "BufferStructs.h"
+#include "InstanceBuffer.h"
+#include "LightGrid.h"
+#include "CommandBackend.h"
+#include "LinearAllocator.h"
+
+struct ImDrawData;
+
+// --------------------------------------------------------
+// Everything the render thread needs for one frame.  The
+// simulation fills it in and never touches it again once
+// submitted, so the two sides share nothing else.
+//
+// - Every array lives in the packet's own allocator, which
+//   is reset when the packet comes back around for reuse
+// - Pointers to meshes' buffers are fine since meshes live
+//   for the whole program
+// --------------------------------------------------------
+struct FramePacket
+{
+	unsigned long long frameIndex = 0;
+
+	// When the simulation began this frame, i.e. when its input was read
+	std::chrono::steady_clock::time_point simulationStart;
+
+	float clearColor[4] = {};
+
+	// One camera's share of the frame: its own viewport,
+	// constants and draw list, over the shared instance data
+	static const unsigned int MaxViews = 4;
+	struct ViewPacket
+	{
+		VertexShaderData camera;
+		float viewport[4];			// Left, top, width, height in pixels
+
+		// PipelineCache id of the shaders and states to draw with
+		unsigned int pipeline;
+
+		const DrawItem* draws;
+		unsigned int drawCount;
+	};
+	ViewPacket views[MaxViews] = {};
+	unsigned int viewCount = 0;
+
+	// Depth first, with prepassPipeline, then each view's
+	// pipeline only shades what ended up nearest
+	bool depthPrepass = false;
+	unsigned int prepassPipeline = 0;
+	InstanceUpdate instances = {};
+
+	// Lights and their clusters, for the CLUSTERED_LIGHTS shaders
+	LightUpdate lights = {};
+
+	// A deep copy of ImGui's draw data, or null
+	ImDrawData* ui = 0;
+
+	LinearAllocator memory;
+
+	// Copies ImGui's draw lists into this packet's memory,
+	// since ImGui reuses its own as soon as the next frame starts
+	void CopyUI(const ImDrawData* source);
+};
@@ -0,0 +1,143 @@
+#include "FrameStats.h"
+
+#include <algorithm>
+
+// Annonymous namespace to hold variables
+// only accessible in this file
+namespace
+{
+	// 0.1 ms buckets up to 100 ms, plus one for slower frames
+	const unsigned int bucketCount = 1001;
+}
+
+FrameStats::FrameStats(unsigned int windowSize)
+	: history(windowSize > 0 ? windowSize : 1, 0.0f),
+	buckets(bucketCount, 0)
+{
+}
+
+unsigned int FrameStats::BucketFor(float milliseconds)
+{
+	if (milliseconds <= 0)
+		return 0;
+
+	float bucket = milliseconds / BucketMilliseconds;
+	return bucket >= (float)(bucketCount - 1) ? bucketCount - 1 : (unsigned int)bucket;
+}
+
+// --------------------------------------------------------
+// Judges the frame against the window as it was, then adds
+// it, pushing out the oldest frame once the window is full
+// --------------------------------------------------------
+bool FrameStats::AddFrame(float milliseconds)
+{
+	bool hitch = count >= minimumFrames && milliseconds > GetPercentile(50.0f) * hitchMultiple;
+	if (hitch)
+	{
+		hitchCount++;
+		lastHitch = milliseconds;
+	}
+
+	if (count == history.size())
+	{
+		float oldest = history[next];
+		buckets[BucketFor(oldest)]--;
+		total -= oldest;
+	}
+	else
+	{
+		count++;
+	}
+
+	history[next] = milliseconds;
+	buckets[BucketFor(milliseconds)]++;
+	total += milliseconds;
+	next = (next + 1) % (unsigned int)history.size();
+
+	return hitch;
+}
+
+// --------------------------------------------------------
+// Walks the histogram to the bucket holding the requested
+// rank and interpolates within it
+// --------------------------------------------------------
+float FrameStats::GetPercentile(float percentile)
+{
+	if (count == 0)
+		return 0;
+
+	if (percentile <= 0)
+		percentile = 0;
+	if (percentile >= 100.0f)
+		return GetMax();
+
+	float rank = percentile / 100.0f * count;
+	unsigned int below = 0;
+	for (unsigned int b = 0; b < bucketCount - 1; b++)
+	{
+		if (buckets[b] > 0 && below + buckets[b] >= rank)
+		{
+			float within = (rank - below) / buckets[b];
+			return (b + within) * BucketMilliseconds;
+		}
+		below += buckets[b];
+	}
+	return GetMax();
+}
+
+float FrameStats::GetMax()
+{
+	float max = 0;
+	for (unsigned int i = 0; i < count; i++)
+	{
+		if (history[i] > max)
+			max = history[i];
+	}
+	return max;
+}
+
+float FrameStats::GetAverage()
+{
+	return count > 0 ? (float)(total / count) : 0.0f;
+}
+
+unsigned int FrameStats::GetCount()
+{
+	return count;
+}
+
+const std::vector<float>& FrameStats::GetHistory()
+{
+	return history;
+}
+
+unsigned int FrameStats::GetHistoryOffset()
+{
+	return count == history.size() ? next : 0;
+}
+
+const std::vector<unsigned int>& FrameStats::GetBuckets()
+{
+	return buckets;
+}
+
+void FrameStats::Reset()
+{
+	std::fill(history.begin(), history.end(), 0.0f);
+	std::fill(buckets.begin(), buckets.end(), 0u);
+	next = 0;
+	count = 0;
+	total = 0;
+	hitchCount = 0;
+	lastHitch = 0;
+}
+
+unsigned int FrameStats::GetHitchCount()
+{
+	return hitchCount;
+}
+
+float FrameStats::GetLastHitchMilliseconds()
+{
+	return lastHitch;
+}
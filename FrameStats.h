@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vector>
+
+// --------------------------------------------------------
+// Rolling frame-time statistics
+//
+// - Keeps the last windowSize frame times, both in order
+//   (for graphing) and as a histogram, so percentiles cost
+//   one pass over the buckets rather than a sort
+// - Percentiles are exact to within one bucket (0.1 ms);
+//   anything past the last bucket reports the window's max
+// - A frame is a hitch when it takes more than hitchMultiple
+//   times the median of the frames before it
+// - No Windows or DirectX headers are used, so this builds
+//   on any platform
+// --------------------------------------------------------
+class FrameStats
+{
+public:
+	explicit FrameStats(unsigned int windowSize = 1024);
+
+	// Returns true if the frame was a hitch
+	bool AddFrame(float milliseconds);
+
+	// percentile is 0 - 100
+	float GetPercentile(float percentile);
+	float GetMax();
+	float GetAverage();
+	unsigned int GetCount();
+
+	// Frame times oldest first, starting at GetHistoryOffset()
+	// and wrapping around (as ImGui::PlotLines() expects)
+	const std::vector<float>& GetHistory();
+	unsigned int GetHistoryOffset();
+
+	const std::vector<unsigned int>& GetBuckets();
+	static constexpr float BucketMilliseconds = 0.1f;
+
+	void Reset();
+
+	// Hitch detection, off until the window has minimumFrames
+	float hitchMultiple = 2.0f;
+	unsigned int minimumFrames = 30;
+
+	unsigned int GetHitchCount();
+	float GetLastHitchMilliseconds();
+
+private:
+	unsigned int BucketFor(float milliseconds);
+
+	std::vector<float> history;
+	unsigned int next = 0;		// Where the next frame goes
+	unsigned int count = 0;
+	double total = 0;
+
+	// The last bucket catches everything too slow for the rest
+	std::vector<unsigned int> buckets;
+
+	unsigned int hitchCount = 0;
+	float lastHitch = 0;
+};
@@ -0,0 +1,101 @@
+#include "Frustum.h"
+
+#include <emmintrin.h>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Pulls the planes straight out of view * projection
+// (Gribb & Hartmann).  With row vectors, clip = v * M, so
+// each plane is a sum or difference of M's columns.
+// --------------------------------------------------------
+void Frustum::Build(const XMFLOAT4X4& m)
+{
+	XMFLOAT4 c0(m._11, m._21, m._31, m._41);
+	XMFLOAT4 c1(m._12, m._22, m._32, m._42);
+	XMFLOAT4 c2(m._13, m._23, m._33, m._43);
+	XMFLOAT4 c3(m._14, m._24, m._34, m._44);
+
+	planes[0] = XMFLOAT4(c3.x + c0.x, c3.y + c0.y, c3.z + c0.z, c3.w + c0.w); // Left
+	planes[1] = XMFLOAT4(c3.x - c0.x, c3.y - c0.y, c3.z - c0.z, c3.w - c0.w); // Right
+	planes[2] = XMFLOAT4(c3.x + c1.x, c3.y + c1.y, c3.z + c1.z, c3.w + c1.w); // Bottom
+	planes[3] = XMFLOAT4(c3.x - c1.x, c3.y - c1.y, c3.z - c1.z, c3.w - c1.w); // Top
+	planes[4] = c2;                                                           // Near (D3D depth starts at 0)
+	planes[5] = XMFLOAT4(c3.x - c2.x, c3.y - c2.y, c3.z - c2.z, c3.w - c2.w); // Far
+}
+
+// --------------------------------------------------------
+// A box is out only if it is entirely behind one plane;
+// testing the corner furthest along each plane's normal
+// is enough to know
+// --------------------------------------------------------
+bool Frustum::Intersects(const Bounds& bounds) const
+{
+	for (int i = 0; i < 6; i++)
+	{
+		const XMFLOAT4& p = planes[i];
+		float x = p.x >= 0.0f ? bounds.max.x : bounds.min.x;
+		float y = p.y >= 0.0f ? bounds.max.y : bounds.min.y;
+		float z = p.z >= 0.0f ? bounds.max.z : bounds.min.z;
+		if (p.x * x + p.y * y + p.z * z + p.w < 0.0f)
+			return false;
+	}
+	return true;
+}
+
+// --------------------------------------------------------
+// Transposes the frustums' planes into lanes
+// --------------------------------------------------------
+void FrustumSet::Build(const Frustum* frustums, unsigned int count)
+{
+	this->count = count < MaxFrustums ? count : MaxFrustums;
+
+	for (int i = 0; i < 6; i++)
+	{
+		float* lanes[4] = { &a[i].x, &b[i].x, &c[i].x, &d[i].x };
+		for (unsigned int f = 0; f < MaxFrustums; f++)
+		{
+			// 0x + 0y + 0z - 1 < 0 everywhere
+			XMFLOAT4 p = f < this->count ? frustums[f].planes[i] : XMFLOAT4(0, 0, 0, -1);
+			lanes[0][f] = p.x;
+			lanes[1][f] = p.y;
+			lanes[2][f] = p.z;
+			lanes[3][f] = p.w;
+		}
+	}
+}
+
+// --------------------------------------------------------
+// The same test as Frustum::Intersects(), written with the
+// box's center and half extents: the corner furthest along
+// a plane's normal is center + |normal| . extent away
+// --------------------------------------------------------
+unsigned int FrustumSet::Intersects(const Bounds& bounds) const
+{
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 signBits = _mm_set1_ps(-0.0f);
+
+	__m128 cx = _mm_set1_ps((bounds.min.x + bounds.max.x) * 0.5f);
+	__m128 cy = _mm_set1_ps((bounds.min.y + bounds.max.y) * 0.5f);
+	__m128 cz = _mm_set1_ps((bounds.min.z + bounds.max.z) * 0.5f);
+	__m128 ex = _mm_mul_ps(_mm_set1_ps(bounds.max.x - bounds.min.x), half);
+	__m128 ey = _mm_mul_ps(_mm_set1_ps(bounds.max.y - bounds.min.y), half);
+	__m128 ez = _mm_mul_ps(_mm_set1_ps(bounds.max.z - bounds.min.z), half);
+
+	__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+	for (int i = 0; i < 6; i++)
+	{
+		__m128 pa = _mm_loadu_ps(&a[i].x);
+		__m128 pb = _mm_loadu_ps(&b[i].x);
+		__m128 pc = _mm_loadu_ps(&c[i].x);
+
+		__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(pa, cx), _mm_mul_ps(pb, cy)), _mm_add_ps(_mm_mul_ps(pc, cz), _mm_loadu_ps(&d[i].x)));
+		__m128 reach = _mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(_mm_andnot_ps(signBits, pa), ex),
+			_mm_mul_ps(_mm_andnot_ps(signBits, pb), ey)),
+			_mm_mul_ps(_mm_andnot_ps(signBits, pc), ez));
+
+		inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, reach), _mm_setzero_ps()));
+	}
+	return (unsigned int)_mm_movemask_ps(inside);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include "Bounds.h"
+
+// --------------------------------------------------------
+// The six planes of a camera's view volume, for culling
+// bounds that can't possibly be on screen
+// --------------------------------------------------------
+struct Frustum
+{
+	// (a, b, c, d) with ax + by + cz + d >= 0 inside
+	DirectX::XMFLOAT4 planes[6];
+
+	void Build(const DirectX::XMFLOAT4X4& viewProjection);
+	bool Intersects(const Bounds& bounds) const;
+};
+
+// --------------------------------------------------------
+// Up to four frustums tested together: each of an SSE
+// register's lanes holds the same plane of a different
+// frustum, so one box is tested against all of them in
+// the time it takes to test one
+// --------------------------------------------------------
+struct FrustumSet
+{
+	static const unsigned int MaxFrustums = 4;
+
+	// Plane i of frustum f is (a[i], b[i], c[i], d[i]) in
+	// lane f.  Unused lanes hold planes nothing is inside.
+	DirectX::XMFLOAT4 a[6];
+	DirectX::XMFLOAT4 b[6];
+	DirectX::XMFLOAT4 c[6];
+	DirectX::XMFLOAT4 d[6];
+	unsigned int count;
+
+	void Build(const Frustum* frustums, unsigned int count);
+
+	// Bit f is set if the box touches frustum f; zero means
+	// it is outside all of them
+	unsigned int Intersects(const Bounds& bounds) const;
+};
\ No newline at end of file
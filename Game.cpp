@@ -4,17 +4,18 @@
 #include "Input.h"
 #include "PathHelpers.h"
 #include "Window.h"
-#include "Mesh.h"
 #include "imgui.h"
 #include "imgui_impl_dx11.h"
 #include "imgui_impl_win32.h"
-#include <string>
+#include <chrono>
 #include <DirectXMath.h>
 #include "BufferStructs.h"
-
-// Needed for a helper function to load pre-compiled shader files
-#pragma comment(lib, "d3dcompiler.lib")
-#include <d3dcompiler.h>
+#include "Systems.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "AllocationTracker.h"
+#include "HotReload.h"
+#include "FramePacing.h"
 
 // For the DirectX Math library
 using namespace DirectX;
@@ -25,36 +26,44 @@ using namespace DirectX;
 // --------------------------------------------------------
 void Game::Initialize()
 {
+	// Worker threads for the per-frame systems (the render
+	// thread joins in too), and a deferred context for each
+	// of them to record draws into
+	JobSystem::SetAttachedThreadCount(1);
+	JobSystem::Initialize();
+	commandBackend.Initialize(JobSystem::GetThreadCount());
+	backend = &commandBackend;
+
 	// Helper methods for loading shaders, creating some basic
 	// geometry to draw and some simple camera matrices.
 	//  - You'll be expanding and/or replacing these later
 	LoadShaders();
-	CreateGeometry();
 
-	// Set initial graphics API state
-	//  - These settings persist until we change them
-	//  - Some of these, like the primitive topology & input layout, probably won't change
-	//  - Others, like setting shaders, will need to be moved elsewhere later
+	// Shaders are rebuilt in the background whenever their
+	// sources change on disk, and swapped in by Render()
 	{
-		// Tell the input assembler (IA) stage of the pipeline what kind of
-		// geometric primitives (points, lines or triangles) we want to draw.  
-		// Essentially: "What kind of shape should the GPU draw with our vertices?"
-		Graphics::Context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-
-		// Ensure the pipeline knows how to interpret all the numbers stored in
-		// the vertex buffer. For this course, all of your vertices will probably
-		// have the same layout, so we can just set this once at startup.
-		Graphics::Context->IASetInputLayout(inputLayout.Get());
-
-		// Set the active vertex and pixel shaders
-		//  - Once you start applying different shaders to different objects,
-		//    these calls will need to happen multiple times per frame
-		Graphics::Context->VSSetShader(vertexShader.Get(), 0, 0);
-		Graphics::Context->PSSetShader(pixelShader.Get(), 0, 0);
-
+		HotReload::Initialize(true);
+
+		std::vector<std::wstring> sources;
+		shaderCache.GetSourcePaths(sources);
+		for (const std::wstring& path : sources)
+		{
+			HotReload::Watch(path, [](void* cache, const FileWatcher::Change& change)
+				{ return ((ShaderCache*)cache)->Rebuild(change.path, change.noticed); }, &shaderCache);
+		}
 	}
 
-	//Creating the CONSTANT BUFFER
+	// Geometry, lights, cameras and ImGui's context
+	InitializeCore();
+
+	// Initial graphics API state
+	//  - The primitive topology, input layout, shaders and fixed-function
+	//    states all come from one pipeline, bound each frame in Render(),
+	//    since the inspector can switch to another one
+	//  - Triangle lists are the PipelineDesc default: "What kind of shape
+	//    should the GPU draw with our vertices?"
+
+	//Creating the CONSTANT BUFFERS, one per view
 	{
 		unsigned int size = sizeof(VertexShaderData);
 		size = (size + 15) / 16 * 16;
@@ -65,127 +74,64 @@ void Game::Initialize()
 		cbDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
 		cbDesc.Usage = D3D11_USAGE_DYNAMIC;
 
-		Graphics::Device->CreateBuffer(&cbDesc, 0, vsConstantBuffer.GetAddressOf());
+		for (unsigned int v = 0; v < FramePacket::MaxViews; v++)
+		{
+			Graphics::Device->CreateBuffer(&cbDesc, 0, vsConstantBuffers[v].GetAddressOf());
+			Graphics::TrackBufferMemory(vsConstantBuffers[v].Get(), "Render");
+		}
+	}
 
-		vsData.colorTint = XMFLOAT4(1.0f, 0.5f, 0.5f, 1.0f);
-		//vsData.offset = XMFLOAT3(0.25f, 0.0f, 0.0f);
+	// ImGui's platform/renderer backends
+	{
+		ALLOCATION_SCOPE("UI");
+		ImGui_ImplWin32_Init(Window::Handle());
+		ImGui_ImplDX11_Init(Graphics::Device.Get(), Graphics::Context.Get());
 	}
 
-	cameraList.push_back(std::make_shared<Camera>((float)Window::Width() / Window::Height(), 
-		XMFLOAT3(0.0f, 0.0f, -5.0f), 
-		XMFLOAT3(0.0f, 0.0f, 0.0f), 
-		5.0f, 1.0f, 
-		XM_PIDIV4, 
-		0.001f, 
-		1000.0f, 
-		false));
-
-	cameraList.push_back(std::make_shared<Camera>((float)Window::Width() / Window::Height(),
-		XMFLOAT3(3.0f, 6.0f, -5.0f),
-		XMFLOAT3(9.0f, 1.0f, 0.0f),
-		5.0f, 1.0f,
-		XM_PIDIV2,
-		0.001f,
-		1000.0f,
-		false));
-
-	cameraList.push_back(std::make_shared<Camera>((float)Window::Width() / Window::Height(),
-		XMFLOAT3(1.0f, 2.0f, -5.0f),
-		XMFLOAT3(5.0f, -2.0f, 0.0f),
-		5.0f, 1.0f,
-		XM_PIDIV4,
-		0.001f,
-		1000.0f,
-		false));
-
-	cameraList.push_back(std::make_shared<Camera>((float)Window::Width() / Window::Height(),
-		XMFLOAT3(-1.0f, 4.0f, -5.0f),
-		XMFLOAT3(-2.0f, -1.0f, 0.0f),
-		5.0f, 1.0f,
-		XM_PIDIV2,
-		0.001f,
-		1000.0f,
-		false));
-
-	camera = cameraList[activeCamera];
-
-	// Initializing ImGui itself and platform/renderer backends
-	IMGUI_CHECKVERSION();
-	ImGui::CreateContext();
-	ImGui_ImplWin32_Init(Window::Handle());
-	ImGui_ImplDX11_Init(Graphics::Device.Get(), Graphics::Context.Get());
-
-	// ImGui Style
-	ImGui::StyleColorsDark();
+	// Everything is set up, so the immediate context can be
+	// handed over to the render thread
+	StartRenderThread();
 }
 
 
 // --------------------------------------------------------
 // Clean up memory or objects created by this class
-// 
-// Note: Using smart pointers means there probably won't
-//       be much to manually clean up here!
+// - GameCore cleans up after itself once this is done
 // --------------------------------------------------------
 Game::~Game()
 {
+	// Finish whatever is queued before anything goes away
+	RenderThread::ShutDown();
+	HotReload::ShutDown();
+
 	// ImGui clean ups
 	ImGui_ImplDX11_Shutdown();
 	ImGui_ImplWin32_Shutdown();
-	ImGui::DestroyContext();
-
 }
 
 
 // --------------------------------------------------------
-// Loads shaders from compiled shader object (.cso) files
-// and also created the Input Layout that describes our 
-// vertex data to the rendering pipeline. 
-// - Input Layout creation is done here because it must 
-//    be verified against vertex shader byte code
-// - We'll have that byte code already loaded below
+// Sets up the shader cache and gets the current permutation
+// of each shader from it, which loads or compiles them and
+// creates the Input Layout that describes our vertex data
+// to the rendering pipeline.
+// - Input Layout creation is done by the cache because it
+//    must be verified against vertex shader byte code
 // --------------------------------------------------------
 void Game::LoadShaders()
 {
-	// BLOBs (or Binary Large OBjects) for reading raw data from external files
-	// - This is a simplified way of handling big chunks of external data
-	// - Literally just a big array of bytes read from a file
-	ID3DBlob* pixelShaderBlob;
-	ID3DBlob* vertexShaderBlob;
-
 	// Loading shaders
 	//  - Visual Studio will compile our shaders at build time
 	//  - They are saved as .cso (Compiled Shader Object) files
-	//  - We need to load them when the application starts
-	{
-		// Read our compiled shader code files into blobs
-		// - Essentially just "open the file and plop its contents here"
-		// - Uses the custom FixPath() helper from Helpers.h to ensure relative paths
-		// - Note the "L" before the string - this tells the compiler the string uses wide characters
-		D3DReadFileToBlob(FixPath(L"PixelShader.cso").c_str(), &pixelShaderBlob);
-		D3DReadFileToBlob(FixPath(L"VertexShader.cso").c_str(), &vertexShaderBlob);
-
-		// Create the actual Direct3D shaders on the GPU
-		Graphics::Device->CreatePixelShader(
-			pixelShaderBlob->GetBufferPointer(),	// Pointer to blob's contents
-			pixelShaderBlob->GetBufferSize(),		// How big is that data?
-			0,										// No classes in this shader
-			pixelShader.GetAddressOf());			// Address of the ID3D11PixelShader pointer
-
-		Graphics::Device->CreateVertexShader(
-			vertexShaderBlob->GetBufferPointer(),	// Get a pointer to the blob's contents
-			vertexShaderBlob->GetBufferSize(),		// How big is that data?
-			0,										// No classes in this shader
-			vertexShader.GetAddressOf());			// The address of the ID3D11VertexShader pointer
-	}
+	//  - Other permutations are compiled from the .hlsl and
+	//    kept in the cache directory for next time
+	shaderCache.Initialize(FixPath(L"ShaderCache"));
 
-	// Create an input layout 
+	// Describe the input layout
 	//  - This describes the layout of data sent to a vertex shader
 	//  - In other words, it describes how to interpret data (numbers) in a vertex buffer
-	//  - Doing this NOW because it requires a vertex shader's byte code to verify against!
-	//  - Luckily, we already have that loaded (the vertex shader blob above)
+	//  - It's a member, since every vertex shader permutation makes its own layout from it
 	{
-		D3D11_INPUT_ELEMENT_DESC inputElements[2] = {};
-
 		// Set up the first element - a position, which is 3 float values
 		inputElements[0].Format = DXGI_FORMAT_R32G32B32_FLOAT;				// Most formats are described as color channels; really it just means "Three 32-bit floats"
 		inputElements[0].SemanticName = "POSITION";							// This is "POSITION" - needs to match the semantics in our vertex shader input!
@@ -196,328 +142,442 @@ void Game::LoadShaders()
 		inputElements[1].SemanticName = "COLOR";							// Match our vertex shader input!
 		inputElements[1].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;	// After the previous element
 
-		// Create the input layout, verifying our description against actual shader code
-		Graphics::Device->CreateInputLayout(
-			inputElements,							// An array of descriptions
-			2,										// How many elements in that array?
-			vertexShaderBlob->GetBufferPointer(),	// Pointer to the code of a shader that uses this layout
-			vertexShaderBlob->GetBufferSize(),		// Size of the shader code that uses this layout
-			inputLayout.GetAddressOf());			// Address of the resulting ID3D11InputLayout pointer
+		// Set up the third element - the draw id, which comes from its own per-instance stream
+		inputElements[2].Format = DXGI_FORMAT_R32_UINT;						// A single 32-bit unsigned int
+		inputElements[2].SemanticName = "INSTANCEINDEX";					// Match our vertex shader input!
+		inputElements[2].InputSlot = 1;										// Lives in vertex buffer slot 1
+		inputElements[2].AlignedByteOffset = 0;								// Only element in that stream
+		inputElements[2].InputSlotClass = D3D11_INPUT_PER_INSTANCE_DATA;	// Advances per instance, not per vertex
+		inputElements[2].InstanceDataStepRate = 1;
+
+		// The depth prepass reads each mesh's position-only buffer
+		// instead, so it's just the position and the draw id
+		depthInputElements[0] = inputElements[0];
+		depthInputElements[1] = inputElements[2];
 	}
-}
 
+	pipelineCache.Initialize(&shaderCache);
+
+	// Depth prepass: positions in, no pixel shader, depth out
+	// - Left unset if the DEPTH_ONLY permutation can't be built,
+	//   which just means no prepass
+	{
+		PipelineDesc desc;
+		desc.vertexShader = shaderCache.GetVertexShader("VertexShader.hlsl", ShaderFeatureDepthOnly, depthInputElements, 2);
+		if (desc.vertexShader != InvalidShader)
+			prepassPipelineId = pipelineCache.GetPipeline(desc);
+	}
+
+	// Lit if the CLUSTERED_LIGHTS permutation builds, and
+	// plain vertex colors otherwise
+	SelectPipeline(shaderFeatures, wireframe);
+	if (pipelineId == InvalidPipeline)
+		SelectPipeline(0, wireframe);
+}
 
 // --------------------------------------------------------
-// Creates the geometry we're going to draw
+// Switches to another shader permutation and fill mode,
+// keeping the current pipeline if the new one can't be
+// built.  Both caches make switching back free.
 // --------------------------------------------------------
-void Game::CreateGeometry()
+void Game::SelectPipeline(uint32_t features, bool wireframeFill)
 {
-	// Create some temporary variables to represent colors
-	// - Not necessary, just makes things more readable
-	XMFLOAT4 red = XMFLOAT4(1.0f, 0.0f, 0.0f, 1.0f);
-	XMFLOAT4 green = XMFLOAT4(0.0f, 1.0f, 0.0f, 1.0f);
-	XMFLOAT4 blue = XMFLOAT4(0.0f, 0.0f, 1.0f, 1.0f);
-	XMFLOAT4 black = XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
-	XMFLOAT4 purple = XMFLOAT4(0.5f, 0.0f, 1.0f, 1.0f);
-
-	// Set up the vertices of the triangle we would like to draw
-	// - We're going to copy this array, exactly as it exists in CPU memory
-	//    over to a Direct3D-controlled data structure on the GPU (the vertex buffer)
-	// - Note: Since we don't have a camera or really any concept of
-	//    a "3d world" yet, we're simply describing positions within the
-	//    bounds of how the rasterizer sees our screen: [-1 to +1] on X and Y
-	// - This means (0,0) is at the very center of the screen.
-	// - These are known as "Normalized Device Coordinates" or "Homogeneous 
-	//    Screen Coords", which are ways to describe a position without
-	//    knowing the exact size (in pixels) of the image/window/etc.  
-	// - Long story short: Resizing the window also resizes the triangle,
-	//    since we're describing the triangle in terms of the window itself
-	Vertex vertices1[] =
+	PipelineDesc desc;
+	desc.vertexShader = shaderCache.GetVertexShader("VertexShader.hlsl", features, inputElements, 3);
+	desc.pixelShader = shaderCache.GetPixelShader("PixelShader.hlsl", features);
+	if (desc.vertexShader == InvalidShader || desc.pixelShader == InvalidShader)
+		return;
+
+	if (wireframeFill)
 	{
-		{ XMFLOAT3(+0.0f, +0.3f, +0.0f), red },
-		{ XMFLOAT3(+0.3f, -0.3f, +0.0f), blue },
-		{ XMFLOAT3(-0.3f, -0.3f, +0.0f), green },
-	};
-
-	// Set up indices, which tell us which vertices to use and in which order
-	// - This is redundant for just 3 vertices, but will be more useful later
-	// - Indices are technically not required if the vertices are in the buffer 
-	//    in the correct order and each one will be used exactly once
-	// - But just to see how it's done...
-	unsigned int indices1[] = { 0, 1, 2 };
-
-	Vertex vertices2[] = {
-		{ XMFLOAT3(-0.80f, +0.80f, +0.0f), purple },
-		{ XMFLOAT3(-0.80f, +0.40f, +0.0f), purple },
-		{ XMFLOAT3(-0.40f, +0.40f, +0.0f), green },
-		{ XMFLOAT3(-0.40f, +0.80f, +0.0f), green },
-	};
-
-	unsigned int indices2[] = { 
-		0,3,2,
-		0,2,1 
-	};
-
-	Vertex vertices3[] = {
-		//right side
-		{ XMFLOAT3(+0.70f, -0.40f, +0.0f), blue},
-		{ XMFLOAT3(+0.60f, -0.60f, +0.0f), blue}, //top left
-		{ XMFLOAT3(+0.60f, -0.40f, +0.0f), black }, //bl
-		//Middle
-		{ XMFLOAT3(+0.40f, -0.40f, +0.0f), black }, //br
-		{ XMFLOAT3(+0.40f, -0.60f, +0.0f), red }, //tr
-		//right side
-		{ XMFLOAT3(+0.30f, -0.40f, +0.0f), red},
-	};
-
-	//boat
-	unsigned int indices3[] = {
-		0, 1, 2,
-		1, 3, 2,
-		1, 4, 3,
-		4, 5, 3
-	};
-
-	//Creating Meshes
-	//puting the mesh data into list so data can be displayed
-	std::shared_ptr<Mesh> triangle = std::make_shared<Mesh>("Triangle", vertices1, ARRAYSIZE(vertices1), indices1, ARRAYSIZE(indices1));
-	meshList.push_back(triangle);
-
-	std::shared_ptr<Mesh> quad = std::make_shared<Mesh>("Quad", vertices2, ARRAYSIZE(vertices2), indices2, ARRAYSIZE(indices2));
-	meshList.push_back(quad);
-
-	std::shared_ptr<Mesh> boat = std::make_shared<Mesh>("Boat", vertices3, ARRAYSIZE(vertices3), indices3, ARRAYSIZE(indices3));
-	meshList.push_back(boat);
-
-	//Creating Game Entity
-	std::shared_ptr<Entity> entity1 = std::make_shared<Entity>(triangle);
-	std::shared_ptr<Entity> entity2 = std::make_shared<Entity>(quad);
-	std::shared_ptr<Entity> entity3 = std::make_shared<Entity>(boat);
-	std::shared_ptr<Entity> entity4 = std::make_shared<Entity>(boat);
-	std::shared_ptr<Entity> entity5 = std::make_shared<Entity>(boat);
-
-	entity1->GetTransform()->SetPosition(XMFLOAT3(0.0f, 0.0f, 0.0f));
-	entity2->GetTransform()->SetPosition(XMFLOAT3(0.0f, 0.0f, 0.0f));
-	entity3->GetTransform()->SetPosition(XMFLOAT3(0.0f, 0.0f, 0.0f));
-	entity4->GetTransform()->SetPosition(XMFLOAT3(-0.2f, 0.6f, 0.0f));
-	entity5->GetTransform()->SetPosition(XMFLOAT3(-0.09f, 0.9f, 0.0f));
-
-	entities.push_back(entity1);
-	entities.push_back(entity2);
-	entities.push_back(entity3);
-	entities.push_back(entity4);
-	entities.push_back(entity5);
-	
-}
+		desc.rasterizer.FillMode = D3D11_FILL_WIREFRAME;
+		desc.rasterizer.CullMode = D3D11_CULL_NONE;
+	}
 
+	PipelineId id = pipelineCache.GetPipeline(desc);
+	if (id == InvalidPipeline)
+		return;
+
+	// The same without lights, for views the light grid isn't
+	// built for; the lit pipeline itself if that doesn't build
+	PipelineDesc unlit = desc;
+	if (features & ShaderFeatureClusteredLights)
+	{
+		unlit.vertexShader = shaderCache.GetVertexShader("VertexShader.hlsl", features & ~ShaderFeatureClusteredLights, inputElements, 3);
+		unlit.pixelShader = shaderCache.GetPixelShader("PixelShader.hlsl", features & ~ShaderFeatureClusteredLights);
+		if (unlit.vertexShader == InvalidShader || unlit.pixelShader == InvalidShader)
+			unlit = desc;
+	}
+
+	pipelineId = id;
+	unlitPipelineId = pipelineCache.GetPipeline(unlit);
+
+	// After a prepass, depth is already final: only the nearest
+	// surface passes, and nothing needs writing
+	desc.depthStencil.DepthFunc = D3D11_COMPARISON_EQUAL;
+	desc.depthStencil.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+	unlit.depthStencil = desc.depthStencil;
+
+	equalPipelineId = pipelineCache.GetPipeline(desc);
+	unlitEqualPipelineId = pipelineCache.GetPipeline(unlit);
+	shaderFeatures = features;
+	wireframe = wireframeFill;
+}
 
 // --------------------------------------------------------
-// Handle resizing to match the new window size
-//  - Eventually, we'll want to update our 3D camera
+// The window's size, input and pacing, for GameCore
 // --------------------------------------------------------
-void Game::OnResize()
+unsigned int Game::GetWidth()
 {
-	if (camera) 
-	{
-		camera->UpdateProjectionMatrix((float)Window::Width() / Window::Height());
-	};
+	return (unsigned int)Window::Width();
 }
 
-// Helper methods
-void Game::ImGuiUpdate(float deltaTime) {
-	//Fresh data
-	ImGuiIO& io = ImGui::GetIO();
-	io.DeltaTime = deltaTime;
-	io.DisplaySize.x = (float)Window::Width();
-	io.DisplaySize.y = (float)Window::Height();
+unsigned int Game::GetHeight()
+{
+	return (unsigned int)Window::Height();
+}
 
-	//Resetting frames
+void Game::NewUIFrame()
+{
 	ImGui_ImplDX11_NewFrame();
 	ImGui_ImplWin32_NewFrame();
-	ImGui::NewFrame();
+}
 
+void Game::GatherInput()
+{
 	//Determine new input capture
+	ImGuiIO& io = ImGui::GetIO();
 	Input::SetKeyboardCapture(io.WantCaptureKeyboard);
 	Input::SetMouseCapture(io.WantCaptureMouse);
 
-	//Show demo window
-	if(showDemo) ImGui::ShowDemoWindow();
-}
-
-void Game::BuildUI()
-{
-	ImGui::Begin("Inspector"); // Inspector
-
-	if (ImGui::TreeNode("App Details")) {
-		ImGui::Text("Frame rate: %f fps", ImGui::GetIO().Framerate); //displaying frame rate
-		ImGui::Text("Window Client Size: %dx%d", Window::Width(), Window::Height()); //displaying window size
-
-		//color og background
-		ImGui::ColorEdit4("Background Color", color);
-
-		//Button to show ImGui Demo
-		if (showDemo == false) {
-			if (ImGui::Button("Show ImGui Demo Window")) showDemo = true;
-		}
-		else {
-			if (ImGui::Button("Close ImGui Demo Window")) showDemo = false;
-		}
-
-		ImGui::TreePop(); // popped app details
+	//Mouse look, spent by the next step
+	if (Input::MouseLeftDown())
+	{
+		pendingMouseX += Input::GetMouseXDelta();
+		pendingMouseY += Input::GetMouseYDelta();
 	}
 
-	if (ImGui::TreeNode("Meshes")) {
+	//Camera movement, for every step this frame
+	cameraMove.x = (Input::KeyDown('D') ? 1.0f : 0.0f) - (Input::KeyDown('A') ? 1.0f : 0.0f);
+	cameraMove.y = (Input::KeyDown(VK_SPACE) ? 1.0f : 0.0f) - (Input::KeyDown('X') ? 1.0f : 0.0f);
+	cameraMove.z = (Input::KeyDown('W') ? 1.0f : 0.0f) - (Input::KeyDown('S') ? 1.0f : 0.0f);
 
-		for (auto& m : meshList) {
-			if (ImGui::TreeNode(m->GetName())) {
-				ImGui::Text("Triangles: %d", m->GetIndexCount() / 3);
-				ImGui::Text("Vertices: %d", m->GetVertexCount());
-				ImGui::Text("Indices: %d", m->GetIndexCount());
-				ImGui::TreePop();
-			}
-		}
+	// Example input checking: Quit if the escape key is pressed
+	if (Input::KeyDown(VK_ESCAPE))
+		Window::Quit();
+}
 
+bool Game::SleptLastFrame()
+{
+	return FramePacing::SleptLastFrame();
+}
+
+// --------------------------------------------------------
+// The inspector's nodes for what only the window and the
+// device have: uploads, pacing, shaders and pipelines
+// --------------------------------------------------------
+void Game::BuildRendererUI()
+{
+	if (ImGui::TreeNode("GPU")) {
+		ImGui::Text("Instance dirty ranges uploaded: %u", instanceUploads.GetUploadedRanges());
+		ImGui::Text("Instance bytes uploaded: %u", instanceUploads.GetUploadedBytes());
+		ImGui::Text("WVP bytes uploaded: %u", instanceUploads.GetWorldViewProjBytes());
+		ImGui::Text("Light bytes uploaded: %u", lightBuffer.GetUploadedBytes());
+		ImGui::Text("Draw chunks: %u of %u", commandBackend.GetLastChunkCount(), commandBackend.GetMaxChunks());
 		ImGui::TreePop();
 	}
 
-	//float offset[3] = {vsData.offset.x, vsData.offset.y, vsData.offset.z };
-	float color[4] = { vsData.colorTint.x, vsData.colorTint.y, vsData.colorTint.z, vsData.colorTint.w };
-
-	if (ImGui::TreeNode("Scene Entities")) {
-		for (int i = 0; i < entities.size(); i++) {
-			std::string label = "Entity #" + std::to_string(i + 1);
-			ImGui::PushID(i);
-			XMFLOAT3 position = entities[i]->GetTransform()->GetPosition();
-			XMFLOAT3 rotation = entities[i]->GetTransform()->GetPitchYawRoll();
-			XMFLOAT3 scale = entities[i]->GetTransform()->GetScale();
-
-			if (ImGui::TreeNode(label.c_str())) {
-
-				ImGui::SliderFloat3("Position", &position.x, -1.0f, 1.0f);
-				entities[i]->GetTransform()->SetPosition(position);
-
-				ImGui::SliderFloat3("Rotation (Radians)", &rotation.x, -180.0f, 180.0f);
-				entities[i]->GetTransform()->SetRotation(rotation.x, rotation.y, rotation.z);
-
-				ImGui::SliderFloat3("Scale", &scale.x, 0.1f, 2.0f);
-				entities[i]->GetTransform()->SetScale(scale);
-
-				ImGui::TreePop();
-			}
-			ImGui::PopID();
-		}
-		
+	if (ImGui::TreeNode("Frame Pacing")) {
+		FramePacing::Settings pacing = FramePacing::GetSettings();
+		bool changed = ImGui::Checkbox("Throttle idle frames", &pacing.enabled);
+		changed |= ImGui::Checkbox("Skip frames with nothing new", &pacing.skipStaticFrames);
+		changed |= ImGui::SliderFloat("Unfocused fps", &pacing.unfocusedRate, 1.0f, 60.0f, "%.0f");
+		changed |= ImGui::SliderFloat("Idle fps", &pacing.idleRate, 1.0f, 60.0f, "%.0f");
+		if (changed)
+			FramePacing::SetSettings(pacing);
+
+		FramePacing::Stats stats = FramePacing::GetStats();
+		ImGui::Text("Frames: %llu, %llu without Draw(), %llu capped unfocused", stats.frames, stats.skippedDraws, stats.throttledFrames);
+		ImGui::Text("Draw() saved: %.1f ms (%.3f ms each)", stats.savedDrawMs, stats.averageDrawMs);
+		ImGui::Text("Asleep: %.1f s between frames, %.1f s minimized", stats.sleptSeconds, stats.minimizedSeconds);
+		ImGui::Text("Timer: %s", stats.highResolutionTimer ? "high resolution" : "regular");
+		if (ImGui::Button("Reset"))
+			FramePacing::ResetStats();
 		ImGui::TreePop();
 	}
 
-	//Camera Switching
-	std::string cameraLabel = "Camera in use: " + std::to_string(activeCamera + 1);
-	if (ImGui::TreeNode(cameraLabel.c_str())) {
-
-		if (ImGui::TreeNode("Cameras")) {
-			if (ImGui::Button("Camera 1 ([0])")) { activeCamera = 0; camera = cameraList[activeCamera]; }
-			if (ImGui::Button("Camera 2 ([1])")) { activeCamera = 1; camera = cameraList[activeCamera]; }
-			if (ImGui::Button("Camera 3 ([3])")) { activeCamera = 2; camera = cameraList[activeCamera]; }
-			if (ImGui::Button("Camera 4 ([4])")) { activeCamera = 3; camera = cameraList[activeCamera]; }
-			ImGui::TreePop();
+	if (ImGui::TreeNode("Shaders")) {
+		// Each feature is a #define; changing them switches to
+		// that permutation, building it the first time
+		// - DEPTH_ONLY is the prepass's alone
+		uint32_t features = shaderFeatures;
+		for (unsigned int f = 0; f < ShaderFeatureCount; f++) {
+			if ((1u << f) == ShaderFeatureDepthOnly)
+				continue;
+			bool enabled = (features & (1u << f)) != 0;
+			if (ImGui::Checkbox(ShaderCache::GetFeatureName(f), &enabled))
+				features = enabled ? features | (1u << f) : features & ~(1u << f);
+		}
+		if (features != shaderFeatures)
+			SelectPipeline(features, wireframe);
+
+		if (!(shaderFeatures & ShaderFeatureClusteredLights))
+			ImGui::Text("Unlit: CLUSTERED_LIGHTS is off");
+
+		ShaderCache::Stats stats = shaderCache.GetStats();
+		ImGui::Text("Permutations loaded: %u", stats.permutations);
+		ImGui::Text("Compiled: %u (%.1f ms), from blob cache: %u, precompiled: %u", stats.compiled, stats.compileMs, stats.blobHits, stats.precompiled);
+		if (stats.failed > 0)
+			ImGui::Text("Failed: %u (see console)", stats.failed);
+
+		// Edits to the sources are picked up while running
+		bool notifications = HotReload::UsesNotifications();
+		if (ImGui::Checkbox("Watch with OS notifications", &notifications))
+			HotReload::SetNotifications(notifications);
+
+		HotReload::Stats reload = HotReload::GetStats();
+		ImGui::Text("Watching %u files (%s)", reload.watchedFiles, reload.watcher ? reload.watcher : "starting");
+		ImGui::Text("Reloads: %u, failed: %u, permutations rebuilt: %u", reload.applied, reload.failures, stats.rebuilt);
+		if (!reload.lastFile.empty())
+		{
+			ImGui::Text("Last: %s", frameMemory.Format("%ls", reload.lastFile.c_str()));
+			ImGui::Text("Rebuilt in %.1f ms, in use after %.1f ms (worst %.1f ms)", reload.lastBuildMs, reload.lastLatencyMs, reload.worstLatencyMs);
 		}
-
-
 		ImGui::TreePop();
 	}
 
-	if (ImGui::TreeNode("Random Things")) {
-		ImGui::InputInt("size", &num);
-		ImGui::DragFloat("float drag", &fnum);
-		ImGui::Checkbox("check", &check);
-	
+	if (ImGui::TreeNode("Pipelines")) {
+		bool fill = wireframe;
+		if (ImGui::Checkbox("Wireframe", &fill))
+			SelectPipeline(shaderFeatures, fill);
+
+		// Both take effect on the next frame, for flipping back
+		// and forth while watching the GPU time
+		ImGui::Checkbox("Sort opaque front to back", &frontToBack);
+		if (prepassPipelineId == InvalidPipeline)
+			ImGui::Text("Depth prepass unavailable (no DEPTH_ONLY shader)");
+		else
+			ImGui::Checkbox(wireframe ? "Depth prepass (off while wireframe)" : "Depth prepass", &depthPrepass);
+
+		// Hits are requests that found an existing object
+		PipelineCache::Stats stats = pipelineCache.GetStats();
+		unsigned int stateHits = stats.stateRequests - stats.stateObjects - stats.stateFailures;
+		unsigned int pipelineHits = stats.pipelineRequests - stats.pipelines;
+		ImGui::Text("Pipelines: %u created, %u of %u requests hit (%.0f%%)", stats.pipelines, pipelineHits, stats.pipelineRequests,
+			stats.pipelineRequests > 0 ? 100.0 * pipelineHits / stats.pipelineRequests : 0.0);
+		ImGui::Text("State objects: %u created, %u of %u requests hit (%.0f%%)", stats.stateObjects, stateHits, stats.stateRequests,
+			stats.stateRequests > 0 ? 100.0 * stateHits / stats.stateRequests : 0.0);
+		if (stats.stateFailures > 0)
+			ImGui::Text("State objects that failed to create: %u", stats.stateFailures);
+		ImGui::Text("Binds: %llu, %llu skipped as redundant", stats.binds, stats.redundantBinds);
 		ImGui::TreePop();
-
 	}
-
-	ImGui::End(); //Inspector
 }
 
-
 // --------------------------------------------------------
-// Update your game here - user input, move objects, AI, etc.
+// GameCore's checks, plus shaders rebuilt since the last
+// frame drawn, which would be swapped in by Render()
 // --------------------------------------------------------
-void Game::Update(float deltaTime, float totalTime)
+bool Game::NeedsDraw()
 {
-	ImGuiUpdate(deltaTime);
-	BuildUI();
-
-	entities[0]->GetTransform()->Rotate(XMFLOAT3(0, 0, deltaTime));
-
-	camera->Update(deltaTime);
-
-	// Example input checking: Quit if the escape key is pressed
-	if (Input::KeyDown(VK_ESCAPE))
-		Window::Quit();
+	return GameCore::NeedsDraw() || shaderCache.HasRebuilds();
 }
 
+// --------------------------------------------------------
+// Each view's pipeline: the first is lit, the rest aren't.
+// No prepass under wireframe, where the main pass doesn't
+// cover what the prepass would, or without its shaders.
+// --------------------------------------------------------
+void Game::ChoosePipelines(FramePacket& packet)
+{
+	if (wireframe || prepassPipelineId == InvalidPipeline || equalPipelineId == InvalidPipeline)
+		packet.depthPrepass = false;
+	packet.prepassPipeline = prepassPipelineId;
 
+	for (unsigned int v = 0; v < packet.viewCount; v++)
+	{
+		if (v == 0)
+			packet.views[v].pipeline = packet.depthPrepass ? equalPipelineId : pipelineId;
+		else
+			packet.views[v].pipeline = packet.depthPrepass ? unlitEqualPipelineId : unlitPipelineId;
+	}
+}
 
 // --------------------------------------------------------
 // Clear the screen, redraw everything, present to the user
+//  - Runs on the render thread, and only reads the packet
 // --------------------------------------------------------
-void Game::Draw(float deltaTime, float totalTime)
+void Game::Render(FramePacket& packet)
 {
+	ALLOCATION_SCOPE("Render");
+
 	// Frame START
 	// - These things should happen ONCE PER FRAME
-	// - At the beginning of Game::Draw() before drawing *anything*
+	// - At the beginning of Game::Render() before drawing *anything*
 	{
-		// Clear the back buffer (erase what's on screen) and depth buffer
-		/*const float color[4] = { 0.4f, 0.6f, 0.75f, 0.0f };*/
-		Graphics::Context->ClearRenderTargetView(Graphics::BackBufferRTV.Get(),	color);
-		Graphics::Context->ClearDepthStencilView(Graphics::DepthBufferDSV.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
+		// Shaders rebuilt since the last frame take over here,
+		// before anything binds them
+		std::chrono::steady_clock::time_point noticed;
+		if (shaderCache.ApplyRebuilds(noticed))
+			HotReload::Applied(noticed);
 	}
 
-	//ColorTint and Offset
+	//Per-frame camera data, one constant buffer per view
+	// - Each pass binds its view's, along with its viewport
+	for (unsigned int v = 0; v < packet.viewCount; v++)
 	{
-
 		D3D11_MAPPED_SUBRESOURCE mappedBuffer = {};
-		Graphics::Context->Map(vsConstantBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedBuffer);
+		Graphics::Context->Map(vsConstantBuffers[v].Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedBuffer);
+
+		memcpy(mappedBuffer.pData, &packet.views[v].camera, sizeof(VertexShaderData));
 
-		memcpy(mappedBuffer.pData, &vsData, sizeof(vsData));
+		Graphics::Context->Unmap(vsConstantBuffers[v].Get(), 0);
+	}
+
+	//Per-instance data
+	{
+		PROFILE_SCOPE("Upload instances");
 
-		Graphics::Context->Unmap(vsConstantBuffer.Get(), 0);
+		instanceUploads.Upload(packet.instances);
 
-		//Binding Constant Buffer
-		Graphics::Context->VSSetConstantBuffers(0, 1, vsConstantBuffer.GetAddressOf());
+		// Instance data (t0), per-draw WVPs and slots (t1) and the matching draw id stream (vertex slot 1)
+		// - Every frame, since Upload() may have had to recreate the buffers
+		instanceUploads.Bind(0, 1, 1);
 	}
 
-	// DRAW geometry
-	// - These steps are generally repeated for EACH object you draw
-	// - Other Direct3D calls will also be necessary to do more complex things
+	//Lights, which only the CLUSTERED_LIGHTS pixel shader reads
 	{
-		for (int i = 0; i < entities.size(); i++) {
-			entities[i]->Draw(vsConstantBuffer, camera);
-		}
+		PROFILE_SCOPE("Upload lights");
+
+		lightBuffer.Upload(packet.lights);
+
+		// Constants (b0), lights (t0), cluster ranges (t1) and light indices (t2)
+		lightBuffer.Bind(0, 0, 1, 2);
 	}
-	//ImGui
+
+	// DRAW everything, as passes of the frame's render graph
+	// - The scene, into the back buffer and a transient depth buffer,
+	//   then the UI on top
 	{
-		ImGui::Render();
-		ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
+		RenderFrame frame = { &packet };
+		BuildRenderGraph(frame);
+		transientTextures.Realize(renderGraph);
+		renderGraph.Execute();
+		AddRecordTimes(frame);
 	}
 
 	// Frame END
 	// - These should happen exactly ONCE PER FRAME
 	// - At the very end of the frame (after drawing *everything*)
 	{
+		PROFILE_SCOPE("Present");
+
 		// Present at the end of the frame
+		// - Every pass binds its own targets, so nothing needs
+		//   re-binding afterwards
 		bool vsync = Graphics::VsyncState();
 		Graphics::SwapChain->Present(
 			vsync ? 1 : 0,
 			vsync ? 0 : DXGI_PRESENT_ALLOW_TEARING);
+	}
+
+#if defined(DEBUG) || defined(_DEBUG)
+	// Print any graphics debug messages that occurred this frame
+	// - Here rather than in the main loop, since the info queue
+	//   belongs with the context
+	Graphics::PrintDebugMessages();
+#endif
+}
+
+// --------------------------------------------------------
+// Clears depth and fills it in from every entity's
+// positions alone, with no render target or pixel shader.
+// Views don't overlap, so they share one depth buffer.
+// --------------------------------------------------------
+void Game::DepthPrepass(RenderFrame& frame, const RenderGraph& graph)
+{
+	FramePacket& packet = *frame.packet;
+
+	ID3D11DepthStencilView* depth = transientTextures.GetDepthTarget(graph, frame.depth);
+	Graphics::Context->OMSetRenderTargets(0, 0, depth);
+	if (depth)
+		Graphics::Context->ClearDepthStencilView(depth, D3D11_CLEAR_DEPTH, 1.0f, 0);
+
+	pipelineCache.Invalidate();
+	pipelineCache.Bind(Graphics::Context.Get(), packet.prepassPipeline);
+	for (unsigned int v = 0; v < packet.viewCount; v++)
+	{
+		const FramePacket::ViewPacket& view = packet.views[v];
+		BindView(packet, v);
 
-		// Re-bind back buffer and depth buffer after presenting
-		Graphics::Context->OMSetRenderTargets(
-			1,
-			Graphics::BackBufferRTV.GetAddressOf(),
-			Graphics::DepthBufferDSV.Get());
+		auto start = std::chrono::high_resolution_clock::now();
+		Systems::Draw(view.draws, view.drawCount, commandBackend, true);
+		frame.recordMs[v] += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
 	}
 }
 
+// --------------------------------------------------------
+// Clears its targets and draws every view's entities.
+// After a prepass, depth is left as it is and only tested.
+// --------------------------------------------------------
+void Game::ScenePass(RenderFrame& frame, const RenderGraph& graph)
+{
+	FramePacket& packet = *frame.packet;
+
+	// Clear the back buffer (erase what's on screen) and depth buffer
+	ID3D11DepthStencilView* depth = transientTextures.GetDepthTarget(graph, frame.depth);
+	Graphics::Context->OMSetRenderTargets(1, Graphics::BackBufferRTV.GetAddressOf(), depth);
+	Graphics::Context->ClearRenderTargetView(Graphics::BackBufferRTV.Get(), packet.clearColor);
+	if (depth && !packet.depthPrepass)
+		Graphics::Context->ClearDepthStencilView(depth, D3D11_CLEAR_DEPTH, 1.0f, 0);
+
+	//Shaders and states for each view's pipeline
+	// - ImGui and reloaded shaders change things behind the cache's
+	//   back, so it starts each frame knowing nothing is bound
+	// - Deferred contexts pick all of it up (targets, viewport and
+	//   the view's constants included) from the immediate context
+	pipelineCache.Invalidate();
+	for (unsigned int v = 0; v < packet.viewCount; v++)
+	{
+		const FramePacket::ViewPacket& view = packet.views[v];
+		pipelineCache.Bind(Graphics::Context.Get(), view.pipeline);
+		BindView(packet, v);
+
+		// Each thread records a contiguous run of draws on its own
+		// deferred context; the lists execute in order
+		auto start = std::chrono::high_resolution_clock::now();
+		Systems::Draw(view.draws, view.drawCount, commandBackend);
+		frame.recordMs[v] += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+}
 
+// --------------------------------------------------------
+// Points the immediate context at one view: its part of
+// the window, and its camera constants
+// --------------------------------------------------------
+void Game::BindView(const FramePacket& packet, unsigned int view)
+{
+	const float* rect = packet.views[view].viewport;
+
+	D3D11_VIEWPORT viewport = {};
+	viewport.TopLeftX = rect[0];
+	viewport.TopLeftY = rect[1];
+	viewport.Width = rect[2];
+	viewport.Height = rect[3];
+	viewport.MinDepth = 0.0f;
+	viewport.MaxDepth = 1.0f;
+	Graphics::Context->RSSetViewports(1, &viewport);
+
+	Graphics::Context->VSSetConstantBuffers(0, 1, vsConstantBuffers[view].GetAddressOf());
+}
 
+// --------------------------------------------------------
+// ImGui, straight onto the back buffer
+// --------------------------------------------------------
+void Game::UIPass(RenderFrame& frame, const RenderGraph&)
+{
+	FramePacket& packet = *frame.packet;
+
+	Graphics::Context->OMSetRenderTargets(1, Graphics::BackBufferRTV.GetAddressOf(), 0);
+	ImGui_ImplDX11_RenderDrawData(packet.ui);
+}
@@ -2,13 +2,18 @@
 
 #include <d3d11.h>
 #include <wrl/client.h>
-#include <vector>
-#include <memory>
-#include "Entity.h"
-#include "Mesh.h"
-#include "Camera.h"
+#include "GameCore.h"
+#include "D3D11CommandBackend.h"
+#include "D3D11InstanceBuffer.h"
+#include "ShaderCache.h"
+#include "PipelineCache.h"
+#include "D3D11TexturePool.h"
+#include "LightBuffer.h"
 
-class Game
+// --------------------------------------------------------
+// The game in a window: GameCore, drawn with D3D11
+// --------------------------------------------------------
+class Game : public GameCore
 {
 public:
 	// Basic OOP setup
@@ -19,45 +24,64 @@ public:
 
 	// Primary functions
 	void Initialize();
-	void Update(float deltaTime, float totalTime);
-	void Draw(float deltaTime, float totalTime);
-	void OnResize();
 
-	float color[4] = { 0.4f, 0.6f, 0.75f, 0.0f };
-	bool showDemo = false;
-	int num = 200;
-	float fnum = 100;
-	bool check = true;
-	int activeCamera = 0;
-
-	VertexShaderData vsData;
+	// Also true while a rebuilt shader waits to be swapped in
+	bool NeedsDraw() override;
 
 private:
 
 	// Initialization helper methods - feel free to customize, combine, remove, etc.
 	void LoadShaders();
-	void CreateGeometry();
-	void ImGuiUpdate(float deltaTime);
-	void BuildUI();
+	void SelectPipeline(uint32_t features, bool wireframeFill);
+	void BindView(const FramePacket& packet, unsigned int view);
+
+	// The window, its input and the device, for GameCore
+	unsigned int GetWidth() override;
+	unsigned int GetHeight() override;
+	void NewUIFrame() override;
+	void GatherInput() override;
+	bool SleptLastFrame() override;
+	void BuildRendererUI() override;
+	void ChoosePipelines(FramePacket& packet) override;
+	void Render(FramePacket& packet) override;
+	void DepthPrepass(RenderFrame& frame, const RenderGraph& graph) override;
+	void ScenePass(RenderFrame& frame, const RenderGraph& graph) override;
+	void UIPass(RenderFrame& frame, const RenderGraph& graph) override;
 
 	// Note the usage of ComPtr below
 	//  - This is a smart pointer for objects that abide by the
 	//     Component Object Model, which DirectX objects do
 	//  - More info here: https://github.com/Microsoft/DirectXTK/wiki/ComPtr
 
-	//storing all the meshes in list/vector
-	std::vector<std::shared_ptr<Mesh>> meshList;
+	// Records the draws on deferred contexts, one per thread
+	D3D11CommandBackend commandBackend;
 
-	std::shared_ptr<Camera> camera;
-	std::vector<std::shared_ptr<Camera>> cameraList;
+	// The textures behind the render graph's transient resources
+	D3D11TexturePool transientTextures;
 
-	std::vector <std::shared_ptr<Entity>> entities;
+	// One per view, all filled in at the start of the frame
+	Microsoft::WRL::ComPtr<ID3D11Buffer> vsConstantBuffers[FramePacket::MaxViews];
 
-	Microsoft::WRL::ComPtr<ID3D11Buffer> vsConstantBuffer;
+	// The instance data and lights on the GPU, filled in on
+	// the render thread from each packet
+	D3D11InstanceBuffer instanceUploads;
+	LightBuffer lightBuffer;
 
 	// Shaders and shader-related constructs
-	Microsoft::WRL::ComPtr<ID3D11PixelShader> pixelShader;
-	Microsoft::WRL::ComPtr<ID3D11VertexShader> vertexShader;
-	Microsoft::WRL::ComPtr<ID3D11InputLayout> inputLayout;
+	// - The current pipeline, and the feature bits and fill mode that picked it
+	// - The depth prepass's pipeline, and the current one's twin
+	//   that draws after it, testing EQUAL without writing depth
+	// - Unlit twins of both for every view but the first, which
+	//   is the only one the light grid is built for
+	ShaderCache shaderCache;
+	PipelineCache pipelineCache;
+	D3D11_INPUT_ELEMENT_DESC inputElements[3] = {};
+	D3D11_INPUT_ELEMENT_DESC depthInputElements[2] = {};
+	PipelineId pipelineId = InvalidPipeline;
+	PipelineId prepassPipelineId = InvalidPipeline;
+	PipelineId equalPipelineId = InvalidPipeline;
+	PipelineId unlitPipelineId = InvalidPipeline;
+	PipelineId unlitEqualPipelineId = InvalidPipeline;
+	uint32_t shaderFeatures = ShaderFeatureClusteredLights;
+	bool wireframe = false;
 };
-
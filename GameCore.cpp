@@ -0,0 +1,1676 @@
+#include "GameCore.h"
+#include "Vertex.h"
+#include "Mesh.h"
+#include "imgui.h"
+#include <string>
+#include <chrono>
+#include <cmath>
+#include <cfloat>
+#include <cstring>
+#include <iterator>
+#include <algorithm>
+#include <DirectXMath.h>
+#include "BufferStructs.h"
+#include "Benchmarks.h"
+#include "BatchMath.h"
+#include "Systems.h"
+#include "JobSystem.h"
+#include "RenderThread.h"
+#include "Profiler.h"
+#include "AllocationTracker.h"
+#include "CrtCompat.h"
+
+// For the DirectX Math library
+using namespace DirectX;
+
+// Annonymous namespace to hold helpers
+// only accessible in this file
+namespace
+{
+	// FNV-1a, continuing from hash
+	uint64_t HashBytes(uint64_t hash, const void* data, size_t size)
+	{
+		const unsigned char* bytes = (const unsigned char*)data;
+		for (size_t i = 0; i < size; i++)
+			hash = (hash ^ bytes[i]) * 1099511628211ull;
+		return hash;
+	}
+
+	// Everything that decides what ImGui's draw data puts on
+	// screen: the geometry, and each command's clip rect,
+	// texture and range.  The skipped lists aren't hashed at
+	// all.
+	uint64_t HashDrawData(const ImDrawData* data, const ImDrawList* const* skip, unsigned int skipCount)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		if (!data || !data->Valid)
+			return hash;
+
+		hash = HashBytes(hash, &data->DisplaySize, sizeof(data->DisplaySize));
+		for (int i = 0; i < data->CmdListsCount; i++)
+		{
+			const ImDrawList* list = data->CmdLists[i];
+			if (std::find(skip, skip + skipCount, list) != skip + skipCount)
+				continue;
+
+			hash = HashBytes(hash, list->VtxBuffer.Data, list->VtxBuffer.size_in_bytes());
+			hash = HashBytes(hash, list->IdxBuffer.Data, list->IdxBuffer.size_in_bytes());
+			for (const ImDrawCmd& cmd : list->CmdBuffer)
+			{
+				hash = HashBytes(hash, &cmd.ClipRect, sizeof(cmd.ClipRect));
+				hash = HashBytes(hash, &cmd.TextureId, sizeof(cmd.TextureId));
+				hash = HashBytes(hash, &cmd.VtxOffset, sizeof(cmd.VtxOffset));
+				hash = HashBytes(hash, &cmd.IdxOffset, sizeof(cmd.IdxOffset));
+				hash = HashBytes(hash, &cmd.ElemCount, sizeof(cmd.ElemCount));
+			}
+		}
+		return hash;
+	}
+}
+
+// --------------------------------------------------------
+// Called once, instead of Game::Initialize(): no window,
+// device or ImGui platform/renderer backends.  Draws are
+// recorded on the same chunks the deferred contexts would
+// use, and only counted.
+// --------------------------------------------------------
+void GameCore::InitializeHeadless(unsigned int width, unsigned int height)
+{
+	headless = true;
+	headlessWidth = width > 0 ? width : 1;
+	headlessHeight = height > 0 ? height : 1;
+
+	// Worker threads for the per-frame systems (the render
+	// thread joins in too)
+	JobSystem::SetAttachedThreadCount(1);
+	JobSystem::Initialize();
+	recordingBackend = std::make_unique<RecordingCommandBackend>(JobSystem::GetThreadCount());
+	recordingBackend->keepSubmitted = false;
+	backend = recordingBackend.get();
+
+	InitializeCore();
+
+	// The renderer backend would normally build the font
+	// atlas, and there's no window to keep settings for
+	{
+		ALLOCATION_SCOPE("UI");
+		unsigned char* pixels = 0;
+		int atlasWidth = 0;
+		int atlasHeight = 0;
+		ImGui::GetIO().Fonts->GetTexDataAsRGBA32(&pixels, &atlasWidth, &atlasHeight);
+		ImGui::GetIO().IniFilename = 0;
+	}
+
+	StartRenderThread();
+}
+
+// --------------------------------------------------------
+// Geometry, lights, cameras, memory budgets and the ImGui
+// context: everything that doesn't depend on where frames
+// end up.  The job system and backend must be up already.
+// --------------------------------------------------------
+void GameCore::InitializeCore()
+{
+	instanceBuffer.Initialize(64);
+	CreateGeometry();
+	CreateLights(lightCount, lightExtent);
+
+	cameras.Emplace(GetAspectRatio(), 
+		XMFLOAT3(0.0f, 0.0f, -5.0f), 
+		XMFLOAT3(0.0f, 0.0f, 0.0f), 
+		5.0f, 1.0f, 
+		XM_PIDIV4, 
+		0.001f, 
+		1000.0f, 
+		false);
+
+	cameras.Emplace(GetAspectRatio(),
+		XMFLOAT3(3.0f, 6.0f, -5.0f),
+		XMFLOAT3(9.0f, 1.0f, 0.0f),
+		5.0f, 1.0f,
+		XM_PIDIV2,
+		0.001f,
+		1000.0f,
+		false);
+
+	cameras.Emplace(GetAspectRatio(),
+		XMFLOAT3(1.0f, 2.0f, -5.0f),
+		XMFLOAT3(5.0f, -2.0f, 0.0f),
+		5.0f, 1.0f,
+		XM_PIDIV4,
+		0.001f,
+		1000.0f,
+		false);
+
+	cameras.Emplace(GetAspectRatio(),
+		XMFLOAT3(-1.0f, 4.0f, -5.0f),
+		XMFLOAT3(-2.0f, -1.0f, 0.0f),
+		5.0f, 1.0f,
+		XM_PIDIV2,
+		0.001f,
+		1000.0f,
+		false);
+
+	camera = cameras.HandleAt(activeCamera);
+
+	// Memory budgets, in bytes (CPU, GPU); the memory window
+	// can change them as the game runs
+	{
+		const unsigned long long mb = 1024 * 1024;
+		AllocationTracker::SetBudget(AllocationTracker::RegisterTag("Meshes"), { 64 * mb, 64 * mb });
+		AllocationTracker::SetBudget(AllocationTracker::RegisterTag("Scene"), { 256 * mb, 0 });
+		AllocationTracker::SetBudget(AllocationTracker::RegisterTag("Instances"), { 64 * mb, 128 * mb });
+		AllocationTracker::SetBudget(AllocationTracker::RegisterTag("UI"), { 16 * mb, 0 });
+		AllocationTracker::SetBudget(AllocationTracker::RegisterTag("Lights"), { 16 * mb, 32 * mb });
+	}
+
+	// Initializing ImGui itself
+	// - ImGui would allocate with malloc() rather than new, so
+	//   it's pointed at the allocation tracker directly
+	// - Its platform/renderer backends, if any, come after
+	{
+		ALLOCATION_SCOPE("UI");
+		IMGUI_CHECKVERSION();
+		ImGui::SetAllocatorFunctions(
+			[](size_t size, void*) { return AllocationTracker::Allocate(size); },
+			[](void* memory, void*) { AllocationTracker::Free(memory); });
+		ImGui::CreateContext();
+
+		// ImGui Style
+		ImGui::StyleColorsDark();
+	}
+}
+
+// --------------------------------------------------------
+// Everything is set up, so frames (and on a device, the
+// immediate context) can be handed over to the render
+// thread
+// --------------------------------------------------------
+void GameCore::StartRenderThread()
+{
+	RenderThread::Initialize([](void* game, FramePacket& packet) { ((GameCore*)game)->Render(packet); }, this);
+}
+
+
+// --------------------------------------------------------
+// Clean up memory or objects created by this class
+// 
+// Note: Using smart pointers means there probably won't
+//       be much to manually clean up here!
+// --------------------------------------------------------
+GameCore::~GameCore()
+{
+	// Finish whatever is queued before anything goes away
+	RenderThread::ShutDown();
+
+	// ImGui clean ups
+	if (ImGui::GetCurrentContext())
+		ImGui::DestroyContext();
+
+	JobSystem::ShutDown();
+}
+
+
+// --------------------------------------------------------
+// Creates the geometry we're going to draw
+// --------------------------------------------------------
+void GameCore::CreateGeometry()
+{
+	// Create some temporary variables to represent colors
+	// - Not necessary, just makes things more readable
+	XMFLOAT4 red = XMFLOAT4(1.0f, 0.0f, 0.0f, 1.0f);
+	XMFLOAT4 green = XMFLOAT4(0.0f, 1.0f, 0.0f, 1.0f);
+	XMFLOAT4 blue = XMFLOAT4(0.0f, 0.0f, 1.0f, 1.0f);
+	XMFLOAT4 black = XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+	XMFLOAT4 purple = XMFLOAT4(0.5f, 0.0f, 1.0f, 1.0f);
+
+	// Set up the vertices of the triangle we would like to draw
+	// - We're going to copy this array, exactly as it exists in CPU memory
+	//    over to a Direct3D-controlled data structure on the GPU (the vertex buffer)
+	// - Note: Since we don't have a camera or really any concept of
+	//    a "3d world" yet, we're simply describing positions within the
+	//    bounds of how the rasterizer sees our screen: [-1 to +1] on X and Y
+	// - This means (0,0) is at the very center of the screen.
+	// - These are known as "Normalized Device Coordinates" or "Homogeneous 
+	//    Screen Coords", which are ways to describe a position without
+	//    knowing the exact size (in pixels) of the image/window/etc.  
+	// - Long story short: Resizing the window also resizes the triangle,
+	//    since we're describing the triangle in terms of the window itself
+	Vertex vertices1[] =
+	{
+		{ XMFLOAT3(+0.0f, +0.3f, +0.0f), red },
+		{ XMFLOAT3(+0.3f, -0.3f, +0.0f), blue },
+		{ XMFLOAT3(-0.3f, -0.3f, +0.0f), green },
+	};
+
+	// Set up indices, which tell us which vertices to use and in which order
+	// - This is redundant for just 3 vertices, but will be more useful later
+	// - Indices are technically not required if the vertices are in the buffer 
+	//    in the correct order and each one will be used exactly once
+	// - But just to see how it's done...
+	unsigned int indices1[] = { 0, 1, 2 };
+
+	Vertex vertices2[] = {
+		{ XMFLOAT3(-0.80f, +0.80f, +0.0f), purple },
+		{ XMFLOAT3(-0.80f, +0.40f, +0.0f), purple },
+		{ XMFLOAT3(-0.40f, +0.40f, +0.0f), green },
+		{ XMFLOAT3(-0.40f, +0.80f, +0.0f), green },
+	};
+
+	unsigned int indices2[] = { 
+		0,3,2,
+		0,2,1 
+	};
+
+	Vertex vertices3[] = {
+		//right side
+		{ XMFLOAT3(+0.70f, -0.40f, +0.0f), blue},
+		{ XMFLOAT3(+0.60f, -0.60f, +0.0f), blue}, //top left
+		{ XMFLOAT3(+0.60f, -0.40f, +0.0f), black }, //bl
+		//Middle
+		{ XMFLOAT3(+0.40f, -0.40f, +0.0f), black }, //br
+		{ XMFLOAT3(+0.40f, -0.60f, +0.0f), red }, //tr
+		//right side
+		{ XMFLOAT3(+0.30f, -0.40f, +0.0f), red},
+	};
+
+	//boat
+	unsigned int indices3[] = {
+		0, 1, 2,
+		1, 3, 2,
+		1, 4, 3,
+		4, 5, 3
+	};
+
+	//Creating Meshes
+	//puting the mesh data into the slot map so data can be displayed
+	MeshHandle triangle = AddMesh("Triangle", vertices1, std::size(vertices1), indices1, std::size(indices1));
+	MeshHandle quad = AddMesh("Quad", vertices2, std::size(vertices2), indices2, std::size(indices2));
+	MeshHandle boat = AddMesh("Boat", vertices3, std::size(vertices3), indices3, std::size(indices3));
+
+	//Creating Game Entities
+	//all still, so an idle window can skip its draws; each
+	//entity's "Spin" box in the inspector sets it turning
+	SpawnEntity(triangle, XMFLOAT3(0.0f, 0.0f, 0.0f), EntityVisible);
+	SpawnEntity(quad, XMFLOAT3(0.0f, 0.0f, 0.0f), EntityVisible);
+	SpawnEntity(boat, XMFLOAT3(0.0f, 0.0f, 0.0f), EntityVisible);
+	SpawnEntity(boat, XMFLOAT3(-0.2f, 0.6f, 0.0f), EntityVisible);
+	SpawnEntity(boat, XMFLOAT3(-0.09f, 0.9f, 0.0f), EntityVisible);
+}
+
+// --------------------------------------------------------
+// Scatters lights through a slab extent wide and half that
+// tall, like the synthetic scenes, in random colors.  Every
+// fourth one is a spot light pointing somewhere downwards.
+// --------------------------------------------------------
+void GameCore::CreateLights(unsigned int count, float extent)
+{
+	ALLOCATION_SCOPE("Lights");
+
+	// Same generator as the synthetic scenes, so the same
+	// count and extent always make the same lights
+	unsigned int state = 1;
+	auto random = [&state](float minValue, float maxValue)
+	{
+		state = state * 1664525u + 1013904223u;
+		return minValue + (state >> 8) * (1.0f / 16777216.0f) * (maxValue - minValue);
+	};
+
+	lightExtent = extent;
+	lightStarts.resize(count);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		Light& light = lightStarts[i];
+		light = {};
+		light.position = XMFLOAT3(random(-extent, extent), random(-extent * 0.25f, extent * 0.25f), random(-extent, extent));
+		light.range = extent * random(0.05f, 0.15f);
+		light.color = XMFLOAT3(random(0.2f, 1.0f), random(0.2f, 1.0f), random(0.2f, 1.0f));
+		light.intensity = 2.0f;
+		light.spotCosOuter = -1.0f;
+
+		if (i % 4 == 0)
+		{
+			XMStoreFloat3(&light.direction, XMVector3Normalize(XMVectorSet(random(-1, 1), -1.0f, random(-1, 1), 0)));
+			float angle = random(0.3f, 0.8f);
+			light.range *= 2.0f;
+			light.spotCosOuter = cosf(angle);
+			light.spotCosInner = cosf(angle * 0.7f);
+		}
+	}
+	lights = lightStarts;
+}
+
+// --------------------------------------------------------
+// Every light circles the vertical axis at its own speed,
+// spot lights turning with it
+// --------------------------------------------------------
+void GameCore::MoveLights(float totalTime)
+{
+	for (size_t i = 0; i < lightStarts.size(); i++)
+	{
+		float angle = totalTime * (0.1f + 0.05f * (i % 7));
+		XMMATRIX rotation = XMMatrixRotationY(i % 2 == 0 ? angle : -angle);
+
+		const Light& start = lightStarts[i];
+		Light& light = lights[i];
+		XMStoreFloat3(&light.position, XMVector3Transform(XMLoadFloat3(&start.position), rotation));
+		XMStoreFloat3(&light.direction, XMVector3TransformNormal(XMLoadFloat3(&start.direction), rotation));
+	}
+}
+
+// --------------------------------------------------------
+// Keeps the mesh's CPU copy, and has the backend copy its
+// geometry to wherever it draws from
+// --------------------------------------------------------
+MeshHandle GameCore::AddMesh(const char* name, Vertex* vertices, size_t vertexCount, unsigned int* indices, size_t indexCount)
+{
+	ALLOCATION_SCOPE("Meshes");
+
+	MeshHandle handle = meshes.Emplace(name, vertices, vertexCount, indices, indexCount);
+	Mesh& mesh = meshes[handle];
+	mesh.SetGeometry(backend->CreateGeometry(mesh.GetVertices(), mesh.GetVertexCount(), mesh.GetIndices(), mesh.GetIndexCount()));
+	return handle;
+}
+
+void GameCore::RemoveMesh(MeshHandle mesh)
+{
+	Mesh* removed = meshes.Get(mesh);
+	if (!removed)
+		return;
+
+	backend->ReleaseGeometry(removed->GetGeometry());
+	meshes.Remove(mesh);
+}
+
+
+// --------------------------------------------------------
+// Creates a renderable entity and gives it a slot in the
+// persistent instance buffer
+// --------------------------------------------------------
+EntityId GameCore::SpawnEntity(MeshHandle mesh, XMFLOAT3 position, uint32_t flags)
+{
+	ALLOCATION_SCOPE("Scene");
+
+	EntityId id = scene.CreateEntity(ComponentRenderable);
+	unsigned int slot = instanceBuffer.Allocate();
+
+	scene.SetMesh(id, mesh);
+	*scene.GetLocalBounds(id) = meshes[mesh].GetLocalBounds();
+	*scene.GetFlags(id) = flags;
+	*scene.GetInstanceSlot(id) = slot;
+
+	//any transform change now flags this slot for upload
+	Transform* transform = scene.GetTransform(id);
+	transform->SetChangeTracker(instanceBuffer.GetTracker(), slot);
+	transform->SetPosition(position);
+
+	if (slot >= instanceOwners.size())
+		instanceOwners.resize(slot + 1, InvalidEntity);
+	instanceOwners[slot] = id;
+
+	return id;
+}
+
+void GameCore::DestroyEntity(EntityId id)
+{
+	unsigned int* slot = scene.GetInstanceSlot(id);
+	if (slot)
+	{
+		instanceOwners[*slot] = InvalidEntity;
+		instanceBuffer.Free(*slot);
+	}
+	scene.DestroyEntity(id);
+}
+
+// --------------------------------------------------------
+// Freed instance slots are reused, so a scene no bigger
+// than the last one needs no new GPU room
+// --------------------------------------------------------
+void GameCore::LoadSyntheticScene(const SyntheticScene::Spec& spec, float loopSeconds)
+{
+	RenderThread::Flush();
+
+	for (EntityId owner : instanceOwners)
+	{
+		if (owner != InvalidEntity)
+			DestroyEntity(owner);
+	}
+	movingInstances.clear();
+
+	// No queued frame can still draw the last synthetic scene's
+	// meshes once flushed, and no entity is left using them
+	for (MeshHandle mesh : syntheticMeshes)
+		RemoveMesh(mesh);
+	syntheticMeshes.clear();
+
+	unsigned int meshCount = spec.meshCount < 1 ? 1 : (spec.meshCount > SyntheticScene::MaxMeshes ? SyntheticScene::MaxMeshes : spec.meshCount);
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+	for (unsigned int m = 0; m < meshCount; m++)
+	{
+		SyntheticScene::BuildMesh(m, vertices, indices);
+		syntheticMeshes.push_back(AddMesh(SyntheticScene::GetMeshName(m), vertices.data(), vertices.size(), indices.data(), indices.size()));
+	}
+
+	std::vector<SyntheticScene::Placement> placements;
+	SyntheticScene::Place(spec, placements);
+
+	scene.Reserve(ComponentRenderable, placements.size());
+	for (const SyntheticScene::Placement& p : placements)
+	{
+		uint32_t flags = EntityVisible | (p.dynamic ? EntitySpin : EntityStatic);
+		EntityId id = SpawnEntity(syntheticMeshes[p.mesh], p.position, flags);
+
+		Transform* transform = scene.GetTransform(id);
+		transform->SetRotation(p.rotation.x, p.rotation.y, p.rotation.z);
+		transform->SetScale(p.scale, p.scale, p.scale);
+	}
+	Systems::UpdateBounds(scene);
+
+	CreateLights(lightCount, spec.extent);
+
+	SyntheticScene::BuildCameraPath(spec, syntheticPath);
+	activeCamera = 0;
+	camera = cameras.HandleAt(activeCamera);
+	cameras[camera].FollowPath(&syntheticPath, loopSeconds);
+}
+
+// --------------------------------------------------------
+// Handle resizing to match the new window size
+//  - Eventually, we'll want to update our 3D camera
+// --------------------------------------------------------
+void GameCore::OnResize()
+{
+	Camera* active = cameras.Get(camera);
+	if (active) 
+	{
+		active->UpdateProjectionMatrix(GetAspectRatio());
+	};
+
+	// The next frame has to be drawn at the new size
+	drawRequested = true;
+}
+
+float GameCore::GetAspectRatio()
+{
+	return (float)GetWidth() / GetHeight();
+}
+
+// --------------------------------------------------------
+// Headless defaults of the platform and renderer hooks
+// --------------------------------------------------------
+unsigned int GameCore::GetWidth()
+{
+	return headlessWidth;
+}
+
+unsigned int GameCore::GetHeight()
+{
+	return headlessHeight;
+}
+
+void GameCore::NewUIFrame()
+{
+}
+
+void GameCore::GatherInput()
+{
+}
+
+bool GameCore::SleptLastFrame()
+{
+	return false;
+}
+
+void GameCore::BuildRendererUI()
+{
+}
+
+void GameCore::ChoosePipelines(FramePacket& packet)
+{
+	packet.prepassPipeline = 0;
+	for (unsigned int v = 0; v < packet.viewCount; v++)
+		packet.views[v].pipeline = 0;
+}
+
+// Helper methods
+void GameCore::ImGuiUpdate(float deltaTime) {
+	//Fresh data
+	ImGuiIO& io = ImGui::GetIO();
+	io.DeltaTime = deltaTime;
+	io.DisplaySize.x = (float)GetWidth();
+	io.DisplaySize.y = (float)GetHeight();
+
+	//Resetting frames
+	NewUIFrame();
+	ImGui::NewFrame();
+
+	//Show demo window
+	if(showDemo) ImGui::ShowDemoWindow();
+}
+
+void GameCore::BuildUI()
+{
+	PROFILE_SCOPE("BuildUI");
+
+	ImGui::Begin("Inspector"); // Inspector
+
+	if (ImGui::TreeNode("App Details")) {
+		ImGui::Text("Frame rate: %f fps", ImGui::GetIO().Framerate); //displaying frame rate
+		ImGui::Text("Window Client Size: %ux%u", GetWidth(), GetHeight()); //displaying window size
+
+		//color og background
+		ImGui::ColorEdit4("Background Color", color);
+
+		//Button to show ImGui Demo
+		if (showDemo == false) {
+			if (ImGui::Button("Show ImGui Demo Window")) showDemo = true;
+		}
+		else {
+			if (ImGui::Button("Close ImGui Demo Window")) showDemo = false;
+		}
+
+		ImGui::TreePop(); // popped app details
+	}
+
+	if (ImGui::TreeNode("Meshes")) {
+
+		for (Mesh& m : meshes) {
+			if (ImGui::TreeNode(m.GetName())) {
+				ImGui::Text("Triangles: %d", m.GetIndexCount() / 3);
+				ImGui::Text("Vertices: %d", m.GetVertexCount());
+				ImGui::Text("Indices: %d", m.GetIndexCount());
+				ImGui::TreePop();
+			}
+		}
+
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("Scene Entities")) {
+		ImGui::Text("Entities: %u", (unsigned int)scene.GetEntityCount());
+		ImGui::Text("Archetypes: %u", (unsigned int)scene.GetArchetypes().size());
+
+		//copying the ids first, since destroying reorders the rows
+		size_t idCount = 0;
+		scene.ForEach(ComponentTransform, [&](Archetype& a) { idCount += a.Count(); });
+
+		EntityId* ids = frameMemory.Allocate<EntityId>(idCount);
+		size_t copied = 0;
+		scene.ForEach(ComponentTransform, [&](Archetype& a) {
+			memcpy(ids + copied, a.entities.data(), sizeof(EntityId) * a.Count());
+			copied += a.Count();
+		});
+
+		for (size_t i = 0; i < idCount; i++) {
+			EntityId id = ids[i];
+			const char* label = frameMemory.Format("Entity #%u", id.Index() + 1);
+			ImGui::PushID((int)id.value);
+			Transform* transform = scene.GetTransform(id);
+			XMFLOAT3 position = transform->GetPosition();
+			XMFLOAT3 rotation = transform->GetPitchYawRoll();
+			XMFLOAT3 scale = transform->GetScale();
+
+			if (ImGui::TreeNode(label)) {
+
+				//only touching the transform when a slider moved, so
+				//untouched entities don't get re-uploaded every frame
+				if (ImGui::SliderFloat3("Position", &position.x, -1.0f, 1.0f))
+					transform->SetPosition(position);
+
+				if (ImGui::SliderFloat3("Rotation (Radians)", &rotation.x, -180.0f, 180.0f))
+					transform->SetRotation(rotation.x, rotation.y, rotation.z);
+
+				if (ImGui::SliderFloat3("Scale", &scale.x, 0.1f, 2.0f))
+					transform->SetScale(scale);
+
+				//tint lives in the instance data too, so flag it for upload
+				XMFLOAT4* tint = scene.GetTint(id);
+				if (tint && ImGui::ColorEdit4("Tint", &tint->x))
+					instanceBuffer.GetTracker()->MarkDirty(*scene.GetInstanceSlot(id));
+
+				uint32_t* flags = scene.GetFlags(id);
+				bool spin = flags && (*flags & EntitySpin);
+				if (flags && ImGui::Checkbox("Spin", &spin))
+					*flags = spin ? (*flags | EntitySpin) : (*flags & ~(uint32_t)EntitySpin);
+
+				bool destroy = ImGui::Button("Destroy");
+
+				ImGui::TreePop();
+
+				if (destroy) DestroyEntity(id);
+			}
+			ImGui::PopID();
+		}
+
+		if (ImGui::Button("Spawn Boat") && meshes.Size() > 2)
+			SpawnEntity(meshes.HandleAt(2), XMFLOAT3(0.0f, 0.0f, 0.0f), EntityVisible);
+		
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("Instance Data")) {
+		ImGui::Text("Instances: %u", instanceBuffer.GetCount());
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("Lights")) {
+		if (ImGui::SliderInt("Light count", &lightCount, 0, 4096))
+			SetLightCount((unsigned int)lightCount);
+		ImGui::SliderFloat("Ambient", &ambient, 0.0f, 1.0f);
+		ImGui::Checkbox("Animate", &animateLights);
+
+		LightGrid::Stats stats = lightGrid.GetStats();
+		ImGui::Text("Clusters: %u x %u x %u, %u with lights", lightGrid.GetClusterCountX(), lightGrid.GetClusterCountY(), LightGrid::SliceCount, stats.occupiedClusters);
+		ImGui::Text("Light indices: %u, most in one cluster: %u", stats.indices, stats.maxPerCluster);
+		ImGui::Text("Sphere tests: %llu", stats.sphereTests);
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("Simulation")) {
+		float rate = timestep.GetRate();
+		if (ImGui::SliderFloat("Steps per second", &rate, 10.0f, 240.0f, "%.0f"))
+			timestep.SetRate(rate);
+
+		int maxSteps = (int)timestep.maxSteps;
+		if (ImGui::SliderInt("Max steps per frame", &maxSteps, 1, 20))
+			timestep.maxSteps = (unsigned int)maxSteps;
+
+		if (ImGui::Checkbox("Interpolate between steps", &interpolate) && !interpolate)
+			Systems::ReleaseMoving(instanceBuffer, movingInstances);
+
+		ImGui::Text("Steps this frame: %u", lastStepCount);
+		ImGui::Text("Step cost: %.3f ms", stepMs);
+		ImGui::Text("Interpolation: %.3f ms for %u instances", interpolateMs, (unsigned int)movingInstances.size());
+		ImGui::Text("Alpha: %.2f", timestep.GetAlpha());
+		ImGui::Text("Time dropped by the step cap: %.2f s", timestep.GetDroppedSeconds());
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("Render Thread")) {
+		bool threaded = RenderThread::IsThreaded();
+		if (ImGui::Checkbox("Render on its own thread", &threaded))
+			RenderThread::SetThreaded(threaded);
+
+		RenderThread::Stats stats = RenderThread::GetStats();
+		ImGui::Text("Latency: %.2f ms average, %.2f ms worst", stats.latencyMs, stats.worstLatencyMs);
+		ImGui::Text("Frames in flight: %.2f", stats.framesInFlight);
+		ImGui::Text("Both threads busy: %.0f%% of the time", stats.overlap * 100.0);
+		ImGui::Text("Simulation waiting for a packet: %.3f ms/frame", stats.simulationWaitMs);
+		ImGui::Text("Render thread waiting for a packet: %.3f ms/frame", stats.renderIdleMs);
+		ImGui::Text("Packet memory: %.1f KB (peak %.1f KB)", stats.packetBytes / 1024.0, stats.packetPeakBytes / 1024.0);
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("Render Graph")) {
+		RenderGraphView view;
+		{
+			std::lock_guard<std::mutex> lock(renderGraphMutex);
+			view = renderGraphView;
+		}
+
+		if (view.error)
+			ImGui::Text("Failed to compile: %s", view.error);
+		for (unsigned int i = 0; i < view.passCount; i++)
+			ImGui::Text("%u. %s%s", i + 1, view.passes[i], view.culled[i] ? " (culled)" : "");
+
+		const double mb = 1024.0 * 1024.0;
+		const RenderGraph::Stats& stats = view.stats;
+		ImGui::Text("Transient textures: %u on %u physical", stats.transientTextures, stats.physicalTextures);
+		ImGui::Text("Transient memory: %.2f MB (%.2f MB without aliasing)", stats.allocatedBytes / mb, stats.transientBytes / mb);
+		ImGui::Text("Peak live at one pass: %.2f MB", stats.peakLiveBytes / mb);
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("Jobs")) {
+		ImGui::Text("Threads: %u", JobSystem::GetThreadCount());
+		ImGui::Text("Drawn: %u of %u entities", (unsigned int)viewPackets[0].size(), (unsigned int)scene.GetEntityCount());
+		for (unsigned int t = 0; t < JobSystem::GetThreadCount(); t++) {
+			JobSystem::ThreadStats stats = JobSystem::GetThreadStats(t);
+			ImGui::Text("Thread %u: %u jobs run, %u stolen", t, stats.executed, stats.stolen);
+		}
+		if (ImGui::Button("Reset")) JobSystem::ResetStats();
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("Benchmarks")) {
+		if (ImGui::Button("Run WVP (100k objects)")) {
+			benchmarkResults.clear();
+			Benchmarks::WorldViewProj(100000, benchmarkResults);
+		}
+		if (ImGui::Button("Run BatchMath kernels (100k items)")) {
+			benchmarkResults.clear();
+			Benchmarks::BatchMathKernels(100000, benchmarkResults);
+		}
+		if (ImGui::Button("Run entity iteration (1M entities)")) {
+			benchmarkResults.clear();
+			Benchmarks::EntityIteration(1000000, benchmarkResults);
+		}
+		if (ImGui::Button("Run handles vs shared_ptr (1M objects)")) {
+			benchmarkResults.clear();
+			Benchmarks::HandleAccess(1000000, benchmarkResults);
+		}
+		// These four restart the job system, which the render
+		// thread must not be using at the time
+		if (ImGui::Button("Run job scaling (500k entities)")) {
+			benchmarkResults.clear();
+			RenderThread::Flush();
+			Benchmarks::JobScaling(500000, benchmarkResults);
+		}
+		if (ImGui::Button("Run command recording (100k draws)")) {
+			benchmarkResults.clear();
+			RenderThread::Flush();
+			Benchmarks::CommandRecording(100000, benchmarkResults);
+		}
+		if (ImGui::Button("Run software raster (100k triangles)")) {
+			benchmarkResults.clear();
+			RenderThread::Flush();
+			Benchmarks::SoftwareRendering(100000, benchmarkResults);
+		}
+		if (ImGui::Button("Run light assignment (4096 lights)")) {
+			benchmarkResults.clear();
+			RenderThread::Flush();
+			Benchmarks::LightAssignment(4096, benchmarkResults);
+		}
+		if (ImGui::Button("Run profiler markers (1M scopes)")) {
+			benchmarkResults.clear();
+			Benchmarks::ProfilerMarkers(1000000, benchmarkResults);
+		}
+		ImGui::Text("BatchMath path: %s", BatchMath::LevelName(BatchMath::GetLevel()));
+
+		for (auto& r : benchmarkResults) {
+			ImGui::Text("%s: %.3f ms (%.1f M/s)", r.name.c_str(), r.milliseconds, r.itemsPerSecond / 1000000.0);
+		}
+
+		ImGui::TreePop();
+	}
+
+	//Camera Switching
+	const char* cameraLabel = frameMemory.Format("Camera in use: %d", activeCamera + 1);
+	if (ImGui::TreeNode(cameraLabel)) {
+
+		if (ImGui::TreeNode("Cameras")) {
+			if (ImGui::Button("Camera 1 ([0])")) { activeCamera = 0; camera = cameras.HandleAt(activeCamera); }
+			if (ImGui::Button("Camera 2 ([1])")) { activeCamera = 1; camera = cameras.HandleAt(activeCamera); }
+			if (ImGui::Button("Camera 3 ([3])")) { activeCamera = 2; camera = cameras.HandleAt(activeCamera); }
+			if (ImGui::Button("Camera 4 ([4])")) { activeCamera = 3; camera = cameras.HandleAt(activeCamera); }
+			ImGui::TreePop();
+		}
+
+
+		ImGui::TreePop();
+	}
+
+	//Several cameras at once
+	// - Culled together, then filtered and drawn per view
+	if (ImGui::TreeNode("Views")) {
+		if (ImGui::Button("Single")) SetViewLayout(ViewLayout::Single);
+		ImGui::SameLine();
+		if (ImGui::Button("Side by side")) SetViewLayout(ViewLayout::SideBySide);
+		ImGui::SameLine();
+		if (ImGui::Button("Quad")) SetViewLayout(ViewLayout::Quad);
+		if (viewLayout != ViewLayout::Single)
+			ImGui::Text("Only the first view is lit");
+
+		ViewCosts costs = GetViewCosts();
+		double frames = costs.frames > 0 ? (double)costs.frames : 1.0;
+		double totalMs = costs.cullMs;
+		ImGui::Text("Culling (shared): %.3f ms, %.0f in any view", costs.cullMs / frames, costs.candidates / frames);
+		for (unsigned int v = 0; v < costs.viewCount; v++)
+		{
+			ImGui::Text("View %u: %.0f visible, filter %.3f ms, record %.3f ms", v + 1,
+				costs.visible[v] / frames, costs.filterMs[v] / frames, costs.recordMs[v] / frames);
+			totalMs += costs.filterMs[v] + costs.recordMs[v];
+		}
+		ImGui::Text("Total: %.3f ms per frame over %llu frames", totalMs / frames, costs.frames);
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("Random Things")) {
+		ImGui::InputInt("size", &num);
+		ImGui::DragFloat("float drag", &fnum);
+		ImGui::Checkbox("check", &check);
+	
+		ImGui::TreePop();
+
+	}
+
+	// Whatever the window and device add
+	BuildRendererUI();
+
+	ImGui::End(); //Inspector
+
+	BuildProfilerUI();
+	BuildFrameStatsUI();
+	BuildMemoryUI();
+}
+
+// --------------------------------------------------------
+// Leaves the current window out of the UI's hash.  For
+// windows of readouts that change every frame by
+// themselves, which would otherwise never let NeedsDraw()
+// be false; they catch up on the next frame that's drawn.
+// --------------------------------------------------------
+void GameCore::MarkLiveWindow()
+{
+	if (liveDrawListCount < MaxLiveWindows)
+		liveDrawLists[liveDrawListCount++] = ImGui::GetWindowDrawList();
+}
+
+// --------------------------------------------------------
+// Live, peak and GPU memory per allocation tag against its
+// budget, and last frame's allocations
+// --------------------------------------------------------
+void GameCore::BuildMemoryUI()
+{
+	ImGui::Begin("Memory");
+	MarkLiveWindow();
+
+	AllocationTracker::Counts total = AllocationTracker::GetLastFrameTotal();
+	ImGui::Text("Last frame: %llu allocations, %llu bytes", total.allocations, total.bytes);
+	ImGui::Text("Frame memory: %.1f KB used (peak %.1f KB, capacity %.1f KB)",
+		frameMemory.GetUsed() / 1024.0, frameMemory.GetPeak() / 1024.0, frameMemory.GetCapacity() / 1024.0);
+
+	const float mb = 1024.0f * 1024.0f;
+	if (ImGui::BeginTable("Tags", 7, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+		ImGui::TableSetupColumn("Tag");
+		ImGui::TableSetupColumn("Live MB");
+		ImGui::TableSetupColumn("Peak MB");
+		ImGui::TableSetupColumn("Live allocs");
+		ImGui::TableSetupColumn("Allocs this frame");
+		ImGui::TableSetupColumn("GPU MB");
+		ImGui::TableSetupColumn("GPU peak MB");
+		ImGui::TableHeadersRow();
+
+		for (unsigned int t = 0; t < AllocationTracker::GetTagCount(); t++) {
+			AllocationTracker::TagMemory m = AllocationTracker::GetMemory(t);
+			AllocationTracker::Counts frame = AllocationTracker::GetLastFrame(t);
+			bool over = AllocationTracker::IsOverBudget(t);
+
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			if (over) ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "%s (over budget)", m.name);
+			else ImGui::Text("%s", m.name);
+			ImGui::TableNextColumn(); ImGui::Text("%.2f", m.liveBytes / mb);
+			ImGui::TableNextColumn(); ImGui::Text("%.2f", m.peakBytes / mb);
+			ImGui::TableNextColumn(); ImGui::Text("%llu", m.liveAllocations);
+			ImGui::TableNextColumn(); ImGui::Text("%llu", frame.allocations);
+			ImGui::TableNextColumn(); ImGui::Text("%.2f", m.gpuBytes / mb);
+			ImGui::TableNextColumn(); ImGui::Text("%.2f", m.gpuPeakBytes / mb);
+		}
+		ImGui::EndTable();
+	}
+
+	// 0 means no budget
+	if (ImGui::TreeNode("Budgets (MB)")) {
+		for (unsigned int t = 0; t < AllocationTracker::GetTagCount(); t++) {
+			AllocationTracker::Budget budget = AllocationTracker::GetBudget(t);
+			float limits[2] = { budget.cpuBytes / mb, budget.gpuBytes / mb };
+
+			ImGui::PushID((int)t);
+			if (ImGui::InputFloat2(AllocationTracker::GetTagName(t), limits, "%.1f")) {
+				budget.cpuBytes = limits[0] > 0 ? (unsigned long long)(limits[0] * mb) : 0;
+				budget.gpuBytes = limits[1] > 0 ? (unsigned long long)(limits[1] * mb) : 0;
+				AllocationTracker::SetBudget(t, budget);
+			}
+			ImGui::PopID();
+		}
+		ImGui::TreePop();
+	}
+
+	if (ImGui::Button("Write Memory.json")) {
+		FILE* file = 0;
+		if (fopen_s(&file, "Memory.json", "w") == 0 && file)
+		{
+			AllocationTracker::WriteJSON(file);
+			fclose(file);
+		}
+	}
+
+	ImGui::End(); //Memory
+}
+
+// --------------------------------------------------------
+// Frame time graph, histogram and percentiles, and the
+// hitch detector's settings
+// --------------------------------------------------------
+void GameCore::BuildFrameStatsUI()
+{
+	ImGui::Begin("Frame Times");
+	MarkLiveWindow();
+
+	float max = frameStats.GetMax();
+	ImGui::Text("p50 %.2f ms   p95 %.2f ms   p99 %.2f ms   max %.2f ms",
+		frameStats.GetPercentile(50.0f),
+		frameStats.GetPercentile(95.0f),
+		frameStats.GetPercentile(99.0f),
+		max);
+	ImGui::Text("Average %.2f ms over the last %u frames", frameStats.GetAverage(), frameStats.GetCount());
+
+	const std::vector<float>& history = frameStats.GetHistory();
+	ImGui::PlotLines("Frame time", history.data(), (int)history.size(), (int)frameStats.GetHistoryOffset(),
+		0, 0.0f, max * 1.1f, ImVec2(0, 120));
+
+	// Only as far as the slowest frame
+	const std::vector<unsigned int>& buckets = frameStats.GetBuckets();
+	int shown = (int)(max / FrameStats::BucketMilliseconds) + 2;
+	if (shown > (int)buckets.size())
+		shown = (int)buckets.size();
+	ImGui::PlotHistogram("Distribution",
+		[](void* data, int i) { return (float)(*(const std::vector<unsigned int>*)data)[i]; },
+		(void*)&buckets, shown, 0, "0.1 ms buckets", 0.0f, FLT_MAX, ImVec2(0, 80));
+
+	ImGui::SliderFloat("Hitch at (x median)", &frameStats.hitchMultiple, 1.2f, 10.0f, "%.1f");
+	ImGui::Text("Hitches: %u (last %.2f ms)", frameStats.GetHitchCount(), frameStats.GetLastHitchMilliseconds());
+
+	ImGui::Checkbox("Write a trace for each hitch", &writeHitchTraces);
+	ImGui::SliderInt("Max traces", &maxHitchTraces, 0, 100);
+	ImGui::Text("Traces written: %u", hitchTracesWritten);
+	if (!lastHitchTrace.empty())
+		ImGui::Text("Last: %s", lastHitchTrace.c_str());
+
+	if (ImGui::Button("Reset")) frameStats.Reset();
+
+	ImGui::End(); //Frame Times
+}
+
+// --------------------------------------------------------
+// The profiler's record of the frames around the last
+// hitch, as a Chrome trace named after the hitch's frame
+// --------------------------------------------------------
+void GameCore::WriteHitchTrace()
+{
+	std::string name = "Hitch_" + std::to_string(hitchFrame) + ".json";
+
+	FILE* file = 0;
+	if (fopen_s(&file, name.c_str(), "w") != 0 || !file)
+		return;
+
+	Profiler::WriteChromeTrace(file, hitchContextFrames * 2 + 1);
+	fclose(file);
+
+	hitchTracesWritten++;
+	lastHitchTrace = name;
+}
+
+// --------------------------------------------------------
+// Its own window: every scope recorded during one finished
+// frame, nested per thread, plus Chrome trace export
+// --------------------------------------------------------
+void GameCore::BuildProfilerUI()
+{
+	ImGui::Begin("Profiler");
+	MarkLiveWindow();
+
+#if !PROFILER_ENABLED
+	ImGui::Text("Markers are compiled out (PROFILER_ENABLED is 0)");
+#endif
+
+	// While paused, the frame on show stays put
+	ImGui::Checkbox("Pause", &profilerPaused);
+	ImGui::SliderInt("Frames ago", &profilerFramesAgo, 0, Profiler::FrameHistory - 2);
+	if (!profilerPaused && Profiler::GetFrameRange(profilerFramesAgo, profilerFrameStart, profilerFrameEnd))
+		Profiler::Collect(profilerFrameStart, profilerFrameEnd, profilerThreads);
+
+	ImGui::Text("Frame: %.3f ms", Profiler::TicksToMilliseconds(profilerFrameEnd - profilerFrameStart));
+
+	for (const Profiler::ThreadEvents& thread : profilerThreads)
+	{
+		ImGui::PushID(thread.id);
+		if (ImGui::TreeNode("thread", "%s (%u scopes)", thread.name.c_str(), (unsigned int)thread.events.size()))
+		{
+			// Events come parents first, so walking them in order
+			// is walking the tree.  Collapsed nodes skip everything
+			// deeper that follows them.
+			std::vector<uint32_t>& openDepths = profilerOpenDepths;
+			openDepths.clear();
+			const std::vector<Profiler::Event>& events = thread.events;
+			size_t i = 0;
+			while (i < events.size())
+			{
+				const Profiler::Event& e = events[i];
+				while (!openDepths.empty() && openDepths.back() >= e.depth)
+				{
+					ImGui::TreePop();
+					openDepths.pop_back();
+				}
+
+				bool hasChildren = i + 1 < events.size() && events[i + 1].depth > e.depth;
+				ImGuiTreeNodeFlags flags = hasChildren ? 0 : ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen;
+				bool open = ImGui::TreeNodeEx(e.name, flags, "%s: %.3f ms", e.name, Profiler::TicksToMilliseconds(e.end - e.start));
+
+				i++;
+				if (open && hasChildren)
+					openDepths.push_back(e.depth);
+				else
+					while (i < events.size() && events[i].depth > e.depth) i++;
+			}
+			for (size_t d = 0; d < openDepths.size(); d++)
+				ImGui::TreePop();
+
+			ImGui::TreePop();
+		}
+		ImGui::PopID();
+	}
+
+	ImGui::Separator();
+	ImGui::SliderInt("Frames to export", &profilerExportFrames, 1, Profiler::FrameHistory - 1);
+	if (ImGui::Button("Export Chrome trace")) {
+		FILE* file = 0;
+		if (fopen_s(&file, "ProfilerTrace.json", "w") == 0 && file)
+		{
+			size_t events = Profiler::WriteChromeTrace(file, profilerExportFrames);
+			fclose(file);
+			profilerExportStatus = "Wrote " + std::to_string(events) + " events to ProfilerTrace.json";
+		}
+		else
+			profilerExportStatus = "Couldn't open ProfilerTrace.json";
+	}
+	if (!profilerExportStatus.empty())
+		ImGui::Text("%s", profilerExportStatus.c_str());
+
+	ImGui::End(); //Profiler
+}
+
+// --------------------------------------------------------
+// Update your game here - user input, move objects, AI, etc.
+// --------------------------------------------------------
+void GameCore::Update(float deltaTime, float)
+{
+	PROFILE_SCOPE("Update");
+
+	// The frame starts here, as far as latency is concerned
+	framePacket = &RenderThread::BeginFrame();
+
+	//Frame timing
+	// - deltaTime is how long the previous frame took, which is
+	//   the profiler's most recently finished frame
+	{
+		bool hitch = frameStats.AddFrame(deltaTime * 1000.0f);
+		if (hitchTraceCountdown > 0)
+		{
+			if (--hitchTraceCountdown == 0)
+				WriteHitchTrace();
+		}
+		else if (hitch && writeHitchTraces && hitchTracesWritten < (unsigned int)maxHitchTraces && !SleptLastFrame())
+		{
+			hitchFrame = Profiler::GetFrameCount() - 2;
+			hitchTraceCountdown = hitchContextFrames;
+		}
+	}
+
+	{
+		ALLOCATION_SCOPE("UI");
+		ImGuiUpdate(deltaTime);
+		liveDrawListCount = 0;
+		BuildUI();
+	}
+
+	//ImGui
+	// - Rendered here rather than in Draw(), so NeedsDraw() can
+	//   tell whether the UI would look any different
+	{
+		PROFILE_SCOPE("ImGui render");
+		ALLOCATION_SCOPE("UI");
+
+		ImGui::Render();
+		uiHash = HashDrawData(ImGui::GetDrawData(), liveDrawLists, liveDrawListCount);
+	}
+
+	// Mouse look is collected every frame and spent by the
+	// next step, so frames that don't step lose none of it
+	GatherInput();
+
+	//Fixed-step simulation
+	// - However long the frame took, the world only advances in whole steps
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+
+		lastStepCount = timestep.Advance(deltaTime);
+		for (unsigned int i = 0; i < lastStepCount; i++)
+			Simulate(timestep.GetStepSeconds());
+
+		if (lastStepCount > 0)
+		{
+			// Derived data only needs refreshing once, after the last step
+			Systems::UpdateBounds(scene);
+			if (interpolate)
+				Systems::FindMoving(scene, instanceBuffer, movingInstances);
+
+			float ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+			stepMs = stepMs * 0.9f + ms / lastStepCount * 0.1f;
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Advances the world by exactly one step
+// --------------------------------------------------------
+void GameCore::Simulate(float stepSeconds)
+{
+	PROFILE_SCOPE("Simulation step");
+	ALLOCATION_SCOPE("Simulation");
+
+	Systems::SavePoses(scene);
+	Systems::Spin(scene, stepSeconds);
+
+	cameras[camera].Update(stepSeconds, cameraMove, pendingMouseX, pendingMouseY);
+	pendingMouseX = 0;
+	pendingMouseY = 0;
+}
+
+// --------------------------------------------------------
+// Gathers everything this frame needs drawn into the frame
+// packet and hands it to the render thread
+// --------------------------------------------------------
+void GameCore::Draw(float, float totalTime)
+{
+	PROFILE_SCOPE("Draw");
+
+	FramePacket& packet = *framePacket;
+	memcpy(packet.clearColor, color, sizeof(color));
+
+	// How far between the last two steps this frame is drawn
+	float alpha = timestep.GetAlpha();
+
+	//Per-frame camera data, for every view
+	XMFLOAT4X4 viewProjections[FramePacket::MaxViews];
+	{
+		packet.depthPrepass = depthPrepass;
+		SetUpViews(packet, alpha);
+		ChoosePipelines(packet);
+		for (unsigned int v = 0; v < packet.viewCount; v++)
+		{
+			const VertexShaderData& viewData = packet.views[v].camera;
+			XMStoreFloat4x4(&viewProjections[v], XMLoadFloat4x4(&viewData.viewMatrix) * XMLoadFloat4x4(&viewData.projectionMatrix));
+		}
+		vsData = packet.views[0].camera;
+	}
+
+	//Culling and draw packets, spread over the job system
+	// - One view is culled on its own.  Several are culled in a
+	//   single pass over the scene, then each view picks its
+	//   own packets out of what any of them can see.
+	{
+		PROFILE_SCOPE("Culling");
+		ALLOCATION_SCOPE("Culling");
+
+		auto start = std::chrono::high_resolution_clock::now();
+
+		Frustum frustums[FramePacket::MaxViews];
+		for (unsigned int v = 0; v < packet.viewCount; v++)
+			frustums[v].Build(viewProjections[v]);
+
+		size_t candidates = 0;
+		if (packet.viewCount == 1)
+		{
+			Systems::BuildDrawPackets(scene, frustums[0], vsData.viewMatrix, viewPackets[0]);
+			candidates = viewPackets[0].size();
+		}
+		else
+		{
+			FrustumSet frustumSet;
+			frustumSet.Build(frustums, packet.viewCount);
+			Systems::CullViews(scene, frustumSet, sharedPackets);
+			candidates = sharedPackets.packets.size();
+		}
+
+		auto end = std::chrono::high_resolution_clock::now();
+		double cullMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+		double filterMs[FramePacket::MaxViews] = {};
+		for (unsigned int v = 0; v < packet.viewCount; v++)
+		{
+			start = end;
+
+			FramePacket::ViewPacket& view = packet.views[v];
+			if (packet.viewCount > 1)
+				Systems::FilterView(sharedPackets, v, view.camera.viewMatrix, viewPackets[v]);
+			if (frontToBack)
+				Systems::SortFrontToBack(viewPackets[v]);
+
+			DrawItem* draws = packet.memory.Allocate<DrawItem>(viewPackets[v].size());
+			view.drawCount = Systems::ResolveDraws(viewPackets[v], meshes, draws);
+			view.draws = draws;
+
+			end = std::chrono::high_resolution_clock::now();
+			filterMs[v] = std::chrono::duration<double, std::milli>(end - start).count();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(viewCostsMutex);
+			viewCosts.frames++;
+			viewCosts.viewCount = packet.viewCount;
+			viewCosts.cullMs += cullMs;
+			viewCosts.candidates += candidates;
+			for (unsigned int v = 0; v < packet.viewCount; v++)
+			{
+				viewCosts.filterMs[v] += filterMs[v];
+				viewCosts.visible[v] += viewPackets[v].size();
+			}
+		}
+
+		if (headless)
+		{
+			headlessCounts.visibleEntities += candidates;
+			headlessCounts.culledEntities += scene.GetEntityCount() - candidates;
+		}
+	}
+
+	//Lights, assigned to this frame's clusters
+	// - The grid only rebuilds its cluster bounds when the
+	//   projection or resolution changes
+	// - Only for the first view, whose viewport starts at the
+	//   window's corner as the pixel shader's lookup expects
+	{
+		PROFILE_SCOPE("Lights");
+		ALLOCATION_SCOPE("Lights");
+
+		lightGrid.Configure((unsigned int)packet.views[0].viewport[2], (unsigned int)packet.views[0].viewport[3], vsData.projectionMatrix);
+
+		if (animateLights)
+			MoveLights(totalTime);
+		lightGrid.Assign(lights.data(), (unsigned int)lights.size(), vsData.viewMatrix);
+
+		XMFLOAT3 cameraPosition;
+		XMStoreFloat3(&cameraPosition, XMMatrixInverse(0, XMLoadFloat4x4(&vsData.viewMatrix)).r[3]);
+		lightGrid.Capture(packet.memory, lights.data(), (unsigned int)lights.size(), cameraPosition, ambient, packet.lights);
+	}
+
+	//Per-instance data
+	// - Only slots whose Transform (or tint) changed are copied into the packet,
+	//   plus whatever moved during the last step, blended to this frame's alpha
+	// - world * view * projection for just each view's visible draws, batched
+	//   on the CPU once per view; the instance data itself is shared
+	{
+		PROFILE_SCOPE("Instances");
+		ALLOCATION_SCOPE("Instances");
+
+		Systems::WriteInstances(scene, instanceBuffer, instanceOwners);
+
+		auto start = std::chrono::high_resolution_clock::now();
+		Systems::Interpolate(movingInstances, instanceOwners, alpha, instanceBuffer);
+		float ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		interpolateMs = interpolateMs * 0.9f + ms * 0.1f;
+
+		InstanceView views[FramePacket::MaxViews];
+		unsigned int drawOffset = 0;
+		for (unsigned int v = 0; v < packet.viewCount; v++)
+		{
+			views[v] = { viewProjections[v], packet.views[v].draws, packet.views[v].drawCount };
+			packet.views[v].camera.drawOffset = drawOffset;
+			drawOffset += packet.views[v].drawCount;
+		}
+		instanceBuffer.Capture(packet.memory, views, packet.viewCount, packet.instances);
+	}
+
+	//ImGui, as Update() rendered it
+	{
+		ALLOCATION_SCOPE("UI");
+		packet.CopyUI(ImGui::GetDrawData());
+	}
+
+	RenderThread::SubmitFrame();
+	framePacket = 0;
+	drawnUiHash = uiHash;
+	drawRequested = false;
+
+	// ImGui has copied everything it kept, so this frame's
+	// labels and lists can go
+	frameMemory.Reset();
+}
+
+// --------------------------------------------------------
+// False when this frame would look just like the last one
+// drawn: no instance has moved or been changed, the camera
+// is where it was, the lights are still and the UI's draw
+// data hashes the same, live windows aside (see
+// MarkLiveWindow()).  Input is left to the caller.
+// --------------------------------------------------------
+bool GameCore::NeedsDraw()
+{
+	if (drawRequested || uiHash != drawnUiHash)
+		return true;
+	if (!movingInstances.empty() || !instanceBuffer.GetDirtyRanges().empty())
+		return true;
+	if (animateLights && !lights.empty())
+		return true;
+
+	XMFLOAT4X4 view = interpolate ? cameras[camera].GetInterpolatedViewMatrix(timestep.GetAlpha()) : cameras[camera].GetViewMatrix();
+	return memcmp(&view, &vsData.viewMatrix, sizeof(view)) != 0;
+}
+
+// --------------------------------------------------------
+// Ends a frame without Draw(): nothing is handed to the
+// render thread, so the last frame stays on screen
+// --------------------------------------------------------
+void GameCore::SkipDraw()
+{
+	RenderThread::CancelFrame();
+	framePacket = 0;
+	frameMemory.Reset();
+}
+
+// --------------------------------------------------------
+// Splits the window between the layout's views, giving
+// each its camera, reshaped to fit.
+// Only the active camera moves, so only it is interpolated.
+// --------------------------------------------------------
+void GameCore::SetUpViews(FramePacket& packet, float alpha)
+{
+	unsigned int width = GetWidth();
+	unsigned int height = GetHeight();
+
+	unsigned int columns = viewLayout == ViewLayout::Single ? 1 : 2;
+	unsigned int rows = viewLayout == ViewLayout::Quad ? 2 : 1;
+	float viewWidth = (float)(width / columns > 0 ? width / columns : 1);
+	float viewHeight = (float)(height / rows > 0 ? height / rows : 1);
+
+	packet.viewCount = columns * rows;
+	if (packet.viewCount > cameras.Size())
+		packet.viewCount = (unsigned int)cameras.Size();
+
+	for (unsigned int v = 0; v < packet.viewCount; v++)
+	{
+		FramePacket::ViewPacket& view = packet.views[v];
+		view.viewport[0] = (v % columns) * viewWidth;
+		view.viewport[1] = (v / columns) * viewHeight;
+		view.viewport[2] = viewWidth;
+		view.viewport[3] = viewHeight;
+
+		Camera& viewCamera = cameras[v == 0 ? camera : cameras.HandleAt((activeCamera + v) % cameras.Size())];
+		viewCamera.UpdateProjectionMatrix(viewWidth / viewHeight);
+		view.camera.viewMatrix = v == 0 && interpolate ? viewCamera.GetInterpolatedViewMatrix(alpha) : viewCamera.GetViewMatrix();
+		view.camera.projectionMatrix = viewCamera.GetProjMatrix();
+		view.camera.drawOffset = 0;
+	}
+}
+
+// --------------------------------------------------------
+// Headless: draws are recorded rather than executed, and
+// everything the D3D11 path would have sent along is
+// counted.  Runs on the render thread, and only reads the
+// packet.
+// --------------------------------------------------------
+void GameCore::Render(FramePacket& packet)
+{
+	ALLOCATION_SCOPE("Render");
+
+	headlessCounts.frames++;
+	headlessCounts.constantBufferBytes += sizeof(VertexShaderData) * packet.viewCount;
+
+	//Per-instance data, as D3D11InstanceBuffer::Upload() would send it
+	{
+		const InstanceUpdate& update = packet.instances;
+		headlessCounts.instanceRanges += update.rangeCount;
+		for (unsigned int i = 0; i < update.rangeCount; i++)
+			headlessCounts.instanceBytes += (update.ranges[i].end - update.ranges[i].begin) * sizeof(InstanceData);
+		headlessCounts.worldViewProjBytes += update.drawCount * sizeof(DrawData);
+	}
+
+	//Lights, as LightBuffer::Upload() would send them
+	{
+		const LightUpdate& update = packet.lights;
+		headlessCounts.lightBytes += update.lightCount * sizeof(Light) + update.clusterCount * sizeof(ClusterRange) +
+			update.indexCount * sizeof(uint32_t) + sizeof(LightingData);
+		headlessCounts.lightIndices += update.indexCount;
+	}
+
+	//The same render graph as Game::Render(), with headless pass bodies
+	if (softwareRasterizer)
+		softwareRasterizer->Upload(packet.instances);
+	{
+		RenderFrame frame = {};
+		frame.packet = &packet;
+		BuildRenderGraph(frame);
+		renderGraph.Execute();
+		AddRecordTimes(frame);
+	}
+}
+
+// --------------------------------------------------------
+// Declares this frame's passes and compiles the graph.
+// Only the pass bodies differ between the D3D11 and
+// headless paths, so headless runs report the same graph.
+// --------------------------------------------------------
+void GameCore::BuildRenderGraph(RenderFrame& frame)
+{
+	frame.game = this;
+
+	unsigned int width = GetWidth();
+	unsigned int height = GetHeight();
+
+	renderGraph.Reset();
+	frame.backBuffer = renderGraph.Import("Back buffer", { width, height, TextureFormat::RGBA8 });
+	frame.depth = renderGraph.CreateTexture("Depth", { width, height, TextureFormat::Depth32F });
+	renderGraph.SetOutput(frame.backBuffer);
+
+	// With a prepass, the scene only reads the depth it left
+	if (frame.packet->depthPrepass)
+	{
+		unsigned int prepass = renderGraph.AddPass("Depth prepass", [](void* f, const RenderGraph& graph) { ((RenderFrame*)f)->game->DepthPrepass(*(RenderFrame*)f, graph); }, &frame);
+		renderGraph.Write(prepass, frame.depth);
+	}
+
+	unsigned int scene = renderGraph.AddPass("Scene", [](void* f, const RenderGraph& graph) { ((RenderFrame*)f)->game->ScenePass(*(RenderFrame*)f, graph); }, &frame);
+	renderGraph.Write(scene, frame.backBuffer);
+	if (frame.packet->depthPrepass)
+		renderGraph.Read(scene, frame.depth);
+	else
+		renderGraph.Write(scene, frame.depth);
+
+	if (frame.packet->ui)
+	{
+		unsigned int ui = renderGraph.AddPass("UI", [](void* f, const RenderGraph& graph) { ((RenderFrame*)f)->game->UIPass(*(RenderFrame*)f, graph); }, &frame);
+		renderGraph.Write(ui, frame.backBuffer);
+	}
+
+	bool compiled = renderGraph.Compile();
+	if (!compiled && !renderGraphError)
+		printf("Render graph: %s\n", renderGraph.GetError());
+	renderGraphError = !compiled;
+
+	// A copy for the inspector, which runs on the other thread
+	std::lock_guard<std::mutex> lock(renderGraphMutex);
+	renderGraphView.stats = renderGraph.GetStats();
+	renderGraphView.error = renderGraph.GetError();
+	renderGraphView.passCount = renderGraph.GetPassCount();
+	for (unsigned int i = 0; i < renderGraphView.passCount; i++)
+	{
+		unsigned int pass = renderGraph.GetOrderedPass(i);
+		renderGraphView.passes[i] = renderGraph.GetPassName(pass);
+		renderGraphView.culled[i] = renderGraph.IsCulled(pass);
+	}
+}
+
+// --------------------------------------------------------
+// Headless: records every view's depth-only draws, and
+// fills in the software rasterizer's depth, if there is one
+// --------------------------------------------------------
+void GameCore::DepthPrepass(RenderFrame& frame, const RenderGraph&)
+{
+	FramePacket& packet = *frame.packet;
+
+	for (unsigned int v = 0; v < packet.viewCount; v++)
+	{
+		const FramePacket::ViewPacket& view = packet.views[v];
+		auto start = std::chrono::high_resolution_clock::now();
+		Systems::Draw(view.draws, view.drawCount, *recordingBackend, true);
+		frame.recordMs[v] += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+		headlessCounts.geometryBinds += recordingBackend->GetSubmittedCount(RecordingCommandBackend::Command::SetGeometry);
+		headlessCounts.draws += recordingBackend->GetSubmittedCount(RecordingCommandBackend::Command::DrawIndexedInstanced);
+	}
+
+	// The software rasterizer only draws the first view
+	if (softwareRasterizer)
+	{
+		softwareRasterizer->Clear(packet.clearColor);
+		softwareRasterizer->Draw(packet.views[0].draws, packet.views[0].drawCount, packet.views[0].camera.drawOffset, SoftwareRasterizer::DepthPass::DepthOnly);
+		headlessCounts.prepassPixels += softwareRasterizer->GetStats().pixels;
+	}
+}
+
+// --------------------------------------------------------
+// Headless: records every view's draws, and draws the
+// first view on the CPU, if there's a rasterizer
+// --------------------------------------------------------
+void GameCore::ScenePass(RenderFrame& frame, const RenderGraph&)
+{
+	FramePacket& packet = *frame.packet;
+
+	//Draws, recorded on the same chunks the deferred contexts would use
+	for (unsigned int v = 0; v < packet.viewCount; v++)
+	{
+		const FramePacket::ViewPacket& view = packet.views[v];
+		auto start = std::chrono::high_resolution_clock::now();
+		Systems::Draw(view.draws, view.drawCount, *recordingBackend);
+		frame.recordMs[v] += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+		headlessCounts.geometryBinds += recordingBackend->GetSubmittedCount(RecordingCommandBackend::Command::SetGeometry);
+		headlessCounts.draws += recordingBackend->GetSubmittedCount(RecordingCommandBackend::Command::DrawIndexedInstanced);
+	}
+
+	//The first view on the CPU, minus the UI
+	if (softwareRasterizer)
+	{
+		if (!packet.depthPrepass)
+			softwareRasterizer->Clear(packet.clearColor);
+		softwareRasterizer->Draw(packet.views[0].draws, packet.views[0].drawCount, packet.views[0].camera.drawOffset,
+			packet.depthPrepass ? SoftwareRasterizer::DepthPass::Equal : SoftwareRasterizer::DepthPass::Full);
+
+		SoftwareRasterizer::Stats stats = softwareRasterizer->GetStats();
+		headlessCounts.rasterizedTriangles += stats.visible;
+		headlessCounts.shadedPixels += stats.shaded;
+		headlessCounts.coveredPixels += stats.covered;
+	}
+}
+
+// --------------------------------------------------------
+// Headless: only counts what ImGui would draw
+// --------------------------------------------------------
+void GameCore::UIPass(RenderFrame& frame, const RenderGraph&)
+{
+	FramePacket& packet = *frame.packet;
+
+	headlessCounts.uiVertices += packet.ui->TotalVtxCount;
+	headlessCounts.uiIndices += packet.ui->TotalIdxCount;
+}
+
+// --------------------------------------------------------
+// Adds a finished frame's recording times to the view
+// costs, which the main thread reads
+// --------------------------------------------------------
+void GameCore::AddRecordTimes(const RenderFrame& frame)
+{
+	std::lock_guard<std::mutex> lock(viewCostsMutex);
+	for (unsigned int v = 0; v < frame.packet->viewCount; v++)
+		viewCosts.recordMs[v] += frame.recordMs[v];
+}
+
+RenderGraph::Stats GameCore::GetRenderGraphStats()
+{
+	std::lock_guard<std::mutex> lock(renderGraphMutex);
+	return renderGraphView.stats;
+}
+
+const GameCore::HeadlessCounts& GameCore::GetHeadlessCounts()
+{
+	return headlessCounts;
+}
+
+// --------------------------------------------------------
+// Starts drawing every headless frame with the software
+// rasterizer too.  The first frame it sees uploads every
+// instance, so it can be turned on at any point.
+// --------------------------------------------------------
+void GameCore::EnableSoftwareRendering()
+{
+	if (!headless || softwareRasterizer)
+		return;
+
+	ALLOCATION_SCOPE("Software raster");
+
+	// The render thread must not be halfway through a frame
+	RenderThread::Flush();
+	instanceBuffer.GetTracker()->MarkAllDirty();
+	softwareRasterizer = std::make_unique<SoftwareRasterizer>(headlessWidth, headlessHeight);
+}
+
+void GameCore::SetFrontToBack(bool enabled)
+{
+	frontToBack = enabled;
+}
+
+void GameCore::SetDepthPrepass(bool enabled)
+{
+	depthPrepass = enabled;
+}
+
+// --------------------------------------------------------
+// New lights over the same area as the old ones.  The
+// render thread may still be reading the old ones, but
+// only its packet's copies.
+// --------------------------------------------------------
+void GameCore::SetLightCount(unsigned int count)
+{
+	lightCount = (int)count;
+	CreateLights(count, lightExtent);
+}
+
+void GameCore::SetLightAnimation(bool enabled)
+{
+	animateLights = enabled;
+}
+
+LightGrid::Stats GameCore::GetLightStats()
+{
+	return lightGrid.GetStats();
+}
+
+// --------------------------------------------------------
+// Takes effect from the next frame.  The costs start over,
+// since they mean something else with another view count.
+// --------------------------------------------------------
+void GameCore::SetViewLayout(ViewLayout layout)
+{
+	viewLayout = layout;
+
+	std::lock_guard<std::mutex> lock(viewCostsMutex);
+	viewCosts = {};
+}
+
+const char* GameCore::GetViewLayoutName(ViewLayout layout)
+{
+	switch (layout)
+	{
+	case ViewLayout::SideBySide: return "split";
+	case ViewLayout::Quad: return "quad";
+	default: return "single";
+	}
+}
+
+GameCore::ViewCosts GameCore::GetViewCosts()
+{
+	std::lock_guard<std::mutex> lock(viewCostsMutex);
+	return viewCosts;
+}
+
+// --------------------------------------------------------
+// Saves the most recent software-rendered frame as a BMP
+// --------------------------------------------------------
+bool GameCore::WriteSoftwareImage(const char* path)
+{
+	if (!softwareRasterizer)
+		return false;
+
+	RenderThread::Flush();
+
+	FILE* file = 0;
+	if (fopen_s(&file, path, "wb") != 0 || !file)
+		return false;
+
+	softwareRasterizer->WriteBMP(file);
+	fclose(file);
+	return true;
+}
@@ -0,0 +1,347 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "Scene.h"
+#include "Systems.h"
+#include "Mesh.h"
+#include "Camera.h"
+#include "InstanceBuffer.h"
+#include "RecordingCommandBackend.h"
+#include "RenderThread.h"
+#include "FixedTimestep.h"
+#include "Profiler.h"
+#include "FrameStats.h"
+#include "Benchmarks.h"
+#include "SoftwareRasterizer.h"
+#include "SyntheticScene.h"
+#include "CameraPath.h"
+#include "RenderGraph.h"
+#include "LightGrid.h"
+#include "LinearAllocator.h"
+
+struct ImDrawList;
+
+// --------------------------------------------------------
+// Everything about the game that needs no window, device
+// or Windows headers: the scene, simulation, culling,
+// lights, render graph, UI and stats.  Draws only ever go
+// through a CommandBackend.
+//
+// - On its own it runs headless: draws are recorded rather
+//   than executed, and everything the GPU would have been
+//   sent is counted instead
+// - Game adds the window, the device and D3D11 on top,
+//   overriding the hooks below
+// --------------------------------------------------------
+class GameCore
+{
+public:
+	GameCore() = default;
+	virtual ~GameCore();
+	GameCore(const GameCore&) = delete; // Remove copy constructor
+	GameCore& operator=(const GameCore&) = delete; // Remove copy-assignment operator
+
+	// No window or device: draws are only written down
+	void InitializeHeadless(unsigned int width, unsigned int height);
+	void Update(float deltaTime, float totalTime);
+	void Draw(float deltaTime, float totalTime);
+	void OnResize();
+
+	// Whether this frame would look any different from the
+	// last one drawn; call after Update().  Frames that don't
+	// can end with SkipDraw() instead of Draw().
+	virtual bool NeedsDraw();
+	void SkipDraw();
+
+	float color[4] = { 0.4f, 0.6f, 0.75f, 0.0f };
+	bool showDemo = false;
+	int num = 200;
+	float fnum = 100;
+	bool check = true;
+	int activeCamera = 0;
+
+	VertexShaderData vsData;
+
+	// What the D3D11 path would have sent to the GPU, added
+	// up over a headless run
+	struct HeadlessCounts
+	{
+		unsigned long long frames;
+		unsigned long long geometryBinds;
+		unsigned long long draws;
+		unsigned long long instanceRanges;
+		unsigned long long instanceBytes;
+		unsigned long long worldViewProjBytes;
+		unsigned long long constantBufferBytes;
+		unsigned long long uiVertices;
+		unsigned long long uiIndices;
+		unsigned long long rasterizedTriangles;
+		unsigned long long shadedPixels;
+		unsigned long long coveredPixels;		// Shaded / covered is the overdraw
+		unsigned long long prepassPixels;		// Depth-only writes
+		unsigned long long lightBytes;			// Lights, cluster ranges, indices and constants
+		unsigned long long lightIndices;
+		unsigned long long visibleEntities;		// Survived culling
+		unsigned long long culledEntities;
+	};
+	const HeadlessCounts& GetHeadlessCounts();
+
+	// The most recently compiled render graph's
+	RenderGraph::Stats GetRenderGraphStats();
+
+	// Swaps every entity for a generated scene and flies the
+	// active camera around its path, once per loopSeconds
+	void LoadSyntheticScene(const SyntheticScene::Spec& spec, float loopSeconds);
+
+	// Headless only: draws every frame on the CPU as well,
+	// so the result can be saved as an image
+	void EnableSoftwareRendering();
+	bool WriteSoftwareImage(const char* path);
+
+	// Opaque draws nearest first, and a depth-only pass ahead
+	// of the main one; both can change between any two frames
+	void SetFrontToBack(bool enabled);
+	void SetDepthPrepass(bool enabled);
+
+	// Replaces the lights with count new ones, scattered over
+	// the current scene; from the next frame on
+	void SetLightCount(unsigned int count);
+
+	// Lights drifting around their starting points, or still
+	void SetLightAnimation(bool enabled);
+
+	// From the most recent frame's light assignment
+	LightGrid::Stats GetLightStats();
+
+	// Several cameras in one frame, each in its own part of
+	// the window.  The first view is always the active camera;
+	// the rest follow it in camera order.
+	enum class ViewLayout { Single, SideBySide, Quad };
+	void SetViewLayout(ViewLayout layout);
+	static const char* GetViewLayoutName(ViewLayout layout);
+
+	// What the views cost, added up since the layout last
+	// changed.  Culling is shared, so only filtering and
+	// recording are per view.
+	struct ViewCosts
+	{
+		unsigned long long frames;
+		unsigned int viewCount;
+		double cullMs;							// Main thread, every view at once
+		unsigned long long candidates;			// In at least one view
+		double filterMs[FramePacket::MaxViews];	// Main thread: filtering, sorting, resolving
+		unsigned long long visible[FramePacket::MaxViews];
+		double recordMs[FramePacket::MaxViews];	// Render thread: every pass's draws
+	};
+	ViewCosts GetViewCosts();
+
+protected:
+	// What one frame's passes need, alive while the graph runs
+	struct RenderFrame
+	{
+		FramePacket* packet;
+		GameCore* game;
+		RenderResource backBuffer;
+		RenderResource depth;
+		double recordMs[FramePacket::MaxViews];	// Each view's draws, over every pass
+	};
+
+	// Everything both ways of running share, once backend
+	// is set: geometry, lights, cameras, budgets and ImGui
+	void InitializeCore();
+
+	// Hands frames over to the render thread, which calls
+	// Render() for each of them
+	void StartRenderThread();
+
+	// Meshes with their geometry copied to the backend, and
+	// released from it again
+	MeshHandle AddMesh(const char* name, Vertex* vertices, size_t vertexCount, unsigned int* indices, size_t indexCount);
+	void RemoveMesh(MeshHandle mesh);
+
+	// Hooks for the platform and the renderer; each default
+	// is the headless one
+	// - The size frames are drawn at
+	// - ImGui's platform/renderer backends, before NewFrame()
+	// - Input for this frame: camera movement and mouse look
+	//   go in cameraMove and pendingMouseX/Y
+	// - Whether the last frame was held back on purpose, so
+	//   its length is no hitch
+	// - The window's own inspector nodes
+	// - Each view's pipeline, and whether the prepass can run
+	virtual unsigned int GetWidth();
+	virtual unsigned int GetHeight();
+	virtual void NewUIFrame();
+	virtual void GatherInput();
+	virtual bool SleptLastFrame();
+	virtual void BuildRendererUI();
+	virtual void ChoosePipelines(FramePacket& packet);
+
+	// Runs on the render thread: turns a packet into the
+	// frame's passes, then each pass into draws
+	virtual void Render(FramePacket& packet);
+	virtual void DepthPrepass(RenderFrame& frame, const RenderGraph& graph);
+	virtual void ScenePass(RenderFrame& frame, const RenderGraph& graph);
+	virtual void UIPass(RenderFrame& frame, const RenderGraph& graph);
+
+	void BuildRenderGraph(RenderFrame& frame);
+	void AddRecordTimes(const RenderFrame& frame);
+
+	//storing all the meshes and cameras densely, reached through handles
+	SlotMap<Mesh> meshes;
+
+	CameraHandle camera;
+	SlotMap<Camera> cameras;
+
+	// Every entity, stored by archetype
+	Scene scene;
+
+	// Where draws are recorded, and where meshes' geometry
+	// is copied to
+	CommandBackend* backend = 0;
+
+	// The frame's passes, rebuilt and compiled on the render
+	// thread each frame
+	RenderGraph renderGraph;
+
+	// Scratch for the main thread's transient data (UI labels,
+	// id lists), reset once the frame has been submitted
+	LinearAllocator frameMemory{ 64 * 1024 };
+
+	// Mouse movement not yet spent by a step, and which way
+	// the camera is being moved this frame
+	float pendingMouseX = 0;
+	float pendingMouseY = 0;
+	DirectX::XMFLOAT3 cameraMove = {};
+
+	// Persistent per-entity world matrices and tints
+	InstanceBuffer instanceBuffer;
+
+	// Clustered lighting
+	// - Where each light started, and where it is this frame
+	// - Assigned to clusters on the main thread each frame;
+	//   the render thread sends them on
+	std::vector<Light> lightStarts;
+	std::vector<Light> lights;
+	int lightCount = 512;
+	float lightExtent = 3.0f;	// Half the width of the area lights go in
+	float ambient = 0.15f;
+	bool animateLights = false;	// Off, so an idle scene is still
+	LightGrid lightGrid;
+
+	// Overdraw controls, read once per frame
+	bool frontToBack = true;
+	bool depthPrepass = false;
+
+private:
+	void CreateGeometry();
+	void CreateLights(unsigned int count, float extent);
+	void MoveLights(float totalTime);
+	void ImGuiUpdate(float deltaTime);
+	void BuildUI();
+	void BuildProfilerUI();
+	void BuildFrameStatsUI();
+	void BuildMemoryUI();
+	void MarkLiveWindow();
+	void WriteHitchTrace();
+	void SetUpViews(FramePacket& packet, float alpha);
+	float GetAspectRatio();
+	void Simulate(float stepSeconds);
+	EntityId SpawnEntity(MeshHandle mesh, DirectX::XMFLOAT3 position, uint32_t flags);
+	void DestroyEntity(EntityId id);
+
+	// Where the camera flies in a synthetic scene, and the
+	// meshes it was built from
+	CameraPath syntheticPath;
+	std::vector<MeshHandle> syntheticMeshes;
+
+	// Which entity owns each instance buffer slot
+	std::vector<EntityId> instanceOwners;
+
+	// What survived culling this frame: everything any view
+	// can see, then each view's share of it
+	Systems::SharedPackets sharedPackets;
+	std::vector<Systems::DrawPacket> viewPackets[FramePacket::MaxViews];
+
+	// How the window is split between cameras, and what that costs
+	ViewLayout viewLayout = ViewLayout::Single;
+	std::mutex viewCostsMutex;
+	ViewCosts viewCosts = {};
+
+	bool renderGraphError = false;
+
+	// What the inspector shows of the render graph, copied
+	// after each compile
+	struct RenderGraphView
+	{
+		RenderGraph::Stats stats;
+		const char* error;
+		unsigned int passCount;
+		const char* passes[RenderGraph::MaxPasses];	// In execution order
+		bool culled[RenderGraph::MaxPasses];
+	};
+	std::mutex renderGraphMutex;
+	RenderGraphView renderGraphView = {};
+
+	// Headless runs record into this, and may draw on the CPU too
+	bool headless = false;
+	unsigned int headlessWidth = 1;
+	unsigned int headlessHeight = 1;
+	std::unique_ptr<RecordingCommandBackend> recordingBackend;
+	std::unique_ptr<SoftwareRasterizer> softwareRasterizer;
+	HeadlessCounts headlessCounts = {};
+
+	// The packet this frame's simulation is filling in
+	FramePacket* framePacket = 0;
+
+	// Fixed-step simulation, with drawing blended between
+	// the last two steps
+	FixedTimestep timestep;
+	bool interpolate = true;
+	std::vector<Systems::MovingInstance> movingInstances;
+
+	// The UI's draw data this frame and in the last frame
+	// drawn, hashed, and whether the next frame must be drawn
+	// regardless (after a resize, say)
+	uint64_t uiHash = 0;
+	uint64_t drawnUiHash = 0;
+	bool drawRequested = true;
+
+	// Windows left out of uiHash, rebuilt with the UI
+	static constexpr unsigned int MaxLiveWindows = 4;
+	const ImDrawList* liveDrawLists[MaxLiveWindows] = {};
+	unsigned int liveDrawListCount = 0;
+
+	// Smoothed costs, for the inspector
+	unsigned int lastStepCount = 0;
+	float stepMs = 0;
+	float interpolateMs = 0;
+
+	// Results of the most recent benchmark run from the inspector
+	std::vector<Benchmarks::Result> benchmarkResults;
+
+	// The frame the profiler window shows
+	std::vector<Profiler::ThreadEvents> profilerThreads;
+	uint64_t profilerFrameStart = 0;
+	uint64_t profilerFrameEnd = 0;
+	bool profilerPaused = false;
+	int profilerFramesAgo = 0;
+	int profilerExportFrames = 120;
+	std::vector<uint32_t> profilerOpenDepths;
+	std::string profilerExportStatus;
+
+	// Frame times, and profiler traces of the worst ones
+	// - A hitch's trace is written hitchContextFrames later, so
+	//   it holds that many frames from either side of it
+	FrameStats frameStats;
+	bool writeHitchTraces = true;
+	int maxHitchTraces = 10;
+	unsigned int hitchTracesWritten = 0;
+	unsigned int hitchTraceCountdown = 0;
+	uint64_t hitchFrame = 0;
+	std::string lastHitchTrace;
+	static const unsigned int hitchContextFrames = 5;
+};
@@ -1,5 +1,7 @@
 #include "Graphics.h"
+#include "AllocationTracker.h"
 #include <dxgi1_6.h>
+#include <atomic>
 
 // Tell the drivers to use high-performance GPU in multi-GPU systems (like laptops)
 extern "C"
@@ -22,6 +24,57 @@ namespace Graphics
 		D3D_FEATURE_LEVEL featureLevel;
 
 		Microsoft::WRL::ComPtr<ID3D11InfoQueue> InfoQueue;
+
+		// Identifies the tracker in a resource's private data
+		// {6B1F3C52-8E0A-4D67-9B3E-2C5D7A41F908}
+		const GUID TrackedMemoryGuid = { 0x6b1f3c52, 0x8e0a, 0x4d67, { 0x9b, 0x3e, 0x2c, 0x5d, 0x7a, 0x41, 0xf9, 0x08 } };
+
+		// Stored as a resource's private data, which D3D releases
+		// along with the resource, so the bytes are handed back
+		// exactly when the resource goes away
+		class TrackedMemory : public IUnknown
+		{
+		public:
+			TrackedMemory(unsigned int tag, long long bytes) : tag(tag), bytes(bytes)
+			{
+				AllocationTracker::AddGpuBytes(tag, bytes);
+			}
+
+			HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** object) override
+			{
+				if (!object)
+					return E_POINTER;
+				if (riid != __uuidof(IUnknown))
+				{
+					*object = 0;
+					return E_NOINTERFACE;
+				}
+				AddRef();
+				*object = this;
+				return S_OK;
+			}
+
+			ULONG STDMETHODCALLTYPE AddRef() override
+			{
+				return ++references;
+			}
+
+			ULONG STDMETHODCALLTYPE Release() override
+			{
+				ULONG remaining = --references;
+				if (remaining == 0)
+				{
+					AllocationTracker::AddGpuBytes(tag, -bytes);
+					delete this;
+				}
+				return remaining;
+			}
+
+		private:
+			std::atomic<ULONG> references{ 1 };
+			unsigned int tag;
+			long long bytes;
+		};
 	}
 }
 
@@ -297,3 +350,21 @@ void Graphics::PrintDebugMessages()
 	// Clear any messages we've printed
 	InfoQueue->ClearStoredMessages();
 }
+
+
+// --------------------------------------------------------
+// The size is the buffer's ByteWidth - an estimate, since
+// drivers may pad or round it up
+// --------------------------------------------------------
+void Graphics::TrackBufferMemory(ID3D11Buffer* buffer, const char* tag)
+{
+	if (!buffer)
+		return;
+
+	D3D11_BUFFER_DESC desc = {};
+	buffer->GetDesc(&desc);
+
+	TrackedMemory* tracked = new TrackedMemory(AllocationTracker::RegisterTag(tag), desc.ByteWidth);
+	buffer->SetPrivateDataInterface(TrackedMemoryGuid, tracked);
+	tracked->Release();
+}
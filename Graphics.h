@@ -34,4 +34,8 @@ namespace Graphics
 
 	// Debug Layer
 	void PrintDebugMessages();
+
+	// Charges a buffer's size to an allocation tag until the
+	// buffer is destroyed, however many references it had
+	void TrackBufferMemory(ID3D11Buffer* buffer, const char* tag);
 }
\ No newline at end of file
@@ -0,0 +1,343 @@
+#include "Headless.h"
+#include "Profiler.h"
+#include "FrameStats.h"
+#include "RenderThread.h"
+#include "AllocationTracker.h"
+#include "CrtCompat.h"
+
+#include <map>
+#include <chrono>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <cstdlib>
+
+namespace Headless
+{
+	// Annonymous namespace to hold helpers
+	// only accessible in this file
+	namespace
+	{
+		// "Worker 3" and "Worker 12" are the same kind of thread
+		std::string ThreadKind(const std::string& name)
+		{
+			size_t end = name.size();
+			while (end > 0 && (isdigit((unsigned char)name[end - 1]) || name[end - 1] == ' '))
+				end--;
+			return end > 0 ? name.substr(0, end) : name;
+		}
+
+		// Adds every scope that ended during the most recently
+		// finished profiler frame
+		void AddLastFrame(std::vector<Phase>& phases, std::map<std::string, size_t>& lookup, std::vector<Profiler::ThreadEvents>& threads)
+		{
+			uint64_t start = 0;
+			uint64_t end = 0;
+			if (!Profiler::GetFrameRange(0, start, end))
+				return;
+
+			Profiler::Collect(start, end, threads);
+			for (const Profiler::ThreadEvents& thread : threads)
+			{
+				std::string kind = ThreadKind(thread.name);
+				for (const Profiler::Event& e : thread.events)
+				{
+					if (e.end < start || e.end >= end)
+						continue;
+
+					std::string key = kind + '\n' + e.name;
+					auto found = lookup.find(key);
+					if (found == lookup.end())
+					{
+						found = lookup.emplace(key, phases.size()).first;
+						phases.push_back({ kind, e.name, 0, 0.0, 0.0 });
+					}
+
+					Phase& phase = phases[found->second];
+					double ms = Profiler::TicksToMilliseconds(e.end - e.start);
+					phase.calls++;
+					phase.totalMs += ms;
+					if (ms > phase.maxMs)
+						phase.maxMs = ms;
+				}
+			}
+		}
+
+		// Adds the most recently finished frame's allocations,
+		// other than the run's own
+		void AddAllocations(AllocationTracker::Counts* steady, unsigned int harnessTag)
+		{
+			for (unsigned int t = 0; t < AllocationTracker::GetTagCount(); t++)
+			{
+				if (t == harnessTag)
+					continue;
+
+				AllocationTracker::Counts frame = AllocationTracker::GetLastFrame(t);
+				steady[t].allocations += frame.allocations;
+				steady[t].bytes += frame.bytes;
+			}
+		}
+	}
+}
+
+
+// --------------------------------------------------------
+// Each frame is Update() then Draw(), exactly as the main
+// loop does it, with no input at all
+// --------------------------------------------------------
+void Headless::Run(const Options& options, Report& outReport)
+{
+	using Clock = std::chrono::steady_clock;
+
+	outReport = Report();
+	outReport.frames = options.frames;
+	outReport.width = options.width;
+	outReport.height = options.height;
+	outReport.frontToBack = options.frontToBack;
+	outReport.depthPrepass = options.depthPrepass;
+	outReport.viewLayout = options.viewLayout;
+
+	Profiler::SetThreadName("Main");
+
+	// Must match the ALLOCATION_SCOPE()s below
+	unsigned int harnessTag = AllocationTracker::RegisterTag("Headless");
+	AllocationTracker::Counts steady[AllocationTracker::MaxTags] = {};
+
+	GameCore* game = new GameCore();
+	game->InitializeHeadless(options.width, options.height);
+	if (options.scene)
+		game->LoadSyntheticScene(*options.scene, options.frames * options.deltaTime);
+	if (!options.imagePath.empty())
+		game->EnableSoftwareRendering();
+	game->SetFrontToBack(options.frontToBack);
+	game->SetDepthPrepass(options.depthPrepass);
+	game->SetLightCount(options.lights);
+	game->SetLightAnimation(options.animateLights);
+	game->SetViewLayout(options.viewLayout);
+
+	FrameStats frameTimes(options.frames > 0 ? options.frames : 1);
+	std::map<std::string, size_t> lookup;
+	std::vector<Profiler::ThreadEvents> threads;
+
+	Clock::time_point runStart = Clock::now();
+	float totalTime = 0;
+	for (unsigned int f = 0; f < options.frames; f++)
+	{
+		// Tally the previous frame before this one's clock starts
+		Profiler::BeginFrame();
+		AllocationTracker::BeginFrame();
+		if (f > options.warmupFrames)
+			AddAllocations(steady, harnessTag);
+		{
+			ALLOCATION_SCOPE("Headless");
+			AddLastFrame(outReport.phases, lookup, threads);
+		}
+
+		Clock::time_point frameStart = Clock::now();
+		totalTime += options.deltaTime;
+		game->Update(options.deltaTime, totalTime);
+		if (!options.skipUnchanged || game->NeedsDraw())
+			game->Draw(options.deltaTime, totalTime);
+		else
+		{
+			game->SkipDraw();
+			outReport.skippedDraws++;
+		}
+		frameTimes.AddFrame(std::chrono::duration<float, std::milli>(Clock::now() - frameStart).count());
+	}
+
+	// Let the render thread catch up, then close the last frame
+	RenderThread::Flush();
+	outReport.totalMs = std::chrono::duration<double, std::milli>(Clock::now() - runStart).count();
+	Profiler::BeginFrame();
+	AllocationTracker::BeginFrame();
+	if (options.frames > options.warmupFrames)
+		AddAllocations(steady, harnessTag);
+	AddLastFrame(outReport.phases, lookup, threads);
+
+	outReport.steadyFrames = options.frames > options.warmupFrames ? options.frames - options.warmupFrames : 0;
+	outReport.steadyAllocations = 0;
+	for (unsigned int t = 0; t < AllocationTracker::GetTagCount(); t++)
+	{
+		if (steady[t].allocations == 0)
+			continue;
+
+		outReport.allocations.push_back({ AllocationTracker::GetTagName(t), steady[t].allocations, steady[t].bytes });
+		outReport.steadyAllocations += steady[t].allocations;
+	}
+
+	std::sort(outReport.phases.begin(), outReport.phases.end(), [](const Phase& a, const Phase& b) { return a.totalMs > b.totalMs; });
+
+	outReport.frameP50Ms = frameTimes.GetPercentile(50.0f);
+	outReport.frameP95Ms = frameTimes.GetPercentile(95.0f);
+	outReport.frameP99Ms = frameTimes.GetPercentile(99.0f);
+	outReport.frameMaxMs = frameTimes.GetMax();
+	outReport.counts = game->GetHeadlessCounts();
+	outReport.renderGraph = game->GetRenderGraphStats();
+	outReport.lights = game->GetLightStats();
+	outReport.views = game->GetViewCosts();
+
+	for (unsigned int t = 0; t < AllocationTracker::GetTagCount(); t++)
+		outReport.memory.push_back(AllocationTracker::GetMemory(t));
+	if (!options.memoryReportPath.empty())
+	{
+		FILE* file = 0;
+		if (fopen_s(&file, options.memoryReportPath.c_str(), "w") == 0 && file)
+		{
+			AllocationTracker::WriteJSON(file);
+			fclose(file);
+		}
+	}
+	if (!options.imagePath.empty() && game->WriteSoftwareImage(options.imagePath.c_str()))
+		outReport.imageWritten = options.imagePath;
+
+	delete game;
+}
+
+void Headless::Print(const Report& report, FILE* file)
+{
+	double frames = report.frames > 0 ? (double)report.frames : 1.0;
+
+	fprintf(file, "Headless run: %u frames at %ux%u in %.1f ms\n", report.frames, report.width, report.height, report.totalMs);
+	fprintf(file, "Draw order: %s, depth prepass: %s\n", report.frontToBack ? "front to back" : "scene", report.depthPrepass ? "on" : "off");
+	fprintf(file, "Update + Draw: p50 %.3f ms, p95 %.3f ms, p99 %.3f ms, max %.3f ms\n\n",
+		report.frameP50Ms, report.frameP95Ms, report.frameP99Ms, report.frameMaxMs);
+
+	fprintf(file, "%-10s %-24s %12s %12s %12s\n", "Thread", "Phase", "Calls/frame", "ms/frame", "Max ms");
+	for (const Phase& p : report.phases)
+		fprintf(file, "%-10s %-24s %12.2f %12.4f %12.4f\n", p.thread.c_str(), p.name.c_str(), p.calls / frames, p.totalMs / frames, p.maxMs);
+
+	const GameCore::HeadlessCounts& c = report.counts;
+	if (report.skippedDraws > 0)
+		fprintf(file, "\nDraws skipped with nothing new to show: %llu of %u frames\n", report.skippedDraws, report.frames);
+	fprintf(file, "\nPer rendered frame (%llu frames):\n", c.frames);
+	double rendered = c.frames > 0 ? (double)c.frames : 1.0;
+	fprintf(file, "  Visible entities:     %10.1f\n", c.visibleEntities / rendered);
+	fprintf(file, "  Culled entities:      %10.1f\n", c.culledEntities / rendered);
+	fprintf(file, "  Draws:                %10.1f\n", c.draws / rendered);
+	fprintf(file, "  Geometry binds:       %10.1f\n", c.geometryBinds / rendered);
+	fprintf(file, "  Instance ranges:      %10.1f\n", c.instanceRanges / rendered);
+	fprintf(file, "  Instance bytes:       %10.1f\n", c.instanceBytes / rendered);
+	fprintf(file, "  WVP bytes:            %10.1f\n", c.worldViewProjBytes / rendered);
+	fprintf(file, "  Constant buffer bytes:%10.1f\n", c.constantBufferBytes / rendered);
+	fprintf(file, "  UI vertices:          %10.1f\n", c.uiVertices / rendered);
+	fprintf(file, "  UI indices:           %10.1f\n", c.uiIndices / rendered);
+
+	if (c.rasterizedTriangles > 0 || !report.imageWritten.empty())
+	{
+		// Raster phases are on the render thread and workers alike
+		double rasterMs = 0;
+		for (const Phase& p : report.phases)
+		{
+			if (p.name == "Software raster")
+				rasterMs += p.totalMs;
+		}
+
+		fprintf(file, "\nSoftware rasterizer:\n");
+		fprintf(file, "  Triangles per frame:  %10.1f\n", c.rasterizedTriangles / rendered);
+		fprintf(file, "  Pixels per frame:     %10.1f\n", c.shadedPixels / rendered);
+		fprintf(file, "  Covered per frame:    %10.1f\n", c.coveredPixels / rendered);
+		if (c.coveredPixels > 0)
+			fprintf(file, "  Overdraw:             %10.3f shaded per covered pixel\n", (double)c.shadedPixels / c.coveredPixels);
+		if (report.depthPrepass)
+			fprintf(file, "  Prepass depth writes: %10.1f\n", c.prepassPixels / rendered);
+		if (rasterMs > 0)
+		{
+			fprintf(file, "  Mtris/s:              %10.2f\n", c.rasterizedTriangles / (rasterMs * 1000.0));
+			fprintf(file, "  Mpixels/s:            %10.2f\n", c.shadedPixels / (rasterMs * 1000.0));
+		}
+		if (!report.imageWritten.empty())
+			fprintf(file, "  Last frame saved to %s\n", report.imageWritten.c_str());
+	}
+
+	const RenderGraph::Stats& g = report.renderGraph;
+	fprintf(file, "\nRender graph: %u passes, %u culled\n", g.passes, g.culledPasses);
+	fprintf(file, "  Transient textures:   %u on %u physical\n", g.transientTextures, g.physicalTextures);
+	fprintf(file, "  Transient MB:         %10.2f (%.2f without aliasing, %.2f peak live)\n",
+		g.allocatedBytes / (1024.0 * 1024.0), g.transientBytes / (1024.0 * 1024.0), g.peakLiveBytes / (1024.0 * 1024.0));
+
+	const LightGrid::Stats& l = report.lights;
+	fprintf(file, "\nClustered lights: %u lights, %u clusters, %u with lights\n", l.lights, l.clusters, l.occupiedClusters);
+	fprintf(file, "  Light indices:        %10u (most in one cluster: %u)\n", l.indices, l.maxPerCluster);
+	fprintf(file, "  Sphere tests:         %10llu\n", l.sphereTests);
+	fprintf(file, "  Upload bytes:         %10.1f per frame\n", c.lightBytes / rendered);
+
+	// Culling once for every view, then each view's own share
+	const GameCore::ViewCosts& v = report.views;
+	double viewFrames = v.frames > 0 ? (double)v.frames : 1.0;
+	double viewTotalMs = v.cullMs;
+	fprintf(file, "\nViews: %u (%s layout)\n", v.viewCount, GameCore::GetViewLayoutName(report.viewLayout));
+	fprintf(file, "  Shared culling:       %10.4f ms per frame, %.1f in any view\n", v.cullMs / viewFrames, v.candidates / viewFrames);
+	for (unsigned int i = 0; i < v.viewCount; i++)
+	{
+		fprintf(file, "  View %u:               %10.1f visible, filter %.4f ms, record %.4f ms\n", i + 1,
+			v.visible[i] / viewFrames, v.filterMs[i] / viewFrames, v.recordMs[i] / viewFrames);
+		viewTotalMs += v.filterMs[i] + v.recordMs[i];
+	}
+	fprintf(file, "  Total:                %10.4f ms per frame\n", viewTotalMs / viewFrames);
+
+	fprintf(file, "\nHeap allocations over %u steady frames: %llu\n", report.steadyFrames, report.steadyAllocations);
+	double steadyFrames = report.steadyFrames > 0 ? (double)report.steadyFrames : 1.0;
+	for (const TagAllocations& a : report.allocations)
+		fprintf(file, "  %-20s %10.2f per frame, %10.1f bytes per frame\n", a.tag.c_str(), a.allocations / steadyFrames, a.bytes / steadyFrames);
+
+	const double mb = 1024.0 * 1024.0;
+	fprintf(file, "\n%-20s %10s %10s %12s %10s\n", "Memory", "Live MB", "Peak MB", "Live allocs", "GPU MB");
+	for (const AllocationTracker::TagMemory& m : report.memory)
+		fprintf(file, "%-20s %10.2f %10.2f %12llu %10.2f\n", m.name, m.liveBytes / mb, m.peakBytes / mb, m.liveAllocations, m.gpuBytes / mb);
+}
+
+void Headless::ParseOptions(const char* commandLine, Options& options)
+{
+	const char* frames = strstr(commandLine, "-frames ");
+	if (frames)
+		options.frames = (unsigned int)atoi(frames + strlen("-frames "));
+	if (strstr(commandLine, "-unsorted"))
+		options.frontToBack = false;
+	if (strstr(commandLine, "-depth-prepass"))
+		options.depthPrepass = true;
+	const char* lights = strstr(commandLine, "-lights ");
+	if (lights)
+		options.lights = (unsigned int)atoi(lights + strlen("-lights "));
+	if (strstr(commandLine, "-animate-lights"))
+		options.animateLights = true;
+	if (strstr(commandLine, "-skip-unchanged"))
+		options.skipUnchanged = true;
+	if (strstr(commandLine, "-views split"))
+		options.viewLayout = GameCore::ViewLayout::SideBySide;
+	else if (strstr(commandLine, "-views quad"))
+		options.viewLayout = GameCore::ViewLayout::Quad;
+}
+
+int Headless::RunCommandLine(const char* commandLine)
+{
+	Options options;
+	ParseOptions(commandLine, options);
+
+	const char* image = strstr(commandLine, "-image ");
+	if (image)
+	{
+		image += strlen("-image ");
+		options.imagePath = std::string(image, strcspn(image, " "));
+	}
+
+	options.memoryReportPath = "Memory.json";
+
+	Report report;
+	Run(options, report);
+	Print(report, stdout);
+
+	FILE* file = 0;
+	if (fopen_s(&file, "Headless.txt", "w") == 0 && file)
+	{
+		Print(report, file);
+		fclose(file);
+	}
+
+	if (strstr(commandLine, "-check-allocations") && report.steadyAllocations > 0)
+	{
+		printf("FAILED: %llu heap allocations in steady-state frames\n", report.steadyAllocations);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdio>
+
+#include "GameCore.h"
+#include "AllocationTracker.h"
+
+// --------------------------------------------------------
+// Runs the game for a fixed number of frames with no
+// window or device, for CPU-side numbers on machines
+// without a GPU
+//
+// - The game comes up through GameCore::InitializeHeadless():
+//   meshes and instances stay CPU-side, and the render
+//   thread records draws instead of executing them
+// - Every frame advances by the same fixed delta, so two
+//   runs do exactly the same work
+// - Per-phase timings come from the profiler's markers;
+//   each scope counts towards the frame it ended in
+// - A synthetic scene can stand in for the usual one, for
+//   repeatable runs at any size
+// - Given an image path, every frame is also drawn by the
+//   software rasterizer and the last one is saved there
+// - Heap allocations are counted per tag once the warm-up
+//   frames are over, when a steady frame should make none.
+//   The run's own bookkeeping is tagged "Headless" and left
+//   out.
+// - Memory per tag is taken at the end of the run, before
+//   the game goes away
+// - The render graph is compiled every frame just as with a
+//   device, so its pass culling and transient memory are
+//   reported too
+// - Draw order and the depth prepass can be set either way,
+//   and the software rasterizer reports the overdraw that
+//   results, for comparing runs
+// - Lights are assigned to clusters every frame as usual,
+//   though the software rasterizer draws unlit
+// - Frames can skip Draw() when NeedsDraw() says they'd
+//   look like the last one drawn, as the paced main loop
+//   does; with no input, a still scene should skip most
+// - Several views cull together and draw separately; the
+//   software rasterizer only draws the first of them
+//
+// It needs nothing from Windows, so besides "-headless" in
+// the Windows executable it builds on its own as the
+// portable Headless target in CMakeLists.txt.
+// --------------------------------------------------------
+namespace Headless
+{
+	struct Options
+	{
+		unsigned int frames = 600;
+		unsigned int width = 1280;
+		unsigned int height = 720;
+		float deltaTime = 1.0f / 60.0f;
+		unsigned int warmupFrames = 60;	// Left out of the allocation counts
+		std::string memoryReportPath;	// AllocationTracker::WriteJSON() goes here, if set
+		std::string imagePath;	// Empty for no software rendering
+		bool frontToBack = true;
+		bool depthPrepass = false;
+		unsigned int lights = 512;		// Assigned to clusters every frame
+		bool animateLights = false;
+		bool skipUnchanged = false;		// SkipDraw() when NeedsDraw() is false
+		GameCore::ViewLayout viewLayout = GameCore::ViewLayout::Single;
+
+		// Replaces the usual scene, with the camera flying one
+		// lap of the scene's path over the whole run
+		const SyntheticScene::Spec* scene = 0;
+	};
+
+	// One profiler scope on one kind of thread
+	struct Phase
+	{
+		std::string thread;		// Numbered threads ("Worker 3") are merged
+		std::string name;
+		unsigned long long calls;
+		double totalMs;
+		double maxMs;			// Longest single call
+	};
+
+	// Heap allocations under one tag, after the warm-up
+	struct TagAllocations
+	{
+		std::string tag;
+		unsigned long long allocations;
+		unsigned long long bytes;
+	};
+
+	struct Report
+	{
+		unsigned int frames;
+		unsigned int width;
+		unsigned int height;
+		double totalMs;
+		bool frontToBack;
+		bool depthPrepass;
+
+		// Update() + Draw() on the main thread
+		float frameP50Ms;
+		float frameP95Ms;
+		float frameP99Ms;
+		float frameMaxMs;
+
+		std::vector<Phase> phases;	// Most total time first
+		GameCore::HeadlessCounts counts;
+		unsigned long long skippedDraws;	// Frames that ended in SkipDraw()
+		std::string imageWritten;	// Empty if none was
+
+		unsigned int steadyFrames;					// Frames after the warm-up
+		unsigned long long steadyAllocations;		// Over all of them
+		std::vector<TagAllocations> allocations;	// Tags that allocated at all
+		std::vector<AllocationTracker::TagMemory> memory;
+
+		RenderGraph::Stats renderGraph;	// The last frame's
+		LightGrid::Stats lights;		// The last frame's
+		GameCore::ViewLayout viewLayout;
+		GameCore::ViewCosts views;			// Added up over the whole run
+	};
+
+	void Run(const Options& options, Report& outReport);
+
+	// Writes a report as plain text
+	void Print(const Report& report, FILE* file);
+
+	// Options from command line arguments, for any run of the
+	// game: "-frames N", "-unsorted", "-depth-prepass",
+	// "-lights N", "-animate-lights", "-skip-unchanged" and
+	// "-views split|quad".  Anything not given is left as it
+	// was.
+	void ParseOptions(const char* commandLine, Options& options);
+
+	// A whole run from command line arguments (the above, plus
+	// "-image Frame.bmp" and "-check-allocations" - see
+	// Main.cpp), printed to the console and to Headless.txt.
+	// Returns the process's exit code.
+	int RunCommandLine(const char* commandLine);
+}
@@ -0,0 +1,26 @@
+#include <string>
+#include <cstring>
+
+#include "Headless.h"
+#include "BenchmarkSuite.h"
+
+// --------------------------------------------------------
+// Entry point for the portable Headless target: the same
+// run as "-headless" in the Windows executable, taking the
+// same arguments ("-frames 600", "-image Frame.bmp", ...),
+// or the benchmark suite with "-benchmark-suite"
+// --------------------------------------------------------
+int main(int argc, char** argv)
+{
+	// Joined back up the way WinMain() would have been given them
+	std::string commandLine;
+	for (int i = 1; i < argc; i++)
+	{
+		commandLine += argv[i];
+		commandLine += ' ';
+	}
+
+	if (strstr(commandLine.c_str(), "-benchmark-suite"))
+		return BenchmarkSuite::RunCommandLine(commandLine.c_str());
+	return Headless::RunCommandLine(commandLine.c_str());
+}
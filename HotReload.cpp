@@ -0,0 +1,210 @@
+#include "HotReload.h"
+#include "Profiler.h"
+
+#include <thread>
+#include <mutex>
+#include <vector>
+#include <memory>
+#include <cstdio>
+
+using Clock = std::chrono::steady_clock;
+
+namespace HotReload
+{
+	// Annonymous namespace to hold variables
+	// only accessible in this file
+	namespace
+	{
+		struct Watched
+		{
+			std::wstring path;
+			ReloadFunction function;
+			void* data;
+		};
+
+		// A change that hasn't settled yet
+		struct Settling
+		{
+			FileWatcher::Change change;
+			Clock::time_point lastSeen;
+		};
+
+		std::thread thread;
+		bool running = false;
+
+		// Shared with the reload thread.  The watcher itself is
+		// only ever touched by the reload thread; new files and
+		// watcher switches are handed over through here.
+		std::mutex mutex;
+		std::vector<Watched> watched;
+		size_t watchedByThread = 0;
+		bool notifications = true;
+		bool watcherChanged = false;
+		bool quit = false;
+		Stats stats = {};
+
+		double Milliseconds(Clock::duration d)
+		{
+			return std::chrono::duration<double, std::milli>(d).count();
+		}
+
+		void ReloadMain()
+		{
+			Profiler::SetThreadName("Hot reload");
+
+			std::unique_ptr<FileWatcher> watcher;
+			std::vector<FileWatcher::Change> changes;
+			std::vector<Settling> settling;
+			std::vector<Watched> reloads;
+
+			while (true)
+			{
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					if (quit)
+						break;
+
+					if (!watcher || watcherChanged)
+					{
+						watcher = CreateFileWatcher(notifications);
+						stats.watcher = watcher->GetName();
+						watchedByThread = 0;
+						watcherChanged = false;
+					}
+					for (; watchedByThread < watched.size(); watchedByThread++)
+						watcher->Watch(watched[watchedByThread].path);
+				}
+
+				// Short waits while something is settling, so it's
+				// picked up on time
+				changes.clear();
+				watcher->GetChanges(changes, settling.empty() ? 100 : 5);
+
+				Clock::time_point now = Clock::now();
+				for (const FileWatcher::Change& c : changes)
+				{
+					bool found = false;
+					for (Settling& s : settling)
+					{
+						if (s.change.path == c.path)
+						{
+							s.lastSeen = now;
+							found = true;
+						}
+					}
+					if (!found)
+						settling.push_back({ c, now });
+				}
+
+				for (size_t s = 0; s < settling.size(); )
+				{
+					if (Milliseconds(now - settling[s].lastSeen) < settleMs)
+					{
+						s++;
+						continue;
+					}
+
+					FileWatcher::Change change = settling[s].change;
+					settling.erase(settling.begin() + s);
+
+					reloads.clear();
+					{
+						std::lock_guard<std::mutex> lock(mutex);
+						for (const Watched& w : watched)
+						{
+							if (w.path == change.path)
+								reloads.push_back(w);
+						}
+						stats.changes++;
+						stats.lastFile = change.path;
+					}
+
+					bool succeeded = true;
+					{
+						PROFILE_SCOPE("Reload");
+						for (const Watched& w : reloads)
+							succeeded = w.function(w.data, change) && succeeded;
+					}
+
+					std::lock_guard<std::mutex> lock(mutex);
+					stats.lastBuildMs = Milliseconds(Clock::now() - change.noticed);
+					if (!succeeded)
+						stats.failures++;
+				}
+			}
+		}
+	}
+}
+
+
+void HotReload::Initialize(bool useNotifications)
+{
+	if (running)
+		ShutDown();
+
+	notifications = useNotifications;
+	watcherChanged = false;
+	quit = false;
+	stats = {};
+
+	running = true;
+	thread = std::thread(ReloadMain);
+}
+
+void HotReload::ShutDown()
+{
+	if (!running)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+	thread.join();
+	running = false;
+
+	watched.clear();
+	watchedByThread = 0;
+}
+
+void HotReload::Watch(const std::wstring& path, ReloadFunction function, void* data)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	watched.push_back({ path, function, data });
+	stats.watchedFiles = (unsigned int)watched.size();
+}
+
+void HotReload::SetNotifications(bool useNotifications)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (notifications == useNotifications)
+		return;
+
+	notifications = useNotifications;
+	watcherChanged = true;
+}
+
+bool HotReload::UsesNotifications()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return notifications;
+}
+
+void HotReload::Applied(std::chrono::steady_clock::time_point noticed)
+{
+	double ms = Milliseconds(Clock::now() - noticed);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	stats.applied++;
+	stats.lastLatencyMs = ms;
+	if (ms > stats.worstLatencyMs)
+		stats.worstLatencyMs = ms;
+
+	printf("Hot reload: %ls in use %.1f ms after it changed\n", stats.lastFile.c_str(), ms);
+}
+
+HotReload::Stats HotReload::GetStats()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return stats;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <chrono>
+#include "FileWatcher.h"
+
+// --------------------------------------------------------
+// Reloads files when they change on disk, on a thread of
+// its own
+//
+// - Each watched file has a function that rebuilds whatever
+//   came from it.  That runs on the reload thread, and
+//   should only get the new version ready; swapping it in
+//   is left to whoever owns it, at a frame boundary.
+// - Changes are given settleMs to stop coming before the
+//   file is read, since editors often write more than once
+// - Latency runs from the change being noticed to Applied()
+//   being called for it, after the swap
+// --------------------------------------------------------
+namespace HotReload
+{
+	const unsigned int settleMs = 30;
+
+	// Runs on the reload thread.  Returns false if the file
+	// couldn't be used, in which case the old version stays.
+	typedef bool (*ReloadFunction)(void* data, const FileWatcher::Change& change);
+
+	void Initialize(bool useNotifications);
+	void ShutDown();
+
+	void Watch(const std::wstring& path, ReloadFunction function, void* data);
+
+	// Switches watchers, keeping every watched file
+	void SetNotifications(bool useNotifications);
+	bool UsesNotifications();
+
+	// Called once a reload's results are in use
+	void Applied(std::chrono::steady_clock::time_point noticed);
+
+	struct Stats
+	{
+		const char* watcher;
+		unsigned int watchedFiles;
+		unsigned int changes;		// Files seen to change (once settled)
+		unsigned int failures;		// Reloads that kept the old version
+		unsigned int applied;
+		double lastBuildMs;			// Noticed to rebuilt
+		double lastLatencyMs;		// Noticed to swapped in
+		double worstLatencyMs;
+		std::wstring lastFile;
+	};
+	Stats GetStats();
+}
@@ -97,6 +97,9 @@ namespace Input
 		// The window's handle (id) from the OS, so
 		// we can get the cursor's position
 		HWND hWnd = 0;
+
+		// Where Update() gets its state from during a replay
+		const Input::FrameState* replayState = 0;
 	}
 }
 
@@ -153,6 +156,24 @@ void Input::Update()
 	// Copy the old keys so we have last frame's data
 	memcpy(prevKbState, kbState, sizeof(unsigned char) * 256);
 
+	// Replaying: the log stands in for the OS entirely
+	if (replayState)
+	{
+		memcpy(kbState, replayState->keys, sizeof(unsigned char) * 256);
+		prevMouseX = mouseX;
+		prevMouseY = mouseY;
+		mouseX = replayState->mouseX;
+		mouseY = replayState->mouseY;
+		mouseXDelta = mouseX - prevMouseX;
+		mouseYDelta = mouseY - prevMouseY;
+		rawMouseXDelta = replayState->rawMouseXDelta;
+		rawMouseYDelta = replayState->rawMouseYDelta;
+		wheelDelta = replayState->wheelDelta;
+		keyboardCaptured = replayState->keyboardCaptured;
+		mouseCaptured = replayState->mouseCaptured;
+		return;
+	}
+
 	// Get the latest keys (from Windows)
 	// Note the use of (void), which denotes to the compiler
 	// that we're intentionally ignoring the return value
@@ -214,6 +235,9 @@ int Input::GetMouseYDelta() { return mouseYDelta; }
 // ---------------------------------------------------------------
 void Input::ProcessRawMouseInput(LPARAM lParam)
 {
+	if (replayState)
+		return;
+
 	// Variables for the raw data and its size
 	unsigned char rawInputBytes[sizeof(RAWINPUT)] = {};
 	unsigned int sizeOfData = sizeof(RAWINPUT);
@@ -255,6 +279,9 @@ float Input::GetMouseWheel() { return wheelDelta; }
 // ---------------------------------------------------------------
 void Input::SetWheelDelta(float delta)
 {
+	if (replayState)
+		return;
+
 	wheelDelta = delta;
 }
 
@@ -266,6 +293,9 @@ void Input::SetWheelDelta(float delta)
 // ---------------------------------------------------------------
 void Input::SetKeyboardCapture(bool captured)
 {
+	if (replayState)
+		return;
+
 	keyboardCaptured = captured;
 }
 
@@ -277,6 +307,9 @@ void Input::SetKeyboardCapture(bool captured)
 // ---------------------------------------------------------------
 void Input::SetMouseCapture(bool captured)
 {
+	if (replayState)
+		return;
+
 	mouseCaptured = captured;
 }
 
@@ -401,3 +434,32 @@ bool Input::MouseRightRelease() { return !(kbState[VK_RBUTTON] & 0x80) && prevKb
 
 bool Input::MouseMiddlePress() { return kbState[VK_MBUTTON] & 0x80 && !(prevKbState[VK_MBUTTON] & 0x80) && !mouseCaptured; }
 bool Input::MouseMiddleRelease() { return !(kbState[VK_MBUTTON] & 0x80) && prevKbState[VK_MBUTTON] & 0x80 && !mouseCaptured; }
+
+
+// ----------------------------------------------------------
+//  Copies out this frame's state as the game sees it, for
+//  recording.  Call after Update() and after the frame has
+//  set capture, but before EndOfFrame() clears the wheel
+//  and raw deltas.
+// ----------------------------------------------------------
+void Input::GetFrameState(FrameState& outState)
+{
+	memcpy(outState.keys, kbState, sizeof(unsigned char) * 256);
+	outState.mouseX = mouseX;
+	outState.mouseY = mouseY;
+	outState.rawMouseXDelta = rawMouseXDelta;
+	outState.rawMouseYDelta = rawMouseYDelta;
+	outState.wheelDelta = wheelDelta;
+	outState.keyboardCaptured = keyboardCaptured;
+	outState.mouseCaptured = mouseCaptured;
+}
+
+// ----------------------------------------------------------
+//  Points Update() at a replayed frame instead of the OS.
+//  The state is read by every Update() until this is
+//  called again, so it must stay alive until then.
+// ----------------------------------------------------------
+void Input::SetReplayState(const FrameState* state)
+{
+	replayState = state;
+}
@@ -50,4 +50,24 @@ namespace Input
 
 	bool MouseMiddlePress();
 	bool MouseMiddleRelease();
+
+	// Everything the rest of the game can read for one frame,
+	// for recording and replaying sessions (see InputLog.h)
+	struct FrameState
+	{
+		unsigned char keys[256];
+		int mouseX;
+		int mouseY;
+		int rawMouseXDelta;
+		int rawMouseYDelta;
+		float wheelDelta;
+		bool keyboardCaptured;
+		bool mouseCaptured;
+	};
+	void GetFrameState(FrameState& outState);
+
+	// While set, Update() copies the state from here instead of
+	// asking the OS, and OS messages and capture changes are
+	// ignored.  Null goes back to live input.
+	void SetReplayState(const FrameState* state);
 }
\ No newline at end of file
@@ -0,0 +1,225 @@
+#include "InputLog.h"
+
+#include <cstring>
+#include <cstdint>
+
+// Annonymous namespace to hold variables
+// only accessible in this file
+namespace
+{
+	const char magic[4] = { 'I', 'N', 'P', 'L' };
+	const uint32_t version = 1;
+}
+
+InputLog::~InputLog()
+{
+	Stop();
+}
+
+bool InputLog::StartRecording(const char* path)
+{
+	Stop();
+	if (fopen_s(&file, path, "wb") != 0 || !file)
+	{
+		file = 0;
+		return false;
+	}
+
+	fwrite(magic, 1, sizeof(magic), file);
+	fwrite(&version, sizeof(version), 1, file);
+
+	state = {};
+	frameCount = 0;
+	recording = true;
+	return true;
+}
+
+bool InputLog::StartReplay(const char* path)
+{
+	Stop();
+	if (fopen_s(&file, path, "rb") != 0 || !file)
+	{
+		file = 0;
+		return false;
+	}
+
+	char fileMagic[4] = {};
+	uint32_t fileVersion = 0;
+	if (fread(fileMagic, 1, sizeof(fileMagic), file) != sizeof(fileMagic) ||
+		fread(&fileVersion, sizeof(fileVersion), 1, file) != 1 ||
+		memcmp(fileMagic, magic, sizeof(magic)) != 0 ||
+		fileVersion != version)
+	{
+		fclose(file);
+		file = 0;
+		return false;
+	}
+
+	state = {};
+	frameCount = 0;
+	replaying = true;
+	Input::SetReplayState(&state);
+	return true;
+}
+
+void InputLog::Stop()
+{
+	if (replaying)
+		Input::SetReplayState(0);
+
+	if (file)
+		fclose(file);
+
+	file = 0;
+	recording = false;
+	replaying = false;
+}
+
+bool InputLog::IsRecording()
+{
+	return recording;
+}
+
+bool InputLog::IsReplaying()
+{
+	return replaying;
+}
+
+unsigned int InputLog::GetFrameCount()
+{
+	return frameCount;
+}
+
+bool InputLog::BeginFrame(float& deltaTime)
+{
+	if (!replaying)
+		return true;
+
+	if (!ReadFrame(deltaTime))
+	{
+		Stop();
+		return false;
+	}
+
+	frameCount++;
+	return true;
+}
+
+// --------------------------------------------------------
+// Compares against the last frame written and stores only
+// the difference
+// --------------------------------------------------------
+void InputLog::EndFrame(float deltaTime)
+{
+	if (!recording)
+		return;
+
+	Input::FrameState current;
+	Input::GetFrameState(current);
+
+	unsigned char changedKeys[256 * 2];
+	uint16_t changedCount = 0;
+	for (unsigned int k = 0; k < 256; k++)
+	{
+		if (current.keys[k] != state.keys[k])
+		{
+			changedKeys[changedCount * 2] = (unsigned char)k;
+			changedKeys[changedCount * 2 + 1] = current.keys[k];
+			changedCount++;
+		}
+	}
+
+	unsigned char flags = 0;
+	if (current.mouseX != state.mouseX || current.mouseY != state.mouseY) flags |= FlagMouse;
+	if (current.rawMouseXDelta != 0 || current.rawMouseYDelta != 0) flags |= FlagRawMouse;
+	if (current.wheelDelta != 0) flags |= FlagWheel;
+	if (changedCount > 0) flags |= FlagKeys;
+	if (current.keyboardCaptured != state.keyboardCaptured || current.mouseCaptured != state.mouseCaptured) flags |= FlagCapture;
+
+	fwrite(&flags, 1, 1, file);
+	fwrite(&deltaTime, sizeof(float), 1, file);
+	if (flags & FlagMouse)
+	{
+		int32_t mouse[2] = { current.mouseX, current.mouseY };
+		fwrite(mouse, sizeof(int32_t), 2, file);
+	}
+	if (flags & FlagRawMouse)
+	{
+		int32_t raw[2] = { current.rawMouseXDelta, current.rawMouseYDelta };
+		fwrite(raw, sizeof(int32_t), 2, file);
+	}
+	if (flags & FlagWheel)
+		fwrite(&current.wheelDelta, sizeof(float), 1, file);
+	if (flags & FlagKeys)
+	{
+		fwrite(&changedCount, sizeof(changedCount), 1, file);
+		fwrite(changedKeys, 2, changedCount, file);
+	}
+	if (flags & FlagCapture)
+	{
+		unsigned char capture = (current.keyboardCaptured ? 1 : 0) | (current.mouseCaptured ? 2 : 0);
+		fwrite(&capture, 1, 1, file);
+	}
+
+	state = current;
+	frameCount++;
+}
+
+// --------------------------------------------------------
+// Applies one stored frame on top of the last.  Deltas
+// and the wheel only last a frame, so they reset first.
+// --------------------------------------------------------
+bool InputLog::ReadFrame(float& deltaTime)
+{
+	unsigned char flags = 0;
+	float recordedDelta = 0;
+	if (fread(&flags, 1, 1, file) != 1 || fread(&recordedDelta, sizeof(float), 1, file) != 1)
+		return false;
+
+	state.rawMouseXDelta = 0;
+	state.rawMouseYDelta = 0;
+	state.wheelDelta = 0;
+
+	if (flags & FlagMouse)
+	{
+		int32_t mouse[2] = {};
+		if (fread(mouse, sizeof(int32_t), 2, file) != 2)
+			return false;
+		state.mouseX = mouse[0];
+		state.mouseY = mouse[1];
+	}
+	if (flags & FlagRawMouse)
+	{
+		int32_t raw[2] = {};
+		if (fread(raw, sizeof(int32_t), 2, file) != 2)
+			return false;
+		state.rawMouseXDelta = raw[0];
+		state.rawMouseYDelta = raw[1];
+	}
+	if (flags & FlagWheel)
+	{
+		if (fread(&state.wheelDelta, sizeof(float), 1, file) != 1)
+			return false;
+	}
+	if (flags & FlagKeys)
+	{
+		uint16_t count = 0;
+		unsigned char changedKeys[256 * 2];
+		if (fread(&count, sizeof(count), 1, file) != 1 || count > 256 ||
+			fread(changedKeys, 2, count, file) != count)
+			return false;
+		for (unsigned int i = 0; i < count; i++)
+			state.keys[changedKeys[i * 2]] = changedKeys[i * 2 + 1];
+	}
+	if (flags & FlagCapture)
+	{
+		unsigned char capture = 0;
+		if (fread(&capture, 1, 1, file) != 1)
+			return false;
+		state.keyboardCaptured = (capture & 1) != 0;
+		state.mouseCaptured = (capture & 2) != 0;
+	}
+
+	deltaTime = recordedDelta;
+	return true;
+}
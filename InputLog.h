@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdio>
+
+#include "Input.h"
+
+// --------------------------------------------------------
+// Records a session's input, and the delta time of every
+// frame, to a compact binary file, and plays it back
+// through the Input namespace in place of the OS
+//
+// - Each frame stores only what changed since the one
+//   before: keys that went up or down, and the mouse
+//   position, raw deltas and wheel when they moved
+// - Input capture (ImGui wanting the mouse or keyboard) is
+//   recorded too, so the game sees exactly what it saw
+//   live; the UI itself still gets live input
+// - With the recorded delta times (or a fixed delta for
+//   both runs) a replay repeats the session exactly
+//
+// Per frame:
+//   uint8  flags (FrameFlag bits)
+//   float  deltaTime
+//   int32  mouseX, mouseY				if FlagMouse
+//   int32  rawMouseX, rawMouseY		if FlagRawMouse
+//   float  wheel						if FlagWheel
+//   uint16 count, count x (key, state)	if FlagKeys
+//   uint8  keyboard | mouse << 1		if FlagCapture
+// --------------------------------------------------------
+class InputLog
+{
+public:
+	InputLog() = default;
+	~InputLog();
+	InputLog(const InputLog&) = delete; // Remove copy constructor
+	InputLog& operator=(const InputLog&) = delete; // Remove copy-assignment operator
+
+	bool StartRecording(const char* path);
+	bool StartReplay(const char* path);
+	void Stop();
+
+	bool IsRecording();
+	bool IsReplaying();
+	unsigned int GetFrameCount();
+
+	// Before Input::Update().  When replaying, hands Input the
+	// next frame and replaces deltaTime with the recorded one.
+	// Returns false once the replay has run out of frames.
+	bool BeginFrame(float& deltaTime);
+
+	// After the frame's Update() and Draw(), before
+	// Input::EndOfFrame().  When recording, writes the frame.
+	void EndFrame(float deltaTime);
+
+private:
+	enum FrameFlag : unsigned char
+	{
+		FlagMouse		= 1 << 0,
+		FlagRawMouse	= 1 << 1,
+		FlagWheel		= 1 << 2,
+		FlagKeys		= 1 << 3,
+		FlagCapture		= 1 << 4,
+	};
+
+	bool ReadFrame(float& deltaTime);
+
+	FILE* file = 0;
+	bool recording = false;
+	bool replaying = false;
+	unsigned int frameCount = 0;
+
+	// The previous frame, which the next one is stored against
+	Input::FrameState state = {};
+};
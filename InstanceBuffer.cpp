@@ -0,0 +1,159 @@
+#include "InstanceBuffer.h"
+#include "MatrixBatch.h"
+#include "AllocationTracker.h"
+
+#include <cstring>
+
+InstanceBuffer::~InstanceBuffer()
+{
+}
+
+// --------------------------------------------------------
+// Starts with room for the given number of instances.
+// More room is made on demand, and the GPU side sizes
+// its buffers from what Capture() reports.
+// --------------------------------------------------------
+void InstanceBuffer::Initialize(unsigned int initialCapacity)
+{
+	shadow.clear();
+	freeSlots.clear();
+	tracker.Resize(0);
+	capacity = initialCapacity > 0 ? initialCapacity : 1;
+}
+
+// --------------------------------------------------------
+// Reserves a slot (reusing freed ones first) and returns
+// its index.  The slot starts dirty so its first contents
+// get uploaded.
+// --------------------------------------------------------
+unsigned int InstanceBuffer::Allocate()
+{
+	ALLOCATION_SCOPE("Instances");
+
+	if (!freeSlots.empty())
+	{
+		unsigned int reused = freeSlots.back();
+		freeSlots.pop_back();
+		tracker.MarkDirty(reused);
+		return reused;
+	}
+
+	unsigned int slot = (unsigned int)shadow.size();
+
+	// Out of room?  The GPU side recreates everything twice
+	// as large on its next upload, so every slot has to go
+	// with it, since the old contents are gone
+	if (slot >= capacity)
+	{
+		capacity *= 2;
+		tracker.MarkAllDirty();
+	}
+
+	InstanceData blank = {};
+	DirectX::XMStoreFloat4x4(&blank.world, DirectX::XMMatrixIdentity());
+	blank.colorTint = DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+	shadow.push_back(blank);
+
+	tracker.Resize((unsigned int)shadow.size());
+	tracker.MarkDirty(slot);
+	return slot;
+}
+
+// --------------------------------------------------------
+// Returns a slot for reuse.  Its contents are reset so a
+// stale draw of it would show nothing out of place.
+// --------------------------------------------------------
+void InstanceBuffer::Free(unsigned int slot)
+{
+	DirectX::XMStoreFloat4x4(&shadow[slot].world, DirectX::XMMatrixIdentity());
+	shadow[slot].colorTint = DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+	tracker.MarkDirty(slot);
+	freeSlots.push_back(slot);
+}
+
+unsigned int InstanceBuffer::GetCount()
+{
+	return (unsigned int)shadow.size();
+}
+
+InstanceData* InstanceBuffer::GetInstance(unsigned int slot)
+{
+	return &shadow[slot];
+}
+
+DirtyRangeTracker* InstanceBuffer::GetTracker()
+{
+	return &tracker;
+}
+
+// --------------------------------------------------------
+// Returns the coalesced ranges marked so far, so callers
+// can refresh the shadow copy of just those slots before
+// Capture().  Slots may still be marked afterwards (by
+// interpolation, say); Capture() coalesces again anyway.
+// --------------------------------------------------------
+const std::vector<DirtyRange>& InstanceBuffer::GetDirtyRanges()
+{
+	tracker.Coalesce(ranges, maxMergeGap);
+	return ranges;
+}
+
+// --------------------------------------------------------
+// Copies every dirty range of the shadow, plus world *
+// view * projection for each view's visible draws alone
+// (gathered in a single batched pass per view), then
+// resets the tracker for the next frame
+// --------------------------------------------------------
+void InstanceBuffer::Capture(LinearAllocator& memory, const InstanceView* views, unsigned int viewCount, InstanceUpdate& outUpdate)
+{
+	tracker.Coalesce(ranges, maxMergeGap);
+
+	unsigned int dirtySlots = 0;
+	for (const DirtyRange& range : ranges)
+		dirtySlots += range.end - range.begin;
+
+	DirtyRange* outRanges = memory.Allocate<DirtyRange>(ranges.size());
+	InstanceData* outData = memory.Allocate<InstanceData>(dirtySlots);
+
+	InstanceData* next = outData;
+	for (size_t i = 0; i < ranges.size(); i++)
+	{
+		outRanges[i] = ranges[i];
+		memcpy(next, &shadow[ranges[i].begin], (ranges[i].end - ranges[i].begin) * sizeof(InstanceData));
+		next += ranges[i].end - ranges[i].begin;
+	}
+
+	unsigned int drawCount = 0;
+	for (unsigned int v = 0; v < viewCount; v++)
+		drawCount += views[v].drawCount;
+
+	// Slots first, then every WVP in one gathered pass per view
+	DrawData* outDraws = memory.Allocate<DrawData>(drawCount);
+	DrawData* nextDraw = outDraws;
+	for (unsigned int v = 0; v < viewCount; v++)
+	{
+		const InstanceView& view = views[v];
+		for (unsigned int i = 0; i < view.drawCount; i++)
+			nextDraw[i].instanceSlot = view.draws[i].instanceSlot;
+
+		if (view.drawCount > 0)
+		{
+			MatrixBatch::MultiplyGathered(
+				&shadow[0].world, sizeof(InstanceData),
+				&nextDraw[0].instanceSlot, &nextDraw[0].worldViewProj, sizeof(DrawData),
+				view.drawCount, view.viewProjection);
+		}
+		nextDraw += view.drawCount;
+	}
+
+	outUpdate.ranges = outRanges;
+	outUpdate.rangeCount = (unsigned int)ranges.size();
+	outUpdate.data = outData;
+	outUpdate.instanceCount = (unsigned int)shadow.size();
+	outUpdate.capacity = capacity;
+	outUpdate.draws = outDraws;
+	outUpdate.drawCount = drawCount;
+
+	tracker.Clear();
+	ranges.clear();
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <vector>
+
+#include "BufferStructs.h"
+#include "CommandBackend.h"
+#include "DirtyRangeTracker.h"
+#include "LinearAllocator.h"
+
+// Everything one frame's upload needs, copied out of the
+// shadow so the GPU side never reads it
+struct InstanceUpdate
+{
+	const DirtyRange* ranges;
+	unsigned int rangeCount;
+	const InstanceData* data;			// Every range's slots, back to back
+	unsigned int instanceCount;
+	unsigned int capacity;				// Slots the GPU buffers must hold
+	const DrawData* draws;				// One per visible draw, every view's back to back
+	unsigned int drawCount;
+};
+
+// One view's visible draws, for Capture() to compose WVPs for
+struct InstanceView
+{
+	DirectX::XMFLOAT4X4 viewProjection;
+	const DrawItem* draws;
+	unsigned int drawCount;
+};
+
+// --------------------------------------------------------
+// The simulation side of the per-instance data (world
+// matrix and tint) for every entity.
+//
+// - A CPU-side shadow copy is kept for every slot
+// - Only slots flagged in the tracker are captured for
+//   upload, as coalesced ranges
+// - A DrawData (world * view * proj, and the slot) is
+//   captured for each visible draw only, computed in one
+//   batch per view.  Several views share the instance
+//   data and each get a block of DrawData.
+// - The GPU side (D3D11InstanceBuffer) only meets it
+//   through an InstanceUpdate, so they can run on
+//   different threads: Capture() on one, Upload() on the
+//   other, and headless runs have no GPU side at all
+// --------------------------------------------------------
+class InstanceBuffer
+{
+public:
+	InstanceBuffer() = default;
+	~InstanceBuffer();
+	InstanceBuffer(const InstanceBuffer&) = delete; // Remove copy constructor
+	InstanceBuffer& operator=(const InstanceBuffer&) = delete; // Remove copy-assignment operator
+
+	void Initialize(unsigned int initialCapacity);
+	unsigned int Allocate();
+	void Free(unsigned int slot);
+
+	unsigned int GetCount();
+	InstanceData* GetInstance(unsigned int slot);
+	DirtyRangeTracker* GetTracker();
+	const std::vector<DirtyRange>& GetDirtyRanges();
+
+	// Copies the dirty slots and this frame's DrawData for
+	// each view's draws into memory and resets the tracker.
+	// View v's block starts after every earlier view's draws.
+	void Capture(LinearAllocator& memory, const InstanceView* views, unsigned int viewCount, InstanceUpdate& outUpdate);
+
+	// Largest clean gap (in slots) merged into a single upload
+	unsigned int maxMergeGap = 4;
+
+private:
+	std::vector<InstanceData> shadow;
+	std::vector<unsigned int> freeSlots;
+	DirtyRangeTracker tracker;
+	std::vector<DirtyRange> ranges;
+
+	unsigned int capacity = 0;		// Slots the GPU side must make room for
+};
@@ -0,0 +1,400 @@
+#include "JobSystem.h"
+#include "AllocationTracker.h"
+#include "Profiler.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <string>
+
+namespace JobSystem
+{
+	// Annonymous namespace to hold variables
+	// only accessible in this file
+	namespace
+	{
+		struct Job
+		{
+			JobFunction function;
+			void* data;
+			unsigned int begin;
+			unsigned int end;
+			Counter* counter;
+			std::atomic<bool> inUse{ false };
+		};
+
+		// Jobs in flight per thread.  The job pool is a ring of
+		// the same size; a slot is only handed out again once
+		// whoever ran its job has copied it out.
+		const int64_t queueCapacity = 4096;
+		const int64_t queueMask = queueCapacity - 1;
+
+		// ------------------------------------------------
+		// Chase-Lev work-stealing deque (the fixed-size
+		// variant from Le, Pop, Cohen & Zappa Nardelli,
+		// "Correct and Efficient Work-Stealing for Weak
+		// Memory Models").  Only the owner calls Push and
+		// Pop; anyone may call Steal.
+		// ------------------------------------------------
+		class WorkStealingDeque
+		{
+		public:
+			bool Push(Job* job)
+			{
+				int64_t b = bottom.load(std::memory_order_relaxed);
+				int64_t t = top.load(std::memory_order_acquire);
+				if (b - t >= queueCapacity)
+					return false;
+
+				// Release, so whoever takes the job also sees its contents
+				buffer[b & queueMask].store(job, std::memory_order_release);
+				bottom.store(b + 1, std::memory_order_release);
+				return true;
+			}
+
+			Job* Pop()
+			{
+				int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+				bottom.store(b, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				int64_t t = top.load(std::memory_order_relaxed);
+
+				if (t > b)
+				{
+					// Already empty
+					bottom.store(b + 1, std::memory_order_relaxed);
+					return 0;
+				}
+
+				Job* job = buffer[b & queueMask].load(std::memory_order_relaxed);
+				if (t == b)
+				{
+					// Last one - race any thief for it
+					if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+						job = 0;
+					bottom.store(b + 1, std::memory_order_relaxed);
+				}
+				return job;
+			}
+
+			Job* Steal()
+			{
+				int64_t t = top.load(std::memory_order_acquire);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				int64_t b = bottom.load(std::memory_order_acquire);
+
+				if (t >= b)
+					return 0;
+
+				Job* job = buffer[t & queueMask].load(std::memory_order_acquire);
+				if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+					return 0; // Lost the race; try elsewhere
+				return job;
+			}
+
+		private:
+			alignas(64) std::atomic<int64_t> top{ 0 };
+			alignas(64) std::atomic<int64_t> bottom{ 0 };
+			std::atomic<Job*> buffer[queueCapacity] = {};
+		};
+
+		// Everything one thread owns, kept on its own cache lines
+		struct alignas(64) ThreadState
+		{
+			WorkStealingDeque deque;
+			Job jobs[queueCapacity];
+			unsigned int nextJob = 0;
+			uint32_t random = 0;
+			std::atomic<unsigned int> executed{ 0 };
+			std::atomic<unsigned int> stolen{ 0 };
+		};
+
+		std::vector<std::unique_ptr<ThreadState>> threadStates;
+		std::vector<std::thread> workers;
+		unsigned int attachedThreads = 0;
+		bool initialized = false;
+		std::atomic<bool> quit{ false };
+
+		// Sleeping workers are woken when work shows up
+		std::mutex sleepMutex;
+		std::condition_variable sleepCondition;
+		std::atomic<int> queuedJobs{ 0 };
+		std::atomic<int> sleepingWorkers{ 0 };
+
+		thread_local unsigned int threadIndex = 0;
+
+		// Next free slot of this thread's job pool, or null if
+		// every slot is still queued somewhere
+		Job* AllocateJob(ThreadState& self)
+		{
+			for (int64_t tries = 0; tries < queueCapacity; tries++)
+			{
+				Job* job = &self.jobs[self.nextJob++ & queueMask];
+				if (!job->inUse.load(std::memory_order_acquire))
+				{
+					job->inUse.store(true, std::memory_order_relaxed);
+					return job;
+				}
+			}
+			return 0;
+		}
+
+		void Execute(Job* job)
+		{
+			// Copy out and release the slot before running, since
+			// the job itself may queue (and wait on) more jobs
+			JobFunction function = job->function;
+			void* data = job->data;
+			unsigned int begin = job->begin;
+			unsigned int end = job->end;
+			Counter* counter = job->counter;
+			job->inUse.store(false, std::memory_order_release);
+
+			PROFILE_SCOPE("Job");
+			function(data, begin, end);
+			if (counter)
+				counter->pending.fetch_sub(1, std::memory_order_acq_rel);
+
+			threadStates[threadIndex]->executed.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		// Own deque first, then steal from a random victim onwards
+		Job* FindJob()
+		{
+			ThreadState& self = *threadStates[threadIndex];
+
+			Job* job = self.deque.Pop();
+			if (job)
+			{
+				queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+				return job;
+			}
+
+			unsigned int count = (unsigned int)threadStates.size();
+			self.random = self.random * 1664525u + 1013904223u;
+			unsigned int start = (self.random >> 8) % count;
+			for (unsigned int i = 0; i < count; i++)
+			{
+				unsigned int victim = (start + i) % count;
+				if (victim == threadIndex)
+					continue;
+
+				job = threadStates[victim]->deque.Steal();
+				if (job)
+				{
+					queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+					self.stolen.fetch_add(1, std::memory_order_relaxed);
+					return job;
+				}
+			}
+			return 0;
+		}
+
+		void WorkerMain(unsigned int index)
+		{
+			threadIndex = index;
+			Profiler::SetThreadName(("Worker " + std::to_string(index)).c_str());
+			int idleSpins = 0;
+
+			while (!quit.load(std::memory_order_acquire))
+			{
+				Job* job = FindJob();
+				if (job)
+				{
+					Execute(job);
+					idleSpins = 0;
+					continue;
+				}
+
+				// Spin briefly (new work usually arrives in bursts),
+				// then sleep until something is queued
+				if (++idleSpins < 64)
+				{
+					std::this_thread::yield();
+					continue;
+				}
+
+				std::unique_lock<std::mutex> lock(sleepMutex);
+				sleepingWorkers.fetch_add(1, std::memory_order_seq_cst);
+				sleepCondition.wait(lock, []()
+				{
+					return queuedJobs.load(std::memory_order_seq_cst) > 0 || quit.load(std::memory_order_seq_cst);
+				});
+				sleepingWorkers.fetch_sub(1, std::memory_order_seq_cst);
+				idleSpins = 0;
+			}
+		}
+	}
+}
+
+
+// --------------------------------------------------------
+// Starts the worker threads.  The calling thread becomes
+// thread 0 and takes part whenever it waits.
+// --------------------------------------------------------
+void JobSystem::Initialize(unsigned int workerCount)
+{
+	ALLOCATION_SCOPE("Jobs");
+
+	if (initialized)
+		ShutDown();
+
+	if (workerCount == 0)
+	{
+		unsigned int cores = std::thread::hardware_concurrency();
+		workerCount = cores > 1 ? cores - 1 : 1;
+	}
+
+	threadIndex = 0;
+	quit = false;
+	queuedJobs = 0;
+
+	threadStates.clear();
+	for (unsigned int i = 0; i <= attachedThreads + workerCount; i++)
+	{
+		threadStates.push_back(std::make_unique<ThreadState>());
+		threadStates.back()->random = 2891336453u * (i + 1);
+	}
+
+	initialized = true;
+	for (unsigned int i = 1; i <= workerCount; i++)
+		workers.emplace_back(WorkerMain, attachedThreads + i);
+}
+
+void JobSystem::ShutDown()
+{
+	if (!initialized)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		quit = true;
+	}
+	sleepCondition.notify_all();
+
+	for (std::thread& worker : workers)
+		worker.join();
+
+	workers.clear();
+	threadStates.clear();
+	initialized = false;
+}
+
+// --------------------------------------------------------
+// Attached threads keep the same index for as long as the
+// program runs, so a thread only needs to attach once even
+// if the job system is restarted (benchmarks do that)
+// --------------------------------------------------------
+void JobSystem::SetAttachedThreadCount(unsigned int count)
+{
+	attachedThreads = count;
+}
+
+void JobSystem::AttachThread(unsigned int slot)
+{
+	threadIndex = slot < attachedThreads ? 1 + slot : 0;
+}
+
+unsigned int JobSystem::GetThreadCount()
+{
+	return initialized ? (unsigned int)threadStates.size() : 1;
+}
+
+unsigned int JobSystem::GetWorkerCount()
+{
+	return (unsigned int)workers.size();
+}
+
+unsigned int JobSystem::GetThreadIndex()
+{
+	return threadIndex;
+}
+
+
+// --------------------------------------------------------
+// Queues a job on this thread's deque
+// --------------------------------------------------------
+void JobSystem::Run(JobFunction function, void* data, unsigned int begin, unsigned int end, Counter* counter)
+{
+	if (!initialized)
+	{
+		function(data, begin, end);
+		return;
+	}
+
+	ThreadState& self = *threadStates[threadIndex];
+	Job* job = AllocateJob(self);
+
+	// Out of room?  Just do it now
+	if (!job)
+	{
+		function(data, begin, end);
+		return;
+	}
+
+	if (counter)
+		counter->pending.fetch_add(1, std::memory_order_relaxed);
+
+	job->function = function;
+	job->data = data;
+	job->begin = begin;
+	job->end = end;
+	job->counter = counter;
+
+	if (!self.deque.Push(job))
+	{
+		Execute(job);
+		return;
+	}
+
+	queuedJobs.fetch_add(1, std::memory_order_seq_cst);
+	if (sleepingWorkers.load(std::memory_order_seq_cst) > 0)
+	{
+		// Taking the lock means a worker that is about to sleep
+		// either sees the new job or is already waiting
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		sleepCondition.notify_one();
+	}
+}
+
+// --------------------------------------------------------
+// Helps with any queued work until the counter is done
+// --------------------------------------------------------
+void JobSystem::Wait(Counter* counter)
+{
+	while (!counter->IsDone())
+	{
+		Job* job = initialized ? FindJob() : 0;
+		if (job)
+			Execute(job);
+		else
+			std::this_thread::yield();
+	}
+}
+
+
+// --------------------------------------------------------
+// Stats
+// --------------------------------------------------------
+JobSystem::ThreadStats JobSystem::GetThreadStats(unsigned int index)
+{
+	ThreadStats stats = {};
+	if (index < threadStates.size())
+	{
+		stats.executed = threadStates[index]->executed.load(std::memory_order_relaxed);
+		stats.stolen = threadStates[index]->stolen.load(std::memory_order_relaxed);
+	}
+	return stats;
+}
+
+void JobSystem::ResetStats()
+{
+	for (auto& state : threadStates)
+	{
+		state->executed = 0;
+		state->stolen = 0;
+	}
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+
+// --------------------------------------------------------
+// A small work-stealing job scheduler
+//
+// - One worker thread per spare core, plus the main thread,
+//   each with its own Chase-Lev deque: the owner pushes and
+//   pops at the bottom, idle threads steal from the top
+// - Jobs report to a Counter; waiting on a counter runs
+//   other jobs instead of blocking, so the main thread
+//   helps out rather than sitting idle
+// - Dependencies are expressed by waiting on the counter
+//   of the jobs that must finish first
+// - No Windows or DirectX headers are used, so this builds
+//   on any platform
+// --------------------------------------------------------
+namespace JobSystem
+{
+	// Number of jobs still outstanding for a group of work
+	struct Counter
+	{
+		std::atomic<int> pending{ 0 };
+		bool IsDone() const { return pending.load(std::memory_order_acquire) == 0; }
+	};
+
+	// A job processes the items [begin, end) of whatever data points at
+	typedef void (*JobFunction)(void* data, unsigned int begin, unsigned int end);
+
+	// workerCount of 0 means "one per core, minus the main thread"
+	void Initialize(unsigned int workerCount = 0);
+	void ShutDown();
+
+	// Other long-lived threads (the render thread) that queue
+	// and wait on jobs too.  Their slots sit right after the
+	// main thread's and are kept across re-initialization.
+	// Call before Initialize().
+	void SetAttachedThreadCount(unsigned int count);
+
+	// Gives the calling thread attached slot number slot
+	void AttachThread(unsigned int slot);
+
+	// Worker threads plus the main and attached threads
+	unsigned int GetThreadCount();
+	unsigned int GetWorkerCount();
+
+	// 0 on the main thread, then attached threads, then workers
+	unsigned int GetThreadIndex();
+
+	// Queues a job on the calling thread's deque.  The counter
+	// (if any) is incremented now and decremented once the
+	// job has run.  Falls back to running inline when full.
+	void Run(JobFunction function, void* data, unsigned int begin, unsigned int end, Counter* counter);
+
+	// Runs queued jobs until the counter reaches zero
+	void Wait(Counter* counter);
+
+	// Splits [0, count) into batches of at most batchSize
+	// items, runs fn(begin, end) for each across all threads
+	// and returns once every batch is done
+	template<typename Fn>
+	void ParallelFor(unsigned int count, unsigned int batchSize, const Fn& fn)
+	{
+		if (count == 0)
+			return;
+		if (batchSize == 0)
+			batchSize = 1;
+
+		// Not worth splitting - just do it here
+		if (count <= batchSize || GetThreadCount() == 1)
+		{
+			fn(0u, count);
+			return;
+		}
+
+		JobFunction thunk = [](void* data, unsigned int begin, unsigned int end)
+		{
+			(*(const Fn*)data)(begin, end);
+		};
+
+		Counter counter;
+		for (unsigned int begin = 0; begin < count; begin += batchSize)
+		{
+			unsigned int end = count - begin > batchSize ? begin + batchSize : count;
+			Run(thunk, (void*)&fn, begin, end, &counter);
+		}
+		Wait(&counter);
+	}
+
+	// How many jobs each thread ran / stole since the last reset
+	struct ThreadStats
+	{
+		unsigned int executed;
+		unsigned int stolen;
+	};
+	ThreadStats GetThreadStats(unsigned int threadIndex);
+	void ResetStats();
+}
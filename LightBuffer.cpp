@@ -0,0 +1,111 @@
+#include "LightBuffer.h"
+#include "Graphics.h"
+#include "AllocationTracker.h"
+
+LightBuffer::~LightBuffer()
+{
+}
+
+// --------------------------------------------------------
+// Copies each array into its buffer, then the constants
+// --------------------------------------------------------
+void LightBuffer::Upload(const LightUpdate& update)
+{
+	unsigned int bytes = 0;
+	bytes += Write(lights, update.lights, update.lightCount, sizeof(Light));
+	bytes += Write(clusters, update.clusters, update.clusterCount, sizeof(ClusterRange));
+	bytes += Write(indices, update.indices, update.indexCount, sizeof(uint32_t));
+
+	if (!constantBuffer)
+	{
+		ALLOCATION_SCOPE("Lights");
+
+		D3D11_BUFFER_DESC desc = {};
+		desc.Usage = D3D11_USAGE_DYNAMIC;
+		desc.ByteWidth = (sizeof(LightingData) + 15) / 16 * 16;
+		desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+		desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+		Graphics::Device->CreateBuffer(&desc, 0, constantBuffer.GetAddressOf());
+		Graphics::TrackBufferMemory(constantBuffer.Get(), "Lights");
+	}
+
+	D3D11_MAPPED_SUBRESOURCE mapped = {};
+	if (constantBuffer && SUCCEEDED(Graphics::Context->Map(constantBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)))
+	{
+		memcpy(mapped.pData, &update.constants, sizeof(LightingData));
+		Graphics::Context->Unmap(constantBuffer.Get(), 0);
+		bytes += sizeof(LightingData);
+	}
+
+	uploadedBytes = bytes;
+}
+
+// --------------------------------------------------------
+// Binds everything to the pixel shader
+// --------------------------------------------------------
+void LightBuffer::Bind(unsigned int constantBufferSlot, unsigned int lightSrvSlot, unsigned int clusterSrvSlot, unsigned int indexSrvSlot)
+{
+	Graphics::Context->PSSetConstantBuffers(constantBufferSlot, 1, constantBuffer.GetAddressOf());
+	Graphics::Context->PSSetShaderResources(lightSrvSlot, 1, lights.srv.GetAddressOf());
+	Graphics::Context->PSSetShaderResources(clusterSrvSlot, 1, clusters.srv.GetAddressOf());
+	Graphics::Context->PSSetShaderResources(indexSrvSlot, 1, indices.srv.GetAddressOf());
+}
+
+unsigned int LightBuffer::GetUploadedBytes()
+{
+	return uploadedBytes;
+}
+
+// --------------------------------------------------------
+// Recreates the buffer if it's too small, then maps and
+// fills it.  Returns the bytes written.
+// - An empty array still gets a buffer (of one element), so
+//   the shader always has something bound
+// --------------------------------------------------------
+unsigned int LightBuffer::Write(Structured& target, const void* data, unsigned int count, unsigned int stride)
+{
+	if (count > target.capacity || !target.buffer)
+	{
+		ALLOCATION_SCOPE("Lights");
+
+		unsigned int capacity = target.capacity > 0 ? target.capacity : 1;
+		while (capacity < count)
+			capacity *= 2;
+
+		D3D11_BUFFER_DESC desc = {};
+		desc.Usage = D3D11_USAGE_DYNAMIC;
+		desc.ByteWidth = stride * capacity;
+		desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+		desc.StructureByteStride = stride;
+
+		target.buffer.Reset();
+		target.srv.Reset();
+		target.capacity = 0;
+		if (FAILED(Graphics::Device->CreateBuffer(&desc, 0, target.buffer.GetAddressOf())))
+			return 0;
+		Graphics::TrackBufferMemory(target.buffer.Get(), "Lights");
+
+		D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+		srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+		srvDesc.Buffer.FirstElement = 0;
+		srvDesc.Buffer.NumElements = capacity;
+
+		Graphics::Device->CreateShaderResourceView(target.buffer.Get(), &srvDesc, target.srv.GetAddressOf());
+		target.capacity = capacity;
+	}
+
+	if (count == 0)
+		return 0;
+
+	D3D11_MAPPED_SUBRESOURCE mapped = {};
+	if (FAILED(Graphics::Context->Map(target.buffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)))
+		return 0;
+
+	memcpy(mapped.pData, data, (size_t)count * stride);
+	Graphics::Context->Unmap(target.buffer.Get(), 0);
+	return count * stride;
+}
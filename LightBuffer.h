@@ -0,0 +1,54 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <atomic>
+
+#include "LightGrid.h"
+
+// --------------------------------------------------------
+// The GPU side of clustered lighting: the lights, every
+// cluster's (offset, count) and the index list they point
+// into, as structured buffers for the pixel shader, plus
+// its constant buffer
+//
+// - All four are rewritten in full each frame with
+//   WRITE_DISCARD, since lights move every frame anyway
+// - Buffers grow (to the next power of two) when a frame
+//   needs more room, and are only created by the first
+//   Upload(), so headless runs never need a device
+// --------------------------------------------------------
+class LightBuffer
+{
+public:
+	LightBuffer() = default;
+	~LightBuffer();
+	LightBuffer(const LightBuffer&) = delete; // Remove copy constructor
+	LightBuffer& operator=(const LightBuffer&) = delete; // Remove copy-assignment operator
+
+	// Sends a captured update; runs on the render thread
+	void Upload(const LightUpdate& update);
+	void Bind(unsigned int constantBufferSlot, unsigned int lightSrvSlot, unsigned int clusterSrvSlot, unsigned int indexSrvSlot);
+
+	// From the most recent Upload()
+	unsigned int GetUploadedBytes();
+
+private:
+	// A dynamic structured buffer and its view
+	struct Structured
+	{
+		Microsoft::WRL::ComPtr<ID3D11Buffer> buffer;
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv;
+		unsigned int capacity = 0;	// In elements
+	};
+
+	static unsigned int Write(Structured& target, const void* data, unsigned int count, unsigned int stride);
+
+	Structured lights;
+	Structured clusters;
+	Structured indices;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> constantBuffer;
+
+	// Written by Upload(), read from the UI
+	std::atomic<unsigned int> uploadedBytes{ 0 };
+};
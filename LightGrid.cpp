@@ -0,0 +1,408 @@
+#include "LightGrid.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#include <xmmintrin.h>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <cfloat>
+
+using namespace DirectX;
+
+// Annonymous namespace to hold helpers
+// only accessible in this file
+namespace
+{
+	// Where exponential slicing starts; anything nearer is
+	// in slice 0, which would otherwise be a sliver
+	const float firstSliceDepth = 0.1f;
+
+	// Padding spheres sit this far out on every axis, with no
+	// radius, so they can never touch a box.  Squared and
+	// summed, this still fits in a float.
+	const float farAway = 3e18f;
+
+	// Distance from each of four spheres' centers to a box,
+	// squared, against each radius squared
+	int SphereBoxMask(const float* x, const float* y, const float* z, const float* radius,
+		__m128 minX, __m128 minY, __m128 minZ, __m128 maxX, __m128 maxY, __m128 maxZ)
+	{
+		const __m128 zero = _mm_setzero_ps();
+		__m128 cx = _mm_loadu_ps(x);
+		__m128 cy = _mm_loadu_ps(y);
+		__m128 cz = _mm_loadu_ps(z);
+		__m128 r = _mm_loadu_ps(radius);
+
+		// Zero inside the box's extent on that axis
+		__m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minX, cx), zero), _mm_sub_ps(cx, maxX));
+		__m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minY, cy), zero), _mm_sub_ps(cy, maxY));
+		__m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minZ, cz), zero), _mm_sub_ps(cz, maxZ));
+		__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+		return _mm_movemask_ps(_mm_cmple_ps(distance, _mm_mul_ps(r, r)));
+	}
+}
+
+void LightGrid::SphereList::Clear()
+{
+	x.clear();
+	y.clear();
+	z.clear();
+	radius.clear();
+	light.clear();
+	count = 0;
+}
+
+void LightGrid::SphereList::Reserve(unsigned int capacity)
+{
+	x.reserve(capacity);
+	y.reserve(capacity);
+	z.reserve(capacity);
+	radius.reserve(capacity);
+	light.reserve(capacity);
+}
+
+void LightGrid::SphereList::Add(float cx, float cy, float cz, float r, uint32_t index)
+{
+	x.push_back(cx);
+	y.push_back(cy);
+	z.push_back(cz);
+	radius.push_back(r);
+	light.push_back(index);
+	count++;
+}
+
+void LightGrid::SphereList::Pad()
+{
+	while (x.size() % 4 != 0)
+	{
+		x.push_back(farAway);
+		y.push_back(farAway);
+		z.push_back(farAway);
+		radius.push_back(0.0f);
+		light.push_back(0);
+	}
+}
+
+// --------------------------------------------------------
+// Cluster corners come from unprojecting each tile's
+// corners at the near and far planes, and sliding along
+// those lines to each slice's depths, so any projection
+// (perspective or not) gets the right boxes
+// --------------------------------------------------------
+void LightGrid::Configure(unsigned int width, unsigned int height, const XMFLOAT4X4& projection)
+{
+	width = width > 0 ? width : 1;
+	height = height > 0 ? height : 1;
+	if (width == this->width && height == this->height && memcmp(&projection, &this->projection, sizeof(projection)) == 0)
+		return;
+
+	this->width = width;
+	this->height = height;
+	this->projection = projection;
+	countX = (width + TileSize - 1) / TileSize;
+	countY = (height + TileSize - 1) / TileSize;
+
+	XMMATRIX inverse = XMMatrixInverse(0, XMLoadFloat4x4(&projection));
+	auto unproject = [&](float x, float y, float z) { return XMVector3TransformCoord(XMVectorSet(x, y, z, 1.0f), inverse); };
+
+	float nearZ = XMVectorGetZ(unproject(0, 0, 0));
+	float farZ = XMVectorGetZ(unproject(0, 0, 1));
+	float first = std::max(nearZ, firstSliceDepth);
+	if (farZ <= first)
+		farZ = first * 2.0f;
+
+	// slice = log(z) * scale + bias, as the pixel shader does it
+	sliceScale = SliceCount / logf(farZ / first);
+	sliceBias = -logf(first) * sliceScale;
+	auto sliceDepth = [&](unsigned int k) { return expf((k - sliceBias) / sliceScale); };
+
+	clusterBoxes.resize((size_t)countX * countY * SliceCount);
+	rowBoxes.resize((size_t)countY * SliceCount);
+	clusters.assign(clusterBoxes.size(), { 0, 0 });
+
+	for (unsigned int k = 0; k < SliceCount; k++)
+	{
+		float depths[2] = { k == 0 ? nearZ : sliceDepth(k), k == SliceCount - 1 ? farZ : sliceDepth(k + 1) };
+
+		for (unsigned int y = 0; y < countY; y++)
+		{
+			float top = 1.0f - 2.0f * (y * TileSize) / height;
+			float bottom = 1.0f - 2.0f * std::min((y + 1) * TileSize, height) / height;
+
+			for (unsigned int x = 0; x < countX; x++)
+			{
+				float left = 2.0f * (x * TileSize) / width - 1.0f;
+				float right = 2.0f * std::min((x + 1) * TileSize, width) / width - 1.0f;
+
+				XMVECTOR boxMin = XMVectorReplicate(FLT_MAX);
+				XMVECTOR boxMax = XMVectorReplicate(-FLT_MAX);
+				float corners[4][2] = { { left, top }, { right, top }, { left, bottom }, { right, bottom } };
+				for (unsigned int c = 0; c < 4; c++)
+				{
+					XMVECTOR nearPoint = unproject(corners[c][0], corners[c][1], 0.0f);
+					XMVECTOR farPoint = unproject(corners[c][0], corners[c][1], 1.0f);
+					float nearDepth = XMVectorGetZ(nearPoint);
+					float span = XMVectorGetZ(farPoint) - nearDepth;
+
+					for (float depth : depths)
+					{
+						float t = span != 0 ? (depth - nearDepth) / span : 0.0f;
+						XMVECTOR p = XMVectorLerp(nearPoint, farPoint, t);
+						boxMin = XMVectorMin(boxMin, p);
+						boxMax = XMVectorMax(boxMax, p);
+					}
+				}
+
+				Box& box = clusterBoxes[((size_t)k * countY + y) * countX + x];
+				XMFLOAT3 lo, hi;
+				XMStoreFloat3(&lo, boxMin);
+				XMStoreFloat3(&hi, boxMax);
+				box = { lo.x, lo.y, lo.z, hi.x, hi.y, hi.z };
+			}
+		}
+	}
+
+	// Rows and slices are just the union of their clusters
+	auto merge = [](Box& into, const Box& box)
+	{
+		into.minX = std::min(into.minX, box.minX);
+		into.minY = std::min(into.minY, box.minY);
+		into.minZ = std::min(into.minZ, box.minZ);
+		into.maxX = std::max(into.maxX, box.maxX);
+		into.maxY = std::max(into.maxY, box.maxY);
+		into.maxZ = std::max(into.maxZ, box.maxZ);
+	};
+	for (unsigned int k = 0; k < SliceCount; k++)
+	{
+		Box& slice = sliceBoxes[k];
+		slice = clusterBoxes[(size_t)k * countY * countX];
+		for (unsigned int y = 0; y < countY; y++)
+		{
+			Box& row = rowBoxes[(size_t)k * countY + y];
+			row = clusterBoxes[((size_t)k * countY + y) * countX];
+			for (unsigned int x = 1; x < countX; x++)
+				merge(row, clusterBoxes[((size_t)k * countY + y) * countX + x]);
+			merge(slice, row);
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Lights to view space spheres, then every slice on the
+// job system, then the slices' lists joined in order
+// --------------------------------------------------------
+void LightGrid::Assign(const Light* lights, unsigned int count, const XMFLOAT4X4& view)
+{
+	PROFILE_SCOPE("Light assignment");
+
+	// Every list can hold every light (plus padding) from
+	// the start, so lights moving about never grow them
+	if (count + 4 > spheres.x.capacity())
+	{
+		spheres.Reserve(count + 4);
+		for (Slice& slice : slices)
+		{
+			slice.candidates.Reserve(count + 4);
+			slice.rowCandidates.Reserve(count + 4);
+		}
+	}
+
+	XMMATRIX v = XMLoadFloat4x4(&view);
+	spheres.Clear();
+	for (unsigned int i = 0; i < count; i++)
+	{
+		const Light& light = lights[i];
+		XMVECTOR center = XMLoadFloat3(&light.position);
+		float radius = light.range;
+
+		// A cone's bounding sphere: narrow cones fit one through
+		// the apex and the cap's rim, wide ones one around the cap
+		if (light.spotCosOuter > -1.0f)
+		{
+			float cosAngle = std::max(light.spotCosOuter, 0.0f);
+			XMVECTOR direction = XMLoadFloat3(&light.direction);
+			if (cosAngle > 0.70710678f)
+			{
+				radius = light.range / (2.0f * cosAngle);
+				center = XMVectorAdd(center, XMVectorScale(direction, radius));
+			}
+			else if (cosAngle > 0.0f)
+			{
+				center = XMVectorAdd(center, XMVectorScale(direction, cosAngle * light.range));
+				radius = sqrtf(1.0f - cosAngle * cosAngle) * light.range;
+			}
+		}
+
+		XMFLOAT3 p;
+		XMStoreFloat3(&p, XMVector3TransformCoord(center, v));
+		spheres.Add(p.x, p.y, p.z, radius, i);
+	}
+	spheres.Pad();
+
+	JobSystem::ParallelFor(SliceCount, 1, [&](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int k = begin; k < end; k++)
+			AssignSlice(k);
+	});
+
+	// Each slice's clusters point into its own list; make
+	// them point into the joined one
+	stats = {};
+	stats.lights = count;
+	stats.clusters = (unsigned int)clusters.size();
+
+	unsigned int total = 0;
+	for (const Slice& slice : slices)
+		total += (unsigned int)slice.indices.size();
+	indices.resize(total);
+
+	unsigned int base = 0;
+	unsigned int perSlice = countX * countY;
+	for (unsigned int k = 0; k < SliceCount; k++)
+	{
+		const Slice& slice = slices[k];
+		if (!slice.indices.empty())
+			memcpy(&indices[base], slice.indices.data(), slice.indices.size() * sizeof(uint32_t));
+
+		for (unsigned int c = k * perSlice; c < (k + 1) * perSlice; c++)
+		{
+			clusters[c].offset += base;
+			if (clusters[c].count > 0)
+				stats.occupiedClusters++;
+			stats.maxPerCluster = std::max(stats.maxPerCluster, clusters[c].count);
+		}
+
+		base += (unsigned int)slice.indices.size();
+		stats.sphereTests += slice.sphereTests;
+	}
+	stats.indices = total;
+}
+
+// --------------------------------------------------------
+// Lights near enough the slice, then near enough each row,
+// then each cluster in the row
+// --------------------------------------------------------
+void LightGrid::AssignSlice(unsigned int k)
+{
+	Slice& slice = slices[k];
+	slice.indices.clear();
+	slice.sphereTests = 0;
+
+	Filter(spheres, sliceBoxes[k], slice.candidates, slice.sphereTests);
+
+	const SphereList& row = slice.rowCandidates;
+	for (unsigned int y = 0; y < countY; y++)
+	{
+		Filter(slice.candidates, rowBoxes[(size_t)k * countY + y], slice.rowCandidates, slice.sphereTests);
+
+		for (unsigned int x = 0; x < countX; x++)
+		{
+			size_t cluster = ((size_t)k * countY + y) * countX + x;
+			const Box& box = clusterBoxes[cluster];
+			__m128 minX = _mm_set1_ps(box.minX), minY = _mm_set1_ps(box.minY), minZ = _mm_set1_ps(box.minZ);
+			__m128 maxX = _mm_set1_ps(box.maxX), maxY = _mm_set1_ps(box.maxY), maxZ = _mm_set1_ps(box.maxZ);
+
+			unsigned int offset = (unsigned int)slice.indices.size();
+			for (unsigned int i = 0; i < row.count; i += 4)
+			{
+				int mask = SphereBoxMask(&row.x[i], &row.y[i], &row.z[i], &row.radius[i], minX, minY, minZ, maxX, maxY, maxZ);
+				for (unsigned int lane = 0; mask; lane++, mask >>= 1)
+				{
+					if (mask & 1)
+						slice.indices.push_back(row.light[i + lane]);
+				}
+			}
+			slice.sphereTests += row.count;
+			clusters[cluster] = { offset, (unsigned int)slice.indices.size() - offset };
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Keeps the spheres that touch a box, four at a time
+// --------------------------------------------------------
+void LightGrid::Filter(const SphereList& in, const Box& box, SphereList& out, unsigned long long& tests)
+{
+	out.Clear();
+	__m128 minX = _mm_set1_ps(box.minX), minY = _mm_set1_ps(box.minY), minZ = _mm_set1_ps(box.minZ);
+	__m128 maxX = _mm_set1_ps(box.maxX), maxY = _mm_set1_ps(box.maxY), maxZ = _mm_set1_ps(box.maxZ);
+
+	for (unsigned int i = 0; i < in.count; i += 4)
+	{
+		int mask = SphereBoxMask(&in.x[i], &in.y[i], &in.z[i], &in.radius[i], minX, minY, minZ, maxX, maxY, maxZ);
+		for (unsigned int lane = 0; mask; lane++, mask >>= 1)
+		{
+			if (mask & 1)
+				out.Add(in.x[i + lane], in.y[i + lane], in.z[i + lane], in.radius[i + lane], in.light[i + lane]);
+		}
+	}
+	out.Pad();
+	tests += in.count;
+}
+
+void LightGrid::Capture(LinearAllocator& memory, const Light* lights, unsigned int count, const XMFLOAT3& cameraPosition, float ambient, LightUpdate& outUpdate)
+{
+	Light* lightCopy = memory.Allocate<Light>(count);
+	ClusterRange* clusterCopy = memory.Allocate<ClusterRange>(clusters.size());
+	uint32_t* indexCopy = memory.Allocate<uint32_t>(indices.size());
+	if (count > 0)
+		memcpy(lightCopy, lights, count * sizeof(Light));
+	if (!clusters.empty())
+		memcpy(clusterCopy, clusters.data(), clusters.size() * sizeof(ClusterRange));
+	if (!indices.empty())
+		memcpy(indexCopy, indices.data(), indices.size() * sizeof(uint32_t));
+
+	outUpdate.lights = lightCopy;
+	outUpdate.lightCount = count;
+	outUpdate.clusters = clusterCopy;
+	outUpdate.clusterCount = (unsigned int)clusters.size();
+	outUpdate.indices = indexCopy;
+	outUpdate.indexCount = (unsigned int)indices.size();
+
+	LightingData& c = outUpdate.constants;
+	c = {};
+	c.cameraPosition = cameraPosition;
+	c.ambient = ambient;
+	c.clusterCountX = countX;
+	c.clusterCountY = countY;
+	c.clusterCountZ = SliceCount;
+	c.clusterTileSize = TileSize;
+	c.sliceScale = sliceScale;
+	c.sliceBias = sliceBias;
+}
+
+unsigned int LightGrid::GetClusterCountX()
+{
+	return countX;
+}
+
+unsigned int LightGrid::GetClusterCountY()
+{
+	return countY;
+}
+
+unsigned int LightGrid::GetClusterCount()
+{
+	return (unsigned int)clusters.size();
+}
+
+const ClusterRange* LightGrid::GetClusters()
+{
+	return clusters.data();
+}
+
+const uint32_t* LightGrid::GetIndices()
+{
+	return indices.data();
+}
+
+unsigned int LightGrid::GetIndexCount()
+{
+	return (unsigned int)indices.size();
+}
+
+LightGrid::Stats LightGrid::GetStats()
+{
+	return stats;
+}
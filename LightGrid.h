@@ -0,0 +1,135 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+#include <cstdint>
+
+#include "BufferStructs.h"
+#include "LinearAllocator.h"
+
+// Everything one frame's lighting upload needs, copied out
+// so the render thread never reads the grid itself
+struct LightUpdate
+{
+	const Light* lights;
+	unsigned int lightCount;
+	const ClusterRange* clusters;	// x fastest, then y, then depth slice
+	unsigned int clusterCount;
+	const uint32_t* indices;		// Every cluster's lights, back to back
+	unsigned int indexCount;
+	LightingData constants;
+};
+
+// --------------------------------------------------------
+// Assigns lights to clusters: the view frustum split into
+// screen tiles and exponential depth slices, so a pixel
+// only loops over the lights that can reach it
+//
+// - Cluster bounds are view-space boxes, worked out from
+//   the projection alone and only redone when it or the
+//   resolution changes.  Anything nearer than the first
+//   slice boundary shares slice 0.
+// - Each frame, lights go to view space as bounding spheres
+//   (a spot light's is around its cone, not its range),
+//   stored as separate x, y, z and radius arrays
+// - Slices are assigned in parallel on the job system, so
+//   each job owns its clusters outright.  A slice narrows
+//   the lights down by depth, then per row of tiles, then
+//   tests each cluster, four lights per SSE sphere/box test.
+// - The per-slice lists are joined into one compact index
+//   list, with an (offset, count) per cluster
+// - Scratch lists are kept between frames, so a steady
+//   light count allocates nothing.  No device is needed.
+// --------------------------------------------------------
+class LightGrid
+{
+public:
+	LightGrid() = default;
+	LightGrid(const LightGrid&) = delete; // Remove copy constructor
+	LightGrid& operator=(const LightGrid&) = delete; // Remove copy-assignment operator
+
+	static const unsigned int TileSize = 64;	// Pixels per cluster side
+	static const unsigned int SliceCount = 24;
+
+	// Rebuilds the cluster bounds if either has changed
+	void Configure(unsigned int width, unsigned int height, const DirectX::XMFLOAT4X4& projection);
+
+	// This frame's lights, in world space
+	void Assign(const Light* lights, unsigned int count, const DirectX::XMFLOAT4X4& view);
+
+	// Copies the lights, cluster ranges and indices into a
+	// frame's memory, along with the shader constants
+	void Capture(LinearAllocator& memory, const Light* lights, unsigned int count, const DirectX::XMFLOAT3& cameraPosition, float ambient, LightUpdate& outUpdate);
+
+	unsigned int GetClusterCountX();
+	unsigned int GetClusterCountY();
+	unsigned int GetClusterCount();
+	const ClusterRange* GetClusters();
+	const uint32_t* GetIndices();
+	unsigned int GetIndexCount();
+
+	// From the most recent Assign()
+	struct Stats
+	{
+		unsigned int lights;
+		unsigned int clusters;
+		unsigned int occupiedClusters;	// With at least one light
+		unsigned int indices;
+		unsigned int maxPerCluster;
+		unsigned long long sphereTests;	// Light against cluster, counted per light
+	};
+	Stats GetStats();
+
+private:
+	struct Box
+	{
+		float minX, minY, minZ;
+		float maxX, maxY, maxZ;
+	};
+
+	// Lights as SSE-friendly arrays, padded to a multiple of
+	// four with spheres that never touch anything
+	struct SphereList
+	{
+		std::vector<float> x, y, z, radius;
+		std::vector<uint32_t> light;
+		unsigned int count = 0;
+
+		void Clear();
+		void Reserve(unsigned int capacity);
+		void Add(float cx, float cy, float cz, float r, uint32_t index);
+		void Pad();
+	};
+
+	// One slice's job: its narrowed-down lights, and what it found
+	struct Slice
+	{
+		SphereList candidates;
+		SphereList rowCandidates;
+		std::vector<uint32_t> indices;
+		unsigned long long sphereTests = 0;
+	};
+
+	void AssignSlice(unsigned int slice);
+	static void Filter(const SphereList& in, const Box& box, SphereList& out, unsigned long long& tests);
+
+	unsigned int width = 0;
+	unsigned int height = 0;
+	DirectX::XMFLOAT4X4 projection = {};
+	unsigned int countX = 0;
+	unsigned int countY = 0;
+	float sliceScale = 0;
+	float sliceBias = 0;
+
+	// View space bounds of every cluster, every row of tiles
+	// within a slice, and every slice
+	std::vector<Box> clusterBoxes;
+	std::vector<Box> rowBoxes;
+	Box sliceBoxes[SliceCount] = {};
+
+	SphereList spheres;
+	Slice slices[SliceCount];
+	std::vector<ClusterRange> clusters;
+	std::vector<uint32_t> indices;
+	Stats stats = {};
+};
@@ -0,0 +1,108 @@
+#include "LinearAllocator.h"
+
+#include <cstdarg>
+#include <cstdio>
+
+LinearAllocator::LinearAllocator(size_t initialCapacity)
+{
+	AddBlock(initialCapacity > 0 ? initialCapacity : 1);
+}
+
+void* LinearAllocator::Allocate(size_t size, size_t alignment)
+{
+	Block* block = &blocks.back();
+	size_t start = (size_t)block->memory.get() + offset;
+	size_t aligned = (start + alignment - 1) & ~(alignment - 1);
+
+	if (aligned + size > (size_t)block->memory.get() + block->size)
+	{
+		usedBefore += offset;
+		AddBlock(size + alignment);
+
+		block = &blocks.back();
+		start = (size_t)block->memory.get();
+		aligned = (start + alignment - 1) & ~(alignment - 1);
+	}
+
+	offset = aligned + size - (size_t)block->memory.get();
+
+	size_t used = usedBefore + offset;
+	if (used > peak)
+		peak = used;
+
+	return (void*)aligned;
+}
+
+// --------------------------------------------------------
+// Measures first, so the string takes exactly its own size
+// --------------------------------------------------------
+const char* LinearAllocator::Format(const char* format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	va_list measureArgs;
+	va_copy(measureArgs, args);
+	int length = vsnprintf(0, 0, format, measureArgs);
+	va_end(measureArgs);
+
+	if (length < 0)
+	{
+		va_end(args);
+		return "";
+	}
+
+	char* text = (char*)Allocate((size_t)length + 1, 1);
+	vsnprintf(text, (size_t)length + 1, format, args);
+	va_end(args);
+	return text;
+}
+
+// --------------------------------------------------------
+// Everything handed out so far becomes invalid
+// --------------------------------------------------------
+void LinearAllocator::Reset()
+{
+	// Overflowed last time?  Swap the pile of blocks for one
+	// that would have fit it all
+	if (blocks.size() > 1)
+	{
+		size_t total = 0;
+		for (Block& block : blocks)
+			total += block.size;
+
+		blocks.clear();
+		AddBlock(total);
+	}
+
+	offset = 0;
+	usedBefore = 0;
+}
+
+size_t LinearAllocator::GetUsed()
+{
+	return usedBefore + offset;
+}
+
+size_t LinearAllocator::GetCapacity()
+{
+	size_t total = 0;
+	for (Block& block : blocks)
+		total += block.size;
+	return total;
+}
+
+size_t LinearAllocator::GetPeak()
+{
+	return peak;
+}
+
+void LinearAllocator::AddBlock(size_t minimumSize)
+{
+	// At least double, so a growing frame settles quickly
+	size_t size = blocks.empty() ? minimumSize : blocks.back().size * 2;
+	if (size < minimumSize)
+		size = minimumSize;
+
+	blocks.push_back({ std::unique_ptr<uint8_t[]>(new uint8_t[size]), size });
+	offset = 0;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// --------------------------------------------------------
+// A bump allocator for memory that all dies at once
+//
+// - Allocate() just moves a pointer forward; nothing is
+//   freed individually and no destructors ever run
+// - Reset() makes the whole thing available again
+// - Running out adds another block rather than failing,
+//   and the next Reset() merges everything into one block
+//   big enough for the whole frame, so a steady workload
+//   settles on a single block with no allocations at all
+// - One thread at a time
+// --------------------------------------------------------
+class LinearAllocator
+{
+public:
+	explicit LinearAllocator(size_t initialCapacity = 1 << 20);
+	LinearAllocator(const LinearAllocator&) = delete; // Remove copy constructor
+	LinearAllocator& operator=(const LinearAllocator&) = delete; // Remove copy-assignment operator
+
+	void* Allocate(size_t size, size_t alignment = 16);
+
+	// Uninitialized room for count Ts
+	template<typename T>
+	T* Allocate(size_t count)
+	{
+		static_assert(std::is_trivially_destructible<T>::value, "Nothing allocated here is ever destroyed");
+		return (T*)Allocate(sizeof(T) * count, alignof(T) > 16 ? alignof(T) : 16);
+	}
+
+	// printf() into this memory, for text that only has to
+	// last until the next Reset()
+	const char* Format(const char* format, ...);
+
+	void Reset();
+
+	size_t GetUsed();
+	size_t GetCapacity();
+	size_t GetPeak();
+
+private:
+	void AddBlock(size_t minimumSize);
+
+	struct Block
+	{
+		std::unique_ptr<uint8_t[]> memory;
+		size_t size;
+	};
+
+	std::vector<Block> blocks;
+	size_t offset = 0;		// Into the last block
+	size_t usedBefore = 0;	// Everything in the blocks before it
+	size_t peak = 0;
+};
@@ -5,6 +5,13 @@
 #include "Graphics.h"
 #include "Game.h"
 #include "Input.h"
+#include "Benchmarks.h"
+#include "Profiler.h"
+#include "AllocationTracker.h"
+#include "Headless.h"
+#include "BenchmarkSuite.h"
+#include "InputLog.h"
+#include "FramePacing.h"
 
 // Annonymous namespace to hold variables
 // only accessible in this file
@@ -26,6 +33,57 @@ namespace
 		if(game)
 			game->OnResize();
 	}
+
+	// A benchmark run from the command line: the flag that
+	// starts it, the run itself and the file its results also
+	// go to.  A run returning false fails (exit code 1).
+	struct BenchmarkCommand
+	{
+		const char* flag;
+		bool (*run)(std::vector<Benchmarks::Result>& results);
+		const char* outputPath;
+	};
+
+	const BenchmarkCommand benchmarkCommands[] =
+	{
+		// Scaling with worker threads
+		{ "-benchmark-jobs", [](std::vector<Benchmarks::Result>& results) { Benchmarks::JobScaling(500000, results); return true; }, "JobScaling.txt" },
+
+		// Parallel command recording, through the headless backend
+		{ "-benchmark-commands", [](std::vector<Benchmarks::Result>& results) { Benchmarks::CommandRecording(100000, results); return true; }, "CommandRecording.txt" },
+
+		// Clustered light assignment, 4096 lights at 1080p
+		{ "-benchmark-lights", [](std::vector<Benchmarks::Result>& results) { Benchmarks::LightAssignment(4096, results); return true; }, "LightAssignment.txt" },
+
+		// The software rasterizer, in triangles and pixels per second
+		{ "-benchmark-raster", [](std::vector<Benchmarks::Result>& results) { Benchmarks::SoftwareRendering(100000, results); return true; }, "SoftwareRaster.txt" },
+
+		// The profiler's own markers, failing if one costs more
+		// than its budget, so a build machine catches a regression
+		{ "-benchmark-profiler", [](std::vector<Benchmarks::Result>& results) { return Benchmarks::ProfilerMarkers(1000000, results); }, "ProfilerMarkers.txt" },
+	};
+
+	// Runs one, printing its results to the console and its file
+	int RunBenchmark(const BenchmarkCommand& command)
+	{
+		std::vector<Benchmarks::Result> results;
+		bool passed = command.run(results);
+		Benchmarks::Print(results, stdout);
+
+		FILE* file = 0;
+		if (fopen_s(&file, command.outputPath, "w") == 0 && file)
+		{
+			Benchmarks::Print(results, file);
+			fclose(file);
+		}
+
+		if (!passed)
+		{
+			printf("FAILED: %s over budget\n", command.flag);
+			return 1;
+		}
+		return 0;
+	}
 }
 
 
@@ -49,6 +107,45 @@ int WINAPI WinMain(
 	printf("Console window created successfully.  Feel free to printf() here.\n");
 #endif
 
+	// Runs with no window or device, so they work on build
+	// machines too, reporting to a console instead
+	// - A benchmark from the table above
+	// - The game over every synthetic scene in the suite (or
+	//   just "-scene name"), flying each one's camera path.
+	//   Results go to BenchmarkSuite.json.
+	// - The game itself for a fixed number of frames
+	//   ("-headless -frames 600"); the portable Headless target
+	//   runs the same thing.  Results go to Headless.txt.
+	//   "-image Frame.bmp" also draws it on the CPU and saves
+	//   the last frame, and "-check-allocations" fails the run
+	//   (exit code 1) if any frame after the warm-up touched
+	//   the heap.  Memory per tag goes to Memory.json.
+	// Both runs of the game take "-frames N", "-unsorted" (scene
+	// order rather than front to back), "-depth-prepass",
+	// "-lights N" (how many are assigned each frame) and
+	// "-views split" or "-views quad" (two or four cameras at
+	// once) - see Headless::ParseOptions().
+	const BenchmarkCommand* benchmark = 0;
+	for (const BenchmarkCommand& command : benchmarkCommands)
+	{
+		if (strstr(lpCmdLine, command.flag))
+		{
+			benchmark = &command;
+			break;
+		}
+	}
+	bool suite = strstr(lpCmdLine, "-benchmark-suite") != 0;
+	bool headless = strstr(lpCmdLine, "-headless") != 0;
+	if (benchmark || suite || headless)
+	{
+		Window::CreateConsoleWindow(500, 120, 32, 120);
+		if (benchmark)
+			return RunBenchmark(*benchmark);
+		if (suite)
+			return BenchmarkSuite::RunCommandLine(lpCmdLine);
+		return Headless::RunCommandLine(lpCmdLine);
+	}
+
 	// Set up app initialization details
 	unsigned int windowWidth = 1280;
 	unsigned int windowHeight = 720;
@@ -85,6 +182,42 @@ int WINAPI WinMain(
 	// Now the game itself can be initialzied
 	game->Initialize();
 
+	// Input recording and replay ("-record run.inp", "-replay
+	// run.inp"), and a fixed delta time ("-fixed-delta 60") so
+	// that two runs step the game identically.  A replay uses
+	// the recorded deltas and quits when the log runs out.
+	InputLog inputLog;
+	const char* record = strstr(lpCmdLine, "-record ");
+	const char* replay = strstr(lpCmdLine, "-replay ");
+	if (record || replay)
+	{
+		Window::CreateConsoleWindow(500, 120, 32, 120);
+
+		const char* arg = record ? record + strlen("-record ") : replay + strlen("-replay ");
+		std::string path(arg, strcspn(arg, " "));
+		bool started = record ? inputLog.StartRecording(path.c_str()) : inputLog.StartReplay(path.c_str());
+		if (started)
+			printf("%s %s\n", record ? "Recording input to" : "Replaying input from", path.c_str());
+		else
+			printf("Could not open input log %s\n", path.c_str());
+	}
+
+	float fixedDelta = 0;
+	const char* fixed = strstr(lpCmdLine, "-fixed-delta");
+	if (fixed)
+	{
+		int hz = atoi(fixed + strlen("-fixed-delta"));
+		fixedDelta = 1.0f / (hz > 0 ? hz : 60);
+	}
+	float steppedTime = 0;
+
+	// Frames are throttled while minimized, unfocused or
+	// showing nothing new, unless a run has to step exactly
+	// as recorded
+	bool paced = fixedDelta == 0 && !record && !replay;
+	bool inputArrived = false;
+	FramePacing::Initialize();
+
 	// Time tracking
 	LARGE_INTEGER perfFreq{};
 	double perfSeconds = 0;
@@ -101,6 +234,8 @@ int WINAPI WinMain(
 	currentTime = startTime;
 	previousTime = startTime;
 
+	Profiler::SetThreadName("Main");
+
 	// Windows message loop (and our game loop)
 	MSG msg = {};
 	while (msg.message != WM_QUIT)
@@ -112,9 +247,26 @@ int WINAPI WinMain(
 			// to our custom WindowProc function
 			TranslateMessage(&msg);
 			DispatchMessage(&msg);
+
+			if ((msg.message >= WM_KEYFIRST && msg.message <= WM_KEYLAST) ||
+				(msg.message >= WM_MOUSEFIRST && msg.message <= WM_MOUSELAST) ||
+				msg.message == WM_INPUT)
+				inputArrived = true;
+		}
+		else if (paced && Window::IsMinimized())
+		{
+			// Nothing to show, so no frames at all, and the time
+			// spent minimized doesn't count towards the next one
+			FramePacing::WaitForMessages();
+			QueryPerformanceCounter((LARGE_INTEGER*)&previousTime);
 		}
 		else
 		{
+			// Everything from here to the next time around is one frame
+			FramePacing::BeginFrame();
+			Profiler::BeginFrame();
+			AllocationTracker::BeginFrame();
+
 			// Calculate up-to-date timing info
 			QueryPerformanceCounter((LARGE_INTEGER*)&currentTime);
 			float deltaTime = max((float)((currentTime - previousTime) * perfSeconds), 0.0f);
@@ -124,25 +276,60 @@ int WINAPI WinMain(
 			// Calculate basic fps
 			Window::UpdateStats(totalTime);
 
+			// Stepped time when it has to repeat exactly
+			if (fixedDelta > 0)
+				deltaTime = fixedDelta;
+			if (!inputLog.BeginFrame(deltaTime))
+			{
+				printf("Replayed %u frames\n", inputLog.GetFrameCount());
+				Window::Quit();
+				continue;
+			}
+			if (fixedDelta > 0 || inputLog.IsReplaying() || inputLog.IsRecording())
+			{
+				steppedTime += deltaTime;
+				totalTime = steppedTime;
+			}
+
 			// Input updating
 			Input::Update();
 
 			// Update and draw
+			// - Draw() only hands the frame to the render thread
+			// - A frame with no input that would look just like the
+			//   last one drawn skips it
 			game->Update(deltaTime, totalTime);
-			game->Draw(deltaTime, totalTime);
+
+			bool draw = !paced || FramePacing::ShouldDraw(inputArrived || game->NeedsDraw());
+			double drawMs = 0;
+			if (draw)
+			{
+				__int64 drawStart = 0;
+				__int64 drawEnd = 0;
+				QueryPerformanceCounter((LARGE_INTEGER*)&drawStart);
+				game->Draw(deltaTime, totalTime);
+				QueryPerformanceCounter((LARGE_INTEGER*)&drawEnd);
+				drawMs = (drawEnd - drawStart) * perfSeconds * 1000.0;
+			}
+			else
+				game->SkipDraw();
+			inputArrived = false;
+
+			// Before the wheel and raw deltas are cleared
+			inputLog.EndFrame(deltaTime);
 
 			// Notify Input system about end of frame
 			Input::EndOfFrame();
 
-#if defined(DEBUG) || defined(_DEBUG)
-			// Print any graphics debug messages that occurred this frame
-			Graphics::PrintDebugMessages();
-#endif
+			// Sleeps until the next frame is due, if it's capped
+			if (paced)
+				FramePacing::EndFrame(draw, drawMs, Window::HasFocus());
 		}
 	}
 
 	// Clean up
 	delete game;
+	FramePacing::ShutDown();
 	Input::ShutDown();
 	Graphics::ShutDown();
 	return (HRESULT)msg.wParam;
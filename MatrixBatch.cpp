@@ -0,0 +1,76 @@
+#include "MatrixBatch.h"
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Multiplies a run of matrices by one shared matrix
+//
+// - The shared matrix is loaded into SIMD registers once
+//   for the whole batch instead of once per object
+// - Two objects are processed per iteration to give the
+//   CPU independent work to overlap
+// --------------------------------------------------------
+void MatrixBatch::MultiplyByMatrix(
+	const XMFLOAT4X4* inputs,
+	size_t inputStride,
+	size_t count,
+	const XMFLOAT4X4& right,
+	XMFLOAT4X4* outputs)
+{
+	XMMATRIX r = XMLoadFloat4x4(&right);
+	const unsigned char* in = (const unsigned char*)inputs;
+
+	size_t i = 0;
+	for (; i + 1 < count; i += 2)
+	{
+		XMMATRIX a = XMLoadFloat4x4((const XMFLOAT4X4*)(in + i * inputStride));
+		XMMATRIX b = XMLoadFloat4x4((const XMFLOAT4X4*)(in + (i + 1) * inputStride));
+		XMStoreFloat4x4(&outputs[i], XMMatrixMultiply(a, r));
+		XMStoreFloat4x4(&outputs[i + 1], XMMatrixMultiply(b, r));
+	}
+
+	// Odd one out
+	if (i < count)
+	{
+		XMMATRIX a = XMLoadFloat4x4((const XMFLOAT4X4*)(in + i * inputStride));
+		XMStoreFloat4x4(&outputs[i], XMMatrixMultiply(a, r));
+	}
+}
+
+// --------------------------------------------------------
+// The same two-at-a-time pass over a list of indices, so a
+// frame only pays for the matrices it actually uses
+// --------------------------------------------------------
+void MatrixBatch::MultiplyGathered(
+	const XMFLOAT4X4* inputs,
+	size_t inputStride,
+	const unsigned int* indices,
+	XMFLOAT4X4* outputs,
+	size_t outputStride,
+	size_t count,
+	const XMFLOAT4X4& right)
+{
+	XMMATRIX r = XMLoadFloat4x4(&right);
+	const unsigned char* in = (const unsigned char*)inputs;
+	const unsigned char* index = (const unsigned char*)indices;
+	unsigned char* out = (unsigned char*)outputs;
+
+	size_t i = 0;
+	for (; i + 1 < count; i += 2)
+	{
+		unsigned int ia = *(const unsigned int*)(index + i * outputStride);
+		unsigned int ib = *(const unsigned int*)(index + (i + 1) * outputStride);
+		XMMATRIX a = XMLoadFloat4x4((const XMFLOAT4X4*)(in + ia * inputStride));
+		XMMATRIX b = XMLoadFloat4x4((const XMFLOAT4X4*)(in + ib * inputStride));
+		XMStoreFloat4x4((XMFLOAT4X4*)(out + i * outputStride), XMMatrixMultiply(a, r));
+		XMStoreFloat4x4((XMFLOAT4X4*)(out + (i + 1) * outputStride), XMMatrixMultiply(b, r));
+	}
+
+	// Odd one out
+	if (i < count)
+	{
+		unsigned int ia = *(const unsigned int*)(index + i * outputStride);
+		XMMATRIX a = XMLoadFloat4x4((const XMFLOAT4X4*)(in + ia * inputStride));
+		XMStoreFloat4x4((XMFLOAT4X4*)(out + i * outputStride), XMMatrixMultiply(a, r));
+	}
+}
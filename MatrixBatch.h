@@ -0,0 +1,36 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+
+// --------------------------------------------------------
+// Batched matrix helpers for work that used to happen once
+// per vertex on the GPU but is really constant per object
+// --------------------------------------------------------
+namespace MatrixBatch
+{
+	// outputs[i] = inputs[i] * right, for count matrices
+	// - inputs are read with a byte stride so they can live
+	//   inside larger structs (like InstanceData)
+	void MultiplyByMatrix(
+		const DirectX::XMFLOAT4X4* inputs,
+		size_t inputStride,
+		size_t count,
+		const DirectX::XMFLOAT4X4& right,
+		DirectX::XMFLOAT4X4* outputs);
+
+	// outputs[i] = inputs[indices[i]] * right, for count matrices
+	// - Only the listed inputs are read (say, just what's
+	//   visible), and they're read with a byte stride
+	// - indices and outputs are walked with one shared byte
+	//   stride, so both can live in an array of structs
+	//   (like DrawData)
+	void MultiplyGathered(
+		const DirectX::XMFLOAT4X4* inputs,
+		size_t inputStride,
+		const unsigned int* indices,
+		DirectX::XMFLOAT4X4* outputs,
+		size_t outputStride,
+		size_t count,
+		const DirectX::XMFLOAT4X4& right);
+}
@@ -1,8 +1,10 @@
 #pragma once
-#include <d3d11.h>
-#include <wrl/client.h>
+#include <vector>
 
 #include "Vertex.h"
+#include "Bounds.h"
+#include "SlotMap.h"
+#include "CommandBackend.h"
 
 class Mesh
 {
@@ -11,20 +13,33 @@ public:
 	~Mesh();
 	Mesh(const Mesh&) = delete; // Remove copy constructor
 	Mesh& operator=(const Mesh&) = delete; // Remove copy-assignment operator
+	Mesh(Mesh&&) = default; // Movable, so slot maps can pack meshes densely
+	Mesh& operator=(Mesh&&) = default;
 
-	Microsoft::WRL::ComPtr<ID3D11Buffer> GetVertexBuffer();
-	Microsoft::WRL::ComPtr<ID3D11Buffer> GetIndexBuffer();
 	unsigned int GetIndexCount();
 	const char* GetName();
 	unsigned int GetVertexCount();
-	void DrawMesh();
+	const Vertex* GetVertices();
+	const unsigned int* GetIndices();
+	Bounds GetLocalBounds();
+	DrawItem GetDrawItem(unsigned int instanceSlot);
+
+	// Where a command backend copied the geometry to; the
+	// backend owns it, and releases it
+	void SetGeometry(const GeometryBuffers& buffers);
+	const GeometryBuffers& GetGeometry();
 
 private:
-	// Buffers to hold actual geometry data
-	Microsoft::WRL::ComPtr<ID3D11Buffer> vertBuffer;
-	Microsoft::WRL::ComPtr<ID3D11Buffer> inBuffer;
+	// Buffers holding the geometry wherever it's drawn from
+	GeometryBuffers geometry = {};
+
+	// CPU copies, for drawing without a device
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
 	unsigned int totalIndices;
 	unsigned int totalVertices;
 	const char* name;
+	Bounds localBounds;
 };
 
+typedef Handle<Mesh> MeshHandle;
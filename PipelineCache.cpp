@@ -0,0 +1,258 @@
+#include "PipelineCache.h"
+#include "Graphics.h"
+#include "AllocationTracker.h"
+
+// Annonymous namespace to hold helpers
+// only accessible in this file
+namespace
+{
+	// FNV-1a, fed one field at a time so that padding
+	// inside the descriptions never reaches the hash
+	struct Hasher
+	{
+		uint64_t hash = 14695981039346656037ull;
+
+		template<typename T>
+		void Add(const T& value)
+		{
+			const unsigned char* bytes = (const unsigned char*)&value;
+			for (size_t i = 0; i < sizeof(T); i++)
+			{
+				hash ^= bytes[i];
+				hash *= 1099511628211ull;
+			}
+		}
+	};
+
+	uint64_t Hash(const D3D11_RASTERIZER_DESC& d)
+	{
+		Hasher h;
+		h.Add(d.FillMode);
+		h.Add(d.CullMode);
+		h.Add(d.FrontCounterClockwise);
+		h.Add(d.DepthBias);
+		h.Add(d.DepthBiasClamp);
+		h.Add(d.SlopeScaledDepthBias);
+		h.Add(d.DepthClipEnable);
+		h.Add(d.ScissorEnable);
+		h.Add(d.MultisampleEnable);
+		h.Add(d.AntialiasedLineEnable);
+		return h.hash;
+	}
+
+	uint64_t Hash(const D3D11_BLEND_DESC& d)
+	{
+		Hasher h;
+		h.Add(d.AlphaToCoverageEnable);
+		h.Add(d.IndependentBlendEnable);
+
+		// Without independent blending only the first target counts
+		unsigned int targets = d.IndependentBlendEnable ? 8 : 1;
+		for (unsigned int i = 0; i < targets; i++)
+		{
+			const D3D11_RENDER_TARGET_BLEND_DESC& t = d.RenderTarget[i];
+			h.Add(t.BlendEnable);
+			h.Add(t.SrcBlend);
+			h.Add(t.DestBlend);
+			h.Add(t.BlendOp);
+			h.Add(t.SrcBlendAlpha);
+			h.Add(t.DestBlendAlpha);
+			h.Add(t.BlendOpAlpha);
+			h.Add(t.RenderTargetWriteMask);
+		}
+		return h.hash;
+	}
+
+	void AddStencilOp(Hasher& h, const D3D11_DEPTH_STENCILOP_DESC& op)
+	{
+		h.Add(op.StencilFailOp);
+		h.Add(op.StencilDepthFailOp);
+		h.Add(op.StencilPassOp);
+		h.Add(op.StencilFunc);
+	}
+
+	uint64_t Hash(const D3D11_DEPTH_STENCIL_DESC& d)
+	{
+		Hasher h;
+		h.Add(d.DepthEnable);
+		h.Add(d.DepthWriteMask);
+		h.Add(d.DepthFunc);
+		h.Add(d.StencilEnable);
+		h.Add(d.StencilReadMask);
+		h.Add(d.StencilWriteMask);
+		AddStencilOp(h, d.FrontFace);
+		AddStencilOp(h, d.BackFace);
+		return h.hash;
+	}
+
+	// --------------------------------------------------------
+	// Finds or creates one state object.  Call with the
+	// mutex held.
+	// --------------------------------------------------------
+	template<typename State, typename Desc, typename CreateFn>
+	State* FindOrCreate(std::unordered_map<uint64_t, Microsoft::WRL::ComPtr<State>>& states, const Desc& desc, PipelineCache::Stats& stats, const CreateFn& create)
+	{
+		stats.stateRequests++;
+
+		uint64_t key = Hash(desc);
+		auto found = states.find(key);
+		if (found != states.end())
+			return found->second.Get();
+
+		Microsoft::WRL::ComPtr<State> state;
+		if (FAILED(create(&desc, state.GetAddressOf())))
+		{
+			stats.stateFailures++;
+			return 0;
+		}
+
+		stats.stateObjects++;
+		states[key] = state;
+		return state.Get();
+	}
+}
+
+
+PipelineDesc::PipelineDesc()
+{
+	rasterizer = {};
+	rasterizer.FillMode = D3D11_FILL_SOLID;
+	rasterizer.CullMode = D3D11_CULL_BACK;
+	rasterizer.DepthClipEnable = TRUE;
+
+	blend = {};
+	for (D3D11_RENDER_TARGET_BLEND_DESC& target : blend.RenderTarget)
+	{
+		target.SrcBlend = D3D11_BLEND_ONE;
+		target.DestBlend = D3D11_BLEND_ZERO;
+		target.BlendOp = D3D11_BLEND_OP_ADD;
+		target.SrcBlendAlpha = D3D11_BLEND_ONE;
+		target.DestBlendAlpha = D3D11_BLEND_ZERO;
+		target.BlendOpAlpha = D3D11_BLEND_OP_ADD;
+		target.RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+	}
+
+	depthStencil = {};
+	depthStencil.DepthEnable = TRUE;
+	depthStencil.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
+	depthStencil.DepthFunc = D3D11_COMPARISON_LESS;
+	depthStencil.StencilReadMask = D3D11_DEFAULT_STENCIL_READ_MASK;
+	depthStencil.StencilWriteMask = D3D11_DEFAULT_STENCIL_WRITE_MASK;
+	depthStencil.FrontFace = { D3D11_STENCIL_OP_KEEP, D3D11_STENCIL_OP_KEEP, D3D11_STENCIL_OP_KEEP, D3D11_COMPARISON_ALWAYS };
+	depthStencil.BackFace = depthStencil.FrontFace;
+}
+
+
+void PipelineCache::Initialize(ShaderCache* shaderCache)
+{
+	shaders = shaderCache;
+}
+
+ID3D11RasterizerState* PipelineCache::GetRasterizerState(const D3D11_RASTERIZER_DESC& desc)
+{
+	ALLOCATION_SCOPE("Render");
+	std::lock_guard<std::mutex> lock(mutex);
+	return FindOrCreate(rasterizerStates, desc, stats, [](const D3D11_RASTERIZER_DESC* d, ID3D11RasterizerState** out)
+		{ return Graphics::Device->CreateRasterizerState(d, out); });
+}
+
+ID3D11BlendState* PipelineCache::GetBlendState(const D3D11_BLEND_DESC& desc)
+{
+	ALLOCATION_SCOPE("Render");
+	std::lock_guard<std::mutex> lock(mutex);
+	return FindOrCreate(blendStates, desc, stats, [](const D3D11_BLEND_DESC* d, ID3D11BlendState** out)
+		{ return Graphics::Device->CreateBlendState(d, out); });
+}
+
+ID3D11DepthStencilState* PipelineCache::GetDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& desc)
+{
+	ALLOCATION_SCOPE("Render");
+	std::lock_guard<std::mutex> lock(mutex);
+	return FindOrCreate(depthStencilStates, desc, stats, [](const D3D11_DEPTH_STENCIL_DESC* d, ID3D11DepthStencilState** out)
+		{ return Graphics::Device->CreateDepthStencilState(d, out); });
+}
+
+// --------------------------------------------------------
+// The key covers the shader ids, topology and every state
+// field, so equal descriptions share one pipeline
+// --------------------------------------------------------
+PipelineId PipelineCache::GetPipeline(const PipelineDesc& desc)
+{
+	Hasher h;
+	h.Add(desc.vertexShader);
+	h.Add(desc.pixelShader);
+	h.Add(desc.topology);
+	h.Add(Hash(desc.rasterizer));
+	h.Add(Hash(desc.blend));
+	h.Add(Hash(desc.depthStencil));
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stats.pipelineRequests++;
+
+		auto found = lookup.find(h.hash);
+		if (found != lookup.end())
+			return found->second;
+		if (pipelineCount == MaxPipelines)
+			return InvalidPipeline;
+	}
+
+	Pipeline pipeline = {};
+	pipeline.key = h.hash;
+	pipeline.vertexShader = desc.vertexShader;
+	pipeline.pixelShader = desc.pixelShader;
+	pipeline.topology = desc.topology;
+	pipeline.rasterizer = GetRasterizerState(desc.rasterizer);
+	pipeline.blend = GetBlendState(desc.blend);
+	pipeline.depthStencil = GetDepthStencilState(desc.depthStencil);
+	if (!pipeline.rasterizer || !pipeline.blend || !pipeline.depthStencil)
+		return InvalidPipeline;
+
+	ALLOCATION_SCOPE("Render");
+	std::lock_guard<std::mutex> lock(mutex);
+	PipelineId id = pipelineCount;
+	pipelines[id] = pipeline;
+	lookup[pipeline.key] = id;
+	pipelineCount = id + 1;
+	stats.pipelines = pipelineCount;
+	return id;
+}
+
+// --------------------------------------------------------
+// One comparison decides whether anything is set at all
+// --------------------------------------------------------
+void PipelineCache::Bind(ID3D11DeviceContext* context, PipelineId id)
+{
+	binds++;
+	if (id == bound)
+	{
+		redundantBinds++;
+		return;
+	}
+	if (id >= pipelineCount)
+		return;
+
+	const Pipeline& p = pipelines[id];
+	context->IASetPrimitiveTopology(p.topology);
+	context->IASetInputLayout(shaders->GetInputLayout(p.vertexShader));
+	context->VSSetShader(shaders->GetVertexShader(p.vertexShader), 0, 0);
+	context->PSSetShader(shaders->GetPixelShader(p.pixelShader), 0, 0);
+	context->RSSetState(p.rasterizer);
+	context->OMSetBlendState(p.blend, 0, 0xFFFFFFFF);
+	context->OMSetDepthStencilState(p.depthStencil, 0);
+	bound = id;
+}
+
+void PipelineCache::Invalidate()
+{
+	bound = InvalidPipeline;
+}
+
+PipelineCache::Stats PipelineCache::GetStats()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	Stats current = stats;
+	current.binds = binds;
+	current.redundantBinds = redundantBinds;
+	return current;
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include "ShaderCache.h"
+
+// Index of a created pipeline
+typedef unsigned int PipelineId;
+const PipelineId InvalidPipeline = 0xFFFFFFFF;
+
+// --------------------------------------------------------
+// Everything a draw binds besides its buffers.  The
+// defaults are D3D11's own, so an untouched description is
+// the state the device starts out in.
+// --------------------------------------------------------
+struct PipelineDesc
+{
+	PipelineDesc();
+
+	ShaderId vertexShader = InvalidShader;	// Its input layout comes along
+	ShaderId pixelShader = InvalidShader;
+	D3D11_PRIMITIVE_TOPOLOGY topology = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+
+	D3D11_RASTERIZER_DESC rasterizer;
+	D3D11_BLEND_DESC blend;
+	D3D11_DEPTH_STENCIL_DESC depthStencil;
+};
+
+// --------------------------------------------------------
+// Creates each rasterizer, blend and depth-stencil state
+// once, and bundles them with shaders into pipelines
+//
+// - State objects are keyed by a hash of every field of
+//   their description, so asking twice for the same state
+//   (from anywhere) gets the same object back
+// - Pipelines are deduplicated the same way, and are meant
+//   to be made at setup time, not while drawing
+// - Bind() sets a whole pipeline at once, and does nothing
+//   if it's the one already bound.  Anything else that
+//   touches the same state must Invalidate() first.
+// - Shaders are looked up at bind time, so hot-reloaded
+//   ones are picked up by the next Invalidate()d bind
+// --------------------------------------------------------
+class PipelineCache
+{
+public:
+	PipelineCache() = default;
+	PipelineCache(const PipelineCache&) = delete; // Remove copy constructor
+	PipelineCache& operator=(const PipelineCache&) = delete; // Remove copy-assignment operator
+
+	static const unsigned int MaxPipelines = 64;
+
+	void Initialize(ShaderCache* shaders);
+
+	// Setup time
+	PipelineId GetPipeline(const PipelineDesc& desc);
+	ID3D11RasterizerState* GetRasterizerState(const D3D11_RASTERIZER_DESC& desc);
+	ID3D11BlendState* GetBlendState(const D3D11_BLEND_DESC& desc);
+	ID3D11DepthStencilState* GetDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& desc);
+
+	// Draw time, on one context
+	void Bind(ID3D11DeviceContext* context, PipelineId id);
+	void Invalidate();
+
+	struct Stats
+	{
+		unsigned int pipelines;
+		unsigned int pipelineRequests;
+		unsigned int stateObjects;		// Of all three kinds
+		unsigned int stateRequests;
+		unsigned int stateFailures;
+		unsigned long long binds;
+		unsigned long long redundantBinds;	// Skipped, already bound
+	};
+	Stats GetStats();
+
+private:
+	struct Pipeline
+	{
+		uint64_t key;
+		ShaderId vertexShader;
+		ShaderId pixelShader;
+		D3D11_PRIMITIVE_TOPOLOGY topology;
+		ID3D11RasterizerState* rasterizer;		// Owned by the maps below
+		ID3D11BlendState* blend;
+		ID3D11DepthStencilState* depthStencil;
+	};
+
+	ShaderCache* shaders = 0;
+
+	// Created objects, by description hash.  Setup time only,
+	// under the mutex.
+	std::mutex mutex;
+	std::unordered_map<uint64_t, Microsoft::WRL::ComPtr<ID3D11RasterizerState>> rasterizerStates;
+	std::unordered_map<uint64_t, Microsoft::WRL::ComPtr<ID3D11BlendState>> blendStates;
+	std::unordered_map<uint64_t, Microsoft::WRL::ComPtr<ID3D11DepthStencilState>> depthStencilStates;
+	std::unordered_map<uint64_t, PipelineId> lookup;
+
+	// Fixed, so ids stay valid (and readable while drawing)
+	// as more are added
+	Pipeline pipelines[MaxPipelines] = {};
+	std::atomic<unsigned int> pipelineCount{ 0 };
+
+	// Draw side
+	PipelineId bound = InvalidPipeline;
+	std::atomic<unsigned long long> binds{ 0 };
+	std::atomic<unsigned long long> redundantBinds{ 0 };
+
+	Stats stats = {};
+};
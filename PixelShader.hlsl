@@ -1,4 +1,44 @@
 
+// Permutation features, set by ShaderCache (see ShaderFeature
+// in ShaderCache.h).  The .cso the build makes has none.
+#ifndef CLUSTERED_LIGHTS
+#define CLUSTERED_LIGHTS 0
+#endif
+
+#if CLUSTERED_LIGHTS
+// Per-frame lighting constants
+// - Must match LightingData in BufferStructs.h
+cbuffer LightingData : register(b0)
+{
+	float3 cameraPosition;
+	float ambient;
+	uint3 clusterCount;
+	uint clusterTileSize;		// Pixels per side
+	float sliceScale;			// slice = log(view depth) * scale + bias
+	float sliceBias;
+}
+
+// A point light, or a spot light if spotCosOuter > -1
+// - Must match Light in BufferStructs.h
+struct Light
+{
+	float3 position;
+	float range;
+	float3 color;
+	float intensity;
+	float3 direction;
+	float spotCosOuter;
+	float spotCosInner;
+	float3 padding;
+};
+StructuredBuffer<Light> lights : register(t0);
+
+// Each cluster's (offset, count) in lightIndices, x fastest,
+// then y, then depth slice; filled in by LightGrid each frame
+StructuredBuffer<uint2> clusterRanges : register(t1);
+StructuredBuffer<uint> lightIndices : register(t2);
+#endif
+
 // Struct representing the data we expect to receive from earlier pipeline stages
 // - Should match the output of our corresponding vertex shader
 // - The name of the struct itself is unimportant
@@ -13,8 +53,49 @@ struct VertexToPixel
 	//  v    v                v
 	float4 screenPosition	: SV_POSITION;
 	float4 color			: COLOR;
+#if CLUSTERED_LIGHTS
+	float3 worldPosition	: POSITION;
+	float viewDepth			: DEPTH;
+#endif
 };
 
+#if CLUSTERED_LIGHTS
+// --------------------------------------------------------
+// Adds up every light in this pixel's cluster
+// - Vertices carry no normals, so the surface's comes from
+//   screen-space derivatives, turned to face the camera
+// --------------------------------------------------------
+float3 ClusteredLighting(VertexToPixel input)
+{
+	float3 normal = normalize(cross(ddy(input.worldPosition), ddx(input.worldPosition)));
+	if (dot(normal, cameraPosition - input.worldPosition) < 0)
+		normal = -normal;
+
+	uint2 tile = min(uint2(input.screenPosition.xy) / clusterTileSize, clusterCount.xy - 1);
+	uint slice = (uint)clamp(floor(log(max(input.viewDepth, 1e-6f)) * sliceScale + sliceBias), 0.0f, clusterCount.z - 1.0f);
+	uint2 range = clusterRanges[(slice * clusterCount.y + tile.y) * clusterCount.x + tile.x];
+
+	float3 total = float3(0, 0, 0);
+	for (uint i = 0; i < range.y; i++)
+	{
+		Light light = lights[lightIndices[range.x + i]];
+		float3 toLight = light.position - input.worldPosition;
+		float distance = length(toLight);
+		float3 direction = toLight / max(distance, 1e-6f);
+
+		// Falls smoothly to nothing at the range
+		float falloff = saturate(1.0f - distance / light.range);
+		float attenuation = falloff * falloff;
+
+		if (light.spotCosOuter > -1.0f)
+			attenuation *= smoothstep(light.spotCosOuter, light.spotCosInner, dot(-direction, light.direction));
+
+		total += light.color * light.intensity * attenuation * saturate(dot(normal, direction));
+	}
+	return total;
+}
+#endif
+
 // --------------------------------------------------------
 // The entry point (main method) for our pixel shader
 // 
@@ -26,9 +107,14 @@ struct VertexToPixel
 // --------------------------------------------------------
 float4 main(VertexToPixel input) : SV_TARGET
 {
+#if CLUSTERED_LIGHTS
+	// The interpolated color, lit by ambient plus this cluster's lights
+	return float4(input.color.rgb * (ambient + ClusteredLighting(input)), input.color.a);
+#else
 	// Just return the input color
 	// - This color (like most values passing through the rasterizer) is 
 	//   interpolated for each pixel between the corresponding vertices 
 	//   of the triangle we're rendering
 	return input.color;
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,346 @@
+#include "Profiler.h"
+#include "AllocationTracker.h"
+
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <chrono>
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define PROFILER_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PROFILER_TSC 1
+#else
+#define PROFILER_TSC 0
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+namespace Profiler
+{
+	// Annonymous namespace to hold variables
+	// only accessible in this file
+	namespace
+	{
+		uint64_t ReadTicks()
+		{
+#if PROFILER_TSC
+			return __rdtsc();
+#else
+			return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+#endif
+		}
+
+		// Ticks are turned into time by comparing against
+		// steady_clock since startup; after a second that's
+		// accurate enough to keep
+		const uint64_t originTicks = ReadTicks();
+		const Clock::time_point originTime = Clock::now();
+		std::atomic<double> ticksPerSecond{ 0 };
+
+		double TicksPerSecond()
+		{
+			double rate = ticksPerSecond.load(std::memory_order_relaxed);
+			if (rate > 0)
+				return rate;
+
+			double seconds = std::chrono::duration<double>(Clock::now() - originTime).count();
+			uint64_t ticks = ReadTicks() - originTicks;
+			if (seconds <= 0 || ticks == 0)
+				return 1e9;
+
+			rate = ticks / seconds;
+			if (seconds >= 1.0)
+				ticksPerSecond.store(rate, std::memory_order_relaxed);
+			return rate;
+		}
+
+		// One per thread that has ever recorded anything.  Only
+		// its owner writes events; readers check afterwards
+		// which of what they copied may have been overwritten.
+		struct ThreadRing
+		{
+			Event events[RingSize];
+			std::atomic<uint64_t> written{ 0 };
+			std::atomic<uint64_t> firstValid{ 0 };	// Anything before belongs to an earlier owner
+			uint32_t depth = 0;
+			unsigned int id = 0;
+
+			// Guarded by registryMutex
+			std::string name;
+			bool inUse = false;
+		};
+
+		std::mutex registryMutex;
+		std::vector<std::unique_ptr<ThreadRing>> rings;
+
+		// Ring positions of the events Collect() copied.  Guarded
+		// by registryMutex, and kept so its capacity is reused.
+		std::vector<uint64_t> collectIndices;
+
+		thread_local ThreadRing* threadRing = 0;
+
+		// Hands the ring back when its thread exits, so the job
+		// system restarting doesn't leave a trail of dead rings
+		struct RingRelease
+		{
+			~RingRelease()
+			{
+				if (!threadRing)
+					return;
+				std::lock_guard<std::mutex> lock(registryMutex);
+				threadRing->inUse = false;
+			}
+		};
+		thread_local RingRelease ringRelease;
+
+		ThreadRing* AcquireRing()
+		{
+			(void)&ringRelease;
+			ALLOCATION_SCOPE("Profiler");
+
+			std::lock_guard<std::mutex> lock(registryMutex);
+			for (std::unique_ptr<ThreadRing>& ring : rings)
+			{
+				if (ring->inUse)
+					continue;
+
+				ring->inUse = true;
+				ring->depth = 0;
+				ring->firstValid.store(ring->written.load(std::memory_order_relaxed), std::memory_order_relaxed);
+				ring->name = "Thread " + std::to_string(ring->id);
+				threadRing = ring.get();
+				return threadRing;
+			}
+
+			rings.push_back(std::make_unique<ThreadRing>());
+			ThreadRing* ring = rings.back().get();
+			ring->id = (unsigned int)rings.size() - 1;
+			ring->inUse = true;
+			ring->name = "Thread " + std::to_string(ring->id);
+			threadRing = ring;
+			return ring;
+		}
+
+		// Written by the main thread only
+		uint64_t frameStarts[FrameHistory] = {};
+		std::atomic<uint64_t> frameCount{ 0 };
+
+		void WriteJsonString(FILE* file, const char* text)
+		{
+			fputc('"', file);
+			for (const char* c = text; *c; c++)
+			{
+				if (*c == '"' || *c == '\\')
+					fprintf(file, "\\%c", *c);
+				else if ((unsigned char)*c < 0x20)
+					fprintf(file, "\\u%04x", (unsigned int)(unsigned char)*c);
+				else
+					fputc(*c, file);
+			}
+			fputc('"', file);
+		}
+	}
+}
+
+
+// --------------------------------------------------------
+// The hot path: one timestamp and a depth bump on the way
+// in, one timestamp and one event written on the way out
+// --------------------------------------------------------
+uint64_t Profiler::Enter()
+{
+	ThreadRing* ring = threadRing ? threadRing : AcquireRing();
+	ring->depth++;
+	return ReadTicks();
+}
+
+void Profiler::Leave(const char* name, uint64_t start)
+{
+	uint64_t end = ReadTicks();
+	ThreadRing* ring = threadRing;
+
+	uint64_t index = ring->written.load(std::memory_order_relaxed);
+	Event& event = ring->events[index & (RingSize - 1)];
+	event.name = name;
+	event.start = start;
+	event.end = end;
+	event.depth = --ring->depth;
+	ring->written.store(index + 1, std::memory_order_release);
+}
+
+void Profiler::SetThreadName(const char* name)
+{
+	ThreadRing* ring = threadRing ? threadRing : AcquireRing();
+
+	std::lock_guard<std::mutex> lock(registryMutex);
+	ring->name = name;
+}
+
+
+void Profiler::BeginFrame()
+{
+	uint64_t frame = frameCount.load(std::memory_order_relaxed);
+	frameStarts[frame % FrameHistory] = ReadTicks();
+	frameCount.store(frame + 1, std::memory_order_release);
+}
+
+uint64_t Profiler::GetFrameCount()
+{
+	return frameCount.load(std::memory_order_acquire);
+}
+
+bool Profiler::GetFrameRange(unsigned int framesAgo, uint64_t& outStart, uint64_t& outEnd)
+{
+	// The newest frame is still running, so the last finished
+	// one is the one before it
+	uint64_t count = frameCount.load(std::memory_order_acquire);
+	if (count < 2 + (uint64_t)framesAgo || framesAgo + 2 > FrameHistory)
+		return false;
+
+	uint64_t frame = count - 2 - framesAgo;
+	outStart = frameStarts[frame % FrameHistory];
+	outEnd = frameStarts[(frame + 1) % FrameHistory];
+	return true;
+}
+
+uint64_t Profiler::Now()
+{
+	return ReadTicks();
+}
+
+double Profiler::TicksToMilliseconds(uint64_t ticks)
+{
+	return ticks * 1000.0 / TicksPerSecond();
+}
+
+
+// --------------------------------------------------------
+// Each ring is walked from its newest event backwards.
+// Events land in the order their scopes closed, so once one
+// ended before the range, every older one did too.
+// --------------------------------------------------------
+void Profiler::Collect(uint64_t start, uint64_t end, std::vector<ThreadEvents>& outThreads)
+{
+	std::lock_guard<std::mutex> lock(registryMutex);
+
+	// One entry per ring, reused from the last call along
+	// with its event storage, so collecting every frame
+	// doesn't allocate
+	outThreads.resize(rings.size());
+	for (size_t r = 0; r < rings.size(); r++)
+	{
+		ThreadRing* ring = rings[r].get();
+		uint64_t written = ring->written.load(std::memory_order_acquire);
+		uint64_t first = ring->firstValid.load(std::memory_order_relaxed);
+		if (written - first > RingSize)
+			first = written - RingSize;
+
+		ThreadEvents& thread = outThreads[r];
+		thread.name = ring->name;
+		thread.id = ring->id;
+		thread.events.clear();
+		collectIndices.clear();
+
+		for (uint64_t i = written; i > first; i--)
+		{
+			Event event = ring->events[(i - 1) & (RingSize - 1)];
+			if (event.end < start)
+				break;
+			if (event.start < end)
+			{
+				thread.events.push_back(event);
+				collectIndices.push_back(i - 1);
+			}
+		}
+
+		// Whatever the owner may have lapped while we copied
+		std::atomic_thread_fence(std::memory_order_acquire);
+		uint64_t writtenNow = ring->written.load(std::memory_order_relaxed);
+		uint64_t safe = writtenNow > RingSize ? writtenNow - RingSize : 0;
+		size_t keep = 0;
+		while (keep < collectIndices.size() && collectIndices[keep] >= safe)
+			keep++;
+		thread.events.resize(keep);
+
+		std::sort(thread.events.begin(), thread.events.end(), [](const Event& a, const Event& b)
+			{
+				return a.start != b.start ? a.start < b.start : a.depth < b.depth;
+			});
+	}
+}
+
+// --------------------------------------------------------
+// Complete ("X") events with microsecond times relative to
+// the first frame, plus thread names and an instant event
+// at the start of every frame
+// --------------------------------------------------------
+size_t Profiler::WriteChromeTrace(FILE* file, unsigned int frameCount)
+{
+	uint64_t finished = GetFrameCount();
+	finished = finished > 0 ? finished - 1 : 0;
+	if (frameCount > finished)
+		frameCount = (unsigned int)finished;
+	if (frameCount > FrameHistory - 1)
+		frameCount = FrameHistory - 1;
+
+	uint64_t start = 0;
+	uint64_t end = 0;
+	uint64_t unused = 0;
+	if (frameCount == 0 ||
+		!GetFrameRange(frameCount - 1, start, unused) ||
+		!GetFrameRange(0, unused, end))
+	{
+		fprintf(file, "{\"traceEvents\":[]}\n");
+		return 0;
+	}
+
+	std::vector<ThreadEvents> threads;
+	Collect(start, end, threads);
+
+	double microsecondsPerTick = 1000000.0 / TicksPerSecond();
+	size_t written = 0;
+
+	fprintf(file, "{\"traceEvents\":[\n");
+	fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"D3D11Starter\"}}");
+
+	for (const ThreadEvents& thread : threads)
+	{
+		fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", thread.id);
+		WriteJsonString(file, thread.name.c_str());
+		fprintf(file, "}}");
+	}
+
+	for (unsigned int f = frameCount; f > 0; f--)
+	{
+		uint64_t frameStart = 0;
+		uint64_t frameEnd = 0;
+		GetFrameRange(f - 1, frameStart, frameEnd);
+		fprintf(file, ",\n{\"name\":\"Frame\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":%.3f}",
+			(frameStart - start) * microsecondsPerTick);
+	}
+
+	for (const ThreadEvents& thread : threads)
+	{
+		for (const Event& event : thread.events)
+		{
+			// Clip anything hanging over either end
+			uint64_t eventStart = event.start > start ? event.start : start;
+			uint64_t eventEnd = event.end < end ? event.end : end;
+
+			fprintf(file, ",\n{\"name\":");
+			WriteJsonString(file, event.name);
+			fprintf(file, ",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+				thread.id,
+				(eventStart - start) * microsecondsPerTick,
+				(eventEnd - eventStart) * microsecondsPerTick);
+			written++;
+		}
+	}
+
+	fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+	return written;
+}
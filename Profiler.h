@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Markers compile to nothing when this is 0
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1
+#endif
+
+// --------------------------------------------------------
+// A scoped CPU profiler
+//
+// - PROFILE_SCOPE("Name") times the rest of the enclosing
+//   block; names must be string literals (only the pointer
+//   is kept)
+// - Each thread writes finished scopes into its own ring
+//   buffer, so recording never locks; once a ring is full
+//   the oldest events are overwritten
+// - Timestamps are raw TSC ticks where available (assumed
+//   invariant, as on any recent x86) and steady_clock
+//   nanoseconds elsewhere
+// - The main thread marks frame boundaries with
+//   BeginFrame(); the rings are read back per frame for the
+//   inspector or written out as a Chrome trace
+// - No Windows or DirectX headers are used, so this builds
+//   on any platform
+// --------------------------------------------------------
+namespace Profiler
+{
+	// One finished scope
+	struct Event
+	{
+		const char* name;
+		uint64_t start;		// Ticks
+		uint64_t end;
+		uint32_t depth;		// Scopes that were open around it on its thread
+	};
+
+	// Events kept per thread, and frame boundaries kept overall
+	const unsigned int RingSize = 1 << 15;
+	const unsigned int FrameHistory = 256;
+
+	// Shows up in the inspector and in traces
+	void SetThreadName(const char* name);
+
+	// Call on the main thread as each frame starts
+	void BeginFrame();
+
+	// Frames begun so far
+	uint64_t GetFrameCount();
+
+	// Tick range of a finished frame, 0 being the last one.
+	// False once it's older than FrameHistory.
+	bool GetFrameRange(unsigned int framesAgo, uint64_t& outStart, uint64_t& outEnd);
+
+	uint64_t Now();
+	double TicksToMilliseconds(uint64_t ticks);
+
+	// What one thread recorded, ordered by start time with
+	// parents before their children
+	struct ThreadEvents
+	{
+		std::string name;
+		unsigned int id;
+		std::vector<Event> events;
+	};
+
+	// Every recorded event overlapping [start, end), for every
+	// thread that has ever recorded (idle ones come back
+	// empty).  Events are overwritten as they're read, so
+	// anything that may have been is left out.
+	void Collect(uint64_t start, uint64_t end, std::vector<ThreadEvents>& outThreads);
+
+	// The last frameCount finished frames as Chrome trace_event
+	// JSON, for chrome://tracing or Perfetto.  Returns the
+	// number of events written.
+	size_t WriteChromeTrace(FILE* file, unsigned int frameCount);
+
+	// Used by Scope; Enter() returns the start time
+	uint64_t Enter();
+	void Leave(const char* name, uint64_t start);
+
+	// Records its own lifetime
+	class Scope
+	{
+	public:
+		explicit Scope(const char* name) : name(name), start(Enter()) {}
+		~Scope() { Leave(name, start); }
+		Scope(const Scope&) = delete; // Remove copy constructor
+		Scope& operator=(const Scope&) = delete; // Remove copy-assignment operator
+
+	private:
+		const char* name;
+		uint64_t start;
+	};
+}
+
+#define PROFILER_CONCAT_INNER(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_INNER(a, b)
+
+#if PROFILER_ENABLED
+#define PROFILE_SCOPE(name) Profiler::Scope PROFILER_CONCAT(profileScope, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#endif
@@ -0,0 +1,88 @@
+#include "RecordingCommandBackend.h"
+
+RecordingCommandBackend::RecordingCommandBackend(unsigned int maxChunks)
+	: contexts(maxChunks > 0 ? maxChunks : 1)
+{
+}
+
+unsigned int RecordingCommandBackend::GetMaxChunks()
+{
+	return (unsigned int)contexts.size();
+}
+
+void RecordingCommandBackend::BeginFrame(unsigned int chunkCount)
+{
+	this->chunkCount = chunkCount;
+}
+
+CommandContext* RecordingCommandBackend::BeginChunk(unsigned int chunk)
+{
+	// Capacity stays from frame to frame
+	contexts[chunk].commands.clear();
+	return &contexts[chunk];
+}
+
+void RecordingCommandBackend::EndChunk(unsigned int)
+{
+	// Nothing to close: the chunk's list is already complete
+}
+
+// --------------------------------------------------------
+// The stand-in for ExecuteCommandList(): chunks are played
+// back strictly in chunk order
+// --------------------------------------------------------
+void RecordingCommandBackend::Submit()
+{
+	submitted.clear();
+	submittedCount = 0;
+	submittedByType[Command::SetGeometry] = 0;
+	submittedByType[Command::DrawIndexedInstanced] = 0;
+
+	for (unsigned int c = 0; c < chunkCount; c++)
+	{
+		submittedCount += (unsigned int)contexts[c].commands.size();
+		for (const Command& command : contexts[c].commands)
+			submittedByType[command.type]++;
+		if (keepSubmitted)
+			submitted.insert(submitted.end(), contexts[c].commands.begin(), contexts[c].commands.end());
+	}
+}
+
+// --------------------------------------------------------
+// There's no GPU to copy geometry to, so draws only carry
+// each mesh's CPU copy
+// --------------------------------------------------------
+GeometryBuffers RecordingCommandBackend::CreateGeometry(const Vertex*, unsigned int, const unsigned int*, unsigned int)
+{
+	return {};
+}
+
+void RecordingCommandBackend::ReleaseGeometry(const GeometryBuffers&)
+{
+}
+
+const std::vector<RecordingCommandBackend::Command>& RecordingCommandBackend::GetSubmitted()
+{
+	return submitted;
+}
+
+unsigned int RecordingCommandBackend::GetSubmittedCount()
+{
+	return submittedCount;
+}
+
+unsigned int RecordingCommandBackend::GetSubmittedCount(Command::Type type)
+{
+	return submittedByType[type];
+}
+
+
+void RecordingCommandBackend::Context::SetGeometry(ID3D11Buffer* vertexBuffer, unsigned int vertexStride, ID3D11Buffer* indexBuffer)
+{
+	commands.push_back({ Command::SetGeometry, vertexBuffer, indexBuffer, vertexStride, 0, 0 });
+}
+
+void RecordingCommandBackend::Context::DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startInstance)
+{
+	commands.push_back({ Command::DrawIndexedInstanced, 0, 0, indexCount, instanceCount, startInstance });
+}
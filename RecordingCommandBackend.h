@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+#include "CommandBackend.h"
+
+// --------------------------------------------------------
+// A backend that only writes commands down.  Nothing needs
+// a device, so chunking, ordering and threading can be
+// checked and benchmarked anywhere, including headless runs.
+// --------------------------------------------------------
+class RecordingCommandBackend : public CommandBackend
+{
+public:
+	struct Command
+	{
+		enum Type { SetGeometry, DrawIndexedInstanced } type;
+		ID3D11Buffer* vertexBuffer;
+		ID3D11Buffer* indexBuffer;
+		unsigned int a;		// Vertex stride, or index count
+		unsigned int b;		// Instance count
+		unsigned int c;		// Start instance
+	};
+
+	explicit RecordingCommandBackend(unsigned int maxChunks);
+	RecordingCommandBackend(const RecordingCommandBackend&) = delete; // Remove copy constructor
+	RecordingCommandBackend& operator=(const RecordingCommandBackend&) = delete; // Remove copy-assignment operator
+
+	unsigned int GetMaxChunks() override;
+	void BeginFrame(unsigned int chunkCount) override;
+	CommandContext* BeginChunk(unsigned int chunk) override;
+	void EndChunk(unsigned int chunk) override;
+	void Submit() override;
+	GeometryBuffers CreateGeometry(const Vertex* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount) override;
+	void ReleaseGeometry(const GeometryBuffers& geometry) override;
+
+	// Everything the last Submit() "executed", in order
+	const std::vector<Command>& GetSubmitted();
+
+	// When false, Submit() only counts, so benchmarks measure
+	// recording rather than copying
+	bool keepSubmitted = true;
+	unsigned int GetSubmittedCount();
+	unsigned int GetSubmittedCount(Command::Type type);
+
+private:
+	class Context : public CommandContext
+	{
+	public:
+		void SetGeometry(ID3D11Buffer* vertexBuffer, unsigned int vertexStride, ID3D11Buffer* indexBuffer) override;
+		void DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startInstance) override;
+
+		std::vector<Command> commands;
+	};
+
+	std::vector<Context> contexts;
+	unsigned int chunkCount = 0;
+	std::vector<Command> submitted;
+	unsigned int submittedCount = 0;
+	unsigned int submittedByType[2] = {};
+};
@@ -0,0 +1,372 @@
+#include "RenderGraph.h"
+#include "Profiler.h"
+
+// Annonymous namespace to hold helpers
+// only accessible in this file
+namespace
+{
+	bool SameDesc(const TextureDesc& a, const TextureDesc& b)
+	{
+		return a.width == b.width && a.height == b.height && a.format == b.format;
+	}
+
+	const TextureDesc emptyDesc = {};
+}
+
+
+void RenderGraph::Reset()
+{
+	passCount = 0;
+	resourceCount = 0;
+	physicalCount = 0;
+	compiled = false;
+	error = 0;
+	stats = {};
+}
+
+RenderResource RenderGraph::Import(const char* name, const TextureDesc& desc)
+{
+	return AddResource(name, desc, true);
+}
+
+RenderResource RenderGraph::CreateTexture(const char* name, const TextureDesc& desc)
+{
+	return AddResource(name, desc, false);
+}
+
+RenderResource RenderGraph::AddResource(const char* name, const TextureDesc& desc, bool imported)
+{
+	if (resourceCount == MaxResources)
+	{
+		error = "Too many resources";
+		return InvalidResource;
+	}
+
+	Resource& r = resources[resourceCount];
+	r.name = name;
+	r.desc = desc;
+	r.imported = imported;
+	r.output = false;
+	r.firstUse = 0;
+	r.lastUse = 0;
+	r.physical = InvalidResource;
+	return resourceCount++;
+}
+
+void RenderGraph::SetOutput(RenderResource resource)
+{
+	if (resource < resourceCount)
+		resources[resource].output = true;
+}
+
+unsigned int RenderGraph::AddPass(const char* name, ExecuteFunction execute, void* data)
+{
+	if (passCount == MaxPasses)
+	{
+		error = "Too many passes";
+		return MaxPasses;
+	}
+
+	Pass& p = passes[passCount];
+	p.name = name;
+	p.execute = execute;
+	p.data = data;
+	p.readCount = 0;
+	p.writeCount = 0;
+	p.culled = false;
+	return passCount++;
+}
+
+void RenderGraph::Read(unsigned int pass, RenderResource resource)
+{
+	if (pass >= passCount || resource >= resourceCount)
+		return;
+
+	Pass& p = passes[pass];
+	if (p.readCount == MaxAccesses)
+		error = "Too many reads in one pass";
+	else
+		p.reads[p.readCount++] = resource;
+}
+
+void RenderGraph::Write(unsigned int pass, RenderResource resource)
+{
+	if (pass >= passCount || resource >= resourceCount)
+		return;
+
+	Pass& p = passes[pass];
+	if (p.writeCount == MaxAccesses)
+		error = "Too many writes in one pass";
+	else
+		p.writes[p.writeCount++] = resource;
+}
+
+bool RenderGraph::Writes(const Pass& pass, RenderResource resource) const
+{
+	for (unsigned int w = 0; w < pass.writeCount; w++)
+	{
+		if (pass.writes[w] == resource)
+			return true;
+	}
+	return false;
+}
+
+// --------------------------------------------------------
+// Order, then cull against that order, then give the
+// remaining transient textures their physical ones
+// --------------------------------------------------------
+bool RenderGraph::Compile()
+{
+	PROFILE_SCOPE("Compile render graph");
+
+	// Compiling again, after more reads or writes, starts over
+	compiled = false;
+	physicalCount = 0;
+	stats = {};
+	if (error)
+		return false;
+	if (!Order())
+		return false;
+
+	Cull();
+	Allocate();
+	compiled = true;
+	return true;
+}
+
+// --------------------------------------------------------
+// Each pass gets a mask of the passes it has to follow,
+// and then the earliest-added pass that's free to go goes
+// next.  A graph added in a working order stays in it.
+// --------------------------------------------------------
+bool RenderGraph::Order()
+{
+	uint64_t after[MaxPasses] = {};
+	for (unsigned int p = 0; p < passCount; p++)
+	{
+		const Pass& pass = passes[p];
+
+		for (unsigned int r = 0; r < pass.readCount; r++)
+		{
+			RenderResource read = pass.reads[r];
+			if (Writes(pass, read))
+				continue;
+
+			for (unsigned int other = 0; other < passCount; other++)
+			{
+				if (other != p && Writes(passes[other], read))
+					after[p] |= 1ull << other;
+			}
+		}
+
+		for (unsigned int w = 0; w < pass.writeCount; w++)
+		{
+			for (unsigned int other = 0; other < p; other++)
+			{
+				if (Writes(passes[other], pass.writes[w]))
+					after[p] |= 1ull << other;
+			}
+		}
+	}
+
+	uint64_t placed = 0;
+	for (unsigned int position = 0; position < passCount; position++)
+	{
+		unsigned int next = MaxPasses;
+		for (unsigned int p = 0; p < passCount && next == MaxPasses; p++)
+		{
+			if (!(placed & (1ull << p)) && (after[p] & ~placed) == 0)
+				next = p;
+		}
+
+		if (next == MaxPasses)
+		{
+			error = "Passes depend on each other in a cycle";
+			return false;
+		}
+
+		order[position] = next;
+		placed |= 1ull << next;
+	}
+	return true;
+}
+
+// --------------------------------------------------------
+// Back to front: a pass is needed if it writes something
+// needed, and then so is everything it reads
+// --------------------------------------------------------
+void RenderGraph::Cull()
+{
+	bool needed[MaxResources] = {};
+	for (unsigned int r = 0; r < resourceCount; r++)
+		needed[r] = resources[r].output;
+
+	for (unsigned int position = passCount; position-- > 0; )
+	{
+		Pass& pass = passes[order[position]];
+
+		pass.culled = true;
+		for (unsigned int w = 0; w < pass.writeCount; w++)
+		{
+			if (needed[pass.writes[w]])
+				pass.culled = false;
+		}
+		if (pass.culled)
+			continue;
+
+		for (unsigned int r = 0; r < pass.readCount; r++)
+			needed[pass.reads[r]] = true;
+	}
+
+	stats.passes = passCount;
+	for (unsigned int p = 0; p < passCount; p++)
+	{
+		if (passes[p].culled)
+			stats.culledPasses++;
+	}
+}
+
+// --------------------------------------------------------
+// Lifetimes over the live passes, then first fit: each
+// transient texture, earliest first, takes the first
+// matching physical texture that's free by then
+// --------------------------------------------------------
+void RenderGraph::Allocate()
+{
+	const unsigned int unused = 0xFFFFFFFF;
+	for (unsigned int r = 0; r < resourceCount; r++)
+	{
+		resources[r].firstUse = unused;
+		resources[r].lastUse = 0;
+		resources[r].physical = InvalidResource;
+	}
+
+	for (unsigned int position = 0; position < passCount; position++)
+	{
+		const Pass& pass = passes[order[position]];
+		if (pass.culled)
+			continue;
+
+		for (unsigned int a = 0; a < pass.readCount + pass.writeCount; a++)
+		{
+			Resource& r = resources[a < pass.readCount ? pass.reads[a] : pass.writes[a - pass.readCount]];
+			if (r.firstUse == unused)
+				r.firstUse = position;
+			r.lastUse = position;
+		}
+	}
+
+	// Transient and used, by first use
+	unsigned int sorted[MaxResources];
+	unsigned int sortedCount = 0;
+	for (unsigned int r = 0; r < resourceCount; r++)
+	{
+		if (resources[r].imported || resources[r].firstUse == unused)
+			continue;
+
+		unsigned int i = sortedCount++;
+		for (; i > 0 && resources[sorted[i - 1]].firstUse > resources[r].firstUse; i--)
+			sorted[i] = sorted[i - 1];
+		sorted[i] = r;
+	}
+
+	for (unsigned int s = 0; s < sortedCount; s++)
+	{
+		Resource& r = resources[sorted[s]];
+
+		unsigned int physical = physicalCount;
+		for (unsigned int p = 0; p < physicalCount && physical == physicalCount; p++)
+		{
+			if (physicals[p].lastUse < r.firstUse && SameDesc(physicals[p].desc, r.desc))
+				physical = p;
+		}
+		if (physical == physicalCount)
+		{
+			physicals[physicalCount++].desc = r.desc;
+			stats.allocatedBytes += GetTextureBytes(r.desc);
+		}
+
+		physicals[physical].lastUse = r.lastUse;
+		r.physical = physical;
+		stats.transientBytes += GetTextureBytes(r.desc);
+	}
+	stats.transientTextures = sortedCount;
+	stats.physicalTextures = physicalCount;
+
+	for (unsigned int position = 0; position < passCount; position++)
+	{
+		size_t live = 0;
+		for (unsigned int s = 0; s < sortedCount; s++)
+		{
+			const Resource& r = resources[sorted[s]];
+			if (r.firstUse <= position && position <= r.lastUse)
+				live += GetTextureBytes(r.desc);
+		}
+		if (live > stats.peakLiveBytes)
+			stats.peakLiveBytes = live;
+	}
+}
+
+void RenderGraph::Execute() const
+{
+	if (!compiled)
+		return;
+
+	for (unsigned int position = 0; position < passCount; position++)
+	{
+		const Pass& pass = passes[order[position]];
+		if (pass.culled || !pass.execute)
+			continue;
+
+		Profiler::Scope scope(pass.name);
+		pass.execute(pass.data, *this);
+	}
+}
+
+const char* RenderGraph::GetPassName(unsigned int pass) const
+{
+	return pass < passCount ? passes[pass].name : "";
+}
+
+bool RenderGraph::IsCulled(unsigned int pass) const
+{
+	return pass < passCount && passes[pass].culled;
+}
+
+unsigned int RenderGraph::GetOrderedPass(unsigned int position) const
+{
+	return position < passCount ? order[position] : MaxPasses;
+}
+
+const char* RenderGraph::GetResourceName(RenderResource resource) const
+{
+	return resource < resourceCount ? resources[resource].name : "";
+}
+
+const TextureDesc& RenderGraph::GetDesc(RenderResource resource) const
+{
+	return resource < resourceCount ? resources[resource].desc : emptyDesc;
+}
+
+bool RenderGraph::IsImported(RenderResource resource) const
+{
+	return resource < resourceCount && resources[resource].imported;
+}
+
+unsigned int RenderGraph::GetPhysical(RenderResource resource) const
+{
+	return resource < resourceCount ? resources[resource].physical : InvalidResource;
+}
+
+const TextureDesc& RenderGraph::GetPhysicalDesc(unsigned int physical) const
+{
+	return physical < physicalCount ? physicals[physical].desc : emptyDesc;
+}
+
+size_t RenderGraph::GetTextureBytes(const TextureDesc& desc)
+{
+	size_t bytesPerPixel = 4;
+	if (desc.format == TextureFormat::RGBA16F)
+		bytesPerPixel = 8;
+	return (size_t)desc.width * desc.height * bytesPerPixel;
+}
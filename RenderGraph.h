@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// Only what the graph needs to size and match textures; the
+// D3D11 side maps these to real formats
+enum class TextureFormat
+{
+	RGBA8,
+	RGBA16F,
+	R32F,
+	Depth32F
+};
+
+struct TextureDesc
+{
+	unsigned int width;
+	unsigned int height;
+	TextureFormat format;
+};
+
+// Index of a resource in this frame's graph
+typedef unsigned int RenderResource;
+const RenderResource InvalidResource = 0xFFFFFFFF;
+
+// --------------------------------------------------------
+// One frame's passes and the textures they use, rebuilt
+// every frame
+//
+// - Passes declare what they read and write.  Compile()
+//   then culls passes nothing needs, orders the rest and
+//   gives every transient texture a physical one.
+// - Imported resources (the back buffer, say) live outside
+//   the graph; transient ones exist only for the frame.
+//   Outputs are what the frame is for, and keep the passes
+//   that write them alive.
+// - A pass that only reads a resource runs after every pass
+//   that writes it; passes writing the same resource run in
+//   the order they were added
+// - Transient textures whose lifetimes don't overlap share
+//   a physical texture if their descriptions match, since
+//   D3D11 has no way to place different ones in the same
+//   memory
+// - Everything lives in fixed arrays and nothing here needs
+//   a device, so a frame allocates nothing and the compiler
+//   runs anywhere
+// --------------------------------------------------------
+class RenderGraph
+{
+public:
+	static const unsigned int MaxPasses = 64;	// One bit each in a dependency mask
+	static const unsigned int MaxResources = 64;
+	static const unsigned int MaxAccesses = 8;	// Reads, and writes, per pass
+
+	typedef void (*ExecuteFunction)(void* data, const RenderGraph& graph);
+
+	// Building
+	void Reset();
+	RenderResource Import(const char* name, const TextureDesc& desc);
+	RenderResource CreateTexture(const char* name, const TextureDesc& desc);
+	void SetOutput(RenderResource resource);
+	unsigned int AddPass(const char* name, ExecuteFunction execute, void* data);
+	void Read(unsigned int pass, RenderResource resource);
+	void Write(unsigned int pass, RenderResource resource);
+
+	// False (with GetError() saying why) if the graph can't
+	// run: too many of something, or a dependency cycle
+	bool Compile();
+	const char* GetError() const { return error; }
+
+	// Runs every live pass, in order, on the calling thread
+	void Execute() const;
+
+	// After Compile()
+	unsigned int GetPassCount() const { return passCount; }
+	const char* GetPassName(unsigned int pass) const;
+	bool IsCulled(unsigned int pass) const;
+	unsigned int GetOrderedPass(unsigned int position) const;	// Over every pass, culled ones included
+
+	unsigned int GetResourceCount() const { return resourceCount; }
+	const char* GetResourceName(RenderResource resource) const;
+	const TextureDesc& GetDesc(RenderResource resource) const;
+	bool IsImported(RenderResource resource) const;
+
+	// Physical texture of a transient resource, or
+	// InvalidResource if it's imported or unused
+	unsigned int GetPhysical(RenderResource resource) const;
+	unsigned int GetPhysicalCount() const { return physicalCount; }
+	const TextureDesc& GetPhysicalDesc(unsigned int physical) const;
+
+	static size_t GetTextureBytes(const TextureDesc& desc);
+
+	struct Stats
+	{
+		unsigned int passes;
+		unsigned int culledPasses;
+		unsigned int transientTextures;		// Used by a live pass
+		unsigned int physicalTextures;
+		size_t transientBytes;				// Without aliasing
+		size_t allocatedBytes;				// With it: every physical texture
+		size_t peakLiveBytes;				// Most alive at any one pass
+	};
+	const Stats& GetStats() const { return stats; }
+
+private:
+	struct Pass
+	{
+		const char* name;
+		ExecuteFunction execute;
+		void* data;
+		RenderResource reads[MaxAccesses];
+		unsigned int readCount;
+		RenderResource writes[MaxAccesses];
+		unsigned int writeCount;
+		bool culled;
+	};
+
+	struct Resource
+	{
+		const char* name;
+		TextureDesc desc;
+		bool imported;
+		bool output;
+		unsigned int firstUse;	// Positions in the order
+		unsigned int lastUse;
+		unsigned int physical;
+	};
+
+	struct Physical
+	{
+		TextureDesc desc;
+		unsigned int lastUse;
+	};
+
+	RenderResource AddResource(const char* name, const TextureDesc& desc, bool imported);
+	bool Writes(const Pass& pass, RenderResource resource) const;
+	bool Order();
+	void Cull();
+	void Allocate();
+
+	Pass passes[MaxPasses];
+	unsigned int passCount = 0;
+	Resource resources[MaxResources];
+	unsigned int resourceCount = 0;
+	Physical physicals[MaxResources];
+	unsigned int physicalCount = 0;
+
+	unsigned int order[MaxPasses];
+	bool compiled = false;
+	const char* error = 0;
+	Stats stats = {};
+};
@@ -0,0 +1,293 @@
+#include "RenderThread.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+using Clock = std::chrono::steady_clock;
+
+namespace RenderThread
+{
+	// Annonymous namespace to hold variables
+	// only accessible in this file
+	namespace
+	{
+		FramePacket packets[PacketCount];
+
+		std::thread thread;
+		RenderFunction render = 0;
+		void* renderData = 0;
+		bool running = false;
+		bool threaded = true;
+
+		// Packets move through the ring in order: the simulation
+		// owns packet (submitted % PacketCount) until it submits
+		// it, the render thread owns (completed % PacketCount)
+		std::mutex mutex;
+		std::condition_variable packetReady;
+		std::condition_variable packetDone;
+		unsigned long long submitted = 0;
+		unsigned long long completed = 0;
+		bool quit = false;
+
+		// Who is doing something right now, and what that has
+		// added up to over the current one second window
+		std::mutex statsMutex;
+		bool simulationBusy = false;
+		bool renderBusy = false;
+		Clock::time_point lastChange;
+		Clock::time_point windowStart;
+		double bothBusySeconds = 0;
+		double latencySeconds = 0;
+		double worstLatencySeconds = 0;
+		double inFlightSum = 0;
+		double simulationWaitSeconds = 0;
+		double renderIdleSeconds = 0;
+		unsigned int renderedFrames = 0;
+		unsigned int submittedFrames = 0;
+		Stats lastStats = {};
+
+		double Seconds(Clock::duration d)
+		{
+			return std::chrono::duration<double>(d).count();
+		}
+
+		// Call with statsMutex held
+		void AdvanceStats(Clock::time_point now)
+		{
+			if (simulationBusy && renderBusy)
+				bothBusySeconds += Seconds(now - lastChange);
+			lastChange = now;
+
+			double window = Seconds(now - windowStart);
+			if (window < 1.0)
+				return;
+
+			Stats stats = lastStats;
+			stats.latencyMs = renderedFrames ? latencySeconds / renderedFrames * 1000.0 : 0;
+			stats.worstLatencyMs = worstLatencySeconds * 1000.0;
+			stats.framesInFlight = submittedFrames ? inFlightSum / submittedFrames : 0;
+			stats.overlap = bothBusySeconds / window;
+			stats.simulationWaitMs = submittedFrames ? simulationWaitSeconds / submittedFrames * 1000.0 : 0;
+			stats.renderIdleMs = renderedFrames ? renderIdleSeconds / renderedFrames * 1000.0 : 0;
+			lastStats = stats;
+
+			windowStart = now;
+			bothBusySeconds = 0;
+			latencySeconds = 0;
+			worstLatencySeconds = 0;
+			inFlightSum = 0;
+			simulationWaitSeconds = 0;
+			renderIdleSeconds = 0;
+			renderedFrames = 0;
+			submittedFrames = 0;
+		}
+
+		void SetBusy(bool& which, bool busy)
+		{
+			std::lock_guard<std::mutex> lock(statsMutex);
+			AdvanceStats(Clock::now());
+			which = busy;
+		}
+
+		void Render(FramePacket& packet)
+		{
+			SetBusy(renderBusy, true);
+			{
+				PROFILE_SCOPE("Render frame");
+				render(renderData, packet);
+			}
+
+			Clock::time_point now = Clock::now();
+			double latency = Seconds(now - packet.simulationStart);
+
+			std::lock_guard<std::mutex> lock(statsMutex);
+			AdvanceStats(now);
+			renderBusy = false;
+			latencySeconds += latency;
+			if (latency > worstLatencySeconds)
+				worstLatencySeconds = latency;
+			renderedFrames++;
+		}
+
+		void RenderMain()
+		{
+			// Its own job deque, so recording can go wide
+			JobSystem::AttachThread(0);
+			Profiler::SetThreadName("Render");
+
+			while (true)
+			{
+				Clock::time_point idleStart = Clock::now();
+
+				FramePacket* packet = 0;
+				{
+					PROFILE_SCOPE("Wait for packet");
+					std::unique_lock<std::mutex> lock(mutex);
+					packetReady.wait(lock, []() { return quit || completed < submitted; });
+					if (completed == submitted)
+						break;
+					packet = &packets[completed % PacketCount];
+				}
+
+				double idle = Seconds(Clock::now() - idleStart);
+				{
+					std::lock_guard<std::mutex> lock(statsMutex);
+					renderIdleSeconds += idle;
+				}
+
+				Render(*packet);
+
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					completed++;
+				}
+				packetDone.notify_all();
+			}
+		}
+	}
+}
+
+
+// --------------------------------------------------------
+// Starts the render thread.  From here on the immediate
+// context belongs to it.
+// --------------------------------------------------------
+void RenderThread::Initialize(RenderFunction function, void* data)
+{
+	if (running)
+		ShutDown();
+
+	render = function;
+	renderData = data;
+	submitted = 0;
+	completed = 0;
+	quit = false;
+
+	lastChange = Clock::now();
+	windowStart = lastChange;
+
+	running = true;
+	thread = std::thread(RenderMain);
+}
+
+// --------------------------------------------------------
+// Renders whatever is still queued, then stops the thread
+// --------------------------------------------------------
+void RenderThread::ShutDown()
+{
+	if (!running)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+	packetReady.notify_all();
+	thread.join();
+	running = false;
+}
+
+
+// --------------------------------------------------------
+// Waits for the next packet to come free (at most two
+// frames ahead of the render thread) and starts filling it
+// --------------------------------------------------------
+FramePacket& RenderThread::BeginFrame()
+{
+	Clock::time_point waitStart = Clock::now();
+
+	FramePacket* packet = 0;
+	{
+		PROFILE_SCOPE("Wait for free packet");
+		std::unique_lock<std::mutex> lock(mutex);
+		packetDone.wait(lock, []() { return submitted - completed < PacketCount; });
+		packet = &packets[submitted % PacketCount];
+		packet->frameIndex = submitted;
+	}
+
+	Clock::time_point now = Clock::now();
+	{
+		std::lock_guard<std::mutex> lock(statsMutex);
+		simulationWaitSeconds += Seconds(now - waitStart);
+	}
+	SetBusy(simulationBusy, true);
+
+	// The render thread is done with it, so everything
+	// allocated for its last frame can go
+	packet->memory.Reset();
+	packet->simulationStart = now;
+	packet->viewCount = 0;
+	packet->ui = 0;
+	return *packet;
+}
+
+void RenderThread::SubmitFrame()
+{
+	unsigned long long inFlight = 0;
+	FramePacket* packet = 0;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		packet = &packets[submitted % PacketCount];
+		inFlight = submitted - completed;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(statsMutex);
+		AdvanceStats(Clock::now());
+		simulationBusy = false;
+		inFlightSum += (double)inFlight;
+		submittedFrames++;
+		lastStats.packetBytes = packet->memory.GetUsed();
+		lastStats.packetPeakBytes = packet->memory.GetPeak();
+	}
+
+	if (!running || !threaded)
+	{
+		// Nothing else is in flight (see SetThreaded), so just
+		// render it here.  Counting it only afterwards keeps the
+		// render thread from ever seeing it.
+		Render(*packet);
+
+		std::lock_guard<std::mutex> lock(mutex);
+		submitted++;
+		completed++;
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		submitted++;
+	}
+	packetReady.notify_one();
+}
+
+void RenderThread::CancelFrame()
+{
+	SetBusy(simulationBusy, false);
+}
+
+void RenderThread::Flush()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	packetDone.wait(lock, []() { return completed == submitted; });
+}
+
+void RenderThread::SetThreaded(bool threaded)
+{
+	Flush();
+	RenderThread::threaded = threaded;
+}
+
+bool RenderThread::IsThreaded()
+{
+	return threaded;
+}
+
+RenderThread::Stats RenderThread::GetStats()
+{
+	std::lock_guard<std::mutex> lock(statsMutex);
+	return lastStats;
+}
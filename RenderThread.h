@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include "FramePacket.h"
+
+// --------------------------------------------------------
+// A dedicated thread that turns frame packets into GPU work
+//
+// - The simulation grabs a packet with BeginFrame(), fills
+//   it in and hands it over with SubmitFrame()
+// - There are three packets, so while frame N is rendered
+//   the simulation can already be on N+1 (and N+2 can be
+//   queued); BeginFrame() only waits once it's that far
+//   ahead
+// - Only the render thread uses the immediate context
+//   while it runs; anything else that needs it (resizing
+//   the swap chain, say) must Flush() first
+// --------------------------------------------------------
+namespace RenderThread
+{
+	const unsigned int PacketCount = 3;
+
+	// Turns a packet into GPU work; runs on the render thread
+	typedef void (*RenderFunction)(void* data, FramePacket& packet);
+
+	void Initialize(RenderFunction function, void* data);
+	void ShutDown();
+
+	// Simulation side
+	FramePacket& BeginFrame();
+	void SubmitFrame();
+
+	// Gives back the packet from BeginFrame() unrendered, for
+	// frames with nothing to draw; the next BeginFrame() gets
+	// the same one again
+	void CancelFrame();
+
+	// Waits until every submitted packet has been rendered
+	void Flush();
+
+	// When off, SubmitFrame() renders the packet right away
+	// on the calling thread, for comparison
+	void SetThreaded(bool threaded);
+	bool IsThreaded();
+
+	// Averages over the last full second
+	struct Stats
+	{
+		double latencyMs;			// Simulation start to Present() returning
+		double worstLatencyMs;
+		double framesInFlight;		// Submitted but not yet rendered, at submit time
+		double overlap;				// Share of the time both threads were busy
+		double simulationWaitMs;	// Per frame, waiting for a free packet
+		double renderIdleMs;		// Per frame, waiting for a packet to render
+		size_t packetBytes;			// Most recent packet
+		size_t packetPeakBytes;
+	};
+	Stats GetStats();
+}
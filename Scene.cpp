@@ -0,0 +1,280 @@
+#include "Scene.h"
+
+// Record value for ids that are not in use
+static const unsigned int NoArchetype = 0xFFFFFFFF;
+
+
+// --------------------------------------------------------
+// Archetype rows
+// --------------------------------------------------------
+void Archetype::Reserve(size_t count)
+{
+	entities.reserve(count);
+	if (mask & ComponentTransform) transforms.reserve(count);
+	if (mask & ComponentTransform) previousPoses.reserve(count);
+	if (mask & ComponentMesh) meshes.reserve(count);
+	if (mask & ComponentTint) tints.reserve(count);
+	if (mask & ComponentBounds) localBounds.reserve(count);
+	if (mask & ComponentBounds) bounds.reserve(count);
+	if (mask & ComponentFlags) flags.reserve(count);
+	if (mask & ComponentInstance) instanceSlots.reserve(count);
+}
+
+// --------------------------------------------------------
+// Appends a row of default components and returns its index
+// --------------------------------------------------------
+size_t Archetype::AddRow(EntityId id)
+{
+	entities.push_back(id);
+	if (mask & ComponentTransform) transforms.emplace_back();
+	if (mask & ComponentTransform) previousPoses.push_back(transforms.back().GetPose());
+	if (mask & ComponentMesh) meshes.push_back(MeshHandle());
+	if (mask & ComponentTint) tints.push_back(DirectX::XMFLOAT4(1.0f, 0.5f, 0.5f, 1.0f));
+	if (mask & ComponentBounds) localBounds.push_back({});
+	if (mask & ComponentBounds) bounds.push_back({});
+	if (mask & ComponentFlags) flags.push_back(EntityVisible);
+	if (mask & ComponentInstance) instanceSlots.push_back(0);
+	return entities.size() - 1;
+}
+
+// --------------------------------------------------------
+// Removes a row by moving the last row into its place.
+// Returns the id of the entity that moved (whose record
+// needs fixing), or InvalidEntity if none did.
+// --------------------------------------------------------
+EntityId Archetype::RemoveRow(size_t row)
+{
+	size_t last = entities.size() - 1;
+	EntityId moved = row != last ? entities[last] : InvalidEntity;
+
+	if (row != last)
+	{
+		entities[row] = entities[last];
+		if (mask & ComponentTransform) transforms[row] = transforms[last];
+		if (mask & ComponentTransform) previousPoses[row] = previousPoses[last];
+		if (mask & ComponentMesh) meshes[row] = meshes[last];
+		if (mask & ComponentTint) tints[row] = tints[last];
+		if (mask & ComponentBounds) localBounds[row] = localBounds[last];
+		if (mask & ComponentBounds) bounds[row] = bounds[last];
+		if (mask & ComponentFlags) flags[row] = flags[last];
+		if (mask & ComponentInstance) instanceSlots[row] = instanceSlots[last];
+	}
+
+	entities.pop_back();
+	if (mask & ComponentTransform) transforms.pop_back();
+	if (mask & ComponentTransform) previousPoses.pop_back();
+	if (mask & ComponentMesh) meshes.pop_back();
+	if (mask & ComponentTint) tints.pop_back();
+	if (mask & ComponentBounds) localBounds.pop_back();
+	if (mask & ComponentBounds) bounds.pop_back();
+	if (mask & ComponentFlags) flags.pop_back();
+	if (mask & ComponentInstance) instanceSlots.pop_back();
+
+	return moved;
+}
+
+
+Scene::~Scene()
+{
+}
+
+// --------------------------------------------------------
+// Creates an entity with the given components, all set to
+// their defaults
+// --------------------------------------------------------
+EntityId Scene::CreateEntity(uint32_t mask)
+{
+	unsigned int archetypeIndex = 0;
+	Archetype* archetype = FindOrCreateArchetype(mask, &archetypeIndex);
+
+	// Reuse a dead id if there is one
+	unsigned int index;
+	if (!freeIds.empty())
+	{
+		index = freeIds.back();
+		freeIds.pop_back();
+	}
+	else
+	{
+		index = (unsigned int)records.size();
+		records.push_back({ NoArchetype, 0, 0 });
+	}
+
+	EntityId id = EntityId::Make(index, records[index].generation);
+	records[index].archetype = archetypeIndex;
+	records[index].row = (unsigned int)archetype->AddRow(id);
+	entityCount++;
+	return id;
+}
+
+void Scene::DestroyEntity(EntityId id)
+{
+	size_t row = 0;
+	Archetype* archetype = Locate(id, &row);
+	if (!archetype)
+		return;
+
+	// Whoever was swapped into the hole now lives at this row
+	EntityId moved = archetype->RemoveRow(row);
+	if (moved != InvalidEntity)
+		records[moved.Index()].row = (unsigned int)row;
+
+	// Retire this id; the slot comes back with a new generation
+	Record& record = records[id.Index()];
+	record.archetype = NoArchetype;
+	record.generation = (record.generation + 1) % EntityId::MaxGeneration;
+	freeIds.push_back(id.Index());
+	entityCount--;
+}
+
+// --------------------------------------------------------
+// Destroys every entity at once.  The records stay, so each
+// live id is retired with a bumped generation exactly as
+// DestroyEntity() would, and ids held from before the clear
+// never resolve to whatever reuses their slot.
+// --------------------------------------------------------
+void Scene::Clear()
+{
+	archetypes.clear();
+	freeIds.clear();
+
+	// Backwards, so the lowest indices are handed out first
+	for (size_t i = records.size(); i-- > 0;)
+	{
+		Record& record = records[i];
+		if (record.archetype != NoArchetype)
+		{
+			record.archetype = NoArchetype;
+			record.generation = (record.generation + 1) % EntityId::MaxGeneration;
+		}
+		freeIds.push_back((unsigned int)i);
+	}
+	entityCount = 0;
+}
+
+// --------------------------------------------------------
+// Makes room for count more entities with the given mask,
+// so large scenes don't reallocate while being built
+// --------------------------------------------------------
+void Scene::Reserve(uint32_t mask, size_t count)
+{
+	unsigned int archetypeIndex = 0;
+	Archetype* archetype = FindOrCreateArchetype(mask, &archetypeIndex);
+	archetype->Reserve(archetype->Count() + count);
+	records.reserve(records.size() + count);
+}
+
+bool Scene::IsAlive(EntityId id)
+{
+	return id.IsValid() &&
+		id.Index() < records.size() &&
+		records[id.Index()].archetype != NoArchetype &&
+		records[id.Index()].generation == id.Generation();
+}
+
+size_t Scene::GetEntityCount()
+{
+	return entityCount;
+}
+
+uint32_t Scene::GetMask(EntityId id)
+{
+	return IsAlive(id) ? archetypes[records[id.Index()].archetype]->mask : 0;
+}
+
+
+// --------------------------------------------------------
+// Single entity component access
+// --------------------------------------------------------
+Transform* Scene::GetTransform(EntityId id)
+{
+	size_t row = 0;
+	Archetype* a = Locate(id, &row);
+	return a && (a->mask & ComponentTransform) ? &a->transforms[row] : 0;
+}
+
+MeshHandle Scene::GetMesh(EntityId id)
+{
+	size_t row = 0;
+	Archetype* a = Locate(id, &row);
+	return a && (a->mask & ComponentMesh) ? a->meshes[row] : MeshHandle();
+}
+
+void Scene::SetMesh(EntityId id, MeshHandle mesh)
+{
+	size_t row = 0;
+	Archetype* a = Locate(id, &row);
+	if (a && (a->mask & ComponentMesh))
+		a->meshes[row] = mesh;
+}
+
+DirectX::XMFLOAT4* Scene::GetTint(EntityId id)
+{
+	size_t row = 0;
+	Archetype* a = Locate(id, &row);
+	return a && (a->mask & ComponentTint) ? &a->tints[row] : 0;
+}
+
+Bounds* Scene::GetLocalBounds(EntityId id)
+{
+	size_t row = 0;
+	Archetype* a = Locate(id, &row);
+	return a && (a->mask & ComponentBounds) ? &a->localBounds[row] : 0;
+}
+
+Bounds* Scene::GetBounds(EntityId id)
+{
+	size_t row = 0;
+	Archetype* a = Locate(id, &row);
+	return a && (a->mask & ComponentBounds) ? &a->bounds[row] : 0;
+}
+
+uint32_t* Scene::GetFlags(EntityId id)
+{
+	size_t row = 0;
+	Archetype* a = Locate(id, &row);
+	return a && (a->mask & ComponentFlags) ? &a->flags[row] : 0;
+}
+
+unsigned int* Scene::GetInstanceSlot(EntityId id)
+{
+	size_t row = 0;
+	Archetype* a = Locate(id, &row);
+	return a && (a->mask & ComponentInstance) ? &a->instanceSlots[row] : 0;
+}
+
+const std::vector<std::unique_ptr<Archetype>>& Scene::GetArchetypes()
+{
+	return archetypes;
+}
+
+
+// --------------------------------------------------------
+// Helpers
+// --------------------------------------------------------
+Archetype* Scene::FindOrCreateArchetype(uint32_t mask, unsigned int* index)
+{
+	// There are only ever a handful, so a linear search is fine
+	for (size_t i = 0; i < archetypes.size(); i++)
+	{
+		if (archetypes[i]->mask == mask)
+		{
+			*index = (unsigned int)i;
+			return archetypes[i].get();
+		}
+	}
+
+	archetypes.push_back(std::make_unique<Archetype>());
+	archetypes.back()->mask = mask;
+	*index = (unsigned int)(archetypes.size() - 1);
+	return archetypes.back().get();
+}
+
+Archetype* Scene::Locate(EntityId id, size_t* row)
+{
+	if (!IsAlive(id))
+		return 0;
+
+	*row = records[id.Index()].row;
+	return archetypes[records[id.Index()].archetype].get();
+}
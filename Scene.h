@@ -0,0 +1,139 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <DirectXMath.h>
+
+#include "Transform.h"
+#include "Bounds.h"
+#include "Mesh.h"
+#include "SlotMap.h"
+
+// Entities are plain generational ids; everything about
+// them lives in the columns of whichever archetype they
+// belong to
+struct EntityTag;
+typedef Handle<EntityTag> EntityId;
+const EntityId InvalidEntity = EntityId();
+
+// One bit per component type - an archetype is the set of
+// entities that have exactly the same bits
+enum ComponentBits : uint32_t
+{
+	ComponentTransform	= 1 << 0,
+	ComponentMesh		= 1 << 1,
+	ComponentTint		= 1 << 2,
+	ComponentBounds		= 1 << 3,
+	ComponentFlags		= 1 << 4,
+	ComponentInstance	= 1 << 5,
+
+	ComponentRenderable = ComponentTransform | ComponentMesh | ComponentTint | ComponentBounds | ComponentFlags | ComponentInstance
+};
+
+// Values stored in the flags component
+enum EntityFlagBits : uint32_t
+{
+	EntityVisible	= 1 << 0,
+	EntityStatic	= 1 << 1,
+	EntitySpin		= 1 << 2
+};
+
+// --------------------------------------------------------
+// Every entity with the same component mask, stored as
+// one tightly packed array per component ("column").
+//
+// - Row i of every column belongs to entities[i]
+// - Columns for components outside the mask stay empty
+// - Rows are removed by swapping in the last row, so the
+//   columns never have holes
+// --------------------------------------------------------
+struct Archetype
+{
+	uint32_t mask = 0;
+
+	std::vector<EntityId> entities;
+	std::vector<Transform> transforms;
+	std::vector<TransformPose> previousPoses;	// As of the start of the last simulation step
+	std::vector<MeshHandle> meshes;
+	std::vector<DirectX::XMFLOAT4> tints;
+	std::vector<Bounds> localBounds;	// Mesh space, set at spawn
+	std::vector<Bounds> bounds;			// World space, kept current by Systems::UpdateBounds
+	std::vector<uint32_t> flags;
+	std::vector<unsigned int> instanceSlots;
+
+	size_t Count() const { return entities.size(); }
+	bool Has(uint32_t required) const { return (mask & required) == required; }
+
+	void Reserve(size_t count);
+	size_t AddRow(EntityId id);
+	EntityId RemoveRow(size_t row);
+};
+
+// --------------------------------------------------------
+// Archetype based entity storage
+//
+// - Create and destroy are O(1): ids come from a free
+//   list and rows are swap-removed
+// - Destroying an entity bumps its id's generation, so
+//   stale ids simply stop resolving
+// - Systems walk matching archetypes with ForEach() and
+//   loop straight over the columns they need
+// - Pointers returned by the getters are only valid until
+//   the next create or destroy
+// --------------------------------------------------------
+class Scene
+{
+public:
+	Scene() = default;
+	~Scene();
+	Scene(const Scene&) = delete; // Remove copy constructor
+	Scene& operator=(const Scene&) = delete; // Remove copy-assignment operator
+
+	EntityId CreateEntity(uint32_t mask);
+	void DestroyEntity(EntityId id);
+	void Clear();
+	void Reserve(uint32_t mask, size_t count);
+
+	bool IsAlive(EntityId id);
+	size_t GetEntityCount();
+	uint32_t GetMask(EntityId id);
+
+	// Component access for a single entity (null if missing)
+	Transform* GetTransform(EntityId id);
+	MeshHandle GetMesh(EntityId id);
+	void SetMesh(EntityId id, MeshHandle mesh);
+	DirectX::XMFLOAT4* GetTint(EntityId id);
+	Bounds* GetLocalBounds(EntityId id);
+	Bounds* GetBounds(EntityId id);
+	uint32_t* GetFlags(EntityId id);
+	unsigned int* GetInstanceSlot(EntityId id);
+
+	const std::vector<std::unique_ptr<Archetype>>& GetArchetypes();
+
+	// Calls fn(Archetype&) for every non-empty archetype
+	// that has at least the required components
+	template<typename Fn>
+	void ForEach(uint32_t required, Fn fn)
+	{
+		for (auto& a : archetypes)
+			if (a->Has(required) && a->Count() > 0)
+				fn(*a);
+	}
+
+private:
+	struct Record
+	{
+		unsigned int archetype;
+		unsigned int row;
+		unsigned int generation;
+	};
+
+	Archetype* FindOrCreateArchetype(uint32_t mask, unsigned int* index);
+	Archetype* Locate(EntityId id, size_t* row);
+
+	std::vector<std::unique_ptr<Archetype>> archetypes;
+	std::vector<Record> records;
+	std::vector<unsigned int> freeIds;
+	size_t entityCount = 0;
+};
@@ -0,0 +1,431 @@
+#include "ShaderCache.h"
+#include "Graphics.h"
+#include "PathHelpers.h"
+#include "AllocationTracker.h"
+
+#include <d3dcompiler.h>
+#include <chrono>
+#include <cstdio>
+
+#pragma comment(lib, "d3dcompiler.lib")
+
+// Annonymous namespace to hold helpers
+// only accessible in this file
+namespace
+{
+	const char* featureNames[ShaderFeatureCount] = { "TINT_ONLY", "INSTANCE_COLORS", "DEPTH_ONLY", "CLUSTERED_LIGHTS" };
+
+	const char indexMagic[4] = { 'S', 'H', 'C', 'I' };
+	const uint32_t indexVersion = 1;
+
+	struct IndexEntry
+	{
+		uint64_t key;
+		uint64_t blob;
+	};
+
+#if defined(DEBUG) || defined(_DEBUG)
+	const UINT compileFlags = D3DCOMPILE_ENABLE_STRICTNESS | D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
+#else
+	const UINT compileFlags = D3DCOMPILE_ENABLE_STRICTNESS | D3DCOMPILE_OPTIMIZATION_LEVEL3;
+#endif
+
+	// FNV-1a, continued from hash
+	uint64_t Hash(const void* data, size_t size, uint64_t hash = 14695981039346656037ull)
+	{
+		const unsigned char* bytes = (const unsigned char*)data;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	uint64_t PermutationKey(ShaderStage stage, const char* file, uint32_t features)
+	{
+		uint64_t hash = Hash(&stage, sizeof(stage));
+		hash = Hash(file, strlen(file), hash);
+		return Hash(&features, sizeof(features), hash);
+	}
+
+	const char* Target(ShaderStage stage)
+	{
+		return stage == ShaderStage::Vertex ? "vs_5_0" : "ps_5_0";
+	}
+
+	// Next to the exe first, then the working directory (the
+	// project folder when run from Visual Studio), then the
+	// project folder relative to the usual output directory
+	bool FindSource(const std::string& file, std::wstring& outPath)
+	{
+		std::wstring candidates[] = {
+			FixPath(NarrowToWide(file)),
+			NarrowToWide(file),
+			FixPath(L"..\\..\\" + NarrowToWide(file)),
+		};
+		for (const std::wstring& path : candidates)
+		{
+			if (GetFileAttributesW(path.c_str()) != INVALID_FILE_ATTRIBUTES)
+			{
+				outPath = path;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool ReadBytes(const std::wstring& path, std::vector<char>& outBytes)
+	{
+		FILE* file = 0;
+		if (_wfopen_s(&file, path.c_str(), L"rb") != 0 || !file)
+			return false;
+
+		fseek(file, 0, SEEK_END);
+		long size = ftell(file);
+		fseek(file, 0, SEEK_SET);
+
+		outBytes.resize(size > 0 ? (size_t)size : 0);
+		bool read = outBytes.empty() || fread(outBytes.data(), 1, outBytes.size(), file) == outBytes.size();
+		fclose(file);
+		return read;
+	}
+
+	std::wstring BlobPath(const std::wstring& directory, uint64_t blob)
+	{
+		wchar_t name[32] = {};
+		swprintf_s(name, L"%016llx.cso", blob);
+		return directory + L"\\" + name;
+	}
+}
+
+void ShaderCache::Initialize(const std::wstring& cacheDirectory)
+{
+	directory = cacheDirectory;
+	CreateDirectoryW(directory.c_str(), 0);
+	LoadIndex();
+}
+
+ShaderId ShaderCache::GetVertexShader(const char* file, uint32_t features, const D3D11_INPUT_ELEMENT_DESC* layout, unsigned int layoutCount)
+{
+	ShaderId found = Find(PermutationKey(ShaderStage::Vertex, file, features));
+	return found != InvalidShader ? found : Add(ShaderStage::Vertex, file, features, layout, layoutCount);
+}
+
+ShaderId ShaderCache::GetPixelShader(const char* file, uint32_t features)
+{
+	ShaderId found = Find(PermutationKey(ShaderStage::Pixel, file, features));
+	return found != InvalidShader ? found : Add(ShaderStage::Pixel, file, features, 0, 0);
+}
+
+ID3D11VertexShader* ShaderCache::GetVertexShader(ShaderId id)
+{
+	return id < entryCount ? entries[id].vertexShader.Get() : 0;
+}
+
+ID3D11InputLayout* ShaderCache::GetInputLayout(ShaderId id)
+{
+	return id < entryCount ? entries[id].inputLayout.Get() : 0;
+}
+
+ID3D11PixelShader* ShaderCache::GetPixelShader(ShaderId id)
+{
+	return id < entryCount ? entries[id].pixelShader.Get() : 0;
+}
+
+const char* ShaderCache::GetFeatureName(unsigned int bit)
+{
+	return bit < ShaderFeatureCount ? featureNames[bit] : "";
+}
+
+ShaderCache::Stats ShaderCache::GetStats()
+{
+	std::lock_guard<std::mutex> lock(buildMutex);
+	Stats current = stats;
+	current.permutations = entryCount;
+	return current;
+}
+
+ShaderId ShaderCache::Find(uint64_t key)
+{
+	auto found = lookup.find(key);
+	return found != lookup.end() ? found->second : InvalidShader;
+}
+
+ShaderId ShaderCache::Add(ShaderStage stage, const char* file, uint32_t features, const D3D11_INPUT_ELEMENT_DESC* layout, unsigned int layoutCount)
+{
+	std::lock_guard<std::mutex> lock(buildMutex);
+	if (entryCount == MaxShaders)
+		return InvalidShader;
+
+	ALLOCATION_SCOPE("Shaders");
+
+	Entry& entry = entries[entryCount];
+	entry.key = PermutationKey(stage, file, features);
+	entry.stage = stage;
+	entry.file = file;
+	entry.features = features;
+	entry.layout = layout;
+	entry.layoutCount = layoutCount;
+
+	if (!Build(entry, true))
+	{
+		stats.failed++;
+		entry = Entry();
+		return InvalidShader;
+	}
+
+	ShaderId id = entryCount;
+	lookup[entry.key] = id;
+	entryCount = id + 1;
+	return id;
+}
+
+void ShaderCache::GetSourcePaths(std::vector<std::wstring>& outPaths)
+{
+	std::lock_guard<std::mutex> lock(buildMutex);
+
+	outPaths.clear();
+	for (unsigned int i = 0; i < entryCount; i++)
+	{
+		const std::wstring& path = entries[i].sourcePath;
+		bool known = path.empty();
+		for (const std::wstring& p : outPaths)
+			known = known || _wcsicmp(p.c_str(), path.c_str()) == 0;
+		if (!known)
+			outPaths.push_back(path);
+	}
+}
+
+// --------------------------------------------------------
+// Builds into a copy of each entry, so nothing the draw
+// thread can see is touched until ApplyRebuilds()
+// --------------------------------------------------------
+bool ShaderCache::Rebuild(const std::wstring& sourcePath, std::chrono::steady_clock::time_point noticed)
+{
+	ALLOCATION_SCOPE("Shaders");
+	std::lock_guard<std::mutex> lock(buildMutex);
+
+	bool succeeded = true;
+	for (unsigned int i = 0; i < entryCount; i++)
+	{
+		const Entry& current = entries[i];
+		if (_wcsicmp(current.sourcePath.c_str(), sourcePath.c_str()) != 0)
+			continue;
+
+		Entry entry;
+		entry.key = current.key;
+		entry.stage = current.stage;
+		entry.file = current.file;
+		entry.features = current.features;
+		entry.layout = current.layout;
+		entry.layoutCount = current.layoutCount;
+		if (!Build(entry, false))
+		{
+			stats.failed++;
+			succeeded = false;
+			continue;
+		}
+		stats.rebuilt++;
+
+		// A rebuild still waiting is simply replaced, but the
+		// wait counts from the first change
+		std::lock_guard<std::mutex> rebuiltLock(rebuiltMutex);
+		Rebuilt* waiting = 0;
+		for (Rebuilt& r : rebuilt)
+		{
+			if (r.id == i)
+				waiting = &r;
+		}
+		if (!waiting)
+		{
+			rebuilt.push_back({ i, noticed });
+			waiting = &rebuilt.back();
+		}
+		waiting->vertexShader = entry.vertexShader;
+		waiting->inputLayout = entry.inputLayout;
+		waiting->pixelShader = entry.pixelShader;
+	}
+	return succeeded;
+}
+
+bool ShaderCache::ApplyRebuilds(std::chrono::steady_clock::time_point& outNoticed)
+{
+	std::lock_guard<std::mutex> lock(rebuiltMutex);
+	if (rebuilt.empty())
+		return false;
+
+	outNoticed = rebuilt[0].noticed;
+	for (Rebuilt& r : rebuilt)
+	{
+		Entry& entry = entries[r.id];
+		if (entry.stage == ShaderStage::Vertex)
+		{
+			entry.vertexShader = r.vertexShader;
+			entry.inputLayout = r.inputLayout;
+		}
+		else
+			entry.pixelShader = r.pixelShader;
+
+		if (r.noticed < outNoticed)
+			outNoticed = r.noticed;
+	}
+	rebuilt.clear();
+	return true;
+}
+
+bool ShaderCache::HasRebuilds()
+{
+	std::lock_guard<std::mutex> lock(rebuiltMutex);
+	return !rebuilt.empty();
+}
+
+// --------------------------------------------------------
+// Source (hashed to find its blob), then the index's idea
+// of the blob when there's no source, then compiling, then
+// the build's .cso if allowed.  Call with the build mutex
+// held.
+// --------------------------------------------------------
+bool ShaderCache::Build(Entry& entry, bool allowPrecompiled)
+{
+	Microsoft::WRL::ComPtr<ID3DBlob> bytecode;
+	uint64_t blob = 0;
+
+	std::wstring sourcePath;
+	std::vector<char> source;
+	bool haveSource = FindSource(entry.file, sourcePath) && ReadBytes(sourcePath, source);
+	if (haveSource)
+	{
+		entry.sourcePath = sourcePath;
+
+		const char* target = Target(entry.stage);
+		blob = Hash(source.data(), source.size());
+		blob = Hash(target, strlen(target), blob);
+		blob = Hash(&entry.features, sizeof(entry.features), blob);
+		blob = Hash(&compileFlags, sizeof(compileFlags), blob);
+	}
+	else
+	{
+		auto known = index.find(entry.key);
+		if (known != index.end())
+			blob = known->second;
+	}
+
+	if (blob != 0 && SUCCEEDED(D3DReadFileToBlob(BlobPath(directory, blob).c_str(), bytecode.GetAddressOf())))
+		stats.blobHits++;
+
+	if (!bytecode && haveSource)
+	{
+		D3D_SHADER_MACRO defines[ShaderFeatureCount + 1] = {};
+		for (unsigned int f = 0; f < ShaderFeatureCount; f++)
+			defines[f] = { featureNames[f], (entry.features & (1u << f)) ? "1" : "0" };
+
+		auto start = std::chrono::high_resolution_clock::now();
+		Microsoft::WRL::ComPtr<ID3DBlob> errors;
+		std::string sourceName = WideToNarrow(sourcePath);
+		HRESULT result = D3DCompile(source.data(), source.size(), sourceName.c_str(), defines, D3D_COMPILE_STANDARD_FILE_INCLUDE,
+			"main", Target(entry.stage), compileFlags, 0, bytecode.GetAddressOf(), errors.GetAddressOf());
+		stats.compileMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+		if (FAILED(result))
+		{
+			printf("Shader %s (features 0x%x) failed to compile:\n%s\n", entry.file.c_str(), entry.features,
+				errors ? (const char*)errors->GetBufferPointer() : "");
+			bytecode.Reset();
+		}
+		else
+		{
+			stats.compiled++;
+			D3DWriteBlobToFile(bytecode.Get(), BlobPath(directory, blob).c_str(), TRUE);
+		}
+	}
+
+	if (!bytecode && allowPrecompiled && entry.features == 0)
+	{
+		std::string cso = entry.file.substr(0, entry.file.find_last_of('.')) + ".cso";
+		if (SUCCEEDED(D3DReadFileToBlob(FixPath(NarrowToWide(cso)).c_str(), bytecode.GetAddressOf())))
+			stats.precompiled++;
+		blob = 0;
+	}
+
+	if (!bytecode)
+		return false;
+
+	if (entry.stage == ShaderStage::Vertex)
+	{
+		entry.vertexShader.Reset();
+		entry.inputLayout.Reset();
+		Graphics::Device->CreateVertexShader(bytecode->GetBufferPointer(), bytecode->GetBufferSize(), 0, entry.vertexShader.GetAddressOf());
+		if (entry.layoutCount > 0)
+			Graphics::Device->CreateInputLayout(entry.layout, entry.layoutCount, bytecode->GetBufferPointer(), bytecode->GetBufferSize(), entry.inputLayout.GetAddressOf());
+		if (!entry.vertexShader)
+			return false;
+	}
+	else
+	{
+		entry.pixelShader.Reset();
+		Graphics::Device->CreatePixelShader(bytecode->GetBufferPointer(), bytecode->GetBufferSize(), 0, entry.pixelShader.GetAddressOf());
+		if (!entry.pixelShader)
+			return false;
+	}
+
+	// Remembered for runs without the source
+	if (blob != 0)
+	{
+		auto known = index.find(entry.key);
+		if (known == index.end() || known->second != blob)
+		{
+			index[entry.key] = blob;
+			SaveIndex();
+		}
+	}
+	return true;
+}
+
+// --------------------------------------------------------
+// Magic, version, count, then (key, blob) pairs.  Read as
+// a single block and checked before anything is used.
+// --------------------------------------------------------
+void ShaderCache::LoadIndex()
+{
+	index.clear();
+
+	std::vector<char> bytes;
+	if (!ReadBytes(directory + L"\\index.bin", bytes))
+		return;
+
+	const size_t headerSize = sizeof(indexMagic) + sizeof(uint32_t) * 2;
+	if (bytes.size() < headerSize || memcmp(bytes.data(), indexMagic, sizeof(indexMagic)) != 0)
+		return;
+
+	uint32_t version = 0;
+	uint32_t count = 0;
+	memcpy(&version, bytes.data() + sizeof(indexMagic), sizeof(version));
+	memcpy(&count, bytes.data() + sizeof(indexMagic) + sizeof(version), sizeof(count));
+	if (version != indexVersion || bytes.size() != headerSize + count * sizeof(IndexEntry))
+		return;
+
+	const IndexEntry* read = (const IndexEntry*)(bytes.data() + headerSize);
+	index.reserve(count);
+	for (uint32_t i = 0; i < count; i++)
+		index[read[i].key] = read[i].blob;
+}
+
+void ShaderCache::SaveIndex()
+{
+	FILE* file = 0;
+	if (_wfopen_s(&file, (directory + L"\\index.bin").c_str(), L"wb") != 0 || !file)
+		return;
+
+	std::vector<IndexEntry> written;
+	written.reserve(index.size());
+	for (auto& pair : index)
+		written.push_back({ pair.first, pair.second });
+
+	uint32_t count = (uint32_t)written.size();
+	fwrite(indexMagic, 1, sizeof(indexMagic), file);
+	fwrite(&indexVersion, sizeof(indexVersion), 1, file);
+	fwrite(&count, sizeof(count), 1, file);
+	fwrite(written.data(), sizeof(IndexEntry), written.size(), file);
+	fclose(file);
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+
+// Optional parts of the shaders, as #defines.  A set of
+// these picks one permutation; none at all is what the
+// build precompiles into the .cso files.
+enum ShaderFeature : uint32_t
+{
+	ShaderFeatureTintOnly		= 1 << 0,	// TINT_ONLY: ignore vertex colors
+	ShaderFeatureInstanceColors	= 1 << 1,	// INSTANCE_COLORS: color by instance slot, for debugging
+	ShaderFeatureDepthOnly		= 1 << 2,	// DEPTH_ONLY: positions in, nothing but depth out
+	ShaderFeatureClusteredLights	= 1 << 3,	// CLUSTERED_LIGHTS: shade with the LightGrid's lights
+	ShaderFeatureCount			= 4
+};
+
+enum class ShaderStage
+{
+	Vertex,
+	Pixel
+};
+
+// Index of a loaded permutation
+typedef unsigned int ShaderId;
+const ShaderId InvalidShader = 0xFFFFFFFF;
+
+// --------------------------------------------------------
+// Compiles, caches and hands out shader permutations
+//
+// - A permutation is a source file, a stage and a set of
+//   ShaderFeature bits, each of which becomes a #define;
+//   together they hash into a 64-bit key
+// - Compiled bytecode goes to a directory of blobs named
+//   by the hash of what produced them (source text, target,
+//   defines and compile flags), so an unchanged shader is
+//   never compiled twice, and edited ones simply miss
+// - The index maps permutation keys to blobs, for machines
+//   without the sources.  It's one file, read in one go.
+// - Shader objects (and, for vertex shaders, their input
+//   layouts) are created once per permutation.  Lookups by
+//   id are plain array reads, safe from the render thread.
+// - Without a source or a cached blob, the permutation
+//   with no features falls back to the precompiled .cso
+// - An edited source can be rebuilt on any thread.  The new
+//   objects wait until ApplyRebuilds() swaps them in, on
+//   the thread that draws, between frames.
+// --------------------------------------------------------
+class ShaderCache
+{
+public:
+	ShaderCache() = default;
+	ShaderCache(const ShaderCache&) = delete; // Remove copy constructor
+	ShaderCache& operator=(const ShaderCache&) = delete; // Remove copy-assignment operator
+
+	static const unsigned int MaxShaders = 256;
+
+	// Loads the index from cacheDirectory, creating it if needed
+	void Initialize(const std::wstring& cacheDirectory);
+
+	// Setup time: finds or builds a permutation.  The layout
+	// (semantic names included) must stay alive as long as
+	// the cache.
+	ShaderId GetVertexShader(const char* file, uint32_t features, const D3D11_INPUT_ELEMENT_DESC* layout, unsigned int layoutCount);
+	ShaderId GetPixelShader(const char* file, uint32_t features);
+
+	// Draw time
+	ID3D11VertexShader* GetVertexShader(ShaderId id);
+	ID3D11InputLayout* GetInputLayout(ShaderId id);
+	ID3D11PixelShader* GetPixelShader(ShaderId id);
+
+	static const char* GetFeatureName(unsigned int bit);
+
+	// Every source file a loaded permutation was built from
+	void GetSourcePaths(std::vector<std::wstring>& outPaths);
+
+	// Rebuilds every permutation of one source, on any thread,
+	// keeping the current objects for any that fail.  Returns
+	// false if any did.
+	bool Rebuild(const std::wstring& sourcePath, std::chrono::steady_clock::time_point noticed);
+
+	// Draw thread, between frames: swaps rebuilt objects in.
+	// Returns true if there were any, along with when the
+	// oldest change behind them was noticed.
+	bool ApplyRebuilds(std::chrono::steady_clock::time_point& outNoticed);
+
+	// Any thread: whether ApplyRebuilds() has anything to swap in
+	bool HasRebuilds();
+
+	struct Stats
+	{
+		unsigned int permutations;
+		unsigned int compiled;			// From source this run
+		unsigned int blobHits;			// Bytecode found in the blob cache
+		unsigned int precompiled;		// The build's .cso
+		unsigned int failed;
+		unsigned int rebuilt;
+		double compileMs;
+	};
+	Stats GetStats();
+
+private:
+	struct Entry
+	{
+		uint64_t key;
+		ShaderStage stage;
+		std::string file;
+		uint32_t features;
+		const D3D11_INPUT_ELEMENT_DESC* layout;
+		unsigned int layoutCount;
+		std::wstring sourcePath;	// Empty if built without one
+
+		Microsoft::WRL::ComPtr<ID3D11VertexShader> vertexShader;
+		Microsoft::WRL::ComPtr<ID3D11InputLayout> inputLayout;
+		Microsoft::WRL::ComPtr<ID3D11PixelShader> pixelShader;
+	};
+
+	ShaderId Find(uint64_t key);
+	ShaderId Add(ShaderStage stage, const char* file, uint32_t features, const D3D11_INPUT_ELEMENT_DESC* layout, unsigned int layoutCount);
+	bool Build(Entry& entry, bool allowPrecompiled);
+	void LoadIndex();
+	void SaveIndex();
+
+	std::wstring directory;
+
+	// Fixed, so ids stay valid while more are added.  Only
+	// the draw thread reads or swaps the objects in existing
+	// entries; building (adding or rebuilding) holds the
+	// build mutex.
+	Entry entries[MaxShaders];
+	std::atomic<unsigned int> entryCount{ 0 };
+	std::mutex buildMutex;
+
+	// Rebuilt objects waiting for the next frame boundary
+	struct Rebuilt
+	{
+		ShaderId id;
+		std::chrono::steady_clock::time_point noticed;
+		Microsoft::WRL::ComPtr<ID3D11VertexShader> vertexShader;
+		Microsoft::WRL::ComPtr<ID3D11InputLayout> inputLayout;
+		Microsoft::WRL::ComPtr<ID3D11PixelShader> pixelShader;
+	};
+	std::vector<Rebuilt> rebuilt;
+	std::mutex rebuiltMutex;
+	std::unordered_map<uint64_t, ShaderId> lookup;
+
+	// Permutation key -> blob hash, as of the last build
+	std::unordered_map<uint64_t, uint64_t> index;
+
+	Stats stats = {};
+};
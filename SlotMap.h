@@ -0,0 +1,177 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <cstdint>
+#include <cassert>
+#include <utility>
+
+// --------------------------------------------------------
+// A 32-bit generational handle: the low 24 bits pick a
+// slot, the high 8 bits hold that slot's generation when
+// the handle was made.  Freeing a slot bumps its
+// generation, so old handles to it stop resolving.
+//
+// Tag only keeps handles to different things apart
+// (a mesh handle can't be passed where a camera is wanted)
+// --------------------------------------------------------
+template<typename Tag>
+struct Handle
+{
+	static const uint32_t IndexBits = 24;
+	static const uint32_t IndexMask = (1u << IndexBits) - 1;
+	static const uint32_t MaxGeneration = 0xFF;
+
+	uint32_t value = 0xFFFFFFFF;
+
+	static Handle Make(uint32_t index, uint32_t generation)
+	{
+		Handle h;
+		h.value = (generation << IndexBits) | (index & IndexMask);
+		return h;
+	}
+
+	uint32_t Index() const { return value & IndexMask; }
+	uint32_t Generation() const { return value >> IndexBits; }
+	bool IsValid() const { return value != 0xFFFFFFFF; }
+
+	bool operator==(const Handle& other) const { return value == other.value; }
+	bool operator!=(const Handle& other) const { return value != other.value; }
+};
+
+// --------------------------------------------------------
+// Dense storage addressed through generational handles
+//
+// - Values live packed in one array, so iterating them
+//   is a straight walk over memory
+// - Handles go through a small slot table to find their
+//   value; removal swaps the last value into the hole
+// - Get() always checks the generation and returns null
+//   for stale handles; operator[] only checks in debug
+//   builds, where a stale handle asserts
+// - Pointers to values are invalidated by Emplace and
+//   Remove - hold handles instead
+// --------------------------------------------------------
+template<typename T, typename Tag = T>
+class SlotMap
+{
+public:
+	typedef Handle<Tag> HandleType;
+
+	SlotMap() = default;
+	SlotMap(const SlotMap&) = delete; // Remove copy constructor
+	SlotMap& operator=(const SlotMap&) = delete; // Remove copy-assignment operator
+
+	template<typename... Args>
+	HandleType Emplace(Args&&... args)
+	{
+		uint32_t slot;
+		if (!freeSlots.empty())
+		{
+			slot = freeSlots.back();
+			freeSlots.pop_back();
+		}
+		else
+		{
+			slot = (uint32_t)slots.size();
+			assert(slot <= HandleType::IndexMask && "SlotMap is full");
+			slots.push_back({ 0, 0 });
+		}
+
+		slots[slot].dense = (uint32_t)values.size();
+		values.emplace_back(std::forward<Args>(args)...);
+		denseToSlot.push_back(slot);
+		return HandleType::Make(slot, slots[slot].generation);
+	}
+
+	bool Remove(HandleType h)
+	{
+		if (!Contains(h))
+			return false;
+
+		uint32_t slot = h.Index();
+		uint32_t dense = slots[slot].dense;
+		uint32_t last = (uint32_t)values.size() - 1;
+
+		// Fill the hole with the last value
+		if (dense != last)
+		{
+			values[dense] = std::move(values[last]);
+			denseToSlot[dense] = denseToSlot[last];
+			slots[denseToSlot[dense]].dense = dense;
+		}
+		values.pop_back();
+		denseToSlot.pop_back();
+
+		// Retire every handle made for this slot so far
+		slots[slot].generation = (slots[slot].generation + 1) % HandleType::MaxGeneration;
+		freeSlots.push_back(slot);
+		return true;
+	}
+
+	bool Contains(HandleType h) const
+	{
+		return h.IsValid() &&
+			h.Index() < slots.size() &&
+			slots[h.Index()].generation == h.Generation() &&
+			slots[h.Index()].dense < values.size() &&
+			denseToSlot[slots[h.Index()].dense] == h.Index();
+	}
+
+	T* Get(HandleType h)
+	{
+		return Contains(h) ? &values[slots[h.Index()].dense] : 0;
+	}
+
+	T& operator[](HandleType h)
+	{
+		assert(Contains(h) && "Stale or invalid handle");
+		return values[slots[h.Index()].dense];
+	}
+
+	// The handle for the value at a dense position, e.g.
+	// while iterating
+	HandleType HandleAt(size_t denseIndex) const
+	{
+		uint32_t slot = denseToSlot[denseIndex];
+		return HandleType::Make(slot, slots[slot].generation);
+	}
+
+	void Reserve(size_t count)
+	{
+		values.reserve(count);
+		denseToSlot.reserve(count);
+		slots.reserve(count);
+	}
+
+	void Clear()
+	{
+		// Bump every live slot so no old handle survives
+		for (uint32_t slot : denseToSlot)
+		{
+			slots[slot].generation = (slots[slot].generation + 1) % HandleType::MaxGeneration;
+			freeSlots.push_back(slot);
+		}
+		values.clear();
+		denseToSlot.clear();
+	}
+
+	size_t Size() const { return values.size(); }
+	bool Empty() const { return values.empty(); }
+
+	T* Data() { return values.data(); }
+	typename std::vector<T>::iterator begin() { return values.begin(); }
+	typename std::vector<T>::iterator end() { return values.end(); }
+
+private:
+	struct Slot
+	{
+		uint32_t dense;
+		uint32_t generation;
+	};
+
+	std::vector<T> values;
+	std::vector<uint32_t> denseToSlot;
+	std::vector<Slot> slots;
+	std::vector<uint32_t> freeSlots;
+};
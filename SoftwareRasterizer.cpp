@@ -0,0 +1,585 @@
+#include "SoftwareRasterizer.h"
+#include "Vertex.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#include <emmintrin.h>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+
+using namespace DirectX;
+
+// Annonymous namespace to hold helpers
+// only accessible in this file
+namespace
+{
+	// Fewest draws worth a geometry job of their own
+	const unsigned int minDrawsPerChunk = 64;
+
+	// Triangles are clipped against these planes in clip space
+	// (each is >= 0 inside).  x and y only matter once a
+	// triangle reaches this many viewports out, where screen
+	// coordinates would get too large for float edge functions;
+	// anything closer is left to the edge functions.
+	const float guardBand = 4.0f;
+	const unsigned int clipPlaneCount = 6;
+
+	float PlaneDistance(const float* v, unsigned int plane)
+	{
+		switch (plane)
+		{
+		case 0: return v[2];						// Near: z >= 0
+		case 1: return v[3] - v[2];					// Far: z <= w
+		case 2: return v[0] + guardBand * v[3];
+		case 3: return guardBand * v[3] - v[0];
+		case 4: return v[1] + guardBand * v[3];
+		default: return guardBand * v[3] - v[1];
+		}
+	}
+
+	// Packs 0 - 1 colors to RGBA8, as an R8G8B8A8_UNORM target would
+	__m128i PackColor(__m128 r, __m128 g, __m128 b, __m128 a)
+	{
+		__m128 zero = _mm_setzero_ps();
+		__m128 one = _mm_set1_ps(1.0f);
+		__m128 scale = _mm_set1_ps(255.0f);
+		__m128 half = _mm_set1_ps(0.5f);
+
+		__m128i ri = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(r, zero), one), scale), half));
+		__m128i gi = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(g, zero), one), scale), half));
+		__m128i bi = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(b, zero), one), scale), half));
+		__m128i ai = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(a, zero), one), scale), half));
+
+		return _mm_or_si128(_mm_or_si128(ri, _mm_slli_epi32(gi, 8)), _mm_or_si128(_mm_slli_epi32(bi, 16), _mm_slli_epi32(ai, 24)));
+	}
+
+	// Set lanes in a 4-bit movemask
+	const unsigned int laneCounts[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+}
+
+SoftwareRasterizer::SoftwareRasterizer(unsigned int width, unsigned int height)
+{
+	Resize(width, height);
+}
+
+// --------------------------------------------------------
+// Rows are padded out to whole tiles, so a four-pixel step
+// near the right edge always stays inside the buffers
+// --------------------------------------------------------
+void SoftwareRasterizer::Resize(unsigned int width, unsigned int height)
+{
+	this->width = width > 0 ? width : 1;
+	this->height = height > 0 ? height : 1;
+	tilesX = (this->width + TileSize - 1) / TileSize;
+	tilesY = (this->height + TileSize - 1) / TileSize;
+	pitch = tilesX * TileSize;
+
+	colorBuffer.assign((size_t)pitch * tilesY * TileSize, 0);
+	depthBuffer.assign((size_t)pitch * tilesY * TileSize, 1.0f);
+	tilePixels.assign(tilesX * tilesY, 0);
+	tileCovered.assign(tilesX * tilesY, 0);
+	chunks.clear();
+}
+
+unsigned int SoftwareRasterizer::GetWidth()
+{
+	return width;
+}
+
+unsigned int SoftwareRasterizer::GetHeight()
+{
+	return height;
+}
+
+// --------------------------------------------------------
+// Applies a captured update to the local instance copy.
+// Only the tints are needed from it, as the WVPs already
+// include each world matrix.  With several views, Draw()
+// is handed whichever view's block to use.
+// --------------------------------------------------------
+void SoftwareRasterizer::Upload(const InstanceUpdate& update)
+{
+	if (instances.size() < update.instanceCount)
+	{
+		InstanceData blank = {};
+		XMStoreFloat4x4(&blank.world, XMMatrixIdentity());
+		blank.colorTint = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+		instances.resize(update.instanceCount, blank);
+	}
+
+	const InstanceData* next = update.data;
+	for (unsigned int i = 0; i < update.rangeCount; i++)
+	{
+		const DirtyRange& range = update.ranges[i];
+		memcpy(&instances[range.begin], next, (range.end - range.begin) * sizeof(InstanceData));
+		next += range.end - range.begin;
+	}
+
+	drawData = update.draws;
+	drawDataCount = update.drawCount;
+}
+
+void SoftwareRasterizer::Clear(const float color[4])
+{
+	__m128i packed = PackColor(_mm_set1_ps(color[0]), _mm_set1_ps(color[1]), _mm_set1_ps(color[2]), _mm_set1_ps(color[3]));
+	std::fill(colorBuffer.begin(), colorBuffer.end(), (uint32_t)_mm_cvtsi128_si32(packed));
+	std::fill(depthBuffer.begin(), depthBuffer.end(), 1.0f);
+}
+
+// --------------------------------------------------------
+// Two passes, both spread over the job system:
+//  - Geometry: contiguous runs of draws are transformed,
+//    clipped, culled, set up and binned, one run per job
+//  - Tiles: each tile walks the runs in order, so its
+//    triangles are drawn in submission order, then counts
+//    how much of itself has been drawn
+// --------------------------------------------------------
+void SoftwareRasterizer::Draw(const DrawItem* draws, unsigned int count, unsigned int drawOffset, DepthPass pass)
+{
+	PROFILE_SCOPE("Software raster");
+
+	unsigned int tileCount = tilesX * tilesY;
+	unsigned int chunkCount = count / minDrawsPerChunk;
+	if (chunkCount > JobSystem::GetThreadCount()) chunkCount = JobSystem::GetThreadCount();
+	if (chunkCount == 0) chunkCount = 1;
+
+	if (chunks.size() < chunkCount)
+		chunks.resize(chunkCount);
+
+	unsigned int perChunk = (count + chunkCount - 1) / chunkCount;
+	{
+		PROFILE_SCOPE("Raster geometry");
+		JobSystem::ParallelFor(chunkCount, 1, [&](unsigned int first, unsigned int last)
+		{
+			for (unsigned int c = first; c < last; c++)
+			{
+				Chunk& chunk = chunks[c];
+				chunk.triangles.clear();
+				chunk.submitted = 0;
+				chunk.bins.resize(tileCount);
+				for (std::vector<unsigned int>& bin : chunk.bins)
+					bin.clear();
+
+				unsigned int begin = c * perChunk;
+				unsigned int end = begin + perChunk < count ? begin + perChunk : count;
+				if (begin < end)
+					ProcessDraws(chunk, draws + begin, end - begin, drawOffset + begin);
+			}
+		});
+	}
+
+	{
+		PROFILE_SCOPE("Raster tiles");
+		JobSystem::ParallelFor(tileCount, 1, [&](unsigned int first, unsigned int last)
+		{
+			for (unsigned int t = first; t < last; t++)
+			{
+				tilePixels[t] = RasterizeTile(t, chunkCount, pass);
+				tileCovered[t] = CountCovered(t);
+			}
+		});
+	}
+
+	stats = {};
+	for (unsigned int c = 0; c < chunkCount; c++)
+	{
+		stats.triangles += chunks[c].submitted;
+		stats.visible += (unsigned int)chunks[c].triangles.size();
+		for (const std::vector<unsigned int>& bin : chunks[c].bins)
+			stats.binned += (unsigned int)bin.size();
+	}
+	for (unsigned int t = 0; t < tileCount; t++)
+	{
+		stats.pixels += tilePixels[t];
+		stats.covered += tileCovered[t];
+	}
+	stats.shaded = pass == DepthPass::DepthOnly ? 0 : stats.pixels;
+}
+
+// --------------------------------------------------------
+// The vertex shader, run on every corner of every triangle:
+// position by the draw's WVP, color by its instance's tint
+// --------------------------------------------------------
+void SoftwareRasterizer::ProcessDraws(Chunk& chunk, const DrawItem* draws, unsigned int count, unsigned int drawOffset)
+{
+	for (unsigned int d = 0; d < count; d++)
+	{
+		const DrawItem& draw = draws[d];
+		unsigned int triangleCount = draw.indexCount / 3;
+		chunk.submitted += triangleCount;
+
+		if (!draw.vertices || !draw.indices || drawOffset + d >= drawDataCount)
+			continue;
+
+		XMMATRIX wvp = XMLoadFloat4x4(&drawData[drawOffset + d].worldViewProj);
+		XMVECTOR tint = draw.instanceSlot < instances.size() ?
+			XMLoadFloat4(&instances[draw.instanceSlot].colorTint) :
+			XMVectorSplatOne();
+
+		for (unsigned int t = 0; t < triangleCount; t++)
+		{
+			ClipVertex corners[3];
+			for (unsigned int i = 0; i < 3; i++)
+			{
+				const Vertex& vertex = draw.vertices[draw.indices[t * 3 + i]];
+				XMStoreFloat4((XMFLOAT4*)&corners[i].v[0], XMVector3Transform(XMLoadFloat3(&vertex.Position), wvp));
+				XMStoreFloat4((XMFLOAT4*)&corners[i].v[4], XMVectorMultiply(XMLoadFloat4(&vertex.Color), tint));
+			}
+			ClipAndSetUp(chunk, corners);
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Rejects triangles entirely outside any one plane, passes
+// those entirely inside every plane straight on, and clips
+// the rest (Sutherland-Hodgman), fanning the polygon back
+// out into triangles
+// --------------------------------------------------------
+void SoftwareRasterizer::ClipAndSetUp(Chunk& chunk, const ClipVertex* vertices)
+{
+	unsigned int outsideAny = 0;
+	for (unsigned int p = 0; p < clipPlaneCount; p++)
+	{
+		unsigned int outside = 0;
+		for (unsigned int i = 0; i < 3; i++)
+		{
+			if (PlaneDistance(vertices[i].v, p) < 0)
+				outside++;
+		}
+
+		if (outside == 3)
+			return;
+		if (outside > 0)
+			outsideAny |= 1u << p;
+	}
+
+	// Entirely off one side of the screen, though within the guard band
+	if (vertices[0].v[0] > vertices[0].v[3] && vertices[1].v[0] > vertices[1].v[3] && vertices[2].v[0] > vertices[2].v[3]) return;
+	if (vertices[0].v[0] < -vertices[0].v[3] && vertices[1].v[0] < -vertices[1].v[3] && vertices[2].v[0] < -vertices[2].v[3]) return;
+	if (vertices[0].v[1] > vertices[0].v[3] && vertices[1].v[1] > vertices[1].v[3] && vertices[2].v[1] > vertices[2].v[3]) return;
+	if (vertices[0].v[1] < -vertices[0].v[3] && vertices[1].v[1] < -vertices[1].v[3] && vertices[2].v[1] < -vertices[2].v[3]) return;
+
+	if (outsideAny == 0)
+	{
+		SetUp(chunk, vertices[0], vertices[1], vertices[2]);
+		return;
+	}
+
+	// Each plane can add at most one vertex
+	ClipVertex buffers[2][3 + clipPlaneCount];
+	unsigned int counts[2] = { 3, 0 };
+	memcpy(buffers[0], vertices, sizeof(ClipVertex) * 3);
+
+	unsigned int in = 0;
+	for (unsigned int p = 0; p < clipPlaneCount; p++)
+	{
+		if (!(outsideAny & (1u << p)))
+			continue;
+
+		unsigned int out = in ^ 1;
+		counts[out] = 0;
+		for (unsigned int i = 0; i < counts[in]; i++)
+		{
+			const ClipVertex& a = buffers[in][i];
+			const ClipVertex& b = buffers[in][(i + 1) % counts[in]];
+			float da = PlaneDistance(a.v, p);
+			float db = PlaneDistance(b.v, p);
+
+			if (da >= 0)
+				buffers[out][counts[out]++] = a;
+
+			// Crosses the plane, so keep where it does
+			if ((da >= 0) != (db >= 0))
+			{
+				float t = da / (da - db);
+				ClipVertex& split = buffers[out][counts[out]++];
+				for (unsigned int k = 0; k < 8; k++)
+					split.v[k] = a.v[k] + (b.v[k] - a.v[k]) * t;
+			}
+		}
+
+		in = out;
+		if (counts[in] < 3)
+			return;
+	}
+
+	for (unsigned int i = 1; i + 1 < counts[in]; i++)
+		SetUp(chunk, buffers[in][0], buffers[in][i], buffers[in][i + 1]);
+}
+
+// --------------------------------------------------------
+// Projects to the viewport, culls back faces and builds
+// everything the tiles need as planes over screen space,
+// evaluated at pixel centers
+// --------------------------------------------------------
+void SoftwareRasterizer::SetUp(Chunk& chunk, const ClipVertex& a, const ClipVertex& b, const ClipVertex& c)
+{
+	const ClipVertex* corners[3] = { &a, &b, &c };
+	float x[3], y[3], z[3], invW[3];
+	for (unsigned int i = 0; i < 3; i++)
+	{
+		if (!(corners[i]->v[3] > 0))
+			return;
+
+		invW[i] = 1.0f / corners[i]->v[3];
+		x[i] = (corners[i]->v[0] * invW[i] * 0.5f + 0.5f) * width;
+		y[i] = (0.5f - corners[i]->v[1] * invW[i] * 0.5f) * height;
+		z[i] = corners[i]->v[2] * invW[i];
+	}
+
+	// Clockwise on screen is front facing, and only front faces are drawn
+	float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+	if (!(area > 0))
+		return;
+
+	// Pixels whose centers fall inside; no samples means no triangle
+	int minX = std::max(0, (int)ceilf(std::min(x[0], std::min(x[1], x[2])) - 0.5f));
+	int minY = std::max(0, (int)ceilf(std::min(y[0], std::min(y[1], y[2])) - 0.5f));
+	int maxX = std::min((int)width - 1, (int)floorf(std::max(x[0], std::max(x[1], x[2])) - 0.5f));
+	int maxY = std::min((int)height - 1, (int)floorf(std::max(y[0], std::max(y[1], y[2])) - 0.5f));
+	if (minX > maxX || minY > maxY)
+		return;
+
+	Triangle tri;
+	tri.minX = minX;
+	tri.minY = minY;
+	tri.maxX = maxX;
+	tri.maxY = maxY;
+
+	// Edge i runs from corner i to the next, and is >= 0 on the inside
+	for (unsigned int i = 0; i < 3; i++)
+	{
+		unsigned int j = (i + 1) % 3;
+		float dx = x[j] - x[i];
+		float dy = y[j] - y[i];
+
+		Plane& edge = tri.edges[i];
+		edge.a = -dy;
+		edge.b = dx;
+		edge.c = dy * x[i] - dx * y[i] + (edge.a + edge.b) * 0.5f;
+
+		// Pixels exactly on a top or left edge belong to this triangle
+		tri.topLeft[i] = (dy == 0 && dx > 0) || dy < 0;
+	}
+
+	// Fits value = a * x + b * y + c through the three corners
+	float invArea = 1.0f / area;
+	auto makePlane = [&](float f0, float f1, float f2)
+	{
+		Plane plane;
+		plane.a = ((f1 - f0) * (y[2] - y[0]) - (f2 - f0) * (y[1] - y[0])) * invArea;
+		plane.b = ((f2 - f0) * (x[1] - x[0]) - (f1 - f0) * (x[2] - x[0])) * invArea;
+		plane.c = f0 - plane.a * x[0] - plane.b * y[0] + (plane.a + plane.b) * 0.5f;
+		return plane;
+	};
+
+	tri.depth = makePlane(z[0], z[1], z[2]);
+	tri.invW = makePlane(invW[0], invW[1], invW[2]);
+	for (unsigned int k = 0; k < 4; k++)
+		tri.color[k] = makePlane(a.v[4 + k] * invW[0], b.v[4 + k] * invW[1], c.v[4 + k] * invW[2]);
+
+	unsigned int index = (unsigned int)chunk.triangles.size();
+	chunk.triangles.push_back(tri);
+
+	for (unsigned int ty = minY / TileSize; ty <= maxY / TileSize; ty++)
+	{
+		for (unsigned int tx = minX / TileSize; tx <= maxX / TileSize; tx++)
+			chunk.bins[ty * tilesX + tx].push_back(index);
+	}
+}
+
+// --------------------------------------------------------
+// Every triangle binned to one tile, four pixels per step:
+// edge tests, the pass's depth test, then color divided
+// back out by 1 / w.  Returns the pixels that passed.
+// --------------------------------------------------------
+unsigned int SoftwareRasterizer::RasterizeTile(unsigned int tile, unsigned int chunkCount, DepthPass pass)
+{
+	int tileX = (int)((tile % tilesX) * TileSize);
+	int tileY = (int)((tile / tilesX) * TileSize);
+	unsigned int written = 0;
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 laneOffsets = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+	const __m128i laneIndices = _mm_set_epi32(3, 2, 1, 0);
+
+	for (unsigned int c = 0; c < chunkCount; c++)
+	{
+		const Chunk& chunk = chunks[c];
+		for (unsigned int index : chunk.bins[tile])
+		{
+			const Triangle& tri = chunk.triangles[index];
+
+			// Tiles are a multiple of four wide, so groups stay aligned
+			int x0 = std::max(tileX, tri.minX) & ~3;
+			int x1 = std::min(tileX + (int)TileSize - 1, tri.maxX);
+			int y0 = std::max(tileY, tri.minY);
+			int y1 = std::min(tileY + (int)TileSize - 1, tri.maxY);
+
+			__m128 topLeft[3];
+			__m128 edgeStep[3];
+			for (unsigned int e = 0; e < 3; e++)
+			{
+				topLeft[e] = _mm_castsi128_ps(_mm_set1_epi32(tri.topLeft[e] ? -1 : 0));
+				edgeStep[e] = _mm_set1_ps(tri.edges[e].a * 4.0f);
+			}
+			__m128i lastX = _mm_set1_epi32(x1);
+
+			for (int y = y0; y <= y1; y++)
+			{
+				float fy = (float)y;
+				__m128 xs = _mm_add_ps(_mm_set1_ps((float)x0), laneOffsets);
+
+				__m128 edges[3];
+				for (unsigned int e = 0; e < 3; e++)
+				{
+					const Plane& p = tri.edges[e];
+					edges[e] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(p.a), xs), _mm_set1_ps(p.b * fy + p.c));
+				}
+
+				uint32_t* colorRow = &colorBuffer[(size_t)y * pitch];
+				float* depthRow = &depthBuffer[(size_t)y * pitch];
+
+				for (int x = x0; x <= x1; x += 4)
+				{
+					// Inside every edge, counting top-left edges themselves
+					__m128 inside = _mm_castsi128_ps(_mm_cmplt_epi32(_mm_add_epi32(_mm_set1_epi32(x), laneIndices), _mm_add_epi32(lastX, _mm_set1_epi32(1))));
+					for (unsigned int e = 0; e < 3; e++)
+					{
+						__m128 onEdge = _mm_and_ps(_mm_cmpeq_ps(edges[e], zero), topLeft[e]);
+						inside = _mm_and_ps(inside, _mm_or_ps(_mm_cmpgt_ps(edges[e], zero), onEdge));
+						edges[e] = _mm_add_ps(edges[e], edgeStep[e]);
+					}
+
+					if (_mm_movemask_ps(inside))
+					{
+						__m128 px = _mm_add_ps(_mm_set1_ps((float)x), laneOffsets);
+						__m128 py = _mm_set1_ps(fy);
+						auto evaluate = [&](const Plane& p)
+						{
+							return _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(p.a), px), _mm_mul_ps(_mm_set1_ps(p.b), py)), _mm_set1_ps(p.c));
+						};
+
+						// Depths are evaluated the same way in every pass, so
+						// equal really does mean the same triangle won
+						__m128 depth = evaluate(tri.depth);
+						__m128 stored = _mm_load_ps(depthRow + x);
+						__m128 passed = _mm_and_ps(inside, pass == DepthPass::Equal ? _mm_cmpeq_ps(depth, stored) : _mm_cmplt_ps(depth, stored));
+
+						int passMask = _mm_movemask_ps(passed);
+						if (passMask)
+						{
+							if (pass != DepthPass::Equal)
+								_mm_store_ps(depthRow + x, _mm_or_ps(_mm_and_ps(passed, depth), _mm_andnot_ps(passed, stored)));
+
+							if (pass != DepthPass::DepthOnly)
+							{
+								__m128 w = _mm_div_ps(_mm_set1_ps(1.0f), evaluate(tri.invW));
+								__m128i color = PackColor(
+									_mm_mul_ps(evaluate(tri.color[0]), w),
+									_mm_mul_ps(evaluate(tri.color[1]), w),
+									_mm_mul_ps(evaluate(tri.color[2]), w),
+									_mm_mul_ps(evaluate(tri.color[3]), w));
+
+								__m128i passInt = _mm_castps_si128(passed);
+								__m128i old = _mm_load_si128((const __m128i*)(colorRow + x));
+								_mm_store_si128((__m128i*)(colorRow + x), _mm_or_si128(_mm_and_si128(passInt, color), _mm_andnot_si128(passInt, old)));
+							}
+
+							written += laneCounts[passMask];
+						}
+					}
+				}
+			}
+		}
+	}
+
+	return written;
+}
+
+// --------------------------------------------------------
+// Pixels in one tile whose depth is nearer than the clear
+// value, i.e. that something has been drawn over
+// --------------------------------------------------------
+unsigned int SoftwareRasterizer::CountCovered(unsigned int tile)
+{
+	unsigned int tileX = (tile % tilesX) * TileSize;
+	unsigned int tileY = (tile / tilesX) * TileSize;
+	unsigned int rows = std::min(TileSize, height - tileY);
+
+	const __m128 cleared = _mm_set1_ps(1.0f);
+	unsigned int covered = 0;
+	for (unsigned int y = 0; y < rows; y++)
+	{
+		const float* depthRow = &depthBuffer[(size_t)(tileY + y) * pitch + tileX];
+		for (unsigned int x = 0; x < TileSize; x += 4)
+			covered += laneCounts[_mm_movemask_ps(_mm_cmplt_ps(_mm_load_ps(depthRow + x), cleared))];
+	}
+	return covered;
+}
+
+const uint32_t* SoftwareRasterizer::GetPixels()
+{
+	return colorBuffer.data();
+}
+
+unsigned int SoftwareRasterizer::GetRowPitch()
+{
+	return pitch;
+}
+
+// --------------------------------------------------------
+// A plain BITMAPINFOHEADER file, written field by field so
+// this builds without any Windows headers
+// --------------------------------------------------------
+void SoftwareRasterizer::WriteBMP(FILE* file)
+{
+	unsigned int rowBytes = (width * 3 + 3) & ~3u;
+	unsigned int imageBytes = rowBytes * height;
+
+	unsigned char header[54] = {};
+	auto put16 = [&](unsigned int offset, unsigned int value)
+	{
+		header[offset] = (unsigned char)value;
+		header[offset + 1] = (unsigned char)(value >> 8);
+	};
+	auto put32 = [&](unsigned int offset, unsigned int value)
+	{
+		put16(offset, value & 0xFFFF);
+		put16(offset + 2, value >> 16);
+	};
+
+	header[0] = 'B';
+	header[1] = 'M';
+	put32(2, 54 + imageBytes);	// File size
+	put32(10, 54);				// Pixel data offset
+	put32(14, 40);				// Info header size
+	put32(18, width);
+	put32(22, height);			// Positive, so rows go bottom-up
+	put16(26, 1);				// Planes
+	put16(28, 24);				// Bits per pixel
+	put32(34, imageBytes);
+	put32(38, 2835);			// 72 DPI
+	put32(42, 2835);
+	fwrite(header, 1, sizeof(header), file);
+
+	std::vector<unsigned char> row(rowBytes, 0);
+	for (unsigned int y = height; y-- > 0;)
+	{
+		const uint32_t* pixels = &colorBuffer[(size_t)y * pitch];
+		for (unsigned int x = 0; x < width; x++)
+		{
+			row[x * 3 + 0] = (unsigned char)(pixels[x] >> 16);	// B
+			row[x * 3 + 1] = (unsigned char)(pixels[x] >> 8);	// G
+			row[x * 3 + 2] = (unsigned char)(pixels[x]);		// R
+		}
+		fwrite(row.data(), 1, rowBytes, file);
+	}
+}
+
+SoftwareRasterizer::Stats SoftwareRasterizer::GetStats()
+{
+	return stats;
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstdio>
+
+#include "InstanceBuffer.h"
+#include "CommandBackend.h"
+
+// --------------------------------------------------------
+// Draws frames on the CPU the way VertexShader.hlsl and
+// PixelShader.hlsl do on the GPU, for golden images and
+// machines without one
+//
+// - Each vertex goes through its instance's world * view *
+//   projection, and its color is multiplied by the tint
+// - Triangles are clipped to the near and far planes, back
+//   faces are culled (clockwise is front, as in the default
+//   D3D11 rasterizer state) and the rest are binned into
+//   64x64 pixel tiles
+// - Tiles are rasterized in parallel on the job system,
+//   four pixels at a time with SSE edge functions, with a
+//   less-than depth test and perspective-correct color
+// - Every tile sees its triangles in draw order, so the
+//   image never depends on the thread count
+// - A draw can also be a depth prepass, or the pass after
+//   one that only shades depths equal to what's stored, as
+//   D3D11 would with DEPTH_FUNC_EQUAL.  Shaded pixels over
+//   covered ones is the frame's overdraw.
+// --------------------------------------------------------
+class SoftwareRasterizer
+{
+public:
+	SoftwareRasterizer(unsigned int width, unsigned int height);
+	SoftwareRasterizer(const SoftwareRasterizer&) = delete; // Remove copy constructor
+	SoftwareRasterizer& operator=(const SoftwareRasterizer&) = delete; // Remove copy-assignment operator
+
+	static constexpr unsigned int TileSize = 64;
+
+	void Resize(unsigned int width, unsigned int height);
+	unsigned int GetWidth();
+	unsigned int GetHeight();
+
+	// Keeps its own copy of every instance, updated from the
+	// same captured ranges as the GPU buffer.  The DrawData
+	// is used in place, so the update must outlive Draw().
+	void Upload(const InstanceUpdate& update);
+
+	// How a Draw() tests and writes depth
+	enum class DepthPass
+	{
+		Full,		// Less-than, writes depth and color
+		DepthOnly,	// Less-than, writes depth alone
+		Equal		// Shades what a DepthOnly pass left nearest; writes color alone
+	};
+
+	void Clear(const float color[4]);
+	// draws[i] finds its WVP in the update's DrawData at
+	// drawOffset + i, as the vertex shader does
+	void Draw(const DrawItem* draws, unsigned int count, unsigned int drawOffset, DepthPass pass = DepthPass::Full);
+
+	// RGBA8, one row every GetRowPitch() pixels
+	const uint32_t* GetPixels();
+	unsigned int GetRowPitch();
+
+	// 24-bit, bottom-up, as any image viewer expects
+	void WriteBMP(FILE* file);
+
+	// From the most recent Draw()
+	struct Stats
+	{
+		unsigned int triangles;		// Submitted
+		unsigned int visible;		// Survived clipping and culling
+		unsigned int binned;		// Tile references
+		unsigned int pixels;		// Passed the depth test
+		unsigned int shaded;		// Color written, so ran the pixel shader
+		unsigned int covered;		// Depth written at least once since Clear()
+	};
+	Stats GetStats();
+
+private:
+	// Anything linear in screen space: a * x + b * y + c
+	struct Plane
+	{
+		float a, b, c;
+	};
+
+	struct Triangle
+	{
+		Plane edges[3];		// Inside where all three are >= 0
+		bool topLeft[3];	// Whether pixels exactly on the edge count
+		Plane depth;
+		Plane invW;			// 1 / w, and color / w, for perspective correction
+		Plane color[4];
+		int minX, minY, maxX, maxY;
+	};
+
+	// What one job turns a contiguous run of draws into
+	struct Chunk
+	{
+		std::vector<Triangle> triangles;
+		std::vector<std::vector<unsigned int>> bins;	// Triangle indices per tile
+		unsigned int submitted = 0;
+	};
+
+	// Clip space position, then color
+	struct ClipVertex
+	{
+		float v[8];
+	};
+
+	void ProcessDraws(Chunk& chunk, const DrawItem* draws, unsigned int count, unsigned int drawOffset);
+	void ClipAndSetUp(Chunk& chunk, const ClipVertex* vertices);
+	void SetUp(Chunk& chunk, const ClipVertex& a, const ClipVertex& b, const ClipVertex& c);
+	unsigned int RasterizeTile(unsigned int tile, unsigned int chunkCount, DepthPass pass);
+	unsigned int CountCovered(unsigned int tile);
+
+	unsigned int width = 0;
+	unsigned int height = 0;
+	unsigned int tilesX = 0;
+	unsigned int tilesY = 0;
+	unsigned int pitch = 0;		// Whole tiles wide, so no row ever runs off the end
+
+	std::vector<uint32_t> colorBuffer;
+	std::vector<float> depthBuffer;
+
+	std::vector<InstanceData> instances;
+	const DrawData* drawData = 0;
+	unsigned int drawDataCount = 0;
+
+	std::vector<Chunk> chunks;
+	std::vector<unsigned int> tilePixels;
+	std::vector<unsigned int> tileCovered;
+	Stats stats = {};
+};
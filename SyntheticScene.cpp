@@ -0,0 +1,170 @@
+#include "SyntheticScene.h"
+
+#include <cmath>
+
+using namespace DirectX;
+
+namespace SyntheticScene
+{
+	// Annonymous namespace to hold helpers
+	// only accessible in this file
+	namespace
+	{
+		const char* const meshNames[MaxMeshes] =
+		{
+			"Synthetic 0", "Synthetic 1", "Synthetic 2", "Synthetic 3",
+			"Synthetic 4", "Synthetic 5", "Synthetic 6", "Synthetic 7",
+			"Synthetic 8", "Synthetic 9", "Synthetic 10", "Synthetic 11",
+			"Synthetic 12", "Synthetic 13", "Synthetic 14", "Synthetic 15"
+		};
+
+		// Same generator as the micro-benchmarks, but with its
+		// state passed along so specs never affect each other
+		float RandomFloat(unsigned int& state, float minValue, float maxValue)
+		{
+			state = state * 1664525u + 1013904223u;
+			return minValue + (state >> 8) * (1.0f / 16777216.0f) * (maxValue - minValue);
+		}
+
+		// Roughly normal, in -3 to 3
+		float RandomSpread(unsigned int& state)
+		{
+			return RandomFloat(state, -1, 1) + RandomFloat(state, -1, 1) + RandomFloat(state, -1, 1);
+		}
+	}
+}
+
+const char* SyntheticScene::GetDistributionName(Distribution distribution)
+{
+	return distribution == Distribution::Clustered ? "clustered" : "uniform";
+}
+
+const char* SyntheticScene::GetMeshName(unsigned int mesh)
+{
+	return meshNames[mesh % MaxMeshes];
+}
+
+// --------------------------------------------------------
+// A unit-diameter sphere with 6 + 2 * mesh slices and half
+// as many stacks, clockwise from outside (D3D's front face)
+// and shaded top to bottom in a color picked by the index
+// --------------------------------------------------------
+void SyntheticScene::BuildMesh(unsigned int mesh, std::vector<Vertex>& outVertices, std::vector<unsigned int>& outIndices)
+{
+	unsigned int slices = 6 + 2 * (mesh % MaxMeshes);
+	unsigned int stacks = slices / 2;
+
+	unsigned int state = 1000 + mesh;
+	XMFLOAT4 color(RandomFloat(state, 0.2f, 1.0f), RandomFloat(state, 0.2f, 1.0f), RandomFloat(state, 0.2f, 1.0f), 1.0f);
+
+	outVertices.clear();
+	outIndices.clear();
+	for (unsigned int r = 0; r <= stacks; r++)
+	{
+		float theta = XM_PI * r / stacks;
+		float shade = 1.0f - 0.6f * r / stacks;
+		for (unsigned int s = 0; s <= slices; s++)
+		{
+			float phi = XM_2PI * s / slices;
+			Vertex v;
+			v.Position = XMFLOAT3(0.5f * sinf(theta) * cosf(phi), 0.5f * cosf(theta), 0.5f * sinf(theta) * sinf(phi));
+			v.Color = XMFLOAT4(color.x * shade, color.y * shade, color.z * shade, 1.0f);
+			outVertices.push_back(v);
+		}
+	}
+
+	// Seen from outside, r goes down and s goes right
+	for (unsigned int r = 0; r < stacks; r++)
+	{
+		for (unsigned int s = 0; s < slices; s++)
+		{
+			unsigned int topLeft = r * (slices + 1) + s;
+			unsigned int topRight = topLeft + 1;
+			unsigned int bottomLeft = topLeft + slices + 1;
+			unsigned int bottomRight = bottomLeft + 1;
+
+			// The poles would only add empty triangles
+			if (r > 0)
+			{
+				outIndices.push_back(topLeft);
+				outIndices.push_back(topRight);
+				outIndices.push_back(bottomRight);
+			}
+			if (r < stacks - 1)
+			{
+				outIndices.push_back(topLeft);
+				outIndices.push_back(bottomRight);
+				outIndices.push_back(bottomLeft);
+			}
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Entities fill a slab extent wide and half that tall,
+// either evenly or bunched around random cluster centers
+// --------------------------------------------------------
+void SyntheticScene::Place(const Spec& spec, std::vector<Placement>& outPlacements)
+{
+	unsigned int state = spec.seed;
+	unsigned int meshCount = spec.meshCount < 1 ? 1 : (spec.meshCount > MaxMeshes ? MaxMeshes : spec.meshCount);
+	float height = spec.extent * 0.25f;
+
+	std::vector<XMFLOAT3> clusters;
+	if (spec.distribution == Distribution::Clustered)
+	{
+		unsigned int clusterCount = spec.clusterCount > 0 ? spec.clusterCount : 1;
+		for (unsigned int c = 0; c < clusterCount; c++)
+		{
+			clusters.push_back(XMFLOAT3(
+				RandomFloat(state, -spec.extent, spec.extent),
+				RandomFloat(state, -height, height),
+				RandomFloat(state, -spec.extent, spec.extent)));
+		}
+	}
+	float clusterRadius = spec.extent * 0.03f;
+
+	outPlacements.resize(spec.entityCount);
+	for (unsigned int i = 0; i < spec.entityCount; i++)
+	{
+		Placement& p = outPlacements[i];
+		if (clusters.empty())
+		{
+			p.position.x = RandomFloat(state, -spec.extent, spec.extent);
+			p.position.y = RandomFloat(state, -height, height);
+			p.position.z = RandomFloat(state, -spec.extent, spec.extent);
+		}
+		else
+		{
+			const XMFLOAT3& center = clusters[i % clusters.size()];
+			p.position.x = center.x + RandomSpread(state) * clusterRadius;
+			p.position.y = center.y + RandomSpread(state) * clusterRadius;
+			p.position.z = center.z + RandomSpread(state) * clusterRadius;
+		}
+
+		p.rotation.x = RandomFloat(state, -XM_PI, XM_PI);
+		p.rotation.y = RandomFloat(state, -XM_PI, XM_PI);
+		p.rotation.z = RandomFloat(state, -XM_PI, XM_PI);
+		p.scale = RandomFloat(state, 0.5f, 3.0f);
+		p.mesh = i % meshCount;
+		p.dynamic = RandomFloat(state, 0, 1) < spec.dynamicRatio;
+	}
+}
+
+// --------------------------------------------------------
+// A lap weaving in and out through the scene, bobbing up
+// and down as it goes
+// --------------------------------------------------------
+void SyntheticScene::BuildCameraPath(const Spec& spec, CameraPath& outPath)
+{
+	const unsigned int pointCount = 8;
+
+	outPath.Clear();
+	for (unsigned int i = 0; i < pointCount; i++)
+	{
+		float angle = XM_2PI * i / pointCount;
+		float radius = spec.extent * (i % 2 == 0 ? 0.8f : 0.35f);
+		float y = spec.extent * 0.1f * sinf(angle * 3.0f);
+		outPath.AddPoint(XMFLOAT3(radius * cosf(angle), y, radius * sinf(angle)));
+	}
+}
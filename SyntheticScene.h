@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <DirectXMath.h>
+
+#include "Vertex.h"
+#include "CameraPath.h"
+
+// --------------------------------------------------------
+// Generated scenes for benchmarking: entityCount entities
+// spread over meshCount meshes, some fraction of them
+// spinning, scattered evenly or in clusters
+//
+// - Everything comes from the spec and its seed, so the
+//   same spec always builds exactly the same scene
+// - Meshes are lat-long spheres of increasing detail, so a
+//   scene with more meshes has a wider range of draw sizes
+// - Each spec has a camera path looping through the scene
+// - No Windows or DirectX headers beyond DirectXMath are
+//   used; GameCore::LoadSyntheticScene() does the spawning
+// --------------------------------------------------------
+namespace SyntheticScene
+{
+	enum class Distribution
+	{
+		Uniform,
+		Clustered
+	};
+
+	struct Spec
+	{
+		std::string name;
+		unsigned int entityCount = 10000;
+		unsigned int meshCount = 8;
+		float dynamicRatio = 0.1f;		// Fraction of entities that spin
+		Distribution distribution = Distribution::Uniform;
+		unsigned int clusterCount = 16;
+		float extent = 200.0f;			// Half the width of the area entities go in
+		unsigned int seed = 1;
+	};
+
+	static const unsigned int MaxMeshes = 16;
+
+	// Where one entity goes and what it looks like
+	struct Placement
+	{
+		DirectX::XMFLOAT3 position;
+		DirectX::XMFLOAT3 rotation;		// Pitch, yaw, roll in radians
+		float scale;
+		unsigned int mesh;
+		bool dynamic;
+	};
+
+	const char* GetDistributionName(Distribution distribution);
+
+	// Names live forever, as meshes keep the pointer
+	const char* GetMeshName(unsigned int mesh);
+	void BuildMesh(unsigned int mesh, std::vector<Vertex>& outVertices, std::vector<unsigned int>& outIndices);
+
+	void Place(const Spec& spec, std::vector<Placement>& outPlacements);
+	void BuildCameraPath(const Spec& spec, CameraPath& outPath);
+}
@@ -0,0 +1,432 @@
+#include "Systems.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#include <cstring>
+#include <emmintrin.h>
+
+using namespace DirectX;
+
+namespace Systems
+{
+	// Annonymous namespace to hold variables
+	// only accessible in this file
+	namespace
+	{
+		// Rows per job - big enough to dwarf the cost of queueing one
+		const unsigned int transformBatch = 1024;
+		const unsigned int cullBatch = 2048;
+
+		// Fewest draws worth a deferred context of their own
+		const unsigned int drawBatchSize = 256;
+
+		// Per-batch packet lists, kept between frames so their
+		// memory gets reused
+		std::vector<std::vector<DrawPacket>> batchPackets;
+		std::vector<SharedPackets> batchShared;
+		std::vector<std::vector<MovingInstance>> batchMoving;
+		std::vector<DrawPacket> sortScratch;
+
+		// Radix sort digits: three of 11 bits cover a float
+		const unsigned int radixBits = 11;
+		const unsigned int radixSize = 1 << radixBits;
+		const unsigned int radixPasses = 3;
+		unsigned int radixCounts[radixPasses][radixSize];
+
+		// Float bits as an unsigned int that sorts the same way:
+		// negatives have every bit flipped, positives just the sign
+		uint32_t SortableDepth(float depth)
+		{
+			uint32_t bits;
+			memcpy(&bits, &depth, sizeof(bits));
+			return bits ^ ((uint32_t)-(int32_t)(bits >> 31) | 0x80000000u);
+		}
+
+		bool SamePose(const TransformPose& a, const TransformPose& b)
+		{
+			return memcmp(&a, &b, sizeof(TransformPose)) == 0;
+		}
+	}
+}
+
+// --------------------------------------------------------
+// The "before" half of what gets interpolated
+// --------------------------------------------------------
+void Systems::SavePoses(Scene& scene)
+{
+	PROFILE_SCOPE("SavePoses");
+	scene.ForEach(ComponentTransform, [&](Archetype& a)
+	{
+		JobSystem::ParallelFor((unsigned int)a.Count(), transformBatch, [&](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int i = begin; i < end; i++)
+				a.previousPoses[i] = a.transforms[i].GetPose();
+		});
+	});
+}
+
+// --------------------------------------------------------
+// Spins flagged entities (the old "rotate entity 0" logic)
+// --------------------------------------------------------
+void Systems::Spin(Scene& scene, float deltaTime)
+{
+	PROFILE_SCOPE("Spin");
+	scene.ForEach(ComponentTransform | ComponentFlags, [&](Archetype& a)
+	{
+		JobSystem::ParallelFor((unsigned int)a.Count(), transformBatch, [&](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int i = begin; i < end; i++)
+			{
+				if (a.flags[i] & EntitySpin)
+					a.transforms[i].Rotate(0, 0, deltaTime);
+			}
+		});
+	});
+}
+
+// --------------------------------------------------------
+// Transforms each local box by the world matrix: the
+// center moves, and the extents grow by the absolute
+// value of the rotation/scale part
+// --------------------------------------------------------
+void Systems::UpdateBounds(Scene& scene)
+{
+	PROFILE_SCOPE("UpdateBounds");
+	scene.ForEach(ComponentTransform | ComponentBounds, [&](Archetype& a)
+	{
+		JobSystem::ParallelFor((unsigned int)a.Count(), transformBatch, [&](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int i = begin; i < end; i++)
+			{
+				XMVECTOR localMin = XMLoadFloat3(&a.localBounds[i].min);
+				XMVECTOR localMax = XMLoadFloat3(&a.localBounds[i].max);
+				XMVECTOR center = XMVectorScale(XMVectorAdd(localMin, localMax), 0.5f);
+				XMVECTOR extent = XMVectorScale(XMVectorSubtract(localMax, localMin), 0.5f);
+
+				XMFLOAT4X4 world = a.transforms[i].GetWorldMatrix();
+				XMMATRIX w = XMLoadFloat4x4(&world);
+
+				XMVECTOR worldCenter = XMVector3Transform(center, w);
+				XMVECTOR worldExtent = XMVectorAdd(XMVectorAdd(
+					XMVectorMultiply(XMVectorSplatX(extent), XMVectorAbs(w.r[0])),
+					XMVectorMultiply(XMVectorSplatY(extent), XMVectorAbs(w.r[1]))),
+					XMVectorMultiply(XMVectorSplatZ(extent), XMVectorAbs(w.r[2])));
+
+				XMStoreFloat3(&a.bounds[i].min, XMVectorSubtract(worldCenter, worldExtent));
+				XMStoreFloat3(&a.bounds[i].max, XMVectorAdd(worldCenter, worldExtent));
+			}
+		});
+	});
+}
+
+// --------------------------------------------------------
+// Each batch culls into its own list, and the lists are
+// joined in batch order afterwards, so the result is the
+// same no matter which thread did what
+// --------------------------------------------------------
+void Systems::BuildDrawPackets(Scene& scene, const Frustum& frustum, const XMFLOAT4X4& view, std::vector<DrawPacket>& outPackets)
+{
+	PROFILE_SCOPE("BuildDrawPackets");
+	outPackets.clear();
+
+	// The third column of the view matrix gives view space z
+	XMVECTOR forward = XMVectorSet(view._13, view._23, view._33, 0.0f);
+	float offset = view._43;
+
+	scene.ForEach(ComponentMesh | ComponentBounds | ComponentFlags | ComponentInstance, [&](Archetype& a)
+	{
+		unsigned int count = (unsigned int)a.Count();
+		unsigned int batches = (count + cullBatch - 1) / cullBatch;
+		if (batchPackets.size() < batches)
+			batchPackets.resize(batches);
+
+		JobSystem::ParallelFor(count, cullBatch, [&](unsigned int begin, unsigned int end)
+		{
+			std::vector<DrawPacket>& packets = batchPackets[begin / cullBatch];
+			packets.clear();
+
+			for (unsigned int i = begin; i < end; i++)
+			{
+				if (!(a.flags[i] & EntityVisible) || !frustum.Intersects(a.bounds[i]))
+					continue;
+
+				XMVECTOR center = XMVectorScale(XMVectorAdd(XMLoadFloat3(&a.bounds[i].min), XMLoadFloat3(&a.bounds[i].max)), 0.5f);
+				float depth = XMVectorGetX(XMVector3Dot(center, forward)) + offset;
+				packets.push_back({ a.meshes[i], a.instanceSlots[i], depth });
+			}
+		});
+
+		for (unsigned int b = 0; b < batches; b++)
+			outPackets.insert(outPackets.end(), batchPackets[b].begin(), batchPackets[b].end());
+	});
+}
+
+void Systems::SharedPackets::Clear()
+{
+	packets.clear();
+	centers.clear();
+	viewMasks.clear();
+}
+
+// --------------------------------------------------------
+// Like BuildDrawPackets(), but each entity is tested once
+// against every view, and keeps which views it's in
+// --------------------------------------------------------
+void Systems::CullViews(Scene& scene, const FrustumSet& frustums, SharedPackets& outShared)
+{
+	PROFILE_SCOPE("CullViews");
+	outShared.Clear();
+
+	scene.ForEach(ComponentMesh | ComponentBounds | ComponentFlags | ComponentInstance, [&](Archetype& a)
+	{
+		unsigned int count = (unsigned int)a.Count();
+		unsigned int batches = (count + cullBatch - 1) / cullBatch;
+		if (batchShared.size() < batches)
+			batchShared.resize(batches);
+
+		JobSystem::ParallelFor(count, cullBatch, [&](unsigned int begin, unsigned int end)
+		{
+			SharedPackets& shared = batchShared[begin / cullBatch];
+			shared.Clear();
+
+			for (unsigned int i = begin; i < end; i++)
+			{
+				if (!(a.flags[i] & EntityVisible))
+					continue;
+
+				unsigned int mask = frustums.Intersects(a.bounds[i]);
+				if (mask == 0)
+					continue;
+
+				XMFLOAT3 center;
+				XMStoreFloat3(&center, XMVectorScale(XMVectorAdd(XMLoadFloat3(&a.bounds[i].min), XMLoadFloat3(&a.bounds[i].max)), 0.5f));
+				shared.packets.push_back({ a.meshes[i], a.instanceSlots[i], 0.0f });
+				shared.centers.push_back(center);
+				shared.viewMasks.push_back((uint8_t)mask);
+			}
+		});
+
+		for (unsigned int b = 0; b < batches; b++)
+		{
+			const SharedPackets& shared = batchShared[b];
+			outShared.packets.insert(outShared.packets.end(), shared.packets.begin(), shared.packets.end());
+			outShared.centers.insert(outShared.centers.end(), shared.centers.begin(), shared.centers.end());
+			outShared.viewMasks.insert(outShared.viewMasks.end(), shared.viewMasks.begin(), shared.viewMasks.end());
+		}
+	});
+
+	// So FilterView() can always read whole blocks of 16
+	outShared.viewMasks.resize((outShared.viewMasks.size() + 15) / 16 * 16, 0);
+}
+
+// --------------------------------------------------------
+// Blocks with none of this view's packets cost a single
+// compare; the padding's masks are zero, so never match
+// --------------------------------------------------------
+void Systems::FilterView(const SharedPackets& shared, unsigned int view, const XMFLOAT4X4& viewMatrix, std::vector<DrawPacket>& outPackets)
+{
+	PROFILE_SCOPE("FilterView");
+	outPackets.clear();
+
+	XMVECTOR forward = XMVectorSet(viewMatrix._13, viewMatrix._23, viewMatrix._33, 0.0f);
+	float offset = viewMatrix._43;
+
+	const __m128i bit = _mm_set1_epi8((char)(1u << view));
+	for (size_t i = 0; i < shared.viewMasks.size(); i += 16)
+	{
+		__m128i masks = _mm_loadu_si128((const __m128i*)&shared.viewMasks[i]);
+		unsigned int hits = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(masks, bit), bit));
+
+		for (size_t lane = 0; hits; lane++, hits >>= 1)
+		{
+			if (!(hits & 1))
+				continue;
+
+			DrawPacket packet = shared.packets[i + lane];
+			packet.viewDepth = XMVectorGetX(XMVector3Dot(XMLoadFloat3(&shared.centers[i + lane]), forward)) + offset;
+			outPackets.push_back(packet);
+		}
+	}
+}
+
+// --------------------------------------------------------
+// A least-significant-digit radix sort on the depth's bits:
+// linear in the packet count, stable, and with no heap
+// allocations once the scratch list has grown.  Digits that
+// every packet shares are skipped.
+// --------------------------------------------------------
+void Systems::SortFrontToBack(std::vector<DrawPacket>& packets)
+{
+	PROFILE_SCOPE("SortFrontToBack");
+	if (packets.size() < 2)
+		return;
+
+	memset(radixCounts, 0, sizeof(radixCounts));
+	for (const DrawPacket& p : packets)
+	{
+		uint32_t key = SortableDepth(p.viewDepth);
+		for (unsigned int pass = 0; pass < radixPasses; pass++)
+			radixCounts[pass][(key >> (pass * radixBits)) & (radixSize - 1)]++;
+	}
+
+	sortScratch.resize(packets.size());
+	std::vector<DrawPacket>* from = &packets;
+	std::vector<DrawPacket>* to = &sortScratch;
+	for (unsigned int pass = 0; pass < radixPasses; pass++)
+	{
+		unsigned int shift = pass * radixBits;
+		unsigned int* count = radixCounts[pass];
+		if (count[(SortableDepth((*from)[0].viewDepth) >> shift) & (radixSize - 1)] == packets.size())
+			continue;
+
+		// Counts become each digit's first output index
+		unsigned int next = 0;
+		for (unsigned int d = 0; d < radixSize; d++)
+		{
+			unsigned int c = count[d];
+			count[d] = next;
+			next += c;
+		}
+
+		for (const DrawPacket& p : *from)
+			(*to)[count[(SortableDepth(p.viewDepth) >> shift) & (radixSize - 1)]++] = p;
+		std::swap(from, to);
+	}
+
+	if (from != &packets)
+		packets.swap(sortScratch);
+}
+
+// --------------------------------------------------------
+// Only slots whose Transform (or tint) changed are touched;
+// each is looked up through its owner
+// --------------------------------------------------------
+void Systems::WriteInstances(Scene& scene, InstanceBuffer& instances, const std::vector<EntityId>& owners)
+{
+	PROFILE_SCOPE("WriteInstances");
+	for (const DirtyRange& range : instances.GetDirtyRanges())
+	{
+		for (unsigned int slot = range.begin; slot < range.end; slot++)
+		{
+			EntityId id = slot < owners.size() ? owners[slot] : InvalidEntity;
+			Transform* transform = scene.GetTransform(id);
+			XMFLOAT4* tint = scene.GetTint(id);
+			if (!transform || !tint)
+				continue;
+
+			InstanceData* instance = instances.GetInstance(slot);
+			instance->world = transform->GetWorldMatrix();
+			instance->colorTint = *tint;
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Compares each pose with the one saved at the start of
+// the step.  Batches fill their own lists, joined in batch
+// order, like BuildDrawPackets().
+// --------------------------------------------------------
+void Systems::FindMoving(Scene& scene, InstanceBuffer& instances, std::vector<MovingInstance>& moving)
+{
+	PROFILE_SCOPE("FindMoving");
+	ReleaseMoving(instances, moving);
+
+	scene.ForEach(ComponentTransform | ComponentInstance, [&](Archetype& a)
+	{
+		unsigned int count = (unsigned int)a.Count();
+		unsigned int batches = (count + transformBatch - 1) / transformBatch;
+		if (batchMoving.size() < batches)
+			batchMoving.resize(batches);
+
+		JobSystem::ParallelFor(count, transformBatch, [&](unsigned int begin, unsigned int end)
+		{
+			std::vector<MovingInstance>& found = batchMoving[begin / transformBatch];
+			found.clear();
+
+			for (unsigned int i = begin; i < end; i++)
+			{
+				TransformPose pose = a.transforms[i].GetPose();
+				if (!SamePose(pose, a.previousPoses[i]))
+					found.push_back({ a.entities[i], a.instanceSlots[i], a.previousPoses[i], pose });
+			}
+		});
+
+		for (unsigned int b = 0; b < batches; b++)
+			moving.insert(moving.end(), batchMoving[b].begin(), batchMoving[b].end());
+	});
+}
+
+void Systems::ReleaseMoving(InstanceBuffer& instances, std::vector<MovingInstance>& moving)
+{
+	PROFILE_SCOPE("ReleaseMoving");
+	DirtyRangeTracker* tracker = instances.GetTracker();
+	for (const MovingInstance& m : moving)
+		tracker->MarkDirty(m.instanceSlot);
+	moving.clear();
+}
+
+// --------------------------------------------------------
+// Straight into the shadow copy; marking the slots dirty
+// gets them uploaded with everything else
+// --------------------------------------------------------
+void Systems::Interpolate(const std::vector<MovingInstance>& moving, const std::vector<EntityId>& owners, float alpha, InstanceBuffer& instances)
+{
+	PROFILE_SCOPE("Interpolate");
+	DirtyRangeTracker* tracker = instances.GetTracker();
+
+	JobSystem::ParallelFor((unsigned int)moving.size(), transformBatch, [&](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int i = begin; i < end; i++)
+		{
+			const MovingInstance& m = moving[i];
+
+			// Destroyed since the step (and maybe the slot reused)?
+			if (m.instanceSlot >= owners.size() || owners[m.instanceSlot] != m.id)
+				continue;
+
+			TransformPose pose = Transform::Lerp(m.from, m.to, alpha);
+			XMStoreFloat4x4(&instances.GetInstance(m.instanceSlot)->world, Transform::BuildWorldMatrix(pose));
+			tracker->MarkDirty(m.instanceSlot);
+		}
+	});
+}
+
+// --------------------------------------------------------
+// Runs on the simulation side, so that whoever records the
+// draws never needs the mesh slot map
+// --------------------------------------------------------
+unsigned int Systems::ResolveDraws(const std::vector<DrawPacket>& packets, SlotMap<Mesh>& meshes, DrawItem* outDraws)
+{
+	PROFILE_SCOPE("ResolveDraws");
+	unsigned int count = 0;
+	for (const DrawPacket& packet : packets)
+	{
+		// A mesh that was removed leaves a stale handle, which just doesn't draw
+		Mesh* mesh = meshes.Get(packet.mesh);
+		if (mesh)
+			outDraws[count++] = mesh->GetDrawItem(packet.instanceSlot);
+	}
+	return count;
+}
+
+// --------------------------------------------------------
+// WVP, slot, world matrix and tint are already on the GPU,
+// so all a draw needs is its position in the list (via the
+// draw id stream), which finds its DrawData
+// --------------------------------------------------------
+unsigned int Systems::Draw(const DrawItem* draws, unsigned int count, CommandBackend& backend, bool positionsOnly)
+{
+	PROFILE_SCOPE("Draw");
+	return CommandRecording::Record(backend, count, drawBatchSize,
+		[&](CommandContext& context, unsigned int begin, unsigned int end)
+		{
+			for (unsigned int i = begin; i < end; i++)
+			{
+				if (positionsOnly)
+					context.SetGeometry(draws[i].positionBuffer, sizeof(XMFLOAT3), draws[i].indexBuffer);
+				else
+					context.SetGeometry(draws[i].vertexBuffer, draws[i].vertexStride, draws[i].indexBuffer);
+				context.DrawIndexedInstanced(draws[i].indexCount, 1, i);
+			}
+		});
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <vector>
+#include "Scene.h"
+#include "InstanceBuffer.h"
+#include "Mesh.h"
+#include "Frustum.h"
+#include "CommandBackend.h"
+
+// --------------------------------------------------------
+// Per-frame work over the scene.  Each system asks the
+// scene for the archetypes that have the components it
+// needs and walks their columns front to back, split into
+// batches across the job system's threads.
+// --------------------------------------------------------
+namespace Systems
+{
+	// Everything needed to draw one visible entity
+	struct DrawPacket
+	{
+		MeshHandle mesh;
+		unsigned int instanceSlot;
+		float viewDepth;	// Of its bounds' center, for sorting
+	};
+
+	// What survived culling for at least one of several
+	// views: viewMasks[i] has bit v set if packet i is in
+	// view v's frustum.  Depths are left for each view's
+	// FilterView() to work out.
+	struct SharedPackets
+	{
+		std::vector<DrawPacket> packets;
+		std::vector<DirectX::XMFLOAT3> centers;	// Of each packet's bounds
+		std::vector<uint8_t> viewMasks;			// Zero-padded to a multiple of 16
+
+		void Clear();
+	};
+
+	// An instance that moved during the last simulation step,
+	// with its pose before and after
+	struct MovingInstance
+	{
+		EntityId id;
+		unsigned int instanceSlot;
+		TransformPose from;
+		TransformPose to;
+	};
+
+	// Remembers every transform's pose; call at the start of
+	// each simulation step
+	void SavePoses(Scene& scene);
+
+	// Rotates every entity flagged EntitySpin around Z
+	void Spin(Scene& scene, float deltaTime);
+
+	// World space bounds from each entity's local bounds
+	void UpdateBounds(Scene& scene);
+
+	// Frustum culls every visible entity and lists the
+	// survivors, in scene order, each with its depth along
+	// the view's forward axis
+	void BuildDrawPackets(Scene& scene, const Frustum& frustum, const DirectX::XMFLOAT4X4& view, std::vector<DrawPacket>& outPackets);
+
+	// Culls every visible entity against up to four views'
+	// frustums in a single pass (one SSE lane per view), and
+	// lists whatever at least one view can see, in scene order
+	void CullViews(Scene& scene, const FrustumSet& frustums, SharedPackets& outShared);
+
+	// One view's packets out of the shared list, found by
+	// checking its bit in sixteen masks at a time, each with
+	// its depth along this view's forward axis
+	void FilterView(const SharedPackets& shared, unsigned int view, const DirectX::XMFLOAT4X4& viewMatrix, std::vector<DrawPacket>& outPackets);
+
+	// Reorders packets nearest first, so opaque draws fail the
+	// depth test behind what's already drawn rather than
+	// shading over it.  Equal depths keep their order.
+	void SortFrontToBack(std::vector<DrawPacket>& packets);
+
+	// Refreshes the shadow copy of every dirty instance slot;
+	// owners maps each slot back to its entity
+	void WriteInstances(Scene& scene, InstanceBuffer& instances, const std::vector<EntityId>& owners);
+
+	// Lists every instance whose pose changed over the last
+	// step, after releasing the old list
+	void FindMoving(Scene& scene, InstanceBuffer& instances, std::vector<MovingInstance>& moving);
+
+	// Flags every listed slot dirty, so each gets its exact
+	// world matrix back, and empties the list
+	void ReleaseMoving(InstanceBuffer& instances, std::vector<MovingInstance>& moving);
+
+	// Overwrites each moving instance's world matrix with one
+	// alpha of the way from its old pose to its new one.  Call
+	// after WriteInstances().
+	void Interpolate(const std::vector<MovingInstance>& moving, const std::vector<EntityId>& owners, float alpha, InstanceBuffer& instances);
+
+	// Looks up each packet's mesh and writes out the draw,
+	// skipping stale handles; returns how many were written
+	unsigned int ResolveDraws(const std::vector<DrawPacket>& packets, SlotMap<Mesh>& meshes, DrawItem* outDraws);
+
+	// Records the draws across the job system's threads and
+	// submits them in order; returns how many chunks the
+	// draws were split into.  positionsOnly draws from each
+	// mesh's position stream, for depth-only passes.
+	unsigned int Draw(const DrawItem* draws, unsigned int count, CommandBackend& backend, bool positionsOnly = false);
+}
@@ -0,0 +1,117 @@
+#include "Test.h"
+#include "AllocationTracker.h"
+
+// Annonymous namespace to hold helpers
+// only accessible in this file
+namespace
+{
+	// Somewhere to put allocations, so none of them can be
+	// optimized away
+	void* volatile sink = 0;
+
+	// Through the replaced global operator new, not Allocate()
+	char* NewBytes(size_t size)
+	{
+		char* bytes = new char[size];
+		sink = bytes;
+		return bytes;
+	}
+}
+
+TEST(AllocationTracker_CountsPerTag)
+{
+	unsigned int a = AllocationTracker::RegisterTag("Test A");
+	unsigned int b = AllocationTracker::RegisterTag("Test B");
+	CHECK(a != 0 && b != 0 && a != b);
+	CHECK_EQUAL(AllocationTracker::RegisterTag("Test A"), a);
+	CHECK(AllocationTracker::GetTagCount() > b);
+
+	AllocationTracker::Counts startA = AllocationTracker::GetTotal(a);
+	AllocationTracker::Counts startB = AllocationTracker::GetTotal(b);
+	AllocationTracker::TagMemory memoryA = AllocationTracker::GetMemory(a);
+	AllocationTracker::TagMemory memoryB = AllocationTracker::GetMemory(b);
+
+	char* first = 0;
+	char* inner = 0;
+	char* second = 0;
+	{
+		AllocationTracker::Scope scopeA(a);
+		first = NewBytes(100);
+		{
+			// The innermost scope gets it
+			AllocationTracker::Scope scopeB(b);
+			inner = NewBytes(40);
+		}
+		second = NewBytes(28);
+	}
+
+	CHECK_EQUAL(AllocationTracker::GetTotal(a).allocations - startA.allocations, 2ull);
+	CHECK_EQUAL(AllocationTracker::GetTotal(a).bytes - startA.bytes, 128ull);
+	CHECK_EQUAL(AllocationTracker::GetTotal(b).allocations - startB.allocations, 1ull);
+	CHECK_EQUAL(AllocationTracker::GetTotal(b).bytes - startB.bytes, 40ull);
+	CHECK_EQUAL(AllocationTracker::GetMemory(a).liveBytes - memoryA.liveBytes, 128ull);
+	CHECK_EQUAL(AllocationTracker::GetMemory(a).liveAllocations - memoryA.liveAllocations, 2ull);
+	CHECK(AllocationTracker::GetMemory(a).peakBytes >= memoryA.liveBytes + 128);
+
+	// Freed under another tag, but credited back to its own
+	{
+		AllocationTracker::Scope scopeB(b);
+		delete[] first;
+		delete[] second;
+	}
+	delete[] inner;
+	CHECK_EQUAL(AllocationTracker::GetMemory(a).liveBytes, memoryA.liveBytes);
+	CHECK_EQUAL(AllocationTracker::GetMemory(a).liveAllocations, memoryA.liveAllocations);
+	CHECK_EQUAL(AllocationTracker::GetMemory(b).liveBytes, memoryB.liveBytes);
+
+	// Totals only ever go up
+	CHECK_EQUAL(AllocationTracker::GetTotal(a).allocations - startA.allocations, 2ull);
+
+	// Allocate() and Free() count the same way
+	{
+		AllocationTracker::Scope scopeB(b);
+		void* memory = AllocationTracker::Allocate(64);
+		CHECK(memory != 0);
+		CHECK_EQUAL(AllocationTracker::GetTotal(b).allocations - startB.allocations, 2ull);
+		CHECK_EQUAL(AllocationTracker::GetMemory(b).liveBytes - memoryB.liveBytes, 64ull);
+		AllocationTracker::Free(memory);
+	}
+	CHECK_EQUAL(AllocationTracker::GetMemory(b).liveBytes, memoryB.liveBytes);
+}
+
+TEST(AllocationTracker_BeginFrameTakesDeltas)
+{
+	unsigned int tag = AllocationTracker::RegisterTag("Test frames");
+
+	// Whatever happened before is closed off
+	AllocationTracker::BeginFrame();
+	{
+		AllocationTracker::Scope scope(tag);
+		for (int i = 0; i < 3; i++)
+			delete[] NewBytes(16);
+	}
+	CHECK_EQUAL(AllocationTracker::GetLastFrame(tag).allocations, 0ull);
+
+	// The frame just finished
+	AllocationTracker::BeginFrame();
+	CHECK_EQUAL(AllocationTracker::GetLastFrame(tag).allocations, 3ull);
+	CHECK_EQUAL(AllocationTracker::GetLastFrame(tag).bytes, 48ull);
+	CHECK(AllocationTracker::GetLastFrameTotal().allocations >= 3ull);
+
+	// Only this frame's, not a running total
+	{
+		AllocationTracker::Scope scope(tag);
+		delete[] NewBytes(8);
+	}
+	AllocationTracker::BeginFrame();
+	CHECK_EQUAL(AllocationTracker::GetLastFrame(tag).allocations, 1ull);
+	CHECK_EQUAL(AllocationTracker::GetLastFrame(tag).bytes, 8ull);
+
+	// Nothing at all
+	AllocationTracker::BeginFrame();
+	CHECK_EQUAL(AllocationTracker::GetLastFrame(tag).allocations, 0ull);
+	CHECK_EQUAL(AllocationTracker::GetLastFrame(tag).bytes, 0ull);
+
+	// Out of range tags read as nothing
+	CHECK_EQUAL(AllocationTracker::GetLastFrame(AllocationTracker::MaxTags).allocations, 0ull);
+}
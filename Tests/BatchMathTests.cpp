@@ -0,0 +1,231 @@
+#include "Test.h"
+#include "BatchMath.h"
+
+#include <DirectXMath.h>
+#include <vector>
+#include <algorithm>
+
+using namespace DirectX;
+
+// Annonymous namespace to hold helpers
+// only accessible in this file
+namespace
+{
+	// Relative to each value's size, since projections and
+	// inverses of scaled matrices reach well past 1
+	const float tolerance = 1e-4f;
+
+	// Not a multiple of 8 (or 4), so every path has a tail
+	const size_t count = 37;
+
+	unsigned int rngState = 1;
+	float RandomFloat(float minValue, float maxValue)
+	{
+		rngState = rngState * 1664525u + 1013904223u;
+		return minValue + (rngState >> 8) * (1.0f / 16777216.0f) * (maxValue - minValue);
+	}
+
+	// Scale, rotation and translation, so always affine and invertible
+	XMMATRIX RandomWorld()
+	{
+		return
+			XMMatrixScaling(RandomFloat(0.5f, 2.0f), RandomFloat(0.5f, 2.0f), RandomFloat(0.5f, 2.0f)) *
+			XMMatrixRotationRollPitchYaw(RandomFloat(-XM_PI, XM_PI), RandomFloat(-XM_PI, XM_PI), RandomFloat(-XM_PI, XM_PI)) *
+			XMMatrixTranslation(RandomFloat(-50, 50), RandomFloat(-50, 50), RandomFloat(-50, 50));
+	}
+
+	bool Near(float actual, float expected)
+	{
+		return std::fabs(actual - expected) <= tolerance * (1.0f + std::fabs(expected));
+	}
+
+	bool Near(const float* actual, const XMMATRIX& expected)
+	{
+		XMFLOAT4X4 e;
+		XMStoreFloat4x4(&e, expected);
+		for (int i = 0; i < 16; i++)
+			if (!Near(actual[i], (&e._11)[i]))
+				return false;
+		return true;
+	}
+
+	void Set(BatchMath::MatrixStorage& storage, size_t index, const XMMATRIX& m)
+	{
+		XMFLOAT4X4 f;
+		XMStoreFloat4x4(&f, m);
+		storage.Set(index, &f._11);
+	}
+
+	XMMATRIX Get(const BatchMath::MatrixStorage& storage, size_t index)
+	{
+		XMFLOAT4X4 f;
+		storage.Get(index, &f._11);
+		return XMLoadFloat4x4(&f);
+	}
+
+	// Runs check once on every path this CPU supports, then
+	// puts the original path back
+	template<typename Check>
+	void ForEachLevel(Check check)
+	{
+		BatchMath::Level previous = BatchMath::GetLevel();
+		for (int l = (int)BatchMath::Level::Scalar; l <= (int)BatchMath::GetBestLevel(); l++)
+		{
+			BatchMath::SetLevel((BatchMath::Level)l);
+			CHECK_EQUAL((int)BatchMath::GetLevel(), l);
+			check();
+		}
+		BatchMath::SetLevel(previous);
+	}
+}
+
+TEST(BatchMath_MultiplyMatchesXMMatrixMultiply)
+{
+	BatchMath::MatrixStorage a(count), b(count), out(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		Set(a, i, RandomWorld());
+		Set(b, i, RandomWorld());
+	}
+
+	ForEachLevel([&]()
+	{
+		out.Resize(count);
+		BatchMath::Multiply(a.View(), b.View(), out.View(), count);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			float actual[16];
+			out.Get(i, actual);
+			CHECK(Near(actual, XMMatrixMultiply(Get(a, i), Get(b, i))));
+		}
+	});
+}
+
+TEST(BatchMath_MultiplySharedMatchesXMMatrixMultiply)
+{
+	BatchMath::MatrixStorage a(count), out(count);
+	for (size_t i = 0; i < count; i++)
+		Set(a, i, RandomWorld());
+
+	XMMATRIX shared = XMMatrixTranslation(1, -2, 30) * XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 100.0f);
+	XMFLOAT4X4 sharedFloats;
+	XMStoreFloat4x4(&sharedFloats, shared);
+
+	ForEachLevel([&]()
+	{
+		out.Resize(count);
+		BatchMath::MultiplyShared(a.View(), &sharedFloats._11, out.View(), count);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			float actual[16];
+			out.Get(i, actual);
+			CHECK(Near(actual, XMMatrixMultiply(Get(a, i), shared)));
+		}
+	});
+}
+
+TEST(BatchMath_AffineInverseMatchesXMMatrixInverse)
+{
+	BatchMath::MatrixStorage in(count), out(count);
+	for (size_t i = 0; i < count; i++)
+		Set(in, i, RandomWorld());
+
+	ForEachLevel([&]()
+	{
+		out.Resize(count);
+		BatchMath::AffineInverse(in.View(), out.View(), count);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			float actual[16];
+			out.Get(i, actual);
+			CHECK(Near(actual, XMMatrixInverse(0, Get(in, i))));
+		}
+	});
+}
+
+TEST(BatchMath_TransformVectorsMatchesXMVector4Transform)
+{
+	BatchMath::MatrixStorage m(count);
+	std::vector<float> x(count), y(count), z(count), w(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		Set(m, i, RandomWorld());
+		x[i] = RandomFloat(-10, 10);
+		y[i] = RandomFloat(-10, 10);
+		z[i] = RandomFloat(-10, 10);
+		w[i] = RandomFloat(0, 1);
+	}
+
+	std::vector<float> ox(count), oy(count), oz(count), ow(count);
+	BatchMath::Vector4SoA v = { x.data(), y.data(), z.data(), w.data() };
+	BatchMath::Vector4SoA out = { ox.data(), oy.data(), oz.data(), ow.data() };
+
+	ForEachLevel([&]()
+	{
+		for (std::vector<float>* o : { &ox, &oy, &oz, &ow })
+			std::fill(o->begin(), o->end(), 0.0f);
+		BatchMath::TransformVectors(m.View(), v, out, count);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			XMFLOAT4 expected;
+			XMStoreFloat4(&expected, XMVector4Transform(XMVectorSet(x[i], y[i], z[i], w[i]), Get(m, i)));
+			CHECK(Near(ox[i], expected.x) && Near(oy[i], expected.y) && Near(oz[i], expected.z) && Near(ow[i], expected.w));
+		}
+	});
+}
+
+TEST(BatchMath_TransformAABBsBoundEveryCorner)
+{
+	BatchMath::MatrixStorage m(count);
+	std::vector<float> minX(count), minY(count), minZ(count), maxX(count), maxY(count), maxZ(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		Set(m, i, RandomWorld());
+		minX[i] = RandomFloat(-5, 0); maxX[i] = RandomFloat(0, 5);
+		minY[i] = RandomFloat(-5, 0); maxY[i] = RandomFloat(0, 5);
+		minZ[i] = RandomFloat(-5, 0); maxZ[i] = RandomFloat(0, 5);
+	}
+
+	std::vector<float> oMinX(count), oMinY(count), oMinZ(count), oMaxX(count), oMaxY(count), oMaxZ(count);
+	BatchMath::Vector3SoA localMin = { minX.data(), minY.data(), minZ.data() };
+	BatchMath::Vector3SoA localMax = { maxX.data(), maxY.data(), maxZ.data() };
+	BatchMath::Vector3SoA outMin = { oMinX.data(), oMinY.data(), oMinZ.data() };
+	BatchMath::Vector3SoA outMax = { oMaxX.data(), oMaxY.data(), oMaxZ.data() };
+
+	ForEachLevel([&]()
+	{
+		for (std::vector<float>* o : { &oMinX, &oMinY, &oMinZ, &oMaxX, &oMaxY, &oMaxZ })
+			std::fill(o->begin(), o->end(), 0.0f);
+		BatchMath::TransformAABBs(m.View(), localMin, localMax, outMin, outMax, count);
+
+		// The tight world bounds are those of the eight
+		// transformed corners
+		for (size_t i = 0; i < count; i++)
+		{
+			float lo[3] = { 1e30f, 1e30f, 1e30f };
+			float hi[3] = { -1e30f, -1e30f, -1e30f };
+			for (int c = 0; c < 8; c++)
+			{
+				XMVECTOR corner = XMVectorSet(
+					c & 1 ? maxX[i] : minX[i],
+					c & 2 ? maxY[i] : minY[i],
+					c & 4 ? maxZ[i] : minZ[i], 1.0f);
+				XMFLOAT4 p;
+				XMStoreFloat4(&p, XMVector4Transform(corner, Get(m, i)));
+				const float* pf = &p.x;
+				for (int a = 0; a < 3; a++)
+				{
+					lo[a] = pf[a] < lo[a] ? pf[a] : lo[a];
+					hi[a] = pf[a] > hi[a] ? pf[a] : hi[a];
+				}
+			}
+
+			CHECK(Near(oMinX[i], lo[0]) && Near(oMinY[i], lo[1]) && Near(oMinZ[i], lo[2]));
+			CHECK(Near(oMaxX[i], hi[0]) && Near(oMaxY[i], hi[1]) && Near(oMaxZ[i], hi[2]));
+		}
+	});
+}
@@ -0,0 +1,141 @@
+#include "Test.h"
+#include "RecordingCommandBackend.h"
+#include "JobSystem.h"
+
+#include <vector>
+
+// Annonymous namespace to hold helpers
+// only accessible in this file
+namespace
+{
+	typedef RecordingCommandBackend::Command Command;
+
+	// Stand-ins for mesh buffers: never dereferenced, only recorded
+	ID3D11Buffer* FakeBuffer(size_t id)
+	{
+		return reinterpret_cast<ID3D11Buffer*>((id + 1) * 16);
+	}
+
+	// The same two commands per draw that Systems::Draw() records
+	unsigned int RecordDraws(CommandBackend& backend, unsigned int count, unsigned int minPerChunk)
+	{
+		return CommandRecording::Record(backend, count, minPerChunk,
+			[](CommandContext& context, unsigned int begin, unsigned int end)
+			{
+				for (unsigned int i = begin; i < end; i++)
+				{
+					context.SetGeometry(FakeBuffer(i % 8 * 2), 32, FakeBuffer(i % 8 * 2 + 1));
+					context.DrawIndexedInstanced(36 + i % 5, 1, i);
+				}
+			});
+	}
+
+	bool Same(const Command& a, const Command& b)
+	{
+		return a.type == b.type &&
+			a.vertexBuffer == b.vertexBuffer && a.indexBuffer == b.indexBuffer &&
+			a.a == b.a && a.b == b.b && a.c == b.c;
+	}
+
+	bool Same(const std::vector<Command>& a, const std::vector<Command>& b)
+	{
+		if (a.size() != b.size())
+			return false;
+		for (size_t i = 0; i < a.size(); i++)
+			if (!Same(a[i], b[i]))
+				return false;
+		return true;
+	}
+}
+
+TEST(CommandRecording_SerialStreamIsInDrawOrder)
+{
+	JobSystem::ShutDown();
+	RecordingCommandBackend backend(4);
+
+	const unsigned int drawCount = 100;
+	unsigned int chunks = RecordDraws(backend, drawCount, 16);
+	CHECK_EQUAL(chunks, 1u);
+
+	const std::vector<Command>& stream = backend.GetSubmitted();
+	CHECK_EQUAL(stream.size(), drawCount * 2);
+	CHECK_EQUAL(backend.GetSubmittedCount(), drawCount * 2);
+	CHECK_EQUAL(backend.GetSubmittedCount(Command::SetGeometry), drawCount);
+	CHECK_EQUAL(backend.GetSubmittedCount(Command::DrawIndexedInstanced), drawCount);
+
+	for (unsigned int i = 0; i < drawCount && stream.size() == drawCount * 2; i++)
+	{
+		Command geometry = { Command::SetGeometry, FakeBuffer(i % 8 * 2), FakeBuffer(i % 8 * 2 + 1), 32, 0, 0 };
+		Command draw = { Command::DrawIndexedInstanced, 0, 0, 36 + i % 5, 1, i };
+		CHECK(Same(stream[i * 2], geometry));
+		CHECK(Same(stream[i * 2 + 1], draw));
+	}
+}
+
+TEST(CommandRecording_ParallelChunksMergeToSerialStream)
+{
+	const unsigned int drawCount = 1000;
+
+	JobSystem::ShutDown();
+	RecordingCommandBackend backend(8);
+	RecordDraws(backend, drawCount, 16);
+	std::vector<Command> serial = backend.GetSubmitted();
+
+	// Four threads, several chunk counts (including an uneven
+	// split), each merged back in chunk order
+	JobSystem::Initialize(3);
+	const unsigned int minPerChunk[] = { 16, 300, 999 };
+	const unsigned int expectedChunks[] = { 4, 3, 1 };
+	for (int i = 0; i < 3; i++)
+	{
+		CHECK_EQUAL(RecordDraws(backend, drawCount, minPerChunk[i]), expectedChunks[i]);
+		CHECK(Same(backend.GetSubmitted(), serial));
+	}
+
+	// Again, repeatedly, to give a racy merge a chance to show
+	for (int run = 0; run < 50; run++)
+	{
+		RecordDraws(backend, drawCount, 16);
+		CHECK(Same(backend.GetSubmitted(), serial));
+	}
+	JobSystem::ShutDown();
+}
+
+TEST(CommandRecording_SubmitPlaysChunksInChunkOrder)
+{
+	RecordingCommandBackend backend(3);
+
+	// A stale chunk from an earlier frame must not leak in
+	backend.BeginFrame(3);
+	backend.BeginChunk(1)->DrawIndexedInstanced(99, 1, 99);
+	backend.EndChunk(1);
+
+	// Recorded out of order, and chunk 1 left empty this time
+	backend.BeginFrame(3);
+	CommandContext* last = backend.BeginChunk(2);
+	last->DrawIndexedInstanced(3, 1, 2);
+	backend.EndChunk(2);
+	CommandContext* first = backend.BeginChunk(0);
+	first->SetGeometry(FakeBuffer(0), 12, FakeBuffer(1));
+	first->DrawIndexedInstanced(3, 1, 0);
+	backend.EndChunk(0);
+	backend.BeginChunk(1);
+	backend.EndChunk(1);
+	backend.Submit();
+
+	const std::vector<Command>& stream = backend.GetSubmitted();
+	CHECK_EQUAL(stream.size(), 3u);
+	if (stream.size() == 3)
+	{
+		CHECK(stream[0].type == Command::SetGeometry && stream[0].a == 12);
+		CHECK(stream[1].type == Command::DrawIndexedInstanced && stream[1].c == 0);
+		CHECK(stream[2].type == Command::DrawIndexedInstanced && stream[2].c == 2);
+	}
+
+	// Counting alone keeps nothing, but still counts
+	backend.keepSubmitted = false;
+	backend.Submit();
+	CHECK(backend.GetSubmitted().empty());
+	CHECK_EQUAL(backend.GetSubmittedCount(), 3u);
+	CHECK_EQUAL(backend.GetSubmittedCount(Command::DrawIndexedInstanced), 2u);
+}
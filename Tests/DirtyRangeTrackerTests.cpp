@@ -0,0 +1,161 @@
+#include "Test.h"
+#include "DirtyRangeTracker.h"
+
+#include <vector>
+
+TEST(DirtyRangeTracker_CoalescesWithinMaxGap)
+{
+	DirtyRangeTracker tracker(64);
+	tracker.MarkDirty(2);
+	tracker.MarkDirty(3);
+	tracker.MarkDirty(6);
+	tracker.MarkDirty(20);
+
+	// No gap allowed: every run stays on its own
+	std::vector<DirtyRange> ranges;
+	tracker.Coalesce(ranges, 0);
+	CHECK_EQUAL(ranges.size(), 3u);
+	if (ranges.size() == 3)
+	{
+		CHECK(ranges[0].begin == 2 && ranges[0].end == 4);
+		CHECK(ranges[1].begin == 6 && ranges[1].end == 7);
+		CHECK(ranges[2].begin == 20 && ranges[2].end == 21);
+	}
+
+	// Slots 4 and 5 are swallowed, 7 to 19 are not
+	tracker.Coalesce(ranges, 2);
+	CHECK_EQUAL(ranges.size(), 2u);
+	if (ranges.size() == 2)
+	{
+		CHECK(ranges[0].begin == 2 && ranges[0].end == 7);
+		CHECK(ranges[1].begin == 20 && ranges[1].end == 21);
+	}
+
+	// Exactly the 13 slot gap: one range
+	tracker.Coalesce(ranges, 13);
+	CHECK_EQUAL(ranges.size(), 1u);
+	if (ranges.size() == 1)
+		CHECK(ranges[0].begin == 2 && ranges[0].end == 21);
+
+	// Coalescing doesn't clear anything
+	CHECK_EQUAL(tracker.GetDirtyCount(), 4u);
+}
+
+TEST(DirtyRangeTracker_RangesCrossWordBoundaries)
+{
+	DirtyRangeTracker tracker(200);
+	tracker.MarkRangeDirty(60, 130);
+	tracker.MarkDirty(199);
+	CHECK_EQUAL(tracker.GetDirtyCount(), 71u);
+
+	std::vector<DirtyRange> ranges;
+	tracker.Coalesce(ranges, 0);
+	CHECK_EQUAL(ranges.size(), 2u);
+	if (ranges.size() == 2)
+	{
+		CHECK(ranges[0].begin == 60 && ranges[0].end == 130);
+		CHECK(ranges[1].begin == 199 && ranges[1].end == 200);
+	}
+
+	// The last slot of one word and the first of the next
+	tracker.Clear();
+	tracker.MarkDirty(63);
+	tracker.MarkDirty(64);
+	tracker.Coalesce(ranges, 0);
+	CHECK_EQUAL(ranges.size(), 1u);
+	if (ranges.size() == 1)
+		CHECK(ranges[0].begin == 63 && ranges[0].end == 65);
+
+	// A gap that spans a whole clean word still merges
+	tracker.Clear();
+	tracker.MarkDirty(10);
+	tracker.MarkDirty(150);
+	tracker.Coalesce(ranges, 139);
+	CHECK_EQUAL(ranges.size(), 1u);
+	if (ranges.size() == 1)
+		CHECK(ranges[0].begin == 10 && ranges[0].end == 151);
+}
+
+TEST(DirtyRangeTracker_MarkAllDirty)
+{
+	DirtyRangeTracker tracker(130);
+	tracker.MarkDirty(5);
+	tracker.MarkAllDirty();
+	CHECK_EQUAL(tracker.GetDirtyCount(), 130u);
+
+	std::vector<DirtyRange> ranges;
+	tracker.Coalesce(ranges, 0);
+	CHECK_EQUAL(ranges.size(), 1u);
+	if (ranges.size() == 1)
+		CHECK(ranges[0].begin == 0 && ranges[0].end == 130);
+
+	tracker.Clear();
+	CHECK_EQUAL(tracker.GetDirtyCount(), 0u);
+	tracker.Coalesce(ranges, 0);
+	CHECK(ranges.empty());
+
+	// Out of range marks are ignored
+	tracker.MarkDirty(130);
+	tracker.MarkRangeDirty(120, 500);
+	CHECK_EQUAL(tracker.GetDirtyCount(), 10u);
+}
+
+TEST(DirtyRangeTracker_ShrinkDropsMarks)
+{
+	DirtyRangeTracker tracker(130);
+	tracker.MarkDirty(10);
+	tracker.MarkDirty(100);
+	tracker.MarkDirty(129);
+
+	tracker.Resize(100);
+	CHECK_EQUAL(tracker.GetSlotCount(), 100u);
+	CHECK_EQUAL(tracker.GetDirtyCount(), 1u);
+	CHECK(tracker.IsDirty(10));
+	CHECK(!tracker.IsDirty(100));
+
+	// Growing again must not bring the dropped marks back
+	tracker.Resize(130);
+	CHECK_EQUAL(tracker.GetDirtyCount(), 1u);
+	CHECK(!tracker.IsDirty(100));
+	CHECK(!tracker.IsDirty(129));
+
+	std::vector<DirtyRange> ranges;
+	tracker.Coalesce(ranges, 0);
+	CHECK_EQUAL(ranges.size(), 1u);
+	if (ranges.size() == 1)
+		CHECK(ranges[0].begin == 10 && ranges[0].end == 11);
+
+	// Growing keeps existing marks
+	tracker.Resize(1000);
+	CHECK(tracker.IsDirty(10));
+	CHECK_EQUAL(tracker.GetDirtyCount(), 1u);
+}
+
+TEST(DirtyRangeTracker_GrowsOneSlotAtATime)
+{
+	// As InstanceBuffer::Allocate() grows it, once per spawn
+	DirtyRangeTracker tracker;
+	const unsigned int slotCount = 100000;
+	for (unsigned int s = 0; s < slotCount; s++)
+	{
+		tracker.Resize(s + 1);
+		if (s % 3 == 0)
+			tracker.MarkDirty(s);
+	}
+	CHECK_EQUAL(tracker.GetDirtyCount(), (slotCount + 2) / 3);
+	CHECK(tracker.IsDirty(0) && !tracker.IsDirty(1) && tracker.IsDirty(99999));
+
+	// Shrinking by several words and growing back within the
+	// same capacity must find every dropped word clean
+	tracker.Resize(1000);
+	CHECK_EQUAL(tracker.GetDirtyCount(), 334u);
+	tracker.Resize(slotCount);
+	CHECK_EQUAL(tracker.GetDirtyCount(), 334u);
+	CHECK(!tracker.IsDirty(1002) && !tracker.IsDirty(99999));
+
+	std::vector<DirtyRange> ranges;
+	tracker.Coalesce(ranges, 2);
+	CHECK_EQUAL(ranges.size(), 1u);
+	if (ranges.size() == 1)
+		CHECK(ranges[0].begin == 0 && ranges[0].end == 1000);
+}
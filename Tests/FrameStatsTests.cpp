@@ -0,0 +1,131 @@
+#include "Test.h"
+#include "FrameStats.h"
+
+// Annonymous namespace to hold helpers
+// only accessible in this file
+namespace
+{
+	// Percentiles are exact to within one bucket
+	const float tolerance = FrameStats::BucketMilliseconds;
+
+	// Frame times in the middle of a bucket, so float rounding
+	// never decides which bucket they land in
+	float Frame(unsigned int tenths)
+	{
+		return tenths * FrameStats::BucketMilliseconds + FrameStats::BucketMilliseconds / 2;
+	}
+}
+
+TEST(FrameStats_PercentilesOfUniformFrames)
+{
+	// 1 to 100 ms, one frame each, added out of order
+	FrameStats stats(100);
+	for (unsigned int i = 0; i < 100; i++)
+		stats.AddFrame(Frame(((i * 37) % 100 + 1) * 10));
+	CHECK_EQUAL(stats.GetCount(), 100u);
+
+	CHECK_NEAR(stats.GetPercentile(50.0f), Frame(500), tolerance);
+	CHECK_NEAR(stats.GetPercentile(95.0f), Frame(950), tolerance);
+	CHECK_NEAR(stats.GetPercentile(99.0f), Frame(990), tolerance);
+	CHECK_NEAR(stats.GetMax(), Frame(1000), 0.001f);
+	CHECK_NEAR(stats.GetAverage(), Frame(505), 0.001f);
+
+	// 100 ms is past the last bucket, so the top reports the max
+	CHECK_EQUAL(stats.GetBuckets().back(), 1u);
+	CHECK_NEAR(stats.GetPercentile(100.0f), stats.GetMax(), 0.001f);
+}
+
+TEST(FrameStats_PercentilesOfSkewedFrames)
+{
+	// Mostly 16 ms with a 10% tail at 50 ms: the median stays
+	// put and the tail shows up from p95 on
+	FrameStats stats(100);
+	for (unsigned int i = 0; i < 100; i++)
+		stats.AddFrame(i % 10 == 9 ? Frame(500) : Frame(160));
+
+	CHECK_NEAR(stats.GetPercentile(50.0f), Frame(160), tolerance);
+	CHECK_NEAR(stats.GetPercentile(90.0f), Frame(160), tolerance);
+	CHECK_NEAR(stats.GetPercentile(95.0f), Frame(500), tolerance);
+	CHECK_NEAR(stats.GetPercentile(99.0f), Frame(500), tolerance);
+	CHECK_NEAR(stats.GetMax(), Frame(500), 0.001f);
+	CHECK_NEAR(stats.GetAverage(), 0.9f * Frame(160) + 0.1f * Frame(500), 0.001f);
+
+	// Nothing recorded, nothing reported
+	stats.Reset();
+	CHECK_EQUAL(stats.GetCount(), 0u);
+	CHECK_EQUAL(stats.GetPercentile(50.0f), 0.0f);
+	CHECK_EQUAL(stats.GetMax(), 0.0f);
+	CHECK_EQUAL(stats.GetAverage(), 0.0f);
+}
+
+TEST(FrameStats_WindowEvictsOldestFrames)
+{
+	FrameStats stats(10);
+	stats.AddFrame(Frame(900));
+	for (int i = 0; i < 9; i++)
+		stats.AddFrame(Frame(50));
+	CHECK_EQUAL(stats.GetCount(), 10u);
+	CHECK_EQUAL(stats.GetHistoryOffset(), 0u);
+	CHECK_NEAR(stats.GetMax(), Frame(900), 0.001f);
+
+	// Half the window replaced: the spike is gone from the max,
+	// the histogram and the average
+	for (int i = 0; i < 5; i++)
+		stats.AddFrame(Frame(200));
+	CHECK_EQUAL(stats.GetCount(), 10u);
+	CHECK_EQUAL(stats.GetHistoryOffset(), 5u);
+	CHECK_NEAR(stats.GetMax(), Frame(200), 0.001f);
+	CHECK_EQUAL(stats.GetBuckets()[900], 0u);
+	CHECK_EQUAL(stats.GetBuckets()[50], 5u);
+	CHECK_EQUAL(stats.GetBuckets()[200], 5u);
+	CHECK_NEAR(stats.GetAverage(), (Frame(50) * 5 + Frame(200) * 5) / 10, 0.001f);
+
+	// History reads oldest first from the offset
+	const std::vector<float>& history = stats.GetHistory();
+	CHECK_NEAR(history[stats.GetHistoryOffset()], Frame(50), 0.001f);
+	CHECK_NEAR(history[(stats.GetHistoryOffset() + 9) % 10], Frame(200), 0.001f);
+
+	// Whole window replaced: nothing of the first frames is left
+	for (int i = 0; i < 5; i++)
+		stats.AddFrame(Frame(200));
+	CHECK_EQUAL(stats.GetBuckets()[50], 0u);
+	CHECK_NEAR(stats.GetPercentile(1.0f), Frame(200), tolerance);
+	CHECK_NEAR(stats.GetAverage(), Frame(200), 0.001f);
+}
+
+TEST(FrameStats_HitchIsAMultipleOfTheMedian)
+{
+	FrameStats stats;
+
+	// Too few frames to judge against, however slow
+	for (unsigned int i = 0; i + 1 < stats.minimumFrames; i++)
+		CHECK(!stats.AddFrame(Frame(100)));
+	CHECK(!stats.AddFrame(Frame(900)));
+	CHECK_EQUAL(stats.GetHitchCount(), 0u);
+
+	// Steady 10 ms frames put the median at 10 ms, so the
+	// default 2x threshold sits at 20 ms
+	stats.Reset();
+	for (unsigned int i = 0; i < stats.minimumFrames; i++)
+		CHECK(!stats.AddFrame(Frame(100)));
+	CHECK(!stats.AddFrame(19.0f));
+	CHECK(stats.AddFrame(21.0f));
+	CHECK_EQUAL(stats.GetHitchCount(), 1u);
+	CHECK_EQUAL(stats.GetLastHitchMilliseconds(), 21.0f);
+
+	// Raising the multiple raises the threshold with it
+	stats.hitchMultiple = 3.0f;
+	CHECK(!stats.AddFrame(29.0f));
+	CHECK(stats.AddFrame(31.0f));
+	CHECK_EQUAL(stats.GetHitchCount(), 2u);
+	CHECK_EQUAL(stats.GetLastHitchMilliseconds(), 31.0f);
+
+	// It's relative: at a steady 30 ms, 50 ms is no hitch
+	stats.Reset();
+	stats.hitchMultiple = 2.0f;
+	for (unsigned int i = 0; i < stats.minimumFrames; i++)
+		stats.AddFrame(Frame(300));
+	CHECK(!stats.AddFrame(50.0f));
+	CHECK(stats.AddFrame(70.0f));
+	CHECK_EQUAL(stats.GetHitchCount(), 1u);
+}
@@ -0,0 +1,41 @@
+#include "Test.h"
+#include "Headless.h"
+
+// Annonymous namespace to hold helpers
+// only accessible in this file
+namespace
+{
+	// The usual scene, with nothing touching it, drawn only
+	// when NeedsDraw() says it has to be
+	Headless::Report IdleRun(bool animateLights)
+	{
+		Headless::Options options;
+		options.frames = 120;
+		options.warmupFrames = 10;
+		options.lights = 64;
+		options.animateLights = animateLights;
+		options.skipUnchanged = true;
+
+		Headless::Report report;
+		Headless::Run(options, report);
+		return report;
+	}
+}
+
+TEST(IdleFrames_StillSceneSkipsDraws)
+{
+	// The first few frames draw while ImGui's windows settle;
+	// after that the frame stats, profiler and memory windows
+	// are the only things changing, and they don't count
+	Headless::Report report = IdleRun(false);
+	CHECK(report.skippedDraws > 0);
+	CHECK(report.skippedDraws > report.frames / 2);
+	CHECK_EQUAL(report.counts.frames + report.skippedDraws, (unsigned long long)report.frames);
+}
+
+TEST(IdleFrames_MovingLightsDrawEveryFrame)
+{
+	Headless::Report report = IdleRun(true);
+	CHECK_EQUAL(report.skippedDraws, 0ull);
+	CHECK_EQUAL(report.counts.frames, (unsigned long long)report.frames);
+}
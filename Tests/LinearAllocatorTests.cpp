@@ -0,0 +1,102 @@
+#include "Test.h"
+#include "LinearAllocator.h"
+#include "AllocationTracker.h"
+
+#include <cstring>
+
+// Annonymous namespace to hold helpers
+// only accessible in this file
+namespace
+{
+	bool Aligned(const void* memory, size_t alignment)
+	{
+		return (size_t)memory % alignment == 0;
+	}
+}
+
+TEST(LinearAllocator_OverflowsIntoNewBlocks)
+{
+	LinearAllocator memory(256);
+	CHECK_EQUAL(memory.GetCapacity(), (size_t)256);
+	CHECK_EQUAL(memory.GetUsed(), (size_t)0);
+
+	void* a = memory.Allocate(100);
+	void* b = memory.Allocate(100);
+	CHECK(Aligned(a, 16) && Aligned(b, 16));
+	CHECK((char*)b >= (char*)a + 100);
+	CHECK_EQUAL(memory.GetUsed(), (size_t)212);	// b starts at 112
+
+	// Doesn't fit what's left, so another block, at least
+	// twice the size of the last
+	void* c = memory.Allocate(200);
+	CHECK(Aligned(c, 16));
+	CHECK_EQUAL(memory.GetCapacity(), (size_t)256 + 512);
+	CHECK_EQUAL(memory.GetUsed(), (size_t)212 + 200);
+	CHECK_EQUAL(memory.GetPeak(), (size_t)212 + 200);
+
+	// Bigger than doubling: the block fits the allocation
+	memory.Allocate(5000);
+	CHECK(memory.GetCapacity() >= (size_t)256 + 512 + 5000);
+
+	// Typed room keeps the type's alignment, and at least 16
+	struct alignas(32) Wide { float values[8]; };
+	CHECK(Aligned(memory.Allocate<Wide>(3), 32));
+	CHECK(Aligned(memory.Allocate<char>(1), 16));
+}
+
+TEST(LinearAllocator_ResetMergesBlocksAndKeepsPeak)
+{
+	LinearAllocator memory(256);
+	memory.Allocate(200);
+	memory.Allocate(200);
+	memory.Allocate(200);
+	size_t capacity = memory.GetCapacity();
+	size_t peak = memory.GetPeak();
+	CHECK(capacity > 256);
+	CHECK(peak >= 600);
+
+	// One block that holds everything the last frame needed
+	memory.Reset();
+	CHECK_EQUAL(memory.GetUsed(), (size_t)0);
+	CHECK_EQUAL(memory.GetCapacity(), capacity);
+	CHECK_EQUAL(memory.GetPeak(), peak);
+
+	// So the same frame again stays in it, with no heap at all
+	unsigned int tag = AllocationTracker::RegisterTag("Test linear");
+	AllocationTracker::Counts before = AllocationTracker::GetTotal(tag);
+	{
+		AllocationTracker::Scope scope(tag);
+		memory.Allocate(200);
+		memory.Allocate(200);
+		memory.Allocate(200);
+	}
+	CHECK_EQUAL(AllocationTracker::GetTotal(tag).allocations, before.allocations);
+	CHECK_EQUAL(memory.GetCapacity(), capacity);
+	CHECK(memory.GetPeak() >= peak);
+	peak = memory.GetPeak();
+
+	// A smaller frame leaves the peak where it was
+	memory.Reset();
+	memory.Allocate(10);
+	CHECK_EQUAL(memory.GetUsed(), (size_t)10);
+	CHECK_EQUAL(memory.GetPeak(), peak);
+
+	// Resetting a single block keeps it as it is
+	memory.Reset();
+	memory.Reset();
+	CHECK_EQUAL(memory.GetCapacity(), capacity);
+}
+
+TEST(LinearAllocator_FormatTakesExactlyItsLength)
+{
+	LinearAllocator memory(64);
+	const char* text = memory.Format("%s %d", "frame", 42);
+	CHECK_EQUAL(strcmp(text, "frame 42"), 0);
+	CHECK_EQUAL(memory.GetUsed(), strlen("frame 42") + 1);
+
+	// Packed byte-aligned, one after the other
+	const char* next = memory.Format("%u", 7u);
+	CHECK(next == text + strlen(text) + 1);
+	CHECK_EQUAL(strcmp(text, "frame 42"), 0);
+	CHECK_EQUAL(strcmp(next, "7"), 0);
+}
@@ -0,0 +1,112 @@
+#include "Test.h"
+#include "MatrixBatch.h"
+
+#include <DirectXMath.h>
+#include <vector>
+
+using namespace DirectX;
+
+// Annonymous namespace to hold helpers
+// only accessible in this file
+namespace
+{
+	const float tolerance = 1e-4f;
+
+	unsigned int rngState = 1;
+	float RandomFloat(float minValue, float maxValue)
+	{
+		rngState = rngState * 1664525u + 1013904223u;
+		return minValue + (rngState >> 8) * (1.0f / 16777216.0f) * (maxValue - minValue);
+	}
+
+	XMFLOAT4X4 RandomWorld()
+	{
+		XMFLOAT4X4 m;
+		XMStoreFloat4x4(&m,
+			XMMatrixScaling(RandomFloat(0.5f, 2.0f), RandomFloat(0.5f, 2.0f), RandomFloat(0.5f, 2.0f)) *
+			XMMatrixRotationRollPitchYaw(RandomFloat(-XM_PI, XM_PI), RandomFloat(-XM_PI, XM_PI), RandomFloat(-XM_PI, XM_PI)) *
+			XMMatrixTranslation(RandomFloat(-10, 10), RandomFloat(-10, 10), RandomFloat(-10, 10)));
+		return m;
+	}
+
+	XMFLOAT4X4 ViewProjection()
+	{
+		XMFLOAT4X4 m;
+		XMStoreFloat4x4(&m, XMMatrixTranslation(1, -2, 30) * XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 100.0f));
+		return m;
+	}
+
+	bool Near(const XMFLOAT4X4& a, const XMFLOAT4X4& b)
+	{
+		for (int r = 0; r < 4; r++)
+			for (int c = 0; c < 4; c++)
+				if (std::fabs(a.m[r][c] - b.m[r][c]) > tolerance * (1.0f + std::fabs(b.m[r][c])))
+					return false;
+		return true;
+	}
+
+	// Shaped like InstanceData and DrawData, to exercise the strides
+	struct Instance
+	{
+		XMFLOAT4X4 world;
+		XMFLOAT4 tint;
+	};
+
+	struct Draw
+	{
+		XMFLOAT4X4 worldViewProj;
+		unsigned int slot;
+		unsigned int padding[3];
+	};
+}
+
+TEST(MatrixBatch_MultiplyByMatrixMatchesDirectXMath)
+{
+	std::vector<Instance> instances(37);
+	for (Instance& instance : instances)
+		instance.world = RandomWorld();
+	XMFLOAT4X4 viewProj = ViewProjection();
+
+	std::vector<XMFLOAT4X4> outputs(instances.size());
+	MatrixBatch::MultiplyByMatrix(&instances[0].world, sizeof(Instance), instances.size(), viewProj, outputs.data());
+
+	for (size_t i = 0; i < instances.size(); i++)
+	{
+		XMFLOAT4X4 expected;
+		XMStoreFloat4x4(&expected, XMMatrixMultiply(XMLoadFloat4x4(&instances[i].world), XMLoadFloat4x4(&viewProj)));
+		CHECK(Near(outputs[i], expected));
+	}
+}
+
+TEST(MatrixBatch_MultiplyGatheredReadsOnlyListedSlots)
+{
+	std::vector<Instance> instances(64);
+	for (Instance& instance : instances)
+		instance.world = RandomWorld();
+	XMFLOAT4X4 viewProj = ViewProjection();
+
+	// An odd count, out of order, so both the pairs and the
+	// odd one out are covered
+	const unsigned int slots[] = { 63, 0, 17, 17, 5, 40, 2 };
+	const unsigned int count = sizeof(slots) / sizeof(slots[0]);
+
+	std::vector<Draw> draws(count + 1);
+	for (unsigned int i = 0; i < count; i++)
+		draws[i].slot = slots[i];
+
+	// A sentinel past the end must be left alone
+	draws[count].worldViewProj = instances[0].world;
+	draws[count].slot = 12345;
+
+	MatrixBatch::MultiplyGathered(&instances[0].world, sizeof(Instance), &draws[0].slot, &draws[0].worldViewProj, sizeof(Draw), count, viewProj);
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		XMFLOAT4X4 expected;
+		XMStoreFloat4x4(&expected, XMMatrixMultiply(XMLoadFloat4x4(&instances[slots[i]].world), XMLoadFloat4x4(&viewProj)));
+		CHECK(Near(draws[i].worldViewProj, expected));
+		CHECK_EQUAL(draws[i].slot, slots[i]);
+	}
+	CHECK(Near(draws[count].worldViewProj, instances[0].world));
+	CHECK_EQUAL(draws[count].slot, 12345u);
+}
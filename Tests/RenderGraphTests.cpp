@@ -0,0 +1,225 @@
+#include "Test.h"
+#include "RenderGraph.h"
+
+#include <string>
+
+// Annonymous namespace to hold helpers
+// only accessible in this file
+namespace
+{
+	const TextureDesc backBufferDesc = { 64, 32, TextureFormat::RGBA8 };
+	const TextureDesc colorDesc = { 64, 32, TextureFormat::RGBA8 };	// 8192 bytes
+	const TextureDesc hdrDesc = { 64, 32, TextureFormat::RGBA16F };	// 16384 bytes
+	const TextureDesc depthDesc = { 64, 32, TextureFormat::R32F };	// 8192 bytes
+
+	void CountRuns(void* data, const RenderGraph&)
+	{
+		(*(int*)data)++;
+	}
+
+	// Pass names in the order they'll run, culled ones included
+	std::string Order(const RenderGraph& graph)
+	{
+		std::string order;
+		for (unsigned int position = 0; position < graph.GetPassCount(); position++)
+		{
+			if (position > 0)
+				order += " ";
+			order += graph.GetPassName(graph.GetOrderedPass(position));
+		}
+		return order;
+	}
+}
+
+TEST(RenderGraph_CullsPassesNothingConsumes)
+{
+	RenderGraph graph;
+	RenderResource backBuffer = graph.Import("Back buffer", backBufferDesc);
+	RenderResource shadows = graph.CreateTexture("Shadows", depthDesc);
+	RenderResource debug = graph.CreateTexture("Debug", colorDesc);
+	RenderResource debugBlurred = graph.CreateTexture("Debug blurred", colorDesc);
+	graph.SetOutput(backBuffer);
+
+	int runs[4] = {};
+	unsigned int shadowPass = graph.AddPass("Shadows", CountRuns, &runs[0]);
+	graph.Write(shadowPass, shadows);
+
+	// A chain that ends in a texture nobody reads
+	unsigned int debugPass = graph.AddPass("Debug", CountRuns, &runs[1]);
+	graph.Read(debugPass, shadows);
+	graph.Write(debugPass, debug);
+	unsigned int blurPass = graph.AddPass("Blur debug", CountRuns, &runs[2]);
+	graph.Read(blurPass, debug);
+	graph.Write(blurPass, debugBlurred);
+
+	unsigned int lightingPass = graph.AddPass("Lighting", CountRuns, &runs[3]);
+	graph.Read(lightingPass, shadows);
+	graph.Write(lightingPass, backBuffer);
+
+	CHECK(graph.Compile());
+	CHECK(graph.GetError() == 0);
+	CHECK(!graph.IsCulled(shadowPass));
+	CHECK(graph.IsCulled(debugPass));
+	CHECK(graph.IsCulled(blurPass));
+	CHECK(!graph.IsCulled(lightingPass));
+	CHECK_EQUAL(graph.GetStats().passes, 4u);
+	CHECK_EQUAL(graph.GetStats().culledPasses, 2u);
+
+	// Culled passes' textures get nothing
+	CHECK_EQUAL(graph.GetStats().transientTextures, 1u);
+	CHECK(graph.GetPhysical(shadows) != InvalidResource);
+	CHECK_EQUAL(graph.GetPhysical(debug), InvalidResource);
+	CHECK_EQUAL(graph.GetPhysical(debugBlurred), InvalidResource);
+	CHECK_EQUAL(graph.GetPhysical(backBuffer), InvalidResource);
+
+	graph.Execute();
+	CHECK(runs[0] == 1 && runs[1] == 0 && runs[2] == 0 && runs[3] == 1);
+
+	// Reading the debug texture into the output brings the
+	// whole chain back
+	graph.Read(lightingPass, debugBlurred);
+	CHECK(graph.Compile());
+	CHECK_EQUAL(graph.GetStats().culledPasses, 0u);
+	CHECK(!graph.IsCulled(debugPass) && !graph.IsCulled(blurPass));
+
+	// No outputs at all: nothing is needed
+	graph.Reset();
+	RenderResource unused = graph.CreateTexture("Unused", colorDesc);
+	graph.Write(graph.AddPass("Orphan", CountRuns, &runs[0]), unused);
+	CHECK(graph.Compile());
+	CHECK(graph.IsCulled(0));
+	CHECK_EQUAL(graph.GetStats().physicalTextures, 0u);
+}
+
+TEST(RenderGraph_OrdersPassesAfterTheirInputs)
+{
+	RenderGraph graph;
+	RenderResource backBuffer = graph.Import("Back buffer", backBufferDesc);
+	RenderResource depth = graph.CreateTexture("Depth", depthDesc);
+	RenderResource hdr = graph.CreateTexture("HDR", hdrDesc);
+	graph.SetOutput(backBuffer);
+
+	// Added consumers first
+	unsigned int tonemap = graph.AddPass("Tonemap", 0, 0);
+	graph.Read(tonemap, hdr);
+	graph.Write(tonemap, backBuffer);
+	unsigned int ui = graph.AddPass("UI", 0, 0);
+	graph.Write(ui, backBuffer);
+	unsigned int opaque = graph.AddPass("Opaque", 0, 0);
+	graph.Read(opaque, depth);
+	graph.Write(opaque, hdr);
+	unsigned int prepass = graph.AddPass("Prepass", 0, 0);
+	graph.Write(prepass, depth);
+
+	CHECK(graph.Compile());
+	CHECK_EQUAL(Order(graph), std::string("Prepass Opaque Tonemap UI"));
+
+	// Every live pass comes after every pass writing what it reads
+	unsigned int position[4];
+	for (unsigned int p = 0; p < graph.GetPassCount(); p++)
+		position[graph.GetOrderedPass(p)] = p;
+	CHECK(position[prepass] < position[opaque]);
+	CHECK(position[opaque] < position[tonemap]);
+	CHECK(position[tonemap] < position[ui]);
+	CHECK_EQUAL(graph.GetOrderedPass(graph.GetPassCount()), RenderGraph::MaxPasses);
+
+	// A graph added in a working order stays in it
+	graph.Reset();
+	backBuffer = graph.Import("Back buffer", backBufferDesc);
+	depth = graph.CreateTexture("Depth", depthDesc);
+	graph.SetOutput(backBuffer);
+	graph.Write(graph.AddPass("A", 0, 0), depth);
+	graph.Write(graph.AddPass("B", 0, 0), backBuffer);
+	unsigned int c = graph.AddPass("C", 0, 0);
+	graph.Read(c, depth);
+	graph.Write(c, backBuffer);
+	CHECK(graph.Compile());
+	CHECK_EQUAL(Order(graph), std::string("A B C"));
+}
+
+TEST(RenderGraph_RejectsCycles)
+{
+	RenderGraph graph;
+	RenderResource a = graph.CreateTexture("A", colorDesc);
+	RenderResource b = graph.CreateTexture("B", colorDesc);
+	graph.SetOutput(b);
+
+	unsigned int first = graph.AddPass("First", 0, 0);
+	graph.Read(first, b);
+	graph.Write(first, a);
+	unsigned int second = graph.AddPass("Second", 0, 0);
+	graph.Read(second, a);
+	graph.Write(second, b);
+
+	CHECK(!graph.Compile());
+	CHECK(graph.GetError() != 0);
+
+	// Nothing runs from a graph that failed to compile
+	int runs = 0;
+	graph.Reset();
+	graph.AddPass("Never", CountRuns, &runs);
+	graph.Execute();
+	CHECK_EQUAL(runs, 0);
+}
+
+TEST(RenderGraph_AliasesTexturesThatNeverOverlap)
+{
+	// Bloom-style chain:
+	//   position  0: Scene      writes color
+	//   position  1: Bright     color -> bright (HDR)
+	//   position  2: Blur       bright -> blurred (same desc as color)
+	//   position  3: Luminance  blurred -> luminance (R32F)
+	//   position  4: Composite  luminance -> back buffer
+	RenderGraph graph;
+	RenderResource backBuffer = graph.Import("Back buffer", backBufferDesc);
+	RenderResource color = graph.CreateTexture("Color", colorDesc);
+	RenderResource bright = graph.CreateTexture("Bright", hdrDesc);
+	RenderResource blurred = graph.CreateTexture("Blurred", colorDesc);
+	RenderResource luminance = graph.CreateTexture("Luminance", depthDesc);
+	graph.SetOutput(backBuffer);
+
+	graph.Write(graph.AddPass("Scene", 0, 0), color);
+	unsigned int pass = graph.AddPass("Bright", 0, 0);
+	graph.Read(pass, color);
+	graph.Write(pass, bright);
+	pass = graph.AddPass("Blur", 0, 0);
+	graph.Read(pass, bright);
+	graph.Write(pass, blurred);
+	pass = graph.AddPass("Luminance", 0, 0);
+	graph.Read(pass, blurred);
+	graph.Write(pass, luminance);
+	pass = graph.AddPass("Composite", 0, 0);
+	graph.Read(pass, luminance);
+	graph.Write(pass, backBuffer);
+
+	CHECK(graph.Compile());
+	CHECK_EQUAL(Order(graph), std::string("Scene Bright Blur Luminance Composite"));
+
+	// Color is done before blurred starts, and they match, so
+	// they share.  Bright overlaps both, and luminance only
+	// overlaps blurred but is a different format.
+	CHECK_EQUAL(graph.GetPhysical(color), graph.GetPhysical(blurred));
+	CHECK(graph.GetPhysical(bright) != graph.GetPhysical(color));
+	CHECK(graph.GetPhysical(luminance) != graph.GetPhysical(color));
+	CHECK(graph.GetPhysical(luminance) != graph.GetPhysical(bright));
+	CHECK_EQUAL(graph.GetPhysicalCount(), 3u);
+	CHECK(graph.GetPhysicalDesc(graph.GetPhysical(bright)).format == TextureFormat::RGBA16F);
+
+	const size_t colorBytes = RenderGraph::GetTextureBytes(colorDesc);
+	const size_t hdrBytes = RenderGraph::GetTextureBytes(hdrDesc);
+	const size_t depthBytes = RenderGraph::GetTextureBytes(depthDesc);
+	CHECK_EQUAL(colorBytes, (size_t)64 * 32 * 4);
+	CHECK_EQUAL(hdrBytes, (size_t)64 * 32 * 8);
+	CHECK_EQUAL(depthBytes, (size_t)64 * 32 * 4);
+
+	const RenderGraph::Stats& stats = graph.GetStats();
+	CHECK_EQUAL(stats.transientTextures, 4u);
+	CHECK_EQUAL(stats.physicalTextures, 3u);
+	CHECK_EQUAL(stats.transientBytes, colorBytes * 2 + hdrBytes + depthBytes);
+	CHECK_EQUAL(stats.allocatedBytes, colorBytes + hdrBytes + depthBytes);
+
+	// Most alive at once is one texture and the HDR one (at
+	// Bright and at Blur), less than everything allocated
+	CHECK_EQUAL(stats.peakLiveBytes, colorBytes + hdrBytes);
+	CHECK(stats.peakLiveBytes < stats.allocatedBytes);
+}
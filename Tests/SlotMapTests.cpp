@@ -0,0 +1,136 @@
+#include "Test.h"
+#include "SlotMap.h"
+
+#include <string>
+
+// Annonymous namespace to hold helpers
+// only accessible in this file
+namespace
+{
+	typedef SlotMap<std::string> Names;
+	typedef Names::HandleType NameHandle;
+}
+
+TEST(SlotMap_GetRejectsStaleHandles)
+{
+	Names names;
+	NameHandle first = names.Emplace("first");
+	CHECK(names.Get(first) && *names.Get(first) == "first");
+
+	CHECK(names.Remove(first));
+	CHECK(names.Get(first) == 0);
+	CHECK(!names.Contains(first));
+	CHECK(!names.Remove(first));
+
+	// The slot is reused, but the old handle still misses
+	NameHandle second = names.Emplace("second");
+	CHECK_EQUAL(second.Index(), first.Index());
+	CHECK(second.Generation() != first.Generation());
+	CHECK(names.Get(first) == 0);
+	CHECK(names.Get(second) && *names.Get(second) == "second");
+
+	// Never-made and out-of-range handles miss too
+	CHECK(names.Get(NameHandle()) == 0);
+	CHECK(names.Get(NameHandle::Make(1000, 0)) == 0);
+}
+
+TEST(SlotMap_GenerationWrapsAtMaxGeneration)
+{
+	Names names;
+	NameHandle h = names.Emplace("a");
+	const uint32_t slot = h.Index();
+
+	// Walk the slot up to the last generation there is
+	for (uint32_t g = 0; g + 1 < NameHandle::MaxGeneration; g++)
+	{
+		CHECK(names.Remove(h));
+		h = names.Emplace("a");
+		CHECK_EQUAL(h.Index(), slot);
+	}
+	CHECK_EQUAL(h.Generation(), NameHandle::MaxGeneration - 1);
+	CHECK(h.IsValid());
+	CHECK(names.Get(h) != 0);
+
+	// One more retire wraps back to zero, and the handle from
+	// the last generation is rejected
+	NameHandle last = h;
+	CHECK(names.Remove(last));
+	NameHandle wrapped = names.Emplace("b");
+	CHECK_EQUAL(wrapped.Index(), slot);
+	CHECK_EQUAL(wrapped.Generation(), 0u);
+	CHECK(wrapped.IsValid());
+	CHECK(names.Get(last) == 0);
+	CHECK(names.Get(wrapped) && *names.Get(wrapped) == "b");
+}
+
+TEST(SlotMap_FreeListReusesSlots)
+{
+	Names names;
+	NameHandle a = names.Emplace("a");
+	NameHandle b = names.Emplace("b");
+	NameHandle c = names.Emplace("c");
+	CHECK_EQUAL(names.Size(), 3u);
+
+	names.Remove(b);
+	names.Remove(a);
+	CHECK_EQUAL(names.Size(), 1u);
+
+	// Most recently freed first, then fresh slots
+	NameHandle d = names.Emplace("d");
+	NameHandle e = names.Emplace("e");
+	NameHandle f = names.Emplace("f");
+	CHECK_EQUAL(d.Index(), a.Index());
+	CHECK_EQUAL(e.Index(), b.Index());
+	CHECK_EQUAL(f.Index(), 3u);
+	CHECK_EQUAL(names.Size(), 4u);
+
+	CHECK(*names.Get(c) == "c");
+	CHECK(*names.Get(d) == "d");
+	CHECK(*names.Get(e) == "e");
+	CHECK(*names.Get(f) == "f");
+}
+
+TEST(SlotMap_SwapRemoveFixesUpIndices)
+{
+	Names names;
+	NameHandle handles[5];
+	const char* values[5] = { "v0", "v1", "v2", "v3", "v4" };
+	for (int i = 0; i < 5; i++)
+		handles[i] = names.Emplace(values[i]);
+
+	// The last value moves into the hole
+	names.Remove(handles[1]);
+	CHECK_EQUAL(names.Size(), 4u);
+	CHECK(names.Data()[1] == "v4");
+	CHECK(names.Get(handles[4]) == &names.Data()[1]);
+	CHECK(names.HandleAt(1) == handles[4]);
+
+	// Removing the last value moves nothing
+	names.Remove(handles[4]);
+	CHECK_EQUAL(names.Size(), 3u);
+	CHECK(names.Data()[0] == "v0" && names.Data()[1] == "v3" && names.Data()[2] == "v2");
+
+	// Every survivor still resolves to its own value, and
+	// HandleAt() agrees with where each one lives
+	const int survivors[] = { 0, 2, 3 };
+	for (int i : survivors)
+		CHECK(names.Get(handles[i]) && *names.Get(handles[i]) == values[i]);
+	for (size_t d = 0; d < names.Size(); d++)
+		CHECK(names.Get(names.HandleAt(d)) == &names.Data()[d]);
+}
+
+TEST(SlotMap_ClearRetiresEveryHandle)
+{
+	Names names;
+	NameHandle a = names.Emplace("a");
+	NameHandle b = names.Emplace("b");
+	names.Clear();
+
+	CHECK(names.Empty());
+	CHECK(names.Get(a) == 0);
+	CHECK(names.Get(b) == 0);
+
+	NameHandle c = names.Emplace("c");
+	CHECK(c.Index() == a.Index() || c.Index() == b.Index());
+	CHECK(names.Get(c) && *names.Get(c) == "c");
+}
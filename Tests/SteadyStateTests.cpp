@@ -0,0 +1,170 @@
+#include "Test.h"
+#include "Scene.h"
+#include "Systems.h"
+#include "Mesh.h"
+#include "Vertex.h"
+#include "SlotMap.h"
+#include "InstanceBuffer.h"
+#include "LightGrid.h"
+#include "LinearAllocator.h"
+#include "RecordingCommandBackend.h"
+#include "JobSystem.h"
+#include "AllocationTracker.h"
+
+#include <vector>
+
+using namespace DirectX;
+
+// Annonymous namespace to hold helpers
+// only accessible in this file
+namespace
+{
+	// Everything a frame of the game touches that needs no
+	// window, device or ImGui, set up the way GameCore sets
+	// it up
+	struct World
+	{
+		SlotMap<Mesh> meshes;
+		Scene scene;
+		InstanceBuffer instances;
+		std::vector<EntityId> owners;
+		std::vector<Systems::MovingInstance> moving;
+		Systems::SharedPackets shared;
+		std::vector<Systems::DrawPacket> packets[2];
+		std::vector<Light> lights;
+		LightGrid lightGrid;
+		LinearAllocator frameMemory{ 64 * 1024 };
+		RecordingCommandBackend backend{ 8 };
+
+		XMFLOAT4X4 views[2];
+		XMFLOAT4X4 projection;
+	};
+
+	void Build(World& world, unsigned int entityCount, unsigned int lightCount)
+	{
+		Vertex vertices[] =
+		{
+			{ XMFLOAT3(-0.5f, -0.5f, 0.0f), XMFLOAT4(1, 0, 0, 1) },
+			{ XMFLOAT3(+0.0f, +0.5f, 0.0f), XMFLOAT4(0, 1, 0, 1) },
+			{ XMFLOAT3(+0.5f, -0.5f, 0.0f), XMFLOAT4(0, 0, 1, 1) },
+		};
+		unsigned int indices[] = { 0, 1, 2 };
+		MeshHandle mesh = world.meshes.Emplace("Triangle", vertices, 3, indices, 3);
+
+		world.instances.Initialize(64);
+		world.backend.keepSubmitted = false;
+
+		// A grid in front of the cameras, every other entity spinning
+		for (unsigned int i = 0; i < entityCount; i++)
+		{
+			EntityId id = world.scene.CreateEntity(ComponentRenderable);
+			unsigned int slot = world.instances.Allocate();
+			world.scene.SetMesh(id, mesh);
+			*world.scene.GetLocalBounds(id) = world.meshes[mesh].GetLocalBounds();
+			*world.scene.GetFlags(id) = EntityVisible | (i % 2 ? (uint32_t)EntitySpin : 0u);
+			*world.scene.GetInstanceSlot(id) = slot;
+
+			Transform* transform = world.scene.GetTransform(id);
+			transform->SetChangeTracker(world.instances.GetTracker(), slot);
+			transform->SetPosition((float)(i % 16) - 8.0f, (float)(i / 16 % 16) - 8.0f, 10.0f + (float)(i / 256));
+
+			if (slot >= world.owners.size())
+				world.owners.resize(slot + 1, InvalidEntity);
+			world.owners[slot] = id;
+		}
+
+		for (unsigned int i = 0; i < lightCount; i++)
+		{
+			Light light = {};
+			light.position = XMFLOAT3((float)(i % 8) * 2.0f - 8.0f, (float)(i / 8 % 8) * 2.0f - 8.0f, 8.0f + (float)(i % 5));
+			light.range = 3.0f;
+			light.color = XMFLOAT3(1, 1, 1);
+			light.intensity = 1.0f;
+			light.spotCosOuter = -1.0f;
+			world.lights.push_back(light);
+		}
+
+		XMStoreFloat4x4(&world.projection, XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 100.0f));
+		XMStoreFloat4x4(&world.views[0], XMMatrixLookToLH(XMVectorSet(0, 0, -5, 0), XMVectorSet(0, 0, 1, 0), XMVectorSet(0, 1, 0, 0)));
+		XMStoreFloat4x4(&world.views[1], XMMatrixLookToLH(XMVectorSet(4, 0, -5, 0), XMVectorSet(0, 0, 1, 0), XMVectorSet(0, 1, 0, 0)));
+	}
+
+	// Update() then Draw(), minus the UI, for two views
+	void Frame(World& world, float stepSeconds)
+	{
+		Systems::SavePoses(world.scene);
+		Systems::Spin(world.scene, stepSeconds);
+		Systems::UpdateBounds(world.scene);
+		Systems::FindMoving(world.scene, world.instances, world.moving);
+
+		XMFLOAT4X4 viewProjections[2];
+		Frustum frustums[2];
+		for (unsigned int v = 0; v < 2; v++)
+		{
+			XMStoreFloat4x4(&viewProjections[v], XMLoadFloat4x4(&world.views[v]) * XMLoadFloat4x4(&world.projection));
+			frustums[v].Build(viewProjections[v]);
+		}
+		FrustumSet frustumSet;
+		frustumSet.Build(frustums, 2);
+		Systems::CullViews(world.scene, frustumSet, world.shared);
+
+		InstanceView views[2];
+		for (unsigned int v = 0; v < 2; v++)
+		{
+			Systems::FilterView(world.shared, v, world.views[v], world.packets[v]);
+			Systems::SortFrontToBack(world.packets[v]);
+
+			DrawItem* draws = world.frameMemory.Allocate<DrawItem>(world.packets[v].size());
+			unsigned int drawCount = Systems::ResolveDraws(world.packets[v], world.meshes, draws);
+			views[v] = { viewProjections[v], draws, drawCount };
+		}
+
+		world.lightGrid.Configure(1280, 720, world.projection);
+		world.lightGrid.Assign(world.lights.data(), (unsigned int)world.lights.size(), world.views[0]);
+		LightUpdate lightUpdate;
+		world.lightGrid.Capture(world.frameMemory, world.lights.data(), (unsigned int)world.lights.size(), XMFLOAT3(0, 0, -5), 0.15f, lightUpdate);
+
+		Systems::WriteInstances(world.scene, world.instances, world.owners);
+		Systems::Interpolate(world.moving, world.owners, 0.5f, world.instances);
+		InstanceUpdate instanceUpdate;
+		world.instances.Capture(world.frameMemory, views, 2, instanceUpdate);
+
+		for (unsigned int v = 0; v < 2; v++)
+			Systems::Draw(views[v].draws, views[v].drawCount, world.backend);
+
+		world.frameMemory.Reset();
+	}
+}
+
+TEST(SteadyState_FramesAllocateNothingAfterWarmUp)
+{
+	JobSystem::ShutDown();
+	JobSystem::Initialize(3);
+	{
+		World world;
+		Build(world, 2048, 64);
+
+		// Scratch lists, job queues and profiler rings all grow
+		// to fit during the first few frames.  After that it's
+		// the same work every frame, so none of them should.
+		const unsigned int warmupFrames = 10;
+		unsigned long long allocations = 0;
+		for (unsigned int f = 0; f < warmupFrames + 60; f++)
+		{
+			// Tallies the previous frame
+			AllocationTracker::BeginFrame();
+			if (f > warmupFrames)
+				allocations += AllocationTracker::GetLastFrameTotal().allocations;
+			Frame(world, 1.0f / 60.0f);
+		}
+		AllocationTracker::BeginFrame();
+		allocations += AllocationTracker::GetLastFrameTotal().allocations;
+		CHECK_EQUAL(allocations, 0ull);
+
+		// Something was actually drawn, and moved
+		CHECK(world.backend.GetSubmittedCount(RecordingCommandBackend::Command::DrawIndexedInstanced) > 0);
+		CHECK(!world.moving.empty());
+		CHECK(world.lightGrid.GetStats().indices > 0);
+	}
+	JobSystem::ShutDown();
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+
+// --------------------------------------------------------
+// A tiny unit test harness for the parts of the engine that
+// need no window, device or Windows headers
+//
+// - TEST(Name) { ... } registers a test; every test in the
+//   executable runs in registration order
+// - CHECK() and friends record a failure and keep going,
+//   so one run reports everything that's wrong
+// - Built by the CMakeLists.txt next to the solution, and
+//   run with ctest (or directly, optionally with a name
+//   filter as the first argument)
+// --------------------------------------------------------
+namespace Test
+{
+	typedef void (*TestFunction)();
+
+	// Adds a test to the list at static initialization time
+	struct Registration
+	{
+		Registration(const char* name, TestFunction function);
+	};
+
+	// Notes a failed check in the running test
+	void Fail(const char* file, int line, const char* expression);
+
+	// Runs every test whose name contains filter (or all of
+	// them, if null) and returns how many failed
+	int RunAll(const char* filter);
+}
+
+#define TEST(name) \
+	static void Test_##name(); \
+	static Test::Registration Registration_##name(#name, Test_##name); \
+	static void Test_##name()
+
+#define CHECK(expression) \
+	do { if (!(expression)) Test::Fail(__FILE__, __LINE__, #expression); } while (0)
+
+#define CHECK_EQUAL(actual, expected) \
+	CHECK((actual) == (expected))
+
+#define CHECK_NEAR(actual, expected, tolerance) \
+	CHECK(std::fabs((double)(actual) - (double)(expected)) <= (double)(tolerance))
@@ -0,0 +1,66 @@
+#include "Test.h"
+
+#include <cstring>
+#include <vector>
+
+namespace Test
+{
+	// Annonymous namespace to hold variables
+	// only accessible in this file
+	namespace
+	{
+		struct Entry
+		{
+			const char* name;
+			TestFunction function;
+		};
+
+		// A function-local static, so registrations from other
+		// files' static initializers always find it constructed
+		std::vector<Entry>& Entries()
+		{
+			static std::vector<Entry> entries;
+			return entries;
+		}
+
+		int currentFailures = 0;
+	}
+}
+
+Test::Registration::Registration(const char* name, TestFunction function)
+{
+	Entries().push_back({ name, function });
+}
+
+void Test::Fail(const char* file, int line, const char* expression)
+{
+	printf("  %s(%d): CHECK failed: %s\n", file, line, expression);
+	currentFailures++;
+}
+
+int Test::RunAll(const char* filter)
+{
+	int ran = 0;
+	int failed = 0;
+	for (const Entry& entry : Entries())
+	{
+		if (filter && !strstr(entry.name, filter))
+			continue;
+
+		currentFailures = 0;
+		entry.function();
+		ran++;
+
+		printf("%s %s\n", currentFailures == 0 ? "[ ok ]" : "[FAIL]", entry.name);
+		if (currentFailures > 0)
+			failed++;
+	}
+
+	printf("\n%d of %d tests passed\n", ran - failed, ran);
+	return failed;
+}
+
+int main(int argc, char** argv)
+{
+	return Test::RunAll(argc > 1 ? argv[1] : 0) == 0 ? 0 : 1;
+}
@@ -1,4 +1,5 @@
 #include "Transform.h"
+#include "DirtyRangeTracker.h"
 
 Transform::Transform()
 {
@@ -10,6 +11,9 @@ Transform::Transform()
 	up = DirectX::XMFLOAT3(0.0f, 1.0f, 0.0f);
 	forward = DirectX::XMFLOAT3(0.0f, 0.0f, 1.0f);
 
+	changeTracker = 0;
+	changeSlot = 0;
+
 	DirectX::XMStoreFloat4x4(&worldMatrix, DirectX::XMMatrixIdentity());
 	DirectX::XMStoreFloat4x4(&worldInverseTranspose, DirectX::XMMatrixIdentity());
 }
@@ -73,6 +77,29 @@ DirectX::XMFLOAT4X4 Transform::GetWorldInverseTransposeMatrix()
 	return worldInverseTranspose;
 }
 
+TransformPose Transform::GetPose()
+{
+	return { position, rotation, scale };
+}
+
+DirectX::XMMATRIX Transform::BuildWorldMatrix(const TransformPose& pose)
+{
+	DirectX::XMMATRIX tr = DirectX::XMMatrixTranslation(pose.position.x, pose.position.y, pose.position.z);
+	DirectX::XMMATRIX rt = DirectX::XMMatrixRotationRollPitchYawFromVector(DirectX::XMLoadFloat3(&pose.rotation));
+	DirectX::XMMATRIX sc = DirectX::XMMatrixScaling(pose.scale.x, pose.scale.y, pose.scale.z);
+
+	return sc * rt * tr;
+}
+
+TransformPose Transform::Lerp(const TransformPose& from, const TransformPose& to, float t)
+{
+	TransformPose result;
+	DirectX::XMStoreFloat3(&result.position, DirectX::XMVectorLerp(DirectX::XMLoadFloat3(&from.position), DirectX::XMLoadFloat3(&to.position), t));
+	DirectX::XMStoreFloat3(&result.rotation, DirectX::XMVectorLerp(DirectX::XMLoadFloat3(&from.rotation), DirectX::XMLoadFloat3(&to.rotation), t));
+	DirectX::XMStoreFloat3(&result.scale, DirectX::XMVectorLerp(DirectX::XMLoadFloat3(&from.scale), DirectX::XMLoadFloat3(&to.scale), t));
+	return result;
+}
+
 void Transform::MoveAbsolute(float x, float y, float z)
 {
 	position.x = x;
@@ -127,6 +154,7 @@ void Transform::MoveRelative(float x, float y, float z)
 	DirectX::XMVECTOR rot = DirectX::XMQuaternionRotationRollPitchYaw(rotation.x, rotation.y, rotation.z);
 	DirectX::XMVECTOR rotVec = DirectX::XMVector3Rotate(DirectX::XMVectorSet(x, y, z, 1), rot);
 	DirectX::XMStoreFloat3(&position, DirectX::XMVectorAdd(DirectX::XMLoadFloat3(&position), rotVec));
+	UpdateWorld();
 }
 
 void Transform::MoveRelative(DirectX::XMFLOAT3 offset)
@@ -134,6 +162,7 @@ void Transform::MoveRelative(DirectX::XMFLOAT3 offset)
 	DirectX::XMVECTOR rot = DirectX::XMQuaternionRotationRollPitchYaw(rotation.x, rotation.y, rotation.z);
 	DirectX::XMVECTOR rotVec = DirectX::XMVector3Rotate(DirectX::XMVectorSet(offset.x, offset.y, offset.z, 1), rot);
 	DirectX::XMStoreFloat3(&position, DirectX::XMVectorAdd(DirectX::XMLoadFloat3(&position), rotVec));
+	UpdateWorld();
 }
 
 DirectX::XMFLOAT3 Transform::GetRight()
@@ -161,15 +190,23 @@ DirectX::XMFLOAT3 Transform::GetFoward()
 	return forward;
 }
 
-void Transform::UpdateWorld()
+void Transform::SetChangeTracker(DirtyRangeTracker* tracker, unsigned int slot)
 {
-	DirectX::XMMATRIX tr = DirectX::XMMatrixTranslation(position.x, position.y, position.z);
-	DirectX::XMMATRIX rt = DirectX::XMMatrixRotationRollPitchYawFromVector(DirectX::XMLoadFloat3(&rotation));
-	DirectX::XMMATRIX sc = DirectX::XMMatrixScaling(scale.x, scale.y, scale.z);
+	changeTracker = tracker;
+	changeSlot = slot;
 
-	DirectX::XMMATRIX world = sc * rt * tr;
+	if (changeTracker)
+		changeTracker->MarkDirty(changeSlot);
+}
+
+void Transform::UpdateWorld()
+{
+	DirectX::XMMATRIX world = BuildWorldMatrix(GetPose());
 
 	DirectX::XMStoreFloat4x4(&worldMatrix, world);
 	DirectX::XMStoreFloat4x4(&worldInverseTranspose, XMMatrixInverse(0, XMMatrixTranspose(world)));
 
+	if (changeTracker)
+		changeTracker->MarkDirty(changeSlot);
+
 }
@@ -1,7 +1,17 @@
 #pragma once
-#include <d3d11.h>
 #include <DirectXMath.h>
 
+class DirtyRangeTracker;
+
+// The simulated part of a transform (no cached matrices),
+// small enough to snapshot every step for interpolation
+struct TransformPose
+{
+	DirectX::XMFLOAT3 position;
+	DirectX::XMFLOAT3 rotation;
+	DirectX::XMFLOAT3 scale;
+};
+
 class Transform
 {
 public:
@@ -19,6 +29,14 @@ public:
 	DirectX::XMFLOAT3 GetScale();
 	DirectX::XMFLOAT4X4 GetWorldMatrix();
 	DirectX::XMFLOAT4X4 GetWorldInverseTransposeMatrix();
+	TransformPose GetPose();
+
+	// Scale, then rotate, then translate - the same world
+	// matrix a transform with this pose would have
+	static DirectX::XMMATRIX BuildWorldMatrix(const TransformPose& pose);
+
+	// Linear blend of two poses (rotation as pitch/yaw/roll)
+	static TransformPose Lerp(const TransformPose& from, const TransformPose& to, float t);
 	
 	void MoveAbsolute(float x, float y, float z);
 	void MoveAbsolute(DirectX::XMFLOAT3 offset);
@@ -34,6 +52,10 @@ public:
 	DirectX::XMFLOAT3 GetUp();
 	DirectX::XMFLOAT3 GetFoward();
 
+	// Change notification - the tracker's slot is flagged
+	// whenever the world matrix is rebuilt
+	void SetChangeTracker(DirtyRangeTracker* tracker, unsigned int slot);
+
 private:
 	DirectX::XMFLOAT3 position;
 	DirectX::XMFLOAT3 rotation;
@@ -46,6 +68,9 @@ private:
 	DirectX::XMFLOAT3 up;
 	DirectX::XMFLOAT3 forward;
 
+	DirtyRangeTracker* changeTracker;
+	unsigned int changeSlot;
+
 	void UpdateWorld();
 };
 
@@ -1,12 +1,46 @@
 
-//The cbuffer
+// Permutation features, set by ShaderCache (see ShaderFeature
+// in ShaderCache.h).  The .cso the build makes has none.
+#ifndef TINT_ONLY
+#define TINT_ONLY 0
+#endif
+#ifndef INSTANCE_COLORS
+#define INSTANCE_COLORS 0
+#endif
+#ifndef DEPTH_ONLY
+#define DEPTH_ONLY 0
+#endif
+#ifndef CLUSTERED_LIGHTS
+#define CLUSTERED_LIGHTS 0
+#endif
+
+//The cbuffer - per-frame data shared by every draw
 cbuffer ExternalData : register(b0) {
-	float4 colorTint;
-	matrix world;
 	matrix view;
 	matrix projection;
+	uint drawOffset;	// Each view has its own block of DrawData
 }
 
+// Per-instance data, persistent across frames
+// - Must match InstanceData in BufferStructs.h
+struct InstanceData
+{
+	matrix world;
+	float4 colorTint;
+};
+StructuredBuffer<InstanceData> instances : register(t0);
+
+// Per-draw data, computed on the CPU each frame for just the visible draws
+// - Must match DrawData in BufferStructs.h
+// - One block of them per view, one after the other
+struct DrawData
+{
+	matrix worldViewProj;
+	uint instanceSlot;	// Where this draw's InstanceData lives
+	uint3 padding;
+};
+StructuredBuffer<DrawData> draws : register(t1);
+
 // Struct representing a single vertex worth of data
 // - This should match the vertex definition in our C++ code
 // - By "match", I mean the size, order and number of members
@@ -20,7 +54,10 @@ struct VertexShaderInput
 	//  |    |                |
 	//  v    v                v
 	float3 localPosition	: POSITION;     // XYZ position
-	float4 color			: COLOR;        // RGBA color
+#if !DEPTH_ONLY
+	float4 color			: COLOR;        // RGBA color (depth-only passes read positions alone)
+#endif
+	uint drawIndex			: INSTANCEINDEX; // Position in this view's draw list (per-instance stream)
 };
 
 // Struct representing the data we're sending down the pipeline
@@ -37,6 +74,10 @@ struct VertexToPixel
 	//  v    v                v
 	float4 screenPosition	: SV_POSITION;	// XYZW position (System Value Position)
 	float4 color			: COLOR;        // RGBA color
+#if CLUSTERED_LIGHTS
+	float3 worldPosition	: POSITION;		// For the lighting, and the flat normal
+	float viewDepth			: DEPTH;		// Picks the cluster's depth slice
+#endif
 };
 
 // --------------------------------------------------------
@@ -60,13 +101,38 @@ VertexToPixel main( VertexShaderInput input )
 	//   which we're leaving at 1.0 for now (this is more useful when dealing with 
 	//   a perspective projection matrix, which we'll get to in the future).
 	/*output.screenPosition = mul(world, float4(input.localPosition, 1.0f));*/
-	matrix wvp = mul(projection, mul(view, world));
-	output.screenPosition = mul(wvp, float4(input.localPosition, 1.0f));
+	// The full world-view-projection is constant per object, so it's
+	// composed once on the CPU and all that's left here is a single
+	// matrix-vector multiply
+	// - precise, so a depth prepass and the pass after it get
+	//   bit-identical depths for an EQUAL test to match
+	DrawData draw = draws[drawOffset + input.drawIndex];
+	InstanceData instance = instances[draw.instanceSlot];
+	precise float4 position = mul(draw.worldViewProj, float4(input.localPosition, 1.0f));
+	output.screenPosition = position;
 
 	// Pass the color through 
 	// - The values will be interpolated per-pixel by the rasterizer
 	// - We don't need to alter it here, but we do need to send it to the pixel shader
-	output.color = input.color * colorTint;
+#if DEPTH_ONLY
+	// Nothing reads it, as there's no pixel shader
+	output.color = float4(0, 0, 0, 0);
+#elif INSTANCE_COLORS
+	// A stable color per instance slot, to see how they're packed
+	uint hash = draw.instanceSlot * 2654435761u;
+	output.color = float4(((hash >> uint3(0, 8, 16)) & 255) / 255.0f, 1.0f);
+#elif TINT_ONLY
+	output.color = instance.colorTint;
+#else
+	output.color = input.color * instance.colorTint;
+#endif
+
+#if CLUSTERED_LIGHTS
+	// The pixel shader finds its cluster by view depth
+	float4 worldPosition = mul(instance.world, float4(input.localPosition, 1.0f));
+	output.worldPosition = worldPosition.xyz;
+	output.viewDepth = mul(view, worldPosition).z;
+#endif
 
 	// Whatever we return will make its way through the pipeline to the
 	// next programmable stage we're using (the pixel shader for now)
@@ -2,6 +2,7 @@
 #include "Window.h"
 #include "Graphics.h"
 #include "Input.h"
+#include "RenderThread.h"
 #include "imgui_impl_win32.h"
 extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(
 	HWND hWnd,
@@ -294,6 +295,9 @@ LRESULT Window::ProcessMessage(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lPara
 		windowHeight = HIWORD(lParam);
 
 		// Let other systems know
+		// - The render thread has to be done with the old
+		//   buffers before they can be resized
+		RenderThread::Flush();
 		Graphics::ResizeBuffers(windowWidth, windowHeight);
 		if(onResize)
 			onResize();